@@ -20,13 +20,14 @@ vbam/gba/bios.cpp vbam/gba/Globals.cpp \
 vbam/gba/Cheats.cpp vbam/gba/Mode0.cpp \
 vbam/gba/CheatSearch.cpp vbam/gba/Mode1.cpp \
 vbam/gba/EEprom.cpp vbam/gba/Mode2.cpp \
-vbam/gba/Mode3.cpp \
+vbam/gba/Mode3.cpp vbam/gba/GBAGfxCompose.cpp \
 vbam/gba/Flash.cpp vbam/gba/Mode4.cpp \
 vbam/gba/GBA-arm.cpp vbam/gba/Mode5.cpp \
 vbam/gba/GBA.cpp \
 vbam/gba/gbafilter.cpp vbam/gba/RTC.cpp \
 vbam/gba/Sound.cpp \
-vbam/gba/Sram.cpp vbam/common/memgzio.c vbam/Util.cpp
+vbam/gba/Sram.cpp vbam/gba/IdleLoop.cpp vbam/gba/GBAGfxThread.cpp vbam/gba/GBALocalLink.cpp \
+vbam/gba/SaveFile.cpp vbam/common/memgzio.c vbam/Util.cpp
 #vbam/gba/remote.cpp vbam/gba/GBASockClient.cpp vbam/gba/GBALink.cpp vbam/gba/agbprint.cpp
 # vbam/7z_C/7zHeader.c vbam/7z_C/7zItem.c vbam/gba/armdis.cpp vbam/gba/elf.cpp
 
@@ -49,6 +50,10 @@ vbam/7z_C/Bcj2.c vbam/7z_C/Bra86.c vbam/7z_C/Ppmd7.c vbam/7z_C/Ppmd7Dec.c
 
 include $(IMAGINE_PATH)/make/package/stdc++.mk
 
+ifeq ($(ENV), linux)
+ LDLIBS += -lrt # shm_open for GBALocalLink
+endif
+
 ifndef target
  target := gbaemu
 endif
@@ -4,10 +4,82 @@
 class GbaOptionView : public OptionView
 {
 private:
+	struct RenderThreadMenuItem : public BoolMenuItem
+	{
+		void init() { BoolMenuItem::init("Threaded Rendering", optionRenderThread); }
+
+		void select(View *view, const InputEvent &e)
+		{
+			toggle();
+			optionRenderThread = on;
+			gGfxThread.setThreaded(on);
+		}
+	} renderThread;
+
+	#ifndef CONFIG_BASE_ANDROID
+	// no POSIX shared memory on Android
+	struct LocalLinkMenuItem : public BoolMenuItem
+	{
+		void init() { BoolMenuItem::init("Local Link Cable", optionLocalLink); }
+
+		void select(View *view, const InputEvent &e)
+		{
+			toggle();
+			optionLocalLink = on;
+			if(!EmuSystem::gameIsRunning())
+				return;
+			if(on)
+				gLocalLink.open();
+			else
+				gLocalLink.close();
+		}
+	} localLink;
+	#endif
+
+	struct SyncSavesMenuItem : public BoolMenuItem
+	{
+		void init() { BoolMenuItem::init("Sync Saves To Storage", optionSyncSaves); }
+
+		void select(View *view, const InputEvent &e)
+		{
+			toggle();
+			optionSyncSaves = on;
+			gSaveFile.setSyncPolicy(on ? GBASaveFile::SYNC_FLUSH : GBASaveFile::SYNC_NONE);
+		}
+	} syncSaves;
+
+	struct SkipIdleLoopsMenuItem : public BoolMenuItem
+	{
+		void init() { BoolMenuItem::init("Skip Idle Loops", optionSkipIdleLoops); }
+
+		void select(View *view, const InputEvent &e)
+		{
+			toggle();
+			optionSkipIdleLoops = on;
+			gIdleLoop.setEnabled(on);
+		}
+	} skipIdleLoops;
+
 	MenuItem *item[24];
 
 public:
 
+	void loadVideoItems(MenuItem *item[], uint &items)
+	{
+		OptionView::loadVideoItems(item, items);
+		renderThread.init(); item[items++] = &renderThread;
+	}
+
+	void loadSystemItems(MenuItem *item[], uint &items)
+	{
+		OptionView::loadSystemItems(item, items);
+		#ifndef CONFIG_BASE_ANDROID
+		localLink.init(); item[items++] = &localLink;
+		#endif
+		syncSaves.init(); item[items++] = &syncSaves;
+		skipIdleLoops.init(); item[items++] = &skipIdleLoops;
+	}
+
 	void init(uint idx, bool highlightFirst)
 	{
 		uint i = 0;
@@ -28,6 +28,10 @@
 #include <CommonFrameworkIncludes.hh>
 
 #include <vbam/gba/GBA.h>
+#include <vbam/gba/GBAGfxThread.h>
+#include <vbam/gba/GBALocalLink.h>
+#include <vbam/gba/IdleLoop.h>
+#include <vbam/gba/SaveFile.h>
 #include <vbam/gba/Sound.h>
 #include <vbam/common/SoundDriver.h>
 #include <vbam/Util.h>
@@ -183,9 +187,16 @@ enum
 	CFGKEY_GBAKEY_A = 266, CFGKEY_GBAKEY_B = 267,
 	CFGKEY_GBAKEY_A_TURBO = 268, CFGKEY_GBAKEY_B_TURBO = 269,
 	CFGKEY_GBAKEY_L = 270, CFGKEY_GBAKEY_R = 271,
-	CFGKEY_GBAKEY_AB = 272,
+	CFGKEY_GBAKEY_AB = 272, CFGKEY_GBA_RENDER_THREAD = 273,
+	CFGKEY_GBA_LOCAL_LINK = 274, CFGKEY_GBA_SYNC_SAVES = 275,
+	CFGKEY_GBA_SKIP_IDLE_LOOPS = 276,
 };
 
+static BasicByteOption optionRenderThread(CFGKEY_GBA_RENDER_THREAD, 0);
+static BasicByteOption optionLocalLink(CFGKEY_GBA_LOCAL_LINK, 0);
+static BasicByteOption optionSyncSaves(CFGKEY_GBA_SYNC_SAVES, 1);
+static BasicByteOption optionSkipIdleLoops(CFGKEY_GBA_SKIP_IDLE_LOOPS, 1);
+
 bool EmuSystem::readConfig(Io *io, uint key, uint readSize)
 {
 	switch(key)
@@ -208,6 +219,10 @@ bool EmuSystem::readConfig(Io *io, uint key, uint readSize)
 		bcase CFGKEY_GBAKEY_L: readKeyConfig2(io, gbaKeyIdxL, readSize);
 		bcase CFGKEY_GBAKEY_R: readKeyConfig2(io, gbaKeyIdxR, readSize);
 		bcase CFGKEY_GBAKEY_AB: readKeyConfig2(io, gbaKeyIdxAB, readSize);
+		bcase CFGKEY_GBA_RENDER_THREAD: optionRenderThread.readFromIO(io, readSize);
+		bcase CFGKEY_GBA_LOCAL_LINK: optionLocalLink.readFromIO(io, readSize);
+		bcase CFGKEY_GBA_SYNC_SAVES: optionSyncSaves.readFromIO(io, readSize);
+		bcase CFGKEY_GBA_SKIP_IDLE_LOOPS: optionSkipIdleLoops.readFromIO(io, readSize);
 	}
 	return 1;
 }
@@ -231,6 +246,26 @@ void EmuSystem::writeConfig(Io *io)
 	writeKeyConfig2(io, gbaKeyIdxL, CFGKEY_GBAKEY_L);
 	writeKeyConfig2(io, gbaKeyIdxR, CFGKEY_GBAKEY_R);
 	writeKeyConfig2(io, gbaKeyIdxAB, CFGKEY_GBAKEY_AB);
+	if(!optionRenderThread.isDefault())
+	{
+		io->writeVar((uint16)optionRenderThread.ioSize());
+		optionRenderThread.writeToIO(io);
+	}
+	if(!optionLocalLink.isDefault())
+	{
+		io->writeVar((uint16)optionLocalLink.ioSize());
+		optionLocalLink.writeToIO(io);
+	}
+	if(!optionSyncSaves.isDefault())
+	{
+		io->writeVar((uint16)optionSyncSaves.ioSize());
+		optionSyncSaves.writeToIO(io);
+	}
+	if(!optionSkipIdleLoops.isDefault())
+	{
+		io->writeVar((uint16)optionSkipIdleLoops.ioSize());
+		optionSkipIdleLoops.writeToIO(io);
+	}
 }
 
 static bool isGBAExtension(const char *name)
@@ -309,11 +344,21 @@ int EmuSystem::saveState()
 		return STATE_RESULT_IO_ERROR;
 }
 
+// The loaded state's save memory replaces the game's, write it out right away
+// instead of waiting for the save file's update timer
+static bool readState(const char *path)
+{
+	if(!CPUReadState(path))
+		return false;
+	gSaveFile.flush();
+	return true;
+}
+
 int EmuSystem::loadState()
 {
 	FsSys::cPath saveStr;
 	sprintStateFilename(saveStr, saveStateSlot);
-	if(CPUReadState(saveStr))
+	if(readState(saveStr))
 		return STATE_RESULT_OK;
 	else
 		return STATE_RESULT_IO_ERROR;
@@ -334,6 +379,11 @@ void EmuSystem::saveBackupMem()
 	if(gameIsRunning())
 	{
 		logMsg("saving backup memory");
+		if(gSaveFile.active())
+		{
+			gSaveFile.flush();
+			return;
+		}
 		FsSys::cPath saveStr;
 		snprintf(saveStr, sizeof(saveStr), "%s%s", gameName, ".sav");
 		CPUWriteBatteryFile(saveStr);
@@ -349,6 +399,8 @@ void EmuSystem::closeSystem()
 	assert(gameIsRunning());
 	logMsg("closing game %s", gameName);
 	saveBackupMem();
+	gSaveFile.close();
+	gLocalLink.close();
 	CPUCleanUp();
 }
 
@@ -370,10 +422,15 @@ int EmuSystem::loadGame(const char *path, bool allowAutosaveState)
 	string_copyUpToLastCharInstance(gameName, path, '.');
 	logMsg("set game name: %s", gameName);
 	setGameSpecificSettings();
+	gIdleLoop.setEnabled(optionSkipIdleLoops);
 	CPUInit(0, 0);
 	CPUReset();
+	if(optionLocalLink)
+		gLocalLink.open();
 	FsSys::cPath saveStr;
 	snprintf(saveStr, sizeof(saveStr), "%s%s", gameName, ".sav");
+	gSaveFile.setSyncPolicy(optionSyncSaves ? GBASaveFile::SYNC_FLUSH : GBASaveFile::SYNC_NONE);
+	gSaveFile.open(saveStr);
 	CPUReadBatteryFile(saveStr);
 	emuView.initImage(0, 240, 160);
 
@@ -381,7 +438,7 @@ int EmuSystem::loadGame(const char *path, bool allowAutosaveState)
 	{
 		FsSys::cPath saveStr;
 		sprintStateFilename(saveStr, -1);
-		CPUReadState(saveStr);
+		readState(saveStr);
 	}
 
 	logMsg("started emu");
@@ -427,6 +484,7 @@ void systemOnWriteDataToSoundBuffer(const u16 * finalWave, int length)
 void EmuSystem::runFrame(bool renderGfx, bool processGfx, bool renderAudio)
 {
 	CPULoop(renderGfx, processGfx, renderAudio);
+	gSaveFile.frameUpdate();
 }
 
 namespace Input
@@ -456,6 +514,7 @@ CallResult onInit()
 	mainInitCommon();
 	emuView.initPixmap((uchar*)gLcd.pix, pixFmt, 240, 160);
 	utilUpdateSystemColorMaps(0);
+	gGfxThread.setThreaded(optionRenderThread);
 
 	mMenu.init(Config::envIsPS3);
 	viewStack.push(&mMenu);
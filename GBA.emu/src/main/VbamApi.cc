@@ -1,6 +1,7 @@
 #include <vbam/gba/GBA.h>
 #include <vbam/gba/Sound.h>
 #include <vbam/gba/RTC.h>
+#include <vbam/gba/IdleLoop.h>
 #include <vbam/common/SoundDriver.h>
 #include <vbam/Util.h>
 #include <logger/interface.h>
@@ -57,6 +58,7 @@ struct GameSettings
 	int rtcEnabled;
 	int flashSize;
 	int mirroringEnabled;
+	u32 idleLoop; // address of the loop head to always fast-forward, 0 to rely on auto-detection
 };
 
 static void resetGameSettings()
@@ -65,6 +67,8 @@ static void resetGameSettings()
 	rtcEnable(0);
 	cpuSaveType = 0;
 	flashSetSize(0x10000);
+	gIdleLoop.forcedAddr = 0;
+	gIdleLoop.flushCache();
 }
 
 void setGameSpecificSettings()
@@ -935,6 +939,11 @@ void setGameSpecificSettings()
 				cpuSaveType = e->saveType;
 			if(e->mirroringEnabled >= 0)
 				mirroringEnable = e->mirroringEnabled;
+			if(e->idleLoop)
+			{
+				logMsg("using idle loop at 0x%X", e->idleLoop);
+				gIdleLoop.forcedAddr = e->idleLoop;
+			}
 			break;
 		}
 	}
@@ -2,6 +2,7 @@
 #include <memory.h>
 #include "GBA.h"
 #include "EEprom.h"
+#include "SaveFile.h"
 #include "../Util.h"
 
 int eepromMode = EEPROM_IDLE;
@@ -175,6 +176,7 @@ void eepromWrite(u32 /* address */, u8 value, int cpuDmaCount)
       for(int i = 0; i < 8; i++) {
         eepromData[(eepromAddress << 3) + i] = eepromBuffer[i];
       }
+      gSaveFile.eepromWritten(eepromAddress << 3);
       systemSaveUpdateCounter = SYSTEM_SAVE_UPDATED;
     } else if(eepromBits == 0x41) {
       eepromMode = EEPROM_IDLE;
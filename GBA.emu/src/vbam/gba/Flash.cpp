@@ -5,6 +5,7 @@
 #include "Globals.h"
 #include "Flash.h"
 #include "Sram.h"
+#include "SaveFile.h"
 #include "../Util.h"
 
 #define FLASH_READ_ARRAY         0
@@ -218,11 +219,13 @@ void flashWrite(u32 address, u8 byte)
       memset(&flashSaveMemory[(flashBank << 16) + (address & 0xF000)],
              0,
              0x1000);
+      gSaveFile.flashWritten((flashBank << 16) + (address & 0xF000));
       systemSaveUpdateCounter = SYSTEM_SAVE_UPDATED;
       flashReadState = FLASH_ERASE_COMPLETE;
     } else if(byte == 0x10) {
       // CHIP ERASE
       memset(flashSaveMemory, 0, flashSize);
+      gSaveFile.flashErased();
       systemSaveUpdateCounter = SYSTEM_SAVE_UPDATED;
       flashReadState = FLASH_ERASE_COMPLETE;
     } else {
@@ -243,6 +246,7 @@ void flashWrite(u32 address, u8 byte)
     break;
   case FLASH_PROGRAM:
     flashSaveMemory[(flashBank<<16)+address] = byte;
+    gSaveFile.flashWritten((flashBank<<16)+address);
     systemSaveUpdateCounter = SYSTEM_SAVE_UPDATED;
     flashState = FLASH_READ_ARRAY;
     flashReadState = FLASH_READ_ARRAY;
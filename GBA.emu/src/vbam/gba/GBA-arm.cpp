@@ -2400,6 +2400,7 @@ int armExecute(ARM7TDMI &cpu)
         if (clockTicks == 0)
             clockTicks = 1 + codeTicksAccessSeq32(cpu, oldArmNextPC);
         cpuTotalTicks += clockTicks;
+        idleLoopCheckBranch(cpu, oldArmNextPC, 4);
 
     } while (cpuTotalTicks<cpuNextEvent &&
     		(!CONFIG_TRIGGER_ARM_STATE_EVENT && armState)
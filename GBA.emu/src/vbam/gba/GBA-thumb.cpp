@@ -1709,6 +1709,7 @@ int thumbExecute(ARM7TDMI &cpu)
       clockTicks = codeTicksAccessSeq16(cpu, oldArmNextPC) + 1;
     }
     cpuTotalTicks += clockTicks;
+    idleLoopCheckBranch(cpu, oldArmNextPC, 2);
 
   } while (cpuTotalTicks < cpuNextEvent &&
   		(!CONFIG_TRIGGER_ARM_STATE_EVENT && !armState)
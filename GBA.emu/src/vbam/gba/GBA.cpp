@@ -21,6 +21,8 @@
 #include "../System.h"
 #include "agbprint.h"
 #include "GBALink.h"
+#include "GBALocalLink.h"
+#include "SaveFile.h"
 #include <logger/interface.h>
 #include <io/sys.hh>
 
@@ -466,6 +468,9 @@ inline int CPUUpdateTicks(ARM7TDMI &cpu)
   if(timer3On && !(TM3CNT & 4) && (timer3Ticks < cpuLoopTicks)) {
     cpuLoopTicks = timer3Ticks;
   }
+  if(gLocalLink.transferring() && gLocalLink.ticks < cpuLoopTicks) {
+    cpuLoopTicks = gLocalLink.ticks;
+  }
 #ifdef PROFILING
   if(profilingTicksReload != 0) {
     if(profilingTicks < cpuLoopTicks) {
@@ -491,52 +496,13 @@ inline int CPUUpdateTicks(ARM7TDMI &cpu)
   return cpuLoopTicks;
 }
 
-static void CPUUpdateWindow0()
-{
-  int x00 = WIN0H>>8;
-  int x01 = WIN0H & 255;
-
-  if(x00 <= x01) {
-    for(int i = 0; i < 240; i++) {
-      gfxInWin0[i] = (i >= x00 && i < x01);
-    }
-  } else {
-    for(int i = 0; i < 240; i++) {
-      gfxInWin0[i] = (i >= x00 || i < x01);
-    }
-  }
-}
-
-static void CPUUpdateWindow1()
-{
-  int x00 = WIN1H>>8;
-  int x01 = WIN1H & 255;
-
-  if(x00 <= x01) {
-    for(int i = 0; i < 240; i++) {
-      gfxInWin1[i] = (i >= x00 && i < x01);
-    }
-  } else {
-    for(int i = 0; i < 240; i++) {
-      gfxInWin1[i] = (i >= x00 || i < x01);
-    }
-  }
-}
-
 static void CPUUpdateRenderBuffers(bool force)
 {
-  if(!(layerEnable & 0x0100) || force) {
-    gfxClearArray(line0);
-  }
-  if(!(layerEnable & 0x0200) || force) {
-  	gfxClearArray(line1);
-  }
-  if(!(layerEnable & 0x0400) || force) {
-  	gfxClearArray(line2);
-  }
-  if(!(layerEnable & 0x0800) || force) {
-  	gfxClearArray(line3);
-  }
+  // line buffers belong to the renderer, they're cleared before it draws the next line
+  if(force)
+    gGfxThread.clearLayers = 0xF;
+  else
+    gGfxThread.clearLayers |= ~(layerEnable >> 8) & 0xF;
 }
 
 static bool CPUWriteState(gzFile gzFile)
@@ -761,8 +727,9 @@ static bool CPUReadState(gzFile gzFile)
 
   CPUUpdateRender();
   CPUUpdateRenderBuffers(true);
-  CPUUpdateWindow0();
-  CPUUpdateWindow1();
+  gGfxThread.resync();
+  gLocalLink.cancel();
+  gSaveFile.markAll();
   gbaSaveType = 0;
   switch(saveType) {
   case 0:
@@ -1363,18 +1330,6 @@ static const char *dispModeName(void (*renderLine)(MixColorType *lineMix))
 	else return "Invalid";
 }
 
-void blankLine(MixColorType *lineMix)
-{
-	for(int x = 0; x < 240; x++)
-		lineMix[x] = convColor(0x7fff);
-}
-
-void blankLineUpdateLastVCount(MixColorType *lineMix)
-{
-	blankLine(lineMix);
-	gfxLastVCOUNT = VCOUNT;
-}
-
 void CPUUpdateRender()
 {
   switch(DISPCNT & 7) {
@@ -2377,12 +2332,10 @@ void CPUUpdateRegister(ARM7TDMI &cpu, u32 address, u16 value)
   case 0x40:
     WIN0H = value;
     //UPDATE_REG(0x40, WIN0H);
-    CPUUpdateWindow0();
     break;
   case 0x42:
     WIN1H = value;
     //UPDATE_REG(0x42, WIN1H);
-    CPUUpdateWindow1();
     break;
   case 0x44:
     WIN0V = value;
@@ -2629,7 +2582,10 @@ void CPUUpdateRegister(ARM7TDMI &cpu, u32 address, u16 value)
 
 
   case COMM_SIOCNT:
-	  StartLink(value);
+	  if(gLocalLink.active())
+		  gLocalLink.writeSIOCNT(cpu, value);
+	  else
+		  StartLink(value);
 	  break;
 
   case COMM_SIODATA8:
@@ -2957,6 +2913,7 @@ void CPUReset()
       }
   }
   rtcReset();
+  gIdleLoop.flushCache();
   // clean OAM, palette, picture, & vram
   gLcd.resetAll(useBios, skipBios);
   // clean io memory
@@ -3053,8 +3010,8 @@ void CPUReset()
 
   soundReset();
 
-  CPUUpdateWindow0();
-  CPUUpdateWindow1();
+  gGfxThread.resync();
+  gLocalLink.cancel();
 
   // make sure registers are correctly initialized if not using BIOS
   if(!useBios) {
@@ -3236,6 +3193,7 @@ void CPULoop(bool renderGfx, bool processGfx, bool renderAudio)
       clockTicks = cpuNextEvent;
       cpuTotalTicks = 0;
       gGba.dma.cpuDmaHack = false;
+      gIdleLoop.invalidate();
 
     updateLoop:
 
@@ -3347,50 +3305,11 @@ void CPULoop(bool renderGfx, bool processGfx, bool renderAudio)
             	{
             	}*/
 
-              (*renderLine)(lineMix);
-              switch(systemColorDepth) {
-				#ifdef SUPPORT_PIX_16BIT
-                case 16:
-                {
-                	if(!directColorLookup)
-                	{
-                  //u16 *dest = (u16 *)pix + 240 * (VCOUNT);
-                  //memcpy(dest, lineMix, 240*2);*/
-										for(int x = 0; x < 240; x++)
-										{
-											lineMix[x] = systemColorMap.map16[lineMix[x]];
-										}
-                	}
-                }
-                break;
-				#endif
-				#ifdef SUPPORT_PIX_32BIT
-                case 24:
-                {
-                  u8 *dest = (u8 *)pix + 240 * VCOUNT * 3;
-                  for(int x = 0; x < 240;) {
-                	for(int i = 0; i < 16; i++) {
-                      *((u32 *)dest) = systemColorMap32[lineMix[x++] & 0xFFFF];
-                      dest += 3;
-                	}
-                  }
-                }
-                break;
-                case 32:
-                {
-                  u32 *dest = (u32 *)pix + 240 * (VCOUNT);
-                  for(int x = 0; x < 240; ) {
-                	for(int i = 0; i < 16; i++)
-                      *dest++ = systemColorMap32[lineMix[x++] & 0xFFFF];
-
-                  }
-                }
-                break;
-				#endif
-              }
+              gGfxThread.drawLine(lineMix);
             }
             if(VCOUNT == 159 && likely(renderGfx))
             {
+              gGfxThread.finish();
            		systemDrawScreen();
             }
             // entering H-Blank
@@ -3575,6 +3494,9 @@ void CPULoop(bool renderGfx, bool processGfx, bool renderAudio)
 		  LinkUpdate(clockTicks);
 	  }
 
+	  if(gLocalLink.active())
+		  gLocalLink.update(cpu, clockTicks);
+
       cpuNextEvent = CPUUpdateTicks(cpu);
 
       if(gGba.dma.cpuDmaTicksToUpdate > 0) {
@@ -3669,6 +3591,7 @@ void CPULoop(bool renderGfx, bool processGfx, bool renderAudio)
 
     }
   } while(!cpuBreakLoop);
+  gGfxThread.finish();
   gGba.cpu = cpu;
 }
 
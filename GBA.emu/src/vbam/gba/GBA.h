@@ -37,7 +37,13 @@ extern GBAMem gMem;
 static auto &bios = gMem.bios;
 static auto &workRAM = gMem.workRAM;
 static auto &internalRAM = gMem.internalRAM;
+#ifdef VBAM_GBA_RENDER_TU
+// scanline renderers see the per-line register copy kept by GBAGfxThread
+extern u8 gGfxIoMem[0x400];
+static auto &ioMem = gGfxIoMem;
+#else
 static auto &ioMem = gMem.ioMem;
+#endif
 static auto &rom = gMem.rom;
 
 static uint16a &DM0SAD_L = *((uint16a*)&ioMem[0xB0]);
@@ -313,28 +319,35 @@ struct GBALCD
 
 extern GBALCD gLcd;
 
+#ifdef VBAM_GBA_RENDER_TU
+extern GBALCD gGfxLcd;
+static GBALCD &gfxLcd = gGfxLcd;
+#else
+static GBALCD &gfxLcd = gLcd;
+#endif
+
 #ifndef GBALCD_TEMP_LINE_BUFFER
-static auto &line0 = gLcd.line0;
-static auto &line1 = gLcd.line1;
-static auto &line2 = gLcd.line2;
-static auto &line3 = gLcd.line3;
-static auto &lineOBJ = gLcd.lineOBJ;
+static auto &line0 = gfxLcd.line0;
+static auto &line1 = gfxLcd.line1;
+static auto &line2 = gfxLcd.line2;
+static auto &line3 = gfxLcd.line3;
+static auto &lineOBJ = gfxLcd.lineOBJ;
 #endif
-static auto &lineOBJWin = gLcd.lineOBJWin;
-static auto &gfxInWin0 = gLcd.gfxInWin0;
-static auto &gfxInWin1 = gLcd.gfxInWin1;
-static auto &lineOBJpixleft = gLcd.lineOBJpixleft;
-static auto &gfxBG2Changed = gLcd.gfxBG2Changed;
-static auto &gfxBG3Changed = gLcd.gfxBG3Changed;
-static auto &gfxBG2X = gLcd.gfxBG2X;
-static auto &gfxBG2Y = gLcd.gfxBG2Y;
-static auto &gfxBG3X = gLcd.gfxBG3X;
-static auto &gfxBG3Y = gLcd.gfxBG3Y;
-static auto &gfxLastVCOUNT = gLcd.gfxLastVCOUNT;
-static auto &paletteRAM = gLcd.paletteRAM;
-static auto &vram = gLcd.vram;
-static auto &oam = gLcd.oam;
-static auto &layerEnable = gLcd.layerEnable;
+static auto &lineOBJWin = gfxLcd.lineOBJWin;
+static auto &gfxInWin0 = gfxLcd.gfxInWin0;
+static auto &gfxInWin1 = gfxLcd.gfxInWin1;
+static auto &lineOBJpixleft = gfxLcd.lineOBJpixleft;
+static auto &gfxBG2Changed = gfxLcd.gfxBG2Changed;
+static auto &gfxBG3Changed = gfxLcd.gfxBG3Changed;
+static auto &gfxBG2X = gfxLcd.gfxBG2X;
+static auto &gfxBG2Y = gfxLcd.gfxBG2Y;
+static auto &gfxBG3X = gfxLcd.gfxBG3X;
+static auto &gfxBG3Y = gfxLcd.gfxBG3Y;
+static auto &gfxLastVCOUNT = gfxLcd.gfxLastVCOUNT;
+static auto &paletteRAM = gfxLcd.paletteRAM;
+static auto &vram = gfxLcd.vram;
+static auto &oam = gfxLcd.oam;
+static auto &layerEnable = gfxLcd.layerEnable;
 
 typedef struct {
   u8 *address;
@@ -79,6 +79,14 @@ void mode5RenderLine(MixColorType *);
 void mode5RenderLineNoWindow(MixColorType *);
 void mode5RenderLineAll(MixColorType *);
 
+void blankLine(MixColorType *);
+void blankLineUpdateLastVCount(MixColorType *);
+
+// Composites BG0-3 (null if unused by the mode) & OBJ line buffers into lineMix,
+// using per-pixel window masks from gfxBuildWindowMask() or a single mask for the line
+void gfxComposeLine(MixColorType *lineMix, const u32 * const layer[5], const u8 *winMask, u8 mask);
+void gfxBuildWindowMask(u8 *winMask);
+
 static const int coeff[32] = {
   0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
   16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16};
@@ -113,8 +121,8 @@ static inline void gfxClearArray(u32 *array)
 static inline void gfxDrawTextScreen(u16 control, u16 hofs, u16 vofs,
 				     u32 *line)
 {
-	u8 (&paletteRAM)[0x400] = gLcd.paletteRAM;
-	u8 (&vram)[0x20000] = gLcd.vram;
+	u8 (&paletteRAM)[0x400] = gfxLcd.paletteRAM;
+	u8 (&vram)[0x20000] = gfxLcd.vram;
 
   u16 *palette = (u16 *)paletteRAM;
   u8 *charBase = &vram[((control >> 2) & 0x03) * 0x4000];
@@ -263,8 +271,8 @@ static inline void gfxDrawRotScreen(u16 control,
 				    int changed,
 				    u32 *line)
 {
-	u8 (&paletteRAM)[0x400] = gLcd.paletteRAM;
-	u8 (&vram)[0x20000] = gLcd.vram;
+	u8 (&paletteRAM)[0x400] = gfxLcd.paletteRAM;
+	u8 (&vram)[0x20000] = gfxLcd.vram;
 
   u16 *palette = (u16 *)paletteRAM;
   u8 *charBase = &vram[((control >> 2) & 0x03) * 0x4000];
@@ -401,8 +409,8 @@ static inline void gfxDrawRotScreen16Bit(u16 control,
 					 int changed,
 					 u32 *line)
 {
-	u8 (&paletteRAM)[0x400] = gLcd.paletteRAM;
-	u8 (&vram)[0x20000] = gLcd.vram;
+	u8 (&paletteRAM)[0x400] = gfxLcd.paletteRAM;
+	u8 (&vram)[0x20000] = gfxLcd.vram;
 
   u16 *screenBase = (u16 *)&vram[0];
   int prio = ((control & 3) << 25) + 0x1000000;
@@ -501,8 +509,8 @@ static inline void gfxDrawRotScreen256(u16 control,
 				       int changed,
 				       u32 *line)
 {
-	u8 (&paletteRAM)[0x400] = gLcd.paletteRAM;
-	u8 (&vram)[0x20000] = gLcd.vram;
+	u8 (&paletteRAM)[0x400] = gfxLcd.paletteRAM;
+	u8 (&vram)[0x20000] = gfxLcd.vram;
 
   u16 *palette = (u16 *)paletteRAM;
   u8 *screenBase = (DISPCNT & 0x0010) ? &vram[0xA000] : &vram[0x0000];
@@ -605,8 +613,8 @@ static inline void gfxDrawRotScreen16Bit160(u16 control,
 					    int changed,
 					    u32 *line)
 {
-	u8 (&paletteRAM)[0x400] = gLcd.paletteRAM;
-	u8 (&vram)[0x20000] = gLcd.vram;
+	u8 (&paletteRAM)[0x400] = gfxLcd.paletteRAM;
+	u8 (&vram)[0x20000] = gfxLcd.vram;
 
   u16 *screenBase = (DISPCNT & 0x0010) ? (u16 *)&vram[0xa000] :
     (u16 *)&vram[0];
@@ -700,10 +708,10 @@ static inline void gfxDrawRotScreen16Bit160(u16 control,
 
 static inline void gfxDrawSprites(u32 *lineOBJ)
 {
-	u8 (&paletteRAM)[0x400] = gLcd.paletteRAM;
-	u8 (&vram)[0x20000] = gLcd.vram;
-	u8 (&oam)[0x400] = gLcd.oam;
-	unsigned int &layerEnable = gLcd.layerEnable;
+	u8 (&paletteRAM)[0x400] = gfxLcd.paletteRAM;
+	u8 (&vram)[0x20000] = gfxLcd.vram;
+	u8 (&oam)[0x400] = gfxLcd.oam;
+	unsigned int &layerEnable = gfxLcd.layerEnable;
 
   // lineOBJpix is used to keep track of the drawn OBJs
   // and to stop drawing them if the 'maximum number of OBJ per line'
@@ -1168,10 +1176,10 @@ static inline void gfxDrawSprites(u32 *lineOBJ)
 
 static inline void gfxDrawOBJWin(u32 *lineOBJWin)
 {
-	u8 (&paletteRAM)[0x400] = gLcd.paletteRAM;
-	u8 (&vram)[0x20000] = gLcd.vram;
-	u8 (&oam)[0x400] = gLcd.oam;
-	unsigned int &layerEnable = gLcd.layerEnable;
+	u8 (&paletteRAM)[0x400] = gfxLcd.paletteRAM;
+	u8 (&vram)[0x20000] = gfxLcd.vram;
+	u8 (&oam)[0x400] = gfxLcd.oam;
+	unsigned int &layerEnable = gfxLcd.layerEnable;
 
   gfxClearArray(lineOBJWin);
   if((layerEnable & 0x9000) == 0x9000) {
@@ -0,0 +1,426 @@
+#define VBAM_GBA_RENDER_TU
+#include "GBA.h"
+#include "Globals.h"
+#include "GBAGfx.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define GBA_COMPOSE_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define GBA_COMPOSE_NEON
+#endif
+
+// Line compositor shared by all video modes. Each layer line buffer holds
+// 15-bit color | OBJ semi-transparent flag (bit 16) | priority (bits 24-31,
+// 0x80 when transparent), so priority resolution is a minimum search on the
+// high byte across the BG0-3 & OBJ buffers. The SIMD paths work on 8 pixels
+// at a time and produce identical output to the scalar path.
+
+struct GfxComposeFx
+{
+	uint effect; // BLDCNT color special effect
+	uint target1, target2;
+	uint eva, evb, evy;
+};
+
+static GfxComposeFx composeFx()
+{
+	GfxComposeFx fx;
+	fx.effect = (BLDMOD >> 6) & 3;
+	fx.target1 = BLDMOD & 0x3F;
+	fx.target2 = (BLDMOD >> 8) & 0x3F;
+	fx.eva = coeff[COLEV & 0x1F];
+	fx.evb = coeff[(COLEV >> 8) & 0x1F];
+	fx.evy = coeff[COLY & 0x1F];
+	return fx;
+}
+
+static u32 composeBackdrop()
+{
+	if(customBackdropColor == -1)
+		return READ16LE(&((u16 *)paletteRAM)[0]) | 0x30000000;
+	else
+		return (customBackdropColor & 0x7FFF) | 0x30000000;
+}
+
+static void composeScalar(MixColorType *lineMix, const u32 * const layer[5], u32 backdrop,
+	const GfxComposeFx &fx, const u8 *winMask, u8 mask, int x, int xEnd)
+{
+	for(; x < xEnd; x++)
+	{
+		u8 m = winMask ? winMask[x] : mask;
+		u32 color = backdrop;
+		u32 top = 0x20;
+		iterateTimes(5, l)
+		{
+			if(layer[l] && (m & (1 << l)) && (u8)(layer[l][x] >> 24) < (u8)(color >> 24))
+			{
+				color = layer[l][x];
+				top = 1 << l;
+			}
+		}
+
+		bool semiTransparent = color & 0x00010000;
+		if(!semiTransparent && !(m & 0x20))
+		{
+			lineMix[x] = convColor(color);
+			continue;
+		}
+
+		// second layer, as a blend target for semi-transparent OBJ or alpha blending
+		u32 back = backdrop;
+		u32 top2 = 0x20;
+		iterateTimes(5, l)
+		{
+			if(layer[l] && top != (1u << l) && (m & (1 << l))
+				&& (u8)(layer[l][x] >> 24) < (u8)(back >> 24))
+			{
+				back = layer[l][x];
+				top2 = 1 << l;
+			}
+		}
+
+		bool alpha = (top2 & fx.target2) &&
+			(semiTransparent || (fx.effect == 1 && (top & fx.target1)));
+		if(alpha)
+			color = gfxAlphaBlend(color, back, fx.eva, fx.evb);
+		else if(top & fx.target1)
+		{
+			if(fx.effect == 2)
+				color = gfxIncreaseBrightness(color, fx.evy);
+			else if(fx.effect == 3)
+				color = gfxDecreaseBrightness(color, fx.evy);
+		}
+		lineMix[x] = convColor(color);
+	}
+}
+
+#if defined GBA_COMPOSE_SSE2
+
+struct ComposeLanes
+{
+	__m128i color, top, back, top2;
+};
+
+static inline __m128i select(__m128i mask, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static inline __m128i maskHasBits(__m128i m, __m128i bits)
+{
+	return _mm_cmpeq_epi32(_mm_and_si128(m, bits), bits);
+}
+
+// 4 pixels of priority resolution, top layer then the next one below it
+static inline ComposeLanes composeLanes(const u32 * const layer[5], u32 backdrop, __m128i m, int x)
+{
+	ComposeLanes out;
+	out.color = _mm_set1_epi32(backdrop);
+	out.top = _mm_set1_epi32(0x20);
+	__m128i key = _mm_set1_epi32(backdrop >> 24);
+	__m128i data[5], dataKey[5], enabled[5];
+	iterateTimes(5, l)
+	{
+		if(!layer[l])
+			continue;
+		__m128i bit = _mm_set1_epi32(1 << l);
+		data[l] = _mm_loadu_si128((const __m128i*)&layer[l][x]);
+		dataKey[l] = _mm_srli_epi32(data[l], 24);
+		enabled[l] = maskHasBits(m, bit);
+		__m128i lt = _mm_and_si128(_mm_cmplt_epi32(dataKey[l], key), enabled[l]);
+		out.color = select(lt, data[l], out.color);
+		key = select(lt, dataKey[l], key);
+		out.top = select(lt, bit, out.top);
+	}
+	out.back = _mm_set1_epi32(backdrop);
+	out.top2 = _mm_set1_epi32(0x20);
+	key = _mm_set1_epi32(backdrop >> 24);
+	iterateTimes(5, l)
+	{
+		if(!layer[l])
+			continue;
+		__m128i bit = _mm_set1_epi32(1 << l);
+		__m128i lt = _mm_andnot_si128(_mm_cmpeq_epi32(out.top, bit),
+			_mm_and_si128(_mm_cmplt_epi32(dataKey[l], key), enabled[l]));
+		out.back = select(lt, data[l], out.back);
+		key = select(lt, dataKey[l], key);
+		out.top2 = select(lt, bit, out.top2);
+	}
+	return out;
+}
+
+// low 16 bits of 2x4 32-bit lanes -> 8 16-bit lanes
+static inline __m128i packLow16(__m128i a, __m128i b)
+{
+	a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+	b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+	return _mm_packs_epi32(a, b);
+}
+
+static void composeSIMD(MixColorType *lineMix, const u32 * const layer[5], u32 backdrop,
+	const GfxComposeFx &fx, const u8 *winMask, u8 mask)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i fxBit = _mm_set1_epi32(0x20);
+	const __m128i semiBit = _mm_set1_epi32(0x00010000);
+	const __m128i target1 = _mm_set1_epi32(fx.target1);
+	const __m128i target2 = _mm_set1_epi32(fx.target2);
+	const __m128i chanMask = _mm_set1_epi16(0x1F);
+	const __m128i eva = _mm_set1_epi16(fx.eva), evb = _mm_set1_epi16(fx.evb), evy = _mm_set1_epi16(fx.evy);
+	const __m128i alphaEffect = fx.effect == 1 ? _mm_set1_epi32(-1) : zero;
+	const __m128i brightEffect = fx.effect >= 2 ? _mm_set1_epi32(-1) : zero;
+	__m128i m0 = _mm_set1_epi32(mask), m1 = m0;
+	for(int x = 0; x < 240; x += 8)
+	{
+		if(winMask)
+		{
+			__m128i m = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)&winMask[x]), zero);
+			m0 = _mm_unpacklo_epi16(m, zero);
+			m1 = _mm_unpackhi_epi16(m, zero);
+		}
+		ComposeLanes lo = composeLanes(layer, backdrop, m0, x);
+		ComposeLanes hi = composeLanes(layer, backdrop, m1, x + 4);
+
+		__m128i alphaSel[2], brightSel[2];
+		const ComposeLanes *half[2] {&lo, &hi};
+		const __m128i *mHalf[2] {&m0, &m1};
+		iterateTimes(2, i)
+		{
+			__m128i semi = _mm_cmpeq_epi32(_mm_and_si128(half[i]->color, semiBit), semiBit);
+			__m128i fxOn = _mm_or_si128(semi, maskHasBits(*mHalf[i], fxBit));
+			__m128i isT1 = _mm_xor_si128(_mm_cmpeq_epi32(_mm_and_si128(half[i]->top, target1), zero), _mm_set1_epi32(-1));
+			__m128i isT2 = _mm_xor_si128(_mm_cmpeq_epi32(_mm_and_si128(half[i]->top2, target2), zero), _mm_set1_epi32(-1));
+			alphaSel[i] = _mm_and_si128(_mm_and_si128(fxOn, isT2), _mm_or_si128(semi, _mm_and_si128(alphaEffect, isT1)));
+			brightSel[i] = _mm_andnot_si128(alphaSel[i], _mm_and_si128(_mm_and_si128(fxOn, isT1), brightEffect));
+		}
+		__m128i color = packLow16(lo.color, hi.color);
+		__m128i doAlpha = _mm_packs_epi32(alphaSel[0], alphaSel[1]);
+		__m128i doBright = _mm_packs_epi32(brightSel[0], brightSel[1]);
+		if(_mm_movemask_epi8(_mm_or_si128(doAlpha, doBright)))
+		{
+			__m128i r = _mm_and_si128(color, chanMask);
+			__m128i g = _mm_and_si128(_mm_srli_epi16(color, 5), chanMask);
+			__m128i b = _mm_and_si128(_mm_srli_epi16(color, 10), chanMask);
+			__m128i fxR, fxG, fxB;
+			if(fx.effect >= 2)
+			{
+				if(fx.effect == 2)
+				{
+					fxR = _mm_add_epi16(r, _mm_srli_epi16(_mm_mullo_epi16(_mm_sub_epi16(chanMask, r), evy), 4));
+					fxG = _mm_add_epi16(g, _mm_srli_epi16(_mm_mullo_epi16(_mm_sub_epi16(chanMask, g), evy), 4));
+					fxB = _mm_add_epi16(b, _mm_srli_epi16(_mm_mullo_epi16(_mm_sub_epi16(chanMask, b), evy), 4));
+				}
+				else
+				{
+					fxR = _mm_sub_epi16(r, _mm_srli_epi16(_mm_mullo_epi16(r, evy), 4));
+					fxG = _mm_sub_epi16(g, _mm_srli_epi16(_mm_mullo_epi16(g, evy), 4));
+					fxB = _mm_sub_epi16(b, _mm_srli_epi16(_mm_mullo_epi16(b, evy), 4));
+				}
+				fxR = select(doBright, fxR, r);
+				fxG = select(doBright, fxG, g);
+				fxB = select(doBright, fxB, b);
+			}
+			else
+			{
+				fxR = r; fxG = g; fxB = b;
+			}
+			if(_mm_movemask_epi8(doAlpha))
+			{
+				__m128i back = packLow16(lo.back, hi.back);
+				__m128i r2 = _mm_and_si128(back, chanMask);
+				__m128i g2 = _mm_and_si128(_mm_srli_epi16(back, 5), chanMask);
+				__m128i b2 = _mm_and_si128(_mm_srli_epi16(back, 10), chanMask);
+				__m128i aR = _mm_min_epi16(_mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(r, eva), _mm_mullo_epi16(r2, evb)), 4), chanMask);
+				__m128i aG = _mm_min_epi16(_mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(g, eva), _mm_mullo_epi16(g2, evb)), 4), chanMask);
+				__m128i aB = _mm_min_epi16(_mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(b, eva), _mm_mullo_epi16(b2, evb)), 4), chanMask);
+				fxR = select(doAlpha, aR, fxR);
+				fxG = select(doAlpha, aG, fxG);
+				fxB = select(doAlpha, aB, fxB);
+			}
+			__m128i fxColor = _mm_or_si128(_mm_or_si128(fxR, _mm_slli_epi16(fxG, 5)), _mm_slli_epi16(fxB, 10));
+			color = select(_mm_or_si128(doAlpha, doBright), fxColor, color);
+		}
+		_mm_storeu_si128((__m128i*)&lineMix[x], color);
+	}
+}
+
+#elif defined GBA_COMPOSE_NEON
+
+struct ComposeLanes
+{
+	uint32x4_t color, top, back, top2;
+};
+
+static inline uint32x4_t maskHasBits(uint32x4_t m, uint32x4_t bits)
+{
+	return vceqq_u32(vandq_u32(m, bits), bits);
+}
+
+// 4 pixels of priority resolution, top layer then the next one below it
+static inline ComposeLanes composeLanes(const u32 * const layer[5], u32 backdrop, uint32x4_t m, int x)
+{
+	ComposeLanes out;
+	out.color = vdupq_n_u32(backdrop);
+	out.top = vdupq_n_u32(0x20);
+	uint32x4_t key = vdupq_n_u32(backdrop >> 24);
+	uint32x4_t data[5], dataKey[5], enabled[5];
+	iterateTimes(5, l)
+	{
+		if(!layer[l])
+			continue;
+		uint32x4_t bit = vdupq_n_u32(1 << l);
+		data[l] = vld1q_u32(&layer[l][x]);
+		dataKey[l] = vshrq_n_u32(data[l], 24);
+		enabled[l] = maskHasBits(m, bit);
+		uint32x4_t lt = vandq_u32(vcltq_u32(dataKey[l], key), enabled[l]);
+		out.color = vbslq_u32(lt, data[l], out.color);
+		key = vbslq_u32(lt, dataKey[l], key);
+		out.top = vbslq_u32(lt, bit, out.top);
+	}
+	out.back = vdupq_n_u32(backdrop);
+	out.top2 = vdupq_n_u32(0x20);
+	key = vdupq_n_u32(backdrop >> 24);
+	iterateTimes(5, l)
+	{
+		if(!layer[l])
+			continue;
+		uint32x4_t bit = vdupq_n_u32(1 << l);
+		uint32x4_t lt = vbicq_u32(vandq_u32(vcltq_u32(dataKey[l], key), enabled[l]),
+			vceqq_u32(out.top, bit));
+		out.back = vbslq_u32(lt, data[l], out.back);
+		key = vbslq_u32(lt, dataKey[l], key);
+		out.top2 = vbslq_u32(lt, bit, out.top2);
+	}
+	return out;
+}
+
+static inline bool anyLane(uint16x8_t v)
+{
+	uint32x2_t r = vreinterpret_u32_u16(vorr_u16(vget_low_u16(v), vget_high_u16(v)));
+	return vget_lane_u32(r, 0) | vget_lane_u32(r, 1);
+}
+
+static void composeSIMD(MixColorType *lineMix, const u32 * const layer[5], u32 backdrop,
+	const GfxComposeFx &fx, const u8 *winMask, u8 mask)
+{
+	const uint32x4_t fxBit = vdupq_n_u32(0x20);
+	const uint32x4_t semiBit = vdupq_n_u32(0x00010000);
+	const uint32x4_t target1 = vdupq_n_u32(fx.target1);
+	const uint32x4_t target2 = vdupq_n_u32(fx.target2);
+	const uint16x8_t chanMask = vdupq_n_u16(0x1F);
+	const uint16x8_t eva = vdupq_n_u16(fx.eva), evb = vdupq_n_u16(fx.evb), evy = vdupq_n_u16(fx.evy);
+	const uint32x4_t alphaEffect = vdupq_n_u32(fx.effect == 1 ? 0xFFFFFFFF : 0);
+	const uint32x4_t brightEffect = vdupq_n_u32(fx.effect >= 2 ? 0xFFFFFFFF : 0);
+	uint32x4_t m0 = vdupq_n_u32(mask), m1 = m0;
+	for(int x = 0; x < 240; x += 8)
+	{
+		if(winMask)
+		{
+			uint16x8_t m = vmovl_u8(vld1_u8(&winMask[x]));
+			m0 = vmovl_u16(vget_low_u16(m));
+			m1 = vmovl_u16(vget_high_u16(m));
+		}
+		ComposeLanes lo = composeLanes(layer, backdrop, m0, x);
+		ComposeLanes hi = composeLanes(layer, backdrop, m1, x + 4);
+
+		uint32x4_t alphaSel[2], brightSel[2];
+		const ComposeLanes *half[2] {&lo, &hi};
+		const uint32x4_t *mHalf[2] {&m0, &m1};
+		iterateTimes(2, i)
+		{
+			uint32x4_t semi = maskHasBits(half[i]->color, semiBit);
+			uint32x4_t fxOn = vorrq_u32(semi, maskHasBits(*mHalf[i], fxBit));
+			uint32x4_t isT1 = vtstq_u32(half[i]->top, target1);
+			uint32x4_t isT2 = vtstq_u32(half[i]->top2, target2);
+			alphaSel[i] = vandq_u32(vandq_u32(fxOn, isT2), vorrq_u32(semi, vandq_u32(alphaEffect, isT1)));
+			brightSel[i] = vbicq_u32(vandq_u32(vandq_u32(fxOn, isT1), brightEffect), alphaSel[i]);
+		}
+		uint16x8_t color = vcombine_u16(vmovn_u32(lo.color), vmovn_u32(hi.color));
+		uint16x8_t doAlpha = vcombine_u16(vmovn_u32(alphaSel[0]), vmovn_u32(alphaSel[1]));
+		uint16x8_t doBright = vcombine_u16(vmovn_u32(brightSel[0]), vmovn_u32(brightSel[1]));
+		if(anyLane(vorrq_u16(doAlpha, doBright)))
+		{
+			uint16x8_t r = vandq_u16(color, chanMask);
+			uint16x8_t g = vandq_u16(vshrq_n_u16(color, 5), chanMask);
+			uint16x8_t b = vandq_u16(vshrq_n_u16(color, 10), chanMask);
+			uint16x8_t fxR = r, fxG = g, fxB = b;
+			if(fx.effect == 2)
+			{
+				fxR = vbslq_u16(doBright, vaddq_u16(r, vshrq_n_u16(vmulq_u16(vsubq_u16(chanMask, r), evy), 4)), r);
+				fxG = vbslq_u16(doBright, vaddq_u16(g, vshrq_n_u16(vmulq_u16(vsubq_u16(chanMask, g), evy), 4)), g);
+				fxB = vbslq_u16(doBright, vaddq_u16(b, vshrq_n_u16(vmulq_u16(vsubq_u16(chanMask, b), evy), 4)), b);
+			}
+			else if(fx.effect == 3)
+			{
+				fxR = vbslq_u16(doBright, vsubq_u16(r, vshrq_n_u16(vmulq_u16(r, evy), 4)), r);
+				fxG = vbslq_u16(doBright, vsubq_u16(g, vshrq_n_u16(vmulq_u16(g, evy), 4)), g);
+				fxB = vbslq_u16(doBright, vsubq_u16(b, vshrq_n_u16(vmulq_u16(b, evy), 4)), b);
+			}
+			if(anyLane(doAlpha))
+			{
+				uint16x8_t back = vcombine_u16(vmovn_u32(lo.back), vmovn_u32(hi.back));
+				uint16x8_t r2 = vandq_u16(back, chanMask);
+				uint16x8_t g2 = vandq_u16(vshrq_n_u16(back, 5), chanMask);
+				uint16x8_t b2 = vandq_u16(vshrq_n_u16(back, 10), chanMask);
+				fxR = vbslq_u16(doAlpha, vminq_u16(vshrq_n_u16(vmlaq_u16(vmulq_u16(r, eva), r2, evb), 4), chanMask), fxR);
+				fxG = vbslq_u16(doAlpha, vminq_u16(vshrq_n_u16(vmlaq_u16(vmulq_u16(g, eva), g2, evb), 4), chanMask), fxG);
+				fxB = vbslq_u16(doAlpha, vminq_u16(vshrq_n_u16(vmlaq_u16(vmulq_u16(b, eva), b2, evb), 4), chanMask), fxB);
+			}
+			uint16x8_t fxColor = vorrq_u16(vorrq_u16(fxR, vshlq_n_u16(fxG, 5)), vshlq_n_u16(fxB, 10));
+			color = vbslq_u16(vorrq_u16(doAlpha, doBright), fxColor, color);
+		}
+		vst1q_u16(&lineMix[x], color);
+	}
+}
+
+#endif
+
+void gfxComposeLine(MixColorType *lineMix, const u32 * const layer[5], const u8 *winMask, u8 mask)
+{
+	u32 backdrop = composeBackdrop();
+	GfxComposeFx fx = composeFx();
+	#if defined GBA_COMPOSE_SSE2 || defined GBA_COMPOSE_NEON
+	if(!directColorLookup)
+	{
+		composeSIMD(lineMix, layer, backdrop, fx, winMask, mask);
+		return;
+	}
+	#endif
+	composeScalar(lineMix, layer, backdrop, fx, winMask, mask, 0, 240);
+}
+
+static bool lineInWindow(u16 winV)
+{
+	u8 v0 = winV >> 8;
+	u8 v1 = winV & 255;
+	bool inWindow = ((v0 == v1) && (v0 >= 0xe8));
+	if(v1 >= v0)
+		inWindow |= (VCOUNT >= v0 && VCOUNT < v1);
+	else
+		inWindow |= (VCOUNT >= v0 || VCOUNT < v1);
+	return inWindow;
+}
+
+void gfxBuildWindowMask(u8 *winMask)
+{
+	bool inWindow0 = (layerEnable & 0x2000) && lineInWindow(WIN0V);
+	bool inWindow1 = (layerEnable & 0x4000) && lineInWindow(WIN1V);
+	u8 inWin0Mask = WININ & 0xFF;
+	u8 inWin1Mask = WININ >> 8;
+	u8 outMask = WINOUT & 0xFF;
+	u8 objWinMask = WINOUT >> 8;
+
+	for(int x = 0; x < 240; x++)
+	{
+		u8 mask = outMask;
+		if(!(lineOBJWin[x] & 0x80000000))
+			mask = objWinMask;
+		if(inWindow1 && gfxInWin1[x])
+			mask = inWin1Mask;
+		if(inWindow0 && gfxInWin0[x])
+			mask = inWin0Mask;
+		winMask[x] = mask;
+	}
+}
@@ -0,0 +1,277 @@
+#define VBAM_GBA_RENDER_TU
+#include <string.h>
+#include "GBA.h"
+#include "Globals.h"
+#include "GBAGfx.h"
+#include "GBAGfxThread.h"
+
+GBAGfxThread gGfxThread;
+GBALCD gGfxLcd;
+u8 gGfxIoMem[0x400] __attribute__ ((aligned(4))) {0};
+
+void blankLine(MixColorType *lineMix)
+{
+	for(int x = 0; x < 240; x++)
+		lineMix[x] = convColor(0x7fff);
+}
+
+void blankLineUpdateLastVCount(MixColorType *lineMix)
+{
+	blankLine(lineMix);
+	gfxLastVCOUNT = VCOUNT;
+}
+
+static void updateWindow(bool (&inWin)[240], u16 winH)
+{
+	int x00 = winH>>8;
+	int x01 = winH & 255;
+
+	if(x00 <= x01)
+	{
+		for(int i = 0; i < 240; i++)
+			inWin[i] = (i >= x00 && i < x01);
+	}
+	else
+	{
+		for(int i = 0; i < 240; i++)
+			inWin[i] = (i >= x00 || i < x01);
+	}
+}
+
+static u8 *blockAddr(GBALCD &lcd, uint block)
+{
+	if(block < GBAGfxThread::oamBlock)
+		return &lcd.paletteRAM[(block - GBAGfxThread::paletteBlock) << GBAGfxThread::blockShift];
+	else if(block < GBAGfxThread::vramBlock)
+		return &lcd.oam[(block - GBAGfxThread::oamBlock) << GBAGfxThread::blockShift];
+	else
+		return &lcd.vram[(block - GBAGfxThread::vramBlock) << GBAGfxThread::blockShift];
+}
+
+// Copies the blocks written since the last line into the job, or straight
+// into the renderer's copy if job is null, and clears the dirty map
+static void copyDirtyBlocks(GBAGfxThread &gfx, GBAGfxThread::LineJob *job)
+{
+	iterateTimes(sizeofArray(gfx.dirty), w)
+	{
+		u32 bits = gfx.dirty[w];
+		while(bits)
+		{
+			uint block = w * 32 + __builtin_ctz(bits);
+			bits &= bits - 1;
+			if(job)
+			{
+				job->block[job->dirtyBlocks] = block;
+				memcpy(job->data[job->dirtyBlocks], blockAddr(gLcd, block), GBAGfxThread::blockSize);
+				job->dirtyBlocks++;
+			}
+			else
+				memcpy(blockAddr(gGfxLcd, block), blockAddr(gLcd, block), GBAGfxThread::blockSize);
+		}
+		gfx.dirty[w] = 0;
+	}
+	gfx.dirtyBlocks = 0;
+}
+
+// Runs on the worker in threaded mode, only touches the renderer's copy
+// of the video state and the job's line in gLcd.pix
+static void runJob(const GBAGfxThread::LineJob &job)
+{
+	iterateTimes(job.dirtyBlocks, i)
+	{
+		memcpy(blockAddr(gGfxLcd, job.block[i]), job.data[i], GBAGfxThread::blockSize);
+	}
+
+	u16 win0H = WIN0H, win1H = WIN1H;
+	memcpy(gGfxIoMem, job.io, GBAGfxThread::ioBytes);
+	if(WIN0H != win0H)
+		updateWindow(gfxInWin0, WIN0H);
+	if(WIN1H != win1H)
+		updateWindow(gfxInWin1, WIN1H);
+	layerEnable = job.layerEnable;
+	gfxBG2Changed |= job.bg2Changed;
+	gfxBG3Changed |= job.bg3Changed;
+	if(job.clearLayers & 1)
+		gfxClearArray(line0);
+	if(job.clearLayers & 2)
+		gfxClearArray(line1);
+	if(job.clearLayers & 4)
+		gfxClearArray(line2);
+	if(job.clearLayers & 8)
+		gfxClearArray(line3);
+
+	job.renderLine(job.lineMix);
+	switch(systemColorDepth)
+	{
+#ifdef SUPPORT_PIX_16BIT
+		case 16:
+		{
+			if(!directColorLookup)
+			{
+				for(int x = 0; x < 240; x++)
+				{
+					job.lineMix[x] = systemColorMap.map16[job.lineMix[x]];
+				}
+			}
+		}
+		break;
+#endif
+#ifdef SUPPORT_PIX_32BIT
+		// VCOUNT is the job's copy, so the line lands where the CPU was at HBlank
+		case 24:
+		{
+			u8 *dest = (u8 *)gLcd.pix + 240 * VCOUNT * 3;
+			for(int x = 0; x < 240; x++)
+			{
+				*((u32 *)dest) = systemColorMap.map32[job.lineMix[x]];
+				dest += 3;
+			}
+		}
+		break;
+		case 32:
+		{
+			u32 *dest = (u32 *)gLcd.pix + 240 * VCOUNT;
+			for(int x = 0; x < 240; x++)
+				*dest++ = systemColorMap.map32[job.lineMix[x]];
+		}
+		break;
+#endif
+	}
+}
+
+static int renderThread(ThreadPThread &thread)
+{
+	auto &gfx = *(GBAGfxThread*)thread.arg;
+	gfx.mutex.lock();
+	for(;;)
+	{
+		while(gfx.jobsDone == gfx.jobsQueued && !gfx.quit)
+			gfx.workCond.wait();
+		if(gfx.jobsDone == gfx.jobsQueued)
+			break; // quit requested & queue is empty
+		auto &job = gfx.job[gfx.jobsDone % GBAGfxThread::queuedJobs];
+		gfx.mutex.unlock();
+		runJob(job);
+		gfx.mutex.lock();
+		gfx.jobsDone++;
+		gfx.doneCond.signal();
+	}
+	gfx.mutex.unlock();
+	return 0;
+}
+
+void GBAGfxThread::setThreaded(bool on)
+{
+	if(on == threaded)
+		return;
+	if(on)
+	{
+		mutex.create();
+		workCond.create(&mutex);
+		doneCond.create(&mutex);
+		quit = false;
+		jobsQueued = jobsDone = 0;
+		if(!thread.create(0, renderThread, this))
+		{
+			logWarn("unable to start render thread, drawing lines synchronously");
+			workCond.destroy();
+			doneCond.destroy();
+			mutex.destroy();
+			return;
+		}
+		threaded = true;
+	}
+	else
+	{
+		finish();
+		mutex.lock();
+		quit = true;
+		workCond.signal();
+		mutex.unlock();
+		thread.join();
+		threaded = false;
+		workCond.destroy();
+		doneCond.destroy();
+		mutex.destroy();
+	}
+	logMsg("render thread %s", threaded ? "on" : "off");
+}
+
+void GBAGfxThread::drawLine(MixColorType *lineMix)
+{
+	LineJob *j;
+	if(threaded)
+	{
+		mutex.lock();
+		while(jobsQueued - jobsDone == queuedJobs)
+			doneCond.wait();
+		mutex.unlock();
+		j = &job[jobsQueued % queuedJobs];
+		j->dirtyBlocks = 0;
+		if(dirtyBlocks > jobBlocks)
+		{
+			// too much to queue (large DMA, skipped frames), update
+			// the renderer's copy directly once the worker is idle
+			finish();
+			copyDirtyBlocks(*this, nullptr);
+		}
+		else if(dirtyBlocks)
+			copyDirtyBlocks(*this, j);
+	}
+	else
+	{
+		j = &syncJob;
+		if(dirtyBlocks)
+			copyDirtyBlocks(*this, nullptr);
+	}
+
+	memcpy(j->io, gMem.ioMem, ioBytes);
+	j->renderLine = gLcd.renderLine;
+	j->lineMix = lineMix;
+	j->layerEnable = gLcd.layerEnable;
+	j->bg2Changed = gLcd.gfxBG2Changed;
+	j->bg3Changed = gLcd.gfxBG3Changed;
+	gLcd.gfxBG2Changed = gLcd.gfxBG3Changed = 0;
+	j->clearLayers = clearLayers;
+	clearLayers = 0;
+
+	if(threaded)
+	{
+		mutex.lock();
+		jobsQueued++;
+		workCond.signal();
+		mutex.unlock();
+	}
+	else
+		runJob(*j);
+}
+
+void GBAGfxThread::finish()
+{
+	if(!threaded)
+		return;
+	mutex.lock();
+	while(jobsDone != jobsQueued)
+		doneCond.wait();
+	mutex.unlock();
+}
+
+void GBAGfxThread::resync()
+{
+	finish();
+	memcpy(gGfxLcd.paletteRAM, gLcd.paletteRAM, sizeof(gLcd.paletteRAM));
+	memcpy(gGfxLcd.vram, gLcd.vram, sizeof(gLcd.vram));
+	memcpy(gGfxLcd.oam, gLcd.oam, sizeof(gLcd.oam));
+	memset(dirty, 0, sizeof(dirty));
+	dirtyBlocks = 0;
+	memcpy(gGfxIoMem, gMem.ioMem, ioBytes);
+	updateWindow(gfxInWin0, WIN0H);
+	updateWindow(gfxInWin1, WIN1H);
+	layerEnable = gLcd.layerEnable;
+	// the affine reference points are render-side only, reload them
+	// from the BG2/3 X/Y registers on the next line
+	gfxBG2X = gfxBG2Y = gfxBG3X = gfxBG3Y = 0;
+	gfxBG2Changed = gfxBG3Changed = 3;
+	gfxLastVCOUNT = VCOUNT;
+	gLcd.gfxBG2Changed = gLcd.gfxBG3Changed = 0;
+}
@@ -0,0 +1,79 @@
+#ifndef GBAGFXTHREAD_H
+#define GBAGFXTHREAD_H
+
+#include <util/thread/pthread.hh>
+
+// Scanline renderers draw from a copy of the video state (gGfxLcd & gGfxIoMem)
+// that only advances when a line is drawn. The CPU side marks every 64-byte
+// block of palette/OAM/VRAM it writes, and at HBlank packs the LCD registers
+// plus the dirty blocks into a LineJob. Jobs are either run immediately or,
+// in threaded mode, queued to a worker so the CPU keeps running while the
+// line is composited. Since each job carries the exact state at its HBlank,
+// mid-frame raster effects render the same as the synchronous path.
+//
+// The worker is drained before the frame is presented at VBlank and before
+// the copy is rebuilt from scratch (reset, state load, BIOS RAM clear).
+
+struct GBAGfxThread
+{
+	constexpr GBAGfxThread() { }
+
+	static const uint blockShift = 6;
+	static const uint blockSize = 1 << blockShift;
+	static const uint paletteBlock = 0;
+	static const uint oamBlock = 0x400 >> blockShift;
+	static const uint vramBlock = 0x800 >> blockShift;
+	static const uint blocks = vramBlock + (0x18000 >> blockShift);
+	static const uint ioBytes = 0x58; // DISPCNT through BLDY
+	static const uint queuedJobs = 16;
+	static const uint jobBlocks = 64;
+
+	struct LineJob
+	{
+		constexpr LineJob() { }
+		void (*renderLine)(MixColorType *lineMix) = nullptr;
+		MixColorType *lineMix = nullptr;
+		uint layerEnable = 0;
+		u8 io[ioBytes] __attribute__ ((aligned(4))) {0};
+		u8 bg2Changed = 0, bg3Changed = 0;
+		u8 clearLayers = 0;
+		uint dirtyBlocks = 0;
+		u16 block[jobBlocks] {0};
+		u8 data[jobBlocks][blockSize] __attribute__ ((aligned(4))) {{0}};
+	};
+
+	bool threaded = false;
+	bool quit = false;
+	u8 clearLayers = 0; // BG line buffers to clear before the next line
+	uint dirtyBlocks = 0;
+	u32 dirty[(blocks + 31) / 32] {0};
+	uint jobsQueued = 0, jobsDone = 0;
+	ThreadPThread thread;
+	MutexPThread mutex;
+	CondVarPThread workCond, doneCond;
+	LineJob job[queuedJobs];
+	LineJob syncJob;
+
+	void markBlock(uint block)
+	{
+		u32 bit = 1 << (block & 31);
+		if(!(dirty[block >> 5] & bit))
+		{
+			dirty[block >> 5] |= bit;
+			dirtyBlocks++;
+		}
+	}
+
+	void paletteWritten(u32 address) { markBlock(paletteBlock + ((address & 0x3FF) >> blockShift)); }
+	void oamWritten(u32 address) { markBlock(oamBlock + ((address & 0x3FF) >> blockShift)); }
+	void vramWritten(u32 address) { markBlock(vramBlock + (address >> blockShift)); } // address already mirrored below 0x18000
+
+	void setThreaded(bool on);
+	void drawLine(MixColorType *lineMix);
+	void finish();
+	void resync();
+};
+
+extern GBAGfxThread gGfxThread;
+
+#endif // GBAGFXTHREAD_H
@@ -0,0 +1,514 @@
+#include <string.h>
+#include <algorithm>
+#include <time.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+#include "GBA.h"
+#include "GBAcpu.h"
+#include "Globals.h"
+#include "GBALink.h"
+#include "GBALocalLink.h"
+#include "../common/Port.h"
+#include <logger/interface.h>
+#include <util/basicString.h>
+
+GBALocalLink gLocalLink;
+
+static const u32 mailboxMagic = 0x324E4C47; // "GLN2"
+
+struct GBALinkPort
+{
+	u32 seq; // bumped after the transfer fields below are filled in
+	u32 mode, speed, members, stamp, data;
+	u32 clock; // owner's link clock, updated continuously
+	u32 pid; // owner's process, to notice players that exited without leaving
+	u32 ack[GBALocalLink::maxPlayers]; // last sequence number answered, per sender
+	// answer data per sender, double buffered by sequence number since the
+	// sender may post its next transfer before every member read this one
+	u32 reply[GBALocalLink::maxPlayers][2];
+	u32 replyReady[GBALocalLink::maxPlayers][2];
+};
+
+struct GBALinkMailbox
+{
+	u32 magic;
+	u32 players; // bitmask of connected players
+	u32 event; // bumped on every post & answer, players waiting on answers sleep on it
+	u32 waiters;
+	GBALinkPort port[GBALocalLink::maxPlayers];
+};
+
+// multiplayer transfer length by number of players & baud rate
+static const int multiTicks[4][4] =
+{
+	{34080, 8520, 5680, 2840},
+	{65536, 16384, 10923, 5461},
+	{99609, 24903, 16602, 8301},
+	{133692, 33423, 22282, 11141}
+};
+
+template <class T>
+static T loadAcquire(const T &var) { return __atomic_load_n(&var, __ATOMIC_ACQUIRE); }
+
+template <class T>
+static void storeRelease(T &var, T val) { __atomic_store_n(&var, val, __ATOMIC_RELEASE); }
+
+static u64 nowNs()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void signalEvent(GBALinkMailbox &mem)
+{
+	__atomic_add_fetch(&mem.event, 1, __ATOMIC_SEQ_CST);
+	#ifdef __linux__
+	if(__atomic_load_n(&mem.waiters, __ATOMIC_SEQ_CST))
+		syscall(SYS_futex, &mem.event, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+	#endif
+}
+
+// Sleeps until signalEvent() moves the event count past event, or for at most timeout ns
+static void waitEvent(GBALinkMailbox &mem, u32 event, u64 timeout)
+{
+	timespec ts {(time_t)(timeout / 1000000000), (long)(timeout % 1000000000)};
+	#ifdef __linux__
+	// the mailbox is shared between processes, so no FUTEX_PRIVATE_FLAG
+	__atomic_add_fetch(&mem.waiters, 1, __ATOMIC_SEQ_CST);
+	syscall(SYS_futex, &mem.event, FUTEX_WAIT, event, &ts, nullptr, 0);
+	__atomic_sub_fetch(&mem.waiters, 1, __ATOMIC_SEQ_CST);
+	#else
+	// no cross-process wait on the event word, poll it in short sleeps
+	if(__atomic_load_n(&mem.event, __ATOMIC_SEQ_CST) != event)
+		return;
+	ts = {0, (long)std::min(timeout, (u64)200000)};
+	nanosleep(&ts, nullptr);
+	#endif
+}
+
+// Removes players whose process no longer exists from the mailbox,
+// checking only those in candidates, returns the removed players
+static u32 dropDeadPlayers(GBALinkMailbox &mem, u32 candidates)
+{
+	u32 dead = 0;
+	while(candidates)
+	{
+		uint p = __builtin_ctz(candidates);
+		candidates &= candidates - 1;
+		u32 pid = loadAcquire(mem.port[p].pid);
+		if(pid && kill((pid_t)pid, 0) == -1 && errno == ESRCH)
+		{
+			logWarn("link player %d (pid %d) exited without leaving, removing it", p, (int)pid);
+			__atomic_compare_exchange_n(&mem.port[p].pid, &pid, 0u, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+			__atomic_and_fetch(&mem.players, ~(1 << p), __ATOMIC_ACQ_REL);
+			dead |= 1 << p;
+		}
+	}
+	return dead;
+}
+
+static int sioMode(u16 siocnt, u16 rcnt)
+{
+	if(rcnt & 0x8000)
+		return (rcnt & 0x4000) ? JOYBUS : UNSUPPORTED; // general purpose
+	switch(siocnt & 0x3000)
+	{
+		case 0x0000: return NORMAL8;
+		case 0x1000: return NORMAL32;
+		case 0x2000: return MULTIPLAYER;
+		default: return UART;
+	}
+}
+
+static int normalTicks(int mode, u16 siocnt)
+{
+	int bits = mode == NORMAL32 ? 32 : 8;
+	return bits * ((siocnt & 2) ? 8 : 64); // 2MHz or 256KHz shift clock
+}
+
+bool GBALocalLink::open(const char *name)
+{
+	if(active())
+		return true;
+	#ifdef __ANDROID__
+	logWarn("shared memory link not supported on this platform");
+	return false;
+	#else
+	fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+	if(fd == -1)
+	{
+		logWarn("unable to open link mailbox %s", name);
+		return false;
+	}
+	if(ftruncate(fd, sizeof(GBALinkMailbox)) == -1)
+	{
+		logWarn("unable to size link mailbox");
+		::close(fd);
+		fd = -1;
+		return false;
+	}
+	void *map = mmap(nullptr, sizeof(GBALinkMailbox), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(map == MAP_FAILED)
+	{
+		logWarn("unable to map link mailbox");
+		::close(fd);
+		fd = -1;
+		return false;
+	}
+	auto &box = *(GBALinkMailbox*)map;
+	u32 magic = 0;
+	__atomic_compare_exchange_n(&box.magic, &magic, mailboxMagic, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+	if(magic && magic != mailboxMagic)
+	{
+		logWarn("link mailbox %s has unknown format", name);
+		munmap(map, sizeof(GBALinkMailbox));
+		::close(fd);
+		fd = -1;
+		return false;
+	}
+
+	// claim the lowest free player number, after reclaiming the
+	// numbers of players that crashed
+	dropDeadPlayers(box, loadAcquire(box.players));
+	u32 players = loadAcquire(box.players);
+	for(;;)
+	{
+		if(players == (1 << maxPlayers) - 1)
+		{
+			logWarn("link mailbox %s is full", name);
+			munmap(map, sizeof(GBALinkMailbox));
+			::close(fd);
+			fd = -1;
+			return false;
+		}
+		id = __builtin_ctz(~players);
+		if(__atomic_compare_exchange_n(&box.players, &players, players | (1 << id), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			break;
+	}
+
+	mem = &box;
+	storeRelease(mem->port[id].pid, (u32)getpid());
+	string_copy(this->name, name);
+	// continue the port's sequence numbers so the other players don't
+	// mistake a previous owner's transfer for a new one
+	seq = loadAcquire(mem->port[id].seq);
+	iterateTimes(maxPlayers, i)
+	{
+		lastSeq[i] = loadAcquire(mem->port[i].seq);
+	}
+	sender = -1;
+	clock = 0;
+	transfers = sent = 0;
+	roundTripTotal = roundTripMax = stallTotal = stallMax = 0;
+	logMsg("joined link %s as player %d", name, id);
+	return true;
+	#endif
+}
+
+void GBALocalLink::close()
+{
+	if(!active())
+		return;
+	if(transfers)
+		logStats();
+	storeRelease(mem->port[id].pid, 0u);
+	u32 players = __atomic_and_fetch(&mem->players, ~(1 << id), __ATOMIC_ACQ_REL);
+	munmap(mem, sizeof(GBALinkMailbox));
+	::close(fd);
+	#ifndef __ANDROID__
+	if(!players)
+		shm_unlink(name);
+	#endif
+	mem = nullptr;
+	fd = -1;
+	sender = -1;
+	logMsg("left link %s", name);
+}
+
+static void setIdleRegs(GBALocalLink &link, u16 siocnt)
+{
+	if(link.id)
+	{
+		UPDATE_REG(COMM_SIOCNT, (siocnt & 0xff0f) | 0xc | (link.id << 4));
+		UPDATE_REG(COMM_RCNT, 7);
+	}
+	else
+	{
+		UPDATE_REG(COMM_SIOCNT, (siocnt & 0xff0f) | 8);
+		UPDATE_REG(COMM_RCNT, 3);
+	}
+}
+
+static void beginTransfer(GBALocalLink &link, int sender, int mode, u32 members, int ticks)
+{
+	link.sender = sender;
+	link.mode = mode;
+	link.members = members;
+	link.ticks = std::max(ticks, 1);
+	u16 siocnt = READ16LE(&ioMem[COMM_SIOCNT]);
+	if(mode == MULTIPLAYER)
+	{
+		WRITE32LE(&ioMem[COMM_SIOMULTI0], 0xffffffff);
+		WRITE32LE(&ioMem[COMM_SIOMULTI2], 0xffffffff);
+		UPDATE_REG(COMM_SIOCNT, (siocnt & 0xff0b) | 0x80 | 8 | (link.id << 4)); // busy, SI low
+		UPDATE_REG(COMM_RCNT, link.id ? 6 : 2);
+	}
+	else
+		UPDATE_REG(COMM_SIOCNT, siocnt | 0x80);
+}
+
+void GBALocalLink::writeSIOCNT(ARM7TDMI &cpu, u16 value)
+{
+	int mode = sioMode(value, READ16LE(&ioMem[COMM_RCNT]));
+	auto &port = mem->port[id];
+	if(mode == MULTIPLAYER)
+	{
+		bool start = (value & 0x80) && !id && !transferring();
+		if(transferring())
+		{
+			// only the control bits are writable during a transfer
+			u16 siocnt = READ16LE(&ioMem[COMM_SIOCNT]);
+			UPDATE_REG(COMM_SIOCNT, (value & 0xff03) | (siocnt & 0x00fc));
+			return;
+		}
+		setIdleRegs(*this, value & 0xff4b);
+		if(!start)
+			return;
+		u32 players = loadAcquire(mem->players);
+		// players must be numbered contiguously from the parent
+		u32 members = 1;
+		while(members < (1u << maxPlayers) - 1 && (players & ((members << 1) | 1)) == ((members << 1) | 1))
+			members = (members << 1) | 1;
+		port.mode = MULTIPLAYER;
+		port.speed = value & 3;
+		port.members = members;
+		port.stamp = clock;
+		port.data = READ16LE(&ioMem[COMM_SIODATA8]);
+		postTime = nowNs();
+		storeRelease(port.seq, ++seq);
+		signalEvent(*mem);
+		beginTransfer(*this, id, MULTIPLAYER, members, multiTicks[__builtin_popcount(members) - 1][value & 3] + cpu.cpuTotalTicks);
+		cpu.cpuNextEvent = cpu.cpuTotalTicks;
+	}
+	else if(mode == NORMAL8 || mode == NORMAL32)
+	{
+		if(transferring())
+		{
+			u16 siocnt = READ16LE(&ioMem[COMM_SIOCNT]);
+			UPDATE_REG(COMM_SIOCNT, (value & ~0x80) | (siocnt & 0x80));
+			return;
+		}
+		UPDATE_REG(COMM_SIOCNT, value);
+		// the internal clock side drives the transfer, the external
+		// clock side answers it in pollPorts() if its start bit is set
+		if((value & 0x81) != 0x81)
+			return;
+		u32 players = loadAcquire(mem->players);
+		u32 other = players & ~(1 << id);
+		u32 members = (1 << id) | (other & -other); // the first other player
+		port.mode = mode;
+		port.speed = value & 2;
+		port.members = members;
+		port.stamp = clock;
+		port.data = mode == NORMAL32 ? READ32LE(&ioMem[COMM_SIODATA32_L]) : READ16LE(&ioMem[COMM_SIODATA8]) & 0xff;
+		postTime = nowNs();
+		storeRelease(port.seq, ++seq);
+		signalEvent(*mem);
+		beginTransfer(*this, id, mode, members, normalTicks(mode, value) + cpu.cpuTotalTicks);
+		cpu.cpuNextEvent = cpu.cpuTotalTicks;
+	}
+	else
+		UPDATE_REG(COMM_SIOCNT, value);
+}
+
+// Answers new transfers posted by other players, except by player skip
+static void pollPorts(GBALocalLink &link, int skip = -1)
+{
+	auto &mem = *link.mem;
+	auto &myPort = mem.port[link.id];
+	iterateTimes(GBALocalLink::maxPlayers, s)
+	{
+		if(s == link.id || (int)s == skip)
+			continue;
+		auto &port = mem.port[s];
+		u32 seq = loadAcquire(port.seq);
+		if(seq == link.lastSeq[s])
+			continue;
+		link.lastSeq[s] = seq;
+		if(!(port.members & (1 << link.id)))
+			continue;
+		u16 siocnt = READ16LE(&ioMem[COMM_SIOCNT]);
+		int mode = sioMode(siocnt, READ16LE(&ioMem[COMM_RCNT]));
+		bool ready;
+		u32 reply;
+		if(link.transferring() || mode != (int)port.mode)
+		{
+			ready = false;
+			reply = 0xffffffff;
+		}
+		else if(mode == MULTIPLAYER)
+		{
+			ready = true;
+			reply = READ16LE(&ioMem[COMM_SIODATA8]);
+		}
+		else
+		{
+			ready = (siocnt & 0x81) == 0x80;
+			reply = mode == NORMAL32 ? READ32LE(&ioMem[COMM_SIODATA32_L]) : READ16LE(&ioMem[COMM_SIODATA8]) & 0xff;
+		}
+		if(ready)
+		{
+			// shorten the transfer by the ticks the sender already ran
+			int late = loadAcquire(port.clock) - port.stamp;
+			int ticks = mode == MULTIPLAYER ? multiTicks[__builtin_popcount(port.members) - 1][port.speed]
+				: normalTicks(mode, port.speed);
+			link.recvData = port.data;
+			beginTransfer(link, s, mode, port.members, ticks - late);
+		}
+		myPort.reply[s][seq & 1] = reply;
+		myPort.replyReady[s][seq & 1] = ready;
+		storeRelease(myPort.ack[s], seq);
+		signalEvent(mem);
+	}
+}
+
+// Waits until every member answered the current transfer, returns false on timeout
+static bool waitForMembers(GBALocalLink &link, u32 seq)
+{
+	auto &mem = *link.mem;
+	u32 pending = link.members & ~(1 << link.sender);
+	u64 start = 0;
+	const u64 timeout = (u64)link.timeoutMs * 1000000;
+	while(pending)
+	{
+		// read before checking the answers, so one arriving after the
+		// check changes the event count & ends the wait right away
+		u32 event = __atomic_load_n(&mem.event, __ATOMIC_SEQ_CST);
+		u32 bits = pending;
+		while(bits)
+		{
+			uint m = __builtin_ctz(bits);
+			bits &= bits - 1;
+			if((int)(loadAcquire(mem.port[m].ack[link.sender]) - seq) >= 0)
+				pending &= ~(1 << m);
+		}
+		if(!pending)
+			break;
+		u64 now = nowNs();
+		if(!start)
+			start = now;
+		else if(now - start >= timeout)
+		{
+			logWarn("link transfer timed out waiting on players 0x%X", pending);
+			link.members &= ~pending;
+			// later transfers won't include players that crashed
+			dropDeadPlayers(mem, pending);
+			break;
+		}
+		// answer (as busy) anyone else that posted meanwhile so two senders
+		// can't wait on each other, the current sender's next transfer is
+		// left for after this one completes
+		pollPorts(link, link.sender);
+		waitEvent(mem, event, timeout - (now - start));
+	}
+	if(start)
+	{
+		u64 stall = nowNs() - start;
+		link.stallTotal += stall;
+		link.stallMax = std::max(link.stallMax, stall);
+		return !pending;
+	}
+	return true;
+}
+
+static void endTransfer(GBALocalLink &link, ARM7TDMI &cpu)
+{
+	auto &mem = *link.mem;
+	u32 seq = link.sender == (int)link.id ? link.seq : link.lastSeq[link.sender];
+	waitForMembers(link, seq);
+	if(link.sender == (int)link.id)
+	{
+		u64 roundTrip = nowNs() - link.postTime;
+		link.roundTripTotal += roundTrip;
+		link.roundTripMax = std::max(link.roundTripMax, roundTrip);
+		link.sent++;
+	}
+	link.transfers++;
+	if(!(link.transfers & 0xff))
+		link.logStats();
+
+	u16 siocnt = READ16LE(&ioMem[COMM_SIOCNT]);
+	if(link.mode == MULTIPLAYER)
+	{
+		iterateTimes(GBALocalLink::maxPlayers, p)
+		{
+			u16 data = 0xffff;
+			if(p == (uint)link.sender)
+				data = link.sender == (int)link.id ? mem.port[p].data : link.recvData;
+			else if(link.members & (1 << p))
+			{
+				if(mem.port[p].replyReady[link.sender][seq & 1])
+					data = mem.port[p].reply[link.sender][seq & 1];
+			}
+			UPDATE_REG(COMM_SIOMULTI0 + p * 2, data);
+		}
+		setIdleRegs(link, siocnt & 0xff7f);
+	}
+	else
+	{
+		u32 data = 0xffffffff;
+		if(link.sender == (int)link.id)
+		{
+			u32 other = link.members & ~(1 << link.id);
+			if(other)
+			{
+				auto &port = mem.port[__builtin_ctz(other)];
+				if(port.replyReady[link.id][seq & 1])
+					data = port.reply[link.id][seq & 1];
+			}
+		}
+		else
+			data = link.recvData;
+		if(link.mode == NORMAL32)
+			WRITE32LE(&ioMem[COMM_SIODATA32_L], data);
+		else
+			UPDATE_REG(COMM_SIODATA8, (READ16LE(&ioMem[COMM_SIODATA8]) & 0xff00) | (data & 0xff));
+		UPDATE_REG(COMM_SIOCNT, siocnt & ~0x80);
+	}
+	link.sender = -1;
+
+	if(siocnt & 0x4000)
+	{
+		cpu.IF |= 0x80;
+		UPDATE_REG(0x202, cpu.IF);
+	}
+}
+
+void GBALocalLink::update(ARM7TDMI &cpu, int ticks)
+{
+	clock += ticks;
+	storeRelease(mem->port[id].clock, clock);
+	if(transferring())
+	{
+		this->ticks -= ticks;
+		if(this->ticks <= 0)
+			endTransfer(*this, cpu);
+	}
+	pollPorts(*this);
+}
+
+void GBALocalLink::logStats()
+{
+	logMsg("link player %d: %u transfers, %u sent with round trip avg %lluns max %lluns, stalled %lluns max %lluns",
+		id, transfers, sent, (unsigned long long)(roundTripTotal / std::max(sent, 1u)), (unsigned long long)roundTripMax,
+		(unsigned long long)stallTotal, (unsigned long long)stallMax);
+}
@@ -0,0 +1,63 @@
+#ifndef GBALOCALLINK_H
+#define GBALOCALLINK_H
+
+// Link cable between emulator processes on the same machine through a POSIX
+// shared memory mailbox, without the socket round trips of the network link.
+// Supports multiplayer & normal 8/32-bit SIO modes.
+//
+// Every player owns a port in the mailbox that only it writes. A transfer
+// is started by filling in the port & bumping its sequence number, the other
+// players answer by storing their data & acknowledging that sequence number
+// in their own ports, so no locks are needed. Transfers are stamped with the
+// sender's link clock (emulated ticks since connecting) and each player
+// publishes its clock on every update, letting a receiver that notices a
+// transfer late shorten its side by the ticks the sender already ran.
+//
+// Emulation only blocks if the emulated transfer time has elapsed and an
+// answer still hasn't arrived, sleeping on an event count in the mailbox
+// that every post & answer bumps. The time spent waiting is tracked per
+// transfer and logged to measure the latency the link adds. Players whose
+// process exited without leaving are dropped when a transfer to them times
+// out or a new player joins.
+
+struct GBALinkMailbox;
+
+struct GBALocalLink
+{
+	constexpr GBALocalLink() { }
+
+	static const uint maxPlayers = 4;
+
+	GBALinkMailbox *mem = nullptr;
+	int fd = -1;
+	char name[64] {0};
+	uint id = 0; // player number, 0 is the multiplayer parent
+	int mode = -1; // SIO mode of the current transfer
+	int sender = -1; // player that started the current transfer, -1 if none
+	u32 members = 0; // players taking part in the current transfer
+	int ticks = 0; // emulated ticks until the current transfer ends
+	u32 clock = 0;
+	u32 seq = 0; // sequence number of this player's last transfer
+	u32 lastSeq[maxPlayers] {0}; // last seen sequence number of each port
+	u32 recvData = 0; // normal mode data from the other side
+	int timeoutMs = 500;
+
+	// latency stats, nanoseconds
+	u64 postTime = 0;
+	uint transfers = 0, sent = 0;
+	u64 roundTripTotal = 0, roundTripMax = 0;
+	u64 stallTotal = 0, stallMax = 0;
+
+	bool active() const { return mem; }
+	bool transferring() const { return sender != -1; }
+	void cancel() { sender = -1; }
+	bool open(const char *name = "/gbaemu-link");
+	void close();
+	void writeSIOCNT(ARM7TDMI &cpu, u16 value);
+	void update(ARM7TDMI &cpu, int ticks);
+	void logStats();
+};
+
+extern GBALocalLink gLocalLink;
+
+#endif // GBALOCALLINK_H
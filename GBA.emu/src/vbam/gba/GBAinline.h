@@ -8,6 +8,8 @@
 #include "agbprint.h"
 #include "GBAcpu.h"
 #include "GBALink.h"
+#include "IdleLoop.h"
+#include "GBAGfxThread.h"
 
 static const u32  objTilesAddress [3] = {0x010000, 0x014000, 0x014000};
 
@@ -222,6 +224,7 @@ static inline u32 CPUReadHalfWord(ARM7TDMI &cpu, u32 address)
       value =  READ16LE(((u16 *)&ioMem[address & 0x3fe]));
       if (((address & 0x3fe)>0xFF) && ((address & 0x3fe)<0x10E))
       {
+        gIdleLoop.timeDependentRead = true;
         if (((address & 0x3fe) == 0x100) && timer0On)
           value = 0xFFFF - ((timer0Ticks-cpuTotalTicks) >> timer0ClockReload);
         else
@@ -448,6 +451,7 @@ static inline void CPUWriteMemory(ARM7TDMI &cpu, u32 address, u32 value)
     else
 #endif
       WRITE32LE(((u32 *)&paletteRAM[address & 0x3FC]), value);
+    gGfxThread.paletteWritten(address);
     break;
   case 0x06:
     address = (address & 0x1fffc);
@@ -463,6 +467,7 @@ static inline void CPUWriteMemory(ARM7TDMI &cpu, u32 address, u32 value)
 #endif
 
       WRITE32LE(((u32 *)&vram[address]), value);
+    gGfxThread.vramWritten(address);
     break;
   case 0x07:
 #ifdef BKPT_SUPPORT
@@ -473,6 +478,7 @@ static inline void CPUWriteMemory(ARM7TDMI &cpu, u32 address, u32 value)
 #endif
       WRITE32LE(((u32 *)&oam[address & 0x3fc]), value);
       //oamUpdated = 1;
+    gGfxThread.oamWritten(address);
     break;
   case 0x0D:
     if(cpuEEPROMEnabled) {
@@ -548,6 +554,7 @@ static inline void CPUWriteHalfWord(ARM7TDMI &cpu, u32 address, u16 value)
     else
 #endif
       WRITE16LE(((u16 *)&paletteRAM[address & 0x3fe]), value);
+    gGfxThread.paletteWritten(address);
     break;
   case 6:
     address = (address & 0x1fffe);
@@ -562,6 +569,7 @@ static inline void CPUWriteHalfWord(ARM7TDMI &cpu, u32 address, u16 value)
     else
 #endif
       WRITE16LE(((u16 *)&vram[address]), value);
+    gGfxThread.vramWritten(address);
     break;
   case 7:
 #ifdef BKPT_SUPPORT
@@ -572,6 +580,7 @@ static inline void CPUWriteHalfWord(ARM7TDMI &cpu, u32 address, u16 value)
 #endif
       WRITE16LE(((u16 *)&oam[address & 0x3fe]), value);
       //oamUpdated = 1;
+    gGfxThread.oamWritten(address);
     break;
   case 8:
   case 9:
@@ -703,6 +712,7 @@ static inline void CPUWriteByte(ARM7TDMI &cpu, u32 address, u8 b)
   case 5:
     // no need to switch
   	*((uint16a *)&paletteRAM[address & 0x3FE]) = (b << 8) | b;
+    gGfxThread.paletteWritten(address);
     break;
   case 6:
     address = (address & 0x1fffe);
@@ -721,6 +731,7 @@ static inline void CPUWriteByte(ARM7TDMI &cpu, u32 address, u8 b)
       else
 #endif
       	*((uint16a *)&vram[address]) = (b << 8) | b;
+      gGfxThread.vramWritten(address);
     }
     break;
   case 7:
@@ -0,0 +1,179 @@
+#include <string.h>
+#include "GBA.h"
+#include "GBAcpu.h"
+#include "Globals.h"
+#include "IdleLoop.h"
+
+GBAIdleLoop gIdleLoop;
+
+// Returns true if the THUMB instruction can't modify memory, call code
+// outside the loop, or change CPU mode
+static bool thumbInsnIsPassive(u32 opcode)
+{
+	switch(opcode >> 12)
+	{
+		case 0x0: case 0x1: // shift by immediate, add/sub
+		case 0x2: case 0x3: // mov/cmp/add/sub immediate
+			return true;
+		case 0x4:
+			if(opcode < 0x4400) // ALU operations
+				return true;
+			if(opcode < 0x4800) // hi register operations/BX
+			{
+				uint op = (opcode >> 8) & 3;
+				uint rd = (opcode & 7) | ((opcode >> 4) & 8);
+				return op == 1 || (op != 3 && rd != 15);
+			}
+			return true; // PC relative load
+		case 0x5: // load/store with register offset
+			return ((opcode >> 9) & 7) >= 3;
+		case 0x6: case 0x7: // load/store with immediate offset
+		case 0x8: // load/store halfword
+		case 0x9: // SP relative load/store
+			return opcode & 0x800;
+		case 0xA: // load address
+			return true;
+		case 0xB: // add offset to SP, but not push/pop
+			return (opcode & 0xFF00) == 0xB000;
+		case 0xD: // conditional branch, but not SWI
+			return (opcode & 0x0F00) < 0x0E00;
+		case 0xE: // unconditional branch
+			return opcode < 0xE800;
+		default: // LDM/STM, BL
+			return false;
+	}
+}
+
+// Returns true if the ARM instruction can't modify memory, call code
+// outside the loop, or change CPU mode
+static bool armInsnIsPassive(u32 opcode)
+{
+	if((opcode >> 28) == 0xF)
+		return false;
+	uint rd = (opcode >> 12) & 0xF;
+	switch((opcode >> 25) & 7)
+	{
+		case 0:
+			if((opcode & 0x90) == 0x90)
+			{
+				if((opcode & 0x60) == 0) // MUL/MLA, but not long multiplies or SWP
+					return (opcode & 0x0FC00000) == 0 && ((opcode >> 16) & 0xF) != 15;
+				return (opcode & (1 << 20)) && rd != 15; // LDRH/LDRSB/LDRSH
+			}
+			// fall through
+		case 1: // data processing
+		{
+			uint op = (opcode >> 21) & 0xF;
+			if(op >= 0x8 && op <= 0xB) // TST/TEQ/CMP/CMN, but not MRS/MSR/BX
+				return (opcode & (1 << 20)) && rd != 15;
+			return rd != 15;
+		}
+		case 3:
+			if(opcode & 0x10) // undefined
+				return false;
+			// fall through
+		case 2: // LDR/LDRB
+			return (opcode & (1 << 20)) && rd != 15;
+		case 5: // B, but not BL
+			return !(opcode & (1 << 24));
+		default: // LDM/STM, coprocessor, SWI
+			return false;
+	}
+}
+
+static bool loopIsPassive(ARM7TDMI &cpu, u32 head, u32 branch)
+{
+	if(gIdleLoop.forcedAddr && head == gIdleLoop.forcedAddr)
+		return true;
+	if(cpu.armState)
+	{
+		for(u32 addr = head; addr <= branch; addr += 4)
+		{
+			if(!armInsnIsPassive(CPUReadMemoryQuick(addr)))
+				return false;
+		}
+	}
+	else
+	{
+		for(u32 addr = head; addr <= branch; addr += 2)
+		{
+			if(!thumbInsnIsPassive(CPUReadHalfWordQuick(addr)))
+				return false;
+		}
+	}
+	return true;
+}
+
+static bool addrIsRom(u32 addr)
+{
+	return addr < 0x4000 || (addr >> 24) >= 8;
+}
+
+void GBAIdleLoop::checkBranch(ARM7TDMI &cpu, u32 branchPC)
+{
+	u32 loopHead = cpu.armNextPC;
+	if(!detect && (!forcedAddr || loopHead != forcedAddr))
+	{
+		armed = false;
+		return;
+	}
+
+	// cache the static analysis, the final branch itself must also be passive
+	// so returns and jumps through registers are never treated as loops
+	auto &loop = cache[(branchPC >> 1) % cacheEntries];
+	if(loop.head != loopHead || loop.branch != branchPC)
+	{
+		loop.head = loopHead;
+		loop.branch = branchPC;
+		loop.idle = loopIsPassive(cpu, loopHead, branchPC);
+	}
+	if(!loop.idle)
+	{
+		armed = false;
+		return;
+	}
+
+	if(armed && head == loopHead && branch == branchPC && !timeDependentRead
+		&& armMode == cpu.armMode && lastArithmeticRes == cpu.lastArithmeticRes
+		&& C_FLAG == cpu.C_FLAG && V_FLAG == cpu.V_FLAG)
+	{
+		bool regsMatch = true;
+		iterateTimes(16, i)
+		{
+			if(regs[i] != cpu.reg[i].I)
+			{
+				regsMatch = false;
+				break;
+			}
+		}
+		if(regsMatch)
+		{
+			// code in RAM may have been rewritten since it was cached
+			if(!addrIsRom(loopHead) && !loopIsPassive(cpu, loopHead, branchPC))
+			{
+				loop.idle = false;
+				armed = false;
+				return;
+			}
+			// nothing can change until the next event, skip straight to it
+			if(cpu.cpuTotalTicks < cpu.cpuNextEvent)
+				cpu.cpuTotalTicks = cpu.cpuNextEvent;
+			armed = false;
+			return;
+		}
+	}
+
+	// snapshot this iteration and wait for the next one
+	armed = true;
+	timeDependentRead = false;
+	head = loopHead;
+	branch = branchPC;
+	armMode = cpu.armMode;
+	lastArithmeticRes = cpu.lastArithmeticRes;
+	C_FLAG = cpu.C_FLAG;
+	V_FLAG = cpu.V_FLAG;
+	iterateTimes(16, i)
+	{
+		regs[i] = cpu.reg[i].I;
+	}
+}
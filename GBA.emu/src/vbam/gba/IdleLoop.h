@@ -0,0 +1,78 @@
+#ifndef IDLELOOP_H
+#define IDLELOOP_H
+
+#include <util/branch.h>
+
+// Detects loops that only poll memory/IO waiting for an event (VBlank, IRQ,
+// DMA, etc.) and fast-forwards the CPU to the next scheduled event instead of
+// emulating every iteration.
+//
+// A loop is considered idle when:
+// 1. It's a short backward branch whose body contains no stores, calls,
+//    mode switches or software interrupts (or its head matches the per-game
+//    idle loop address)
+// 2. Two consecutive iterations end with identical registers and flags
+//    without reading a running timer counter in between
+//
+// Since other agents (IRQ handlers, DMA, timers, LCD) can only change state
+// when CPULoop processes an event, the candidate is dropped on every event
+// and the loop must be re-confirmed before skipping again.
+
+struct GBAIdleLoop
+{
+	constexpr GBAIdleLoop() { }
+
+	static const uint maxInsns = 16;
+	static const uint cacheEntries = 64;
+
+	struct Loop
+	{
+		constexpr Loop() { }
+		u32 head = 0, branch = 0;
+		bool idle = false;
+	};
+
+	bool enabled = true; // off never skips, not even at forcedAddr
+	bool detect = true;
+	bool timeDependentRead = false;
+	bool armed = false;
+	u32 forcedAddr = 0; // per-game idle loop head, 0 if none
+	u32 head = 0, branch = 0;
+	u32 regs[16] {0};
+	u32 lastArithmeticRes = 0;
+	int armMode = 0;
+	bool C_FLAG = 0, V_FLAG = 0;
+	Loop cache[cacheEntries];
+
+	void invalidate() { armed = false; }
+
+	void setEnabled(bool on)
+	{
+		enabled = on;
+		armed = false;
+	}
+
+	void flushCache()
+	{
+		armed = false;
+		for(auto &e : cache)
+			e = Loop();
+	}
+
+	void checkBranch(ARM7TDMI &cpu, u32 branchPC);
+};
+
+extern GBAIdleLoop gIdleLoop;
+
+// Called after an executed branch, armNextPC holds the target
+static inline void idleLoopCheckBranch(ARM7TDMI &cpu, u32 branchPC, uint insnBytes)
+{
+	if(likely(cpu.armNextPC >= branchPC) || !gIdleLoop.enabled)
+		return;
+	if(branchPC - cpu.armNextPC < GBAIdleLoop::maxInsns * insnBytes || (gIdleLoop.forcedAddr && cpu.armNextPC == gIdleLoop.forcedAddr))
+		gIdleLoop.checkBranch(cpu, branchPC);
+	else
+		gIdleLoop.invalidate();
+}
+
+#endif // IDLELOOP_H
@@ -0,0 +1,408 @@
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "GBA.h"
+#include "Globals.h"
+#include "Flash.h"
+#include "EEprom.h"
+#include "SaveFile.h"
+#include "../System.h"
+#include <logger/interface.h>
+#include <util/basicString.h>
+
+GBASaveFile gSaveFile;
+extern int gbaSaveType;
+
+static const u32 journalMagic = 0x4C4E4A53; // "SJNL"
+
+struct JournalHeader
+{
+	u32 magic, imageSize, pageSize, pages, checksum;
+};
+
+// followed by pages records of a u32 file offset & pageSize bytes of data
+
+static u32 journalChecksum(const u8 *journal, uint size)
+{
+	// FNV-1a of everything except the checksum field
+	u32 hash = 2166136261u;
+	iterateTimes(size, i)
+	{
+		if(i == offsetof(JournalHeader, checksum))
+		{
+			i += 3;
+			continue;
+		}
+		hash = (hash ^ journal[i]) * 16777619;
+	}
+	return hash;
+}
+
+static bool writeAll(int fd, const u8 *data, uint size, off_t offset)
+{
+	while(size)
+	{
+		auto written = pwrite(fd, data, size, offset);
+		if(written <= 0)
+			return false;
+		data += written;
+		size -= written;
+		offset += written;
+	}
+	return true;
+}
+
+// Save type & size in the same way as CPUWriteBatteryFile(), 0 if none is in use
+static int batteryType()
+{
+	if(gbaSaveType)
+		return gbaSaveType == 5 ? 0 : gbaSaveType;
+	if(eepromInUse)
+		return 3;
+	if(saveType == 1 || saveType == 2)
+		return saveType;
+	return 0;
+}
+
+static bool mapSave(GBASaveFile &s, uint size)
+{
+	if(s.map)
+	{
+		munmap(s.map, s.mapSize);
+		s.map = nullptr;
+		s.mapSize = 0;
+	}
+	if(ftruncate(s.fd, size) == -1)
+		return false;
+	void *map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, s.fd, 0);
+	if(map == MAP_FAILED)
+		return false;
+	s.map = (u8*)map;
+	s.mapSize = size;
+	return true;
+}
+
+// Runs on the writer in threaded mode, only touches the journal buffer
+// and the file state
+static void commitJournal(GBASaveFile &s, bool sync)
+{
+	auto &header = *(JournalHeader*)s.journal;
+	header.checksum = journalChecksum(s.journal, s.journalSize);
+	if(s.fd == -1)
+	{
+		s.fd = open(s.path, O_RDWR | O_CREAT, 0644);
+		if(s.fd == -1)
+		{
+			logErr("unable to create save file %s", s.path);
+			return;
+		}
+	}
+	if(s.journalFd == -1)
+		s.journalFd = open(s.journalPath, O_RDWR | O_CREAT, 0644);
+	if(s.journalFd == -1 || !writeAll(s.journalFd, s.journal, s.journalSize, 0))
+		logWarn("unable to write save journal %s, updating save file directly", s.journalPath);
+	else if(sync)
+		fsync(s.journalFd);
+
+	if(header.imageSize != s.mapSize && !mapSave(s, header.imageSize))
+	{
+		logErr("unable to map save file %s", s.path);
+		return;
+	}
+	const u8 *record = s.journal + sizeof(JournalHeader);
+	iterateTimes(header.pages, i)
+	{
+		u32 offset;
+		memcpy(&offset, record, 4);
+		memcpy(s.map + offset, record + 4, header.pageSize);
+		record += 4 + header.pageSize;
+	}
+	if(sync)
+		msync(s.map, s.mapSize, MS_SYNC);
+
+	// save file is current, the journal no longer needs replaying
+	if(s.journalFd != -1)
+	{
+		u32 noMagic = 0;
+		writeAll(s.journalFd, (u8*)&noMagic, 4, 0);
+	}
+	s.flushes++;
+	s.pagesWritten += header.pages;
+}
+
+// Finishes an update interrupted by a crash, before the save is loaded
+static void replayJournal(GBASaveFile &s)
+{
+	int journalFd = open(s.journalPath, O_RDONLY);
+	if(journalFd == -1)
+		return;
+	auto &header = *(JournalHeader*)s.journal;
+	auto size = read(journalFd, s.journal, sizeof(s.journal));
+	close(journalFd);
+	if(size < (int)sizeof(JournalHeader) || header.magic != journalMagic)
+	{
+		unlink(s.journalPath);
+		return;
+	}
+	uint journalSize = sizeof(JournalHeader) + header.pages * (4 + header.pageSize);
+	if((header.pageSize != 1 << GBASaveFile::flashPageShift && header.pageSize != 1 << GBASaveFile::eepromPageShift)
+		|| header.pages > GBASaveFile::maxPages || header.imageSize > 0x20000
+		|| journalSize > (uint)size || journalChecksum(s.journal, journalSize) != header.checksum)
+	{
+		logWarn("discarding incomplete save journal %s", s.journalPath);
+		unlink(s.journalPath);
+		return;
+	}
+	int fd = open(s.path, O_RDWR | O_CREAT, 0644);
+	if(fd == -1)
+		return; // keep the journal for next time
+	bool ok = ftruncate(fd, header.imageSize) != -1;
+	const u8 *record = s.journal + sizeof(JournalHeader);
+	iterateTimes(header.pages, i)
+	{
+		u32 offset;
+		memcpy(&offset, record, 4);
+		if(offset + header.pageSize <= header.imageSize)
+			ok = ok && writeAll(fd, record + 4, header.pageSize, offset);
+		record += 4 + header.pageSize;
+	}
+	ok = ok && fsync(fd) == 0;
+	close(fd);
+	if(ok)
+	{
+		logMsg("replayed %d pages from save journal", header.pages);
+		unlink(s.journalPath);
+	}
+}
+
+static int writerThread(ThreadPThread &thread)
+{
+	auto &s = *(GBASaveFile*)thread.arg;
+	s.mutex.lock();
+	for(;;)
+	{
+		while(!s.busy && !s.quit)
+			s.workCond.wait();
+		if(!s.busy)
+			break; // quit requested & nothing queued
+		bool sync = s.syncPolicy == GBASaveFile::SYNC_FLUSH;
+		s.mutex.unlock();
+		commitJournal(s, sync);
+		s.mutex.lock();
+		s.busy = false;
+		s.doneCond.signal();
+	}
+	s.mutex.unlock();
+	return 0;
+}
+
+static bool writerBusy(GBASaveFile &s)
+{
+	if(!s.threaded)
+		return false;
+	s.mutex.lock();
+	bool busy = s.busy;
+	s.mutex.unlock();
+	return busy;
+}
+
+static void waitForWriter(GBASaveFile &s)
+{
+	if(!s.threaded)
+		return;
+	s.mutex.lock();
+	while(s.busy)
+		s.doneCond.wait();
+	s.mutex.unlock();
+}
+
+// Copies the dirty pages into the journal buffer and passes it to the writer,
+// returns false if the writer is still busy with the previous batch
+static bool queueDirtyPages(GBASaveFile &s)
+{
+	int type = batteryType();
+	if(!type)
+	{
+		s.flashDirty = s.eepromDirty = 0;
+		s.dirtyFrames = 0;
+		return true;
+	}
+	if(writerBusy(s))
+		return false;
+
+	const u8 *src;
+	uint shift, imageSize;
+	u32 dirty;
+	if(type == 3)
+	{
+		src = eepromData;
+		shift = GBASaveFile::eepromPageShift;
+		imageSize = eepromSize;
+		dirty = s.eepromDirty;
+	}
+	else
+	{
+		src = flashSaveMemory;
+		shift = GBASaveFile::flashPageShift;
+		imageSize = type == 2 ? flashSize : 0x10000;
+		dirty = s.flashDirty;
+	}
+	if(imageSize != s.fileSize)
+	{
+		// new file or the save size changed, write the whole image
+		dirty = ~0;
+		s.fileSize = imageSize;
+	}
+	uint pageSize = 1 << shift;
+	uint pages = imageSize >> shift;
+	if(pages < 32)
+		dirty &= (1 << pages) - 1;
+	s.flashDirty = s.eepromDirty = 0;
+	s.dirtyFrames = 0;
+	if(!dirty)
+		return true;
+
+	auto &header = *(JournalHeader*)s.journal;
+	header.magic = journalMagic;
+	header.imageSize = imageSize;
+	header.pageSize = pageSize;
+	header.pages = 0;
+	u8 *record = s.journal + sizeof(JournalHeader);
+	while(dirty)
+	{
+		u32 offset = __builtin_ctz(dirty) << shift;
+		dirty &= dirty - 1;
+		memcpy(record, &offset, 4);
+		memcpy(record + 4, &src[offset], pageSize);
+		record += 4 + pageSize;
+		header.pages++;
+	}
+	s.journalSize = record - s.journal;
+
+	if(s.threaded)
+	{
+		s.mutex.lock();
+		s.busy = true;
+		s.workCond.signal();
+		s.mutex.unlock();
+	}
+	else
+		commitJournal(s, s.syncPolicy == GBASaveFile::SYNC_FLUSH);
+	return true;
+}
+
+bool GBASaveFile::open(const char *path)
+{
+	close();
+	// the file may be created after the working directory changed
+	char dir[512] = "";
+	if(path[0] != '/' && !getcwd(dir, sizeof(dir)))
+		return false;
+	if(strlen(dir) + strlen(path) + sizeof("/.journal") > sizeof(journalPath))
+	{
+		logErr("save path too long");
+		return false;
+	}
+	if(dir[0])
+		snprintf(this->path, sizeof(this->path), "%s/%s", dir, path);
+	else
+		string_copy(this->path, path);
+	snprintf(journalPath, sizeof(journalPath), "%s.journal", this->path);
+	replayJournal(*this);
+	// the file is created on the first write so games without saves don't get one
+	fd = ::open(this->path, O_RDWR);
+	struct stat st;
+	fileSize = (fd != -1 && fstat(fd, &st) == 0) ? st.st_size : 0;
+	flashDirty = eepromDirty = 0;
+	dirtyFrames = 0;
+	flushes = pagesWritten = 0;
+
+	mutex.create();
+	workCond.create(&mutex);
+	doneCond.create(&mutex);
+	quit = busy = false;
+	if(thread.create(0, writerThread, this))
+		threaded = true;
+	else
+	{
+		logWarn("unable to start save writer thread, writing synchronously");
+		workCond.destroy();
+		doneCond.destroy();
+		mutex.destroy();
+	}
+	return true;
+}
+
+void GBASaveFile::close()
+{
+	if(!active())
+		return;
+	flush();
+	if(threaded)
+	{
+		mutex.lock();
+		quit = true;
+		workCond.signal();
+		mutex.unlock();
+		thread.join();
+		threaded = false;
+		workCond.destroy();
+		doneCond.destroy();
+		mutex.destroy();
+	}
+	if(map)
+	{
+		munmap(map, mapSize);
+		map = nullptr;
+		mapSize = 0;
+	}
+	if(fd != -1)
+	{
+		::close(fd);
+		fd = -1;
+	}
+	if(journalFd != -1)
+	{
+		::close(journalFd);
+		journalFd = -1;
+		unlink(journalPath);
+	}
+	logMsg("closed save file %s, wrote %u pages in %u updates", path, pagesWritten, flushes);
+	path[0] = 0;
+}
+
+void GBASaveFile::frameUpdate()
+{
+	if(!active() || !(flashDirty | eepromDirty))
+		return;
+	dirtyFrames++;
+	if(systemSaveUpdateCounter > SYSTEM_SAVE_NOT_UPDATED)
+		systemSaveUpdateCounter--;
+	if(systemSaveUpdateCounter == SYSTEM_SAVE_NOT_UPDATED || dirtyFrames >= maxDelayFrames)
+		queueDirtyPages(*this); // retried next frame if the writer is busy
+}
+
+void GBASaveFile::setSyncPolicy(int policy)
+{
+	if(!threaded)
+	{
+		syncPolicy = policy;
+		return;
+	}
+	mutex.lock();
+	syncPolicy = policy;
+	mutex.unlock();
+}
+
+void GBASaveFile::flush()
+{
+	if(!active())
+		return;
+	waitForWriter(*this);
+	if(flashDirty | eepromDirty)
+		queueDirtyPages(*this);
+	waitForWriter(*this);
+}
@@ -0,0 +1,71 @@
+#ifndef SAVEFILE_H
+#define SAVEFILE_H
+
+#include <util/thread/pthread.hh>
+
+// Writes battery save memory (Flash/SRAM/EEPROM) back to the .sav file as
+// the game changes it, instead of rewriting the whole file on exit.
+//
+// Save writes mark the 4KB Flash/SRAM or 512 byte EEPROM pages they touch.
+// Once a game stops writing for SYSTEM_SAVE_UPDATED frames (or after
+// maxDelayFrames of continuous writes) the dirty pages are copied out and
+// handed to a writer thread, so games saving every frame neither stall
+// emulation nor rewrite the file every frame.
+//
+// The writer first stores the pages in a journal file next to the save,
+// syncs it, copies them into the memory mapped save file and syncs that.
+// If the app dies mid-update, the journal is replayed on the next open so
+// the save file never holds a mix of old and new pages. With the sync policy set
+// to SYNC_NONE syncing is left to the OS and only process crashes are
+// covered.
+
+struct GBASaveFile
+{
+	constexpr GBASaveFile() { }
+
+	static const uint flashPageShift = 12;
+	static const uint eepromPageShift = 9;
+	static const uint maxPages = 0x20000 >> flashPageShift;
+	static const uint maxDelayFrames = 300;
+	static const uint journalBytes = 20 + maxPages * (4 + (1 << flashPageShift));
+
+	enum { SYNC_NONE, SYNC_FLUSH };
+
+	u32 flashDirty = 0; // 4KB pages of flashSaveMemory
+	u32 eepromDirty = 0; // 512 byte pages of eepromData
+	uint dirtyFrames = 0; // frames since the oldest unwritten change
+	uint fileSize = 0; // size the save file will have after queued writes
+	int syncPolicy = SYNC_FLUSH; // read by the writer under mutex, use setSyncPolicy()
+	int fd = -1, journalFd = -1;
+	u8 *map = nullptr;
+	uint mapSize = 0;
+	char path[1024] {0};
+	char journalPath[1024] {0};
+
+	bool threaded = false;
+	bool quit = false;
+	bool busy = false; // journal buffer is owned by the writer
+	ThreadPThread thread;
+	MutexPThread mutex;
+	CondVarPThread workCond, doneCond;
+	u8 journal[journalBytes] __attribute__ ((aligned(4))) {0};
+	uint journalSize = 0;
+
+	uint flushes = 0, pagesWritten = 0;
+
+	bool active() const { return path[0]; }
+	void flashWritten(u32 offset) { flashDirty |= 1 << ((offset & 0x1FFFF) >> flashPageShift); }
+	void flashErased() { flashDirty = ~0; }
+	void eepromWritten(u32 offset) { eepromDirty |= 1 << ((offset & 0x1FFF) >> eepromPageShift); }
+	void markAll() { flashDirty = eepromDirty = ~0; }
+	void setSyncPolicy(int policy);
+
+	bool open(const char *path);
+	void close();
+	void frameUpdate();
+	void flush();
+};
+
+extern GBASaveFile gSaveFile;
+
+#endif // SAVEFILE_H
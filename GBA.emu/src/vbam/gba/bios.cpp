@@ -883,6 +883,8 @@ void BIOS_RegisterRamReset(ARM7TDMI &cpu, u32 flags)
       memset(internalRAM, 0, 0x7e00); // don't clear 0x7e00-0x7fff
     }
     gLcd.registerRamReset(flags);
+    if(flags & 0x1C)
+      gGfxThread.resync();
     /*if(flags & 0x04) {
       // clear palette RAM
       memset(paletteRAM, 0, 0x400);
@@ -0,0 +1,244 @@
+// Headless test of the local link (GBALocalLink.cpp) between two processes:
+// forks a second instance, runs multiplayer & normal 32-bit transfers
+// between them checking the data both sides receive, then has a player
+// crash mid-session and checks the survivor waits out one transfer without
+// spinning and afterwards runs without it. Exits non-zero on failure.
+
+#include <stdio.h>
+#include <algorithm>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "GBA.h"
+#include "GBAcpu.h"
+#include "GBALink.h"
+#include "GBALocalLink.h"
+#include "../common/Port.h"
+
+GBAMem gMem;
+GBALCD gLcd;
+u8 gGfxIoMem[0x400] __attribute__ ((aligned(4))) {0};
+void mode0RenderLine(u16 *) {} // ARM7TDMI's default renderer, never called here
+
+static const char *linkName = "/gbaemu-link-test";
+static ARM7TDMI cpu;
+// transfers the child finished, the parent waits on it before starting the
+// next one to stand in for both instances emulating in real time
+static uint *childDone;
+
+static u16 reg(u32 addr) { return READ16LE(&ioMem[addr]); }
+
+static void step(int ticks)
+{
+	cpu.cpuTotalTicks = 0;
+	gLocalLink.update(cpu, ticks);
+}
+
+static double cpuSeconds()
+{
+	timespec t;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void waitForChild(uint done)
+{
+	while(__atomic_load_n(childDone, __ATOMIC_ACQUIRE) < done)
+		usleep(10);
+}
+
+static void childFinished(uint done)
+{
+	__atomic_store_n(childDone, done, __ATOMIC_RELEASE);
+}
+
+static int multiTest(bool parent, int n)
+{
+	UPDATE_REG(COMM_RCNT, 0);
+	gLocalLink.writeSIOCNT(cpu, 0x6003);
+	int bad = 0;
+	if(parent)
+	{
+		iterateTimes(n, i)
+		{
+			UPDATE_REG(COMM_SIOMLT_SEND, 0x1000 + i);
+			cpu.IF = 0;
+			gLocalLink.writeSIOCNT(cpu, 0x6083);
+			while(reg(COMM_SIOCNT) & 0x80)
+				step(std::min(gLocalLink.ticks, 1232));
+			if(!(cpu.IF & 0x80))
+				bad++;
+			if(reg(COMM_SIOMULTI0) != 0x1000 + i || reg(COMM_SIOMULTI1) != 0x2000 + i
+				|| reg(COMM_SIOMULTI2) != 0xffff)
+				bad++;
+			step(20000);
+			waitForChild(i + 1);
+		}
+	}
+	else
+	{
+		UPDATE_REG(COMM_SIOMLT_SEND, 0x2000);
+		uint done = 0;
+		while(done < (uint)n)
+		{
+			bool busy = reg(COMM_SIOCNT) & 0x80;
+			step(1232);
+			if(busy && !(reg(COMM_SIOCNT) & 0x80))
+			{
+				if(reg(COMM_SIOMULTI0) != 0x1000 + done || reg(COMM_SIOMULTI1) != 0x2000 + done)
+					bad++;
+				done++;
+				UPDATE_REG(COMM_SIOMLT_SEND, 0x2000 + done);
+				childFinished(done);
+			}
+		}
+	}
+	return bad;
+}
+
+static int normalTest(bool master, int n)
+{
+	UPDATE_REG(COMM_RCNT, 0);
+	int bad = 0;
+	if(master)
+	{
+		iterateTimes(n, i)
+		{
+			WRITE32LE(&ioMem[COMM_SIODATA32_L], 0xA0000000 + i);
+			gLocalLink.writeSIOCNT(cpu, 0x5083);
+			while(reg(COMM_SIOCNT) & 0x80)
+				step(gLocalLink.ticks);
+			if(READ32LE(&ioMem[COMM_SIODATA32_L]) != 0xB0000000 + i)
+				bad++;
+			step(30000);
+			waitForChild(n + i + 1);
+		}
+	}
+	else
+	{
+		uint done = 0;
+		WRITE32LE(&ioMem[COMM_SIODATA32_L], 0xB0000000);
+		gLocalLink.writeSIOCNT(cpu, 0x5080);
+		while(done < (uint)n)
+		{
+			step(1232);
+			if(!(reg(COMM_SIOCNT) & 0x80))
+			{
+				if(READ32LE(&ioMem[COMM_SIODATA32_L]) != 0xA0000000 + done)
+					bad++;
+				done++;
+				WRITE32LE(&ioMem[COMM_SIODATA32_L], 0xB0000000 + done);
+				gLocalLink.writeSIOCNT(cpu, 0x5080);
+				childFinished(n + done);
+			}
+		}
+	}
+	return bad;
+}
+
+// Runs one multiplayer transfer as the parent, returns the nanoseconds it stalled on the others
+static u64 parentTransfer()
+{
+	u64 stall = gLocalLink.stallTotal;
+	UPDATE_REG(COMM_SIOMLT_SEND, 0x1234);
+	gLocalLink.writeSIOCNT(cpu, 0x6083);
+	while(reg(COMM_SIOCNT) & 0x80)
+		step(std::min(gLocalLink.ticks, 1232));
+	return gLocalLink.stallTotal - stall;
+}
+
+static int crashTest()
+{
+	UPDATE_REG(COMM_RCNT, 0);
+	gLocalLink.writeSIOCNT(cpu, 0x6003);
+	int pipeFd[2];
+	if(pipe(pipeFd) == -1)
+		return 1;
+	pid_t pid = fork();
+	if(!pid)
+	{
+		// join & die without leaving
+		GBALocalLink peer;
+		if(peer.open(linkName))
+			write(pipeFd[1], "", 1);
+		raise(SIGKILL);
+	}
+	char c;
+	if(read(pipeFd[0], &c, 1) != 1)
+	{
+		printf("crashed player never joined\n");
+		return 1;
+	}
+	waitpid(pid, nullptr, 0);
+	int bad = 0;
+	double cpuStart = cpuSeconds();
+	u64 stall = parentTransfer();
+	double cpuUsed = cpuSeconds() - cpuStart;
+	printf("transfer to crashed player: stalled %.0fms, %.1fms cpu\n", stall / 1e6, cpuUsed * 1e3);
+	if(stall < (u64)gLocalLink.timeoutMs * 900000)
+	{
+		printf("didn't wait for the crashed player\n");
+		bad++;
+	}
+	if(cpuUsed > gLocalLink.timeoutMs / 1e3 / 4)
+	{
+		printf("spun while waiting for the crashed player\n");
+		bad++;
+	}
+	stall = parentTransfer();
+	if(stall)
+	{
+		printf("crashed player still in the link, stalled %.0fms\n", stall / 1e6);
+		bad++;
+	}
+	return bad;
+}
+
+int main()
+{
+	const int n = 2000;
+	shm_unlink(linkName);
+	childDone = (uint*)mmap(nullptr, sizeof(uint), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if(childDone == MAP_FAILED)
+		return 1;
+	pid_t pid = fork();
+	if(pid == -1)
+		return 1;
+	bool parent = pid;
+	if(!parent)
+		usleep(20000); // let the parent claim player 0
+	if(!gLocalLink.open(linkName))
+	{
+		printf("can't open link\n");
+		return 1;
+	}
+	if(gLocalLink.id != (parent ? 0 : 1))
+	{
+		printf("unexpected player number %d\n", gLocalLink.id);
+		return 1;
+	}
+	usleep(100000);
+	int multiBad = multiTest(parent, n);
+	printf("player %d multiplayer: %d bad, avg round trip %lluns\n", gLocalLink.id, multiBad,
+		(unsigned long long)(gLocalLink.roundTripTotal / std::max(gLocalLink.sent, 1u)));
+	usleep(200000);
+	gLocalLink.cancel();
+	int normalBad = normalTest(parent, n);
+	printf("player %d normal: %d bad\n", gLocalLink.id, normalBad);
+	int bad = multiBad + normalBad;
+	if(!parent)
+	{
+		gLocalLink.close();
+		return bad != 0;
+	}
+	int status;
+	waitpid(pid, &status, 0);
+	if(!WIFEXITED(status) || WEXITSTATUS(status))
+		bad++;
+	bad += crashTest();
+	gLocalLink.close();
+	printf("%s\n", bad ? "FAILED" : "passed");
+	return bad != 0;
+}
@@ -15,6 +15,7 @@ libgambatte/src/memory.cpp libgambatte/src/mem/rtc.cpp libgambatte/src/sound.cpp
 libgambatte/src/statesaver.cpp libgambatte/src/video.cpp libgambatte/src/sound/channel1.cpp \
 libgambatte/src/sound/channel2.cpp libgambatte/src/sound/channel3.cpp libgambatte/src/sound/channel4.cpp \
 libgambatte/src/sound/duty_unit.cpp libgambatte/src/sound/envelope_unit.cpp libgambatte/src/sound/length_counter.cpp \
+libgambatte/src/sound/cic_accumulator.cpp \
 libgambatte/src/video/ly_counter.cpp libgambatte/src/video/lyc_irq.cpp \
 libgambatte/src/video/next_m0_time.cpp libgambatte/src/video/ppu.cpp libgambatte/src/video/sprite_mapper.cpp \
 libgambatte/src/mem/cartridge.cpp libgambatte/src/mem/memptrs.cpp libgambatte/src/interruptrequester.cpp \
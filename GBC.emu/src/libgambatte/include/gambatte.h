@@ -22,6 +22,7 @@
 #include "inputgetter.h"
 #include "gbint.h"
 #include <string>
+#include <cstddef>
 
 namespace gambatte {
 enum { BG_PALETTE = 0, SP1_PALETTE = 1, SP2_PALETTE = 2 };
@@ -48,7 +49,8 @@ public:
 	/** Emulates until at least 'samples' stereo sound samples are produced in the supplied buffer,
 	  * or until a video frame has been drawn.
 	  *
-	  * There are 35112 stereo sound samples in a video frame.
+	  * There are 35112 stereo sound samples in a video frame, or 35112 >> shift
+	  * with a decimation shift set by setSoundDecimation().
 	  * May run for up to 2064 stereo samples too long.
 	  * A stereo sample consists of two native endian 2s complement 16-bit PCM samples,
 	  * with the left sample preceding the right one. Usually casting soundBuf to/from
@@ -69,6 +71,14 @@ public:
 	long runFor(gambatte::PixelType *videoBuf, int pitch,
 			gambatte::uint_least32_t *soundBuf, unsigned &samples);
 	
+	/** Lowers the sound sample rate to 2097152 >> shift Hz (0 <= shift <= 5) through a
+	  * second order CIC decimator that the sound channels feed directly. The channels
+	  * then only do work per output level change and runFor() produces 2^shift times
+	  * fewer samples for the caller's resampler. 'samples' passed to runFor() and its
+	  * return value count samples at the lowered rate. Default is 0.
+	  */
+	void setSoundDecimation(unsigned shift);
+	
 	/** Reset to initial state.
 	  * Equivalent to reloading a ROM image, or turning a Game Boy Color off and on again.
 	  */
@@ -119,6 +129,25 @@ public:
 	  */
 	bool loadState(const std::string &filepath);
 	
+	/** Returns the number of bytes saveState() needs to store the current state in a buffer.
+	  *
+	  * @param thumbnail true if a thumbnail will be stored.
+	  */
+	std::size_t stateSize(bool thumbnail) const;
+	
+	/** Saves emulator state to 'buf', which is at least stateSize() bytes.
+	  * Doesn't allocate or touch the file system, suitable for rewind and autosave snapshots.
+	  *
+	  * @param videoBuf 160x144 video frame buffer or 0. Used for storing a thumbnail.
+	  * @param pitch distance in number of pixels (not bytes) from the start of one line to the next in videoBuf.
+	  * @return number of bytes written, 0 on failure.
+	  */
+	std::size_t saveState(const gambatte::PixelType *videoBuf, int pitch, unsigned char *buf, std::size_t size);
+	
+	/** Loads emulator state from a buffer written by saveState().
+	  */
+	bool loadState(const unsigned char *buf, std::size_t size);
+	
 	/** Selects which state slot to save state to or load state from.
 	  * There are 10 such slots, numbered from 0 to 9 (periodically extended for all n).
 	  */
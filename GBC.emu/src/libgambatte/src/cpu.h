@@ -85,6 +85,8 @@ public:
 	
 	void setSoundBuffer(uint_least32_t *const buf) { memory.setSoundBuffer(buf); }
 	unsigned fillSoundBuffer() { return memory.fillSoundBuffer(cycleCounter_); }
+	void setSoundDecimation(unsigned shift) { memory.setSoundDecimation(shift); }
+	unsigned soundDecimation() const { return memory.soundDecimation(); }
 	
 	bool isCgb() const { return memory.isCgb(); }
 	
@@ -24,8 +24,10 @@
 #ifndef GAMBATTE_NO_OSD
 #include "state_osd_elements.h"
 #endif
+#include <io/sys.hh>
 #include <sstream>
 #include <cstring>
+#include <vector>
 
 static const std::string itos(const int i) {
 	std::stringstream ss;
@@ -42,6 +44,7 @@ struct GB::Priv {
 	CPU cpu;
 	int stateNo;
 	bool gbaCgbMode;
+	std::vector<unsigned char> stateBuf; // reused by file saves & non mmapped loads
 	
 	Priv() : stateNo(1), gbaCgbMode(false) {}
 };
@@ -64,12 +67,17 @@ long GB::runFor(gambatte::PixelType *const videoBuf, const int pitch,
 	
 	p_->cpu.setVideoBuffer(videoBuf, pitch);
 	p_->cpu.setSoundBuffer(soundBuf);
-	const long cyclesSinceBlit = p_->cpu.runFor(samples * 2);
+	const unsigned shift = p_->cpu.soundDecimation();
+	const long cyclesSinceBlit = p_->cpu.runFor(static_cast<unsigned long>(samples) << (1 + shift));
 	void commitVideoFrame();
 	commitVideoFrame();
 	samples = p_->cpu.fillSoundBuffer();
 	
-	return cyclesSinceBlit < 0 ? cyclesSinceBlit : static_cast<long>(samples) - (cyclesSinceBlit >> 1);
+	return cyclesSinceBlit < 0 ? cyclesSinceBlit : static_cast<long>(samples) - (cyclesSinceBlit >> (1 + shift));
+}
+
+void GB::setSoundDecimation(const unsigned shift) {
+	p_->cpu.setSoundDecimation(shift);
 }
 
 void GB::reset() {
@@ -140,20 +148,48 @@ void GB::saveSavedata()
 
 bool GB::loadState(const std::string &filepath, const bool osdMessage) {
 	if (p_->cpu.loaded()) {
-		p_->cpu.saveSavedata();
+		Io *const file = IoSys::open(filepath.c_str());
 		
-		SaveState state;
-		p_->cpu.setStatePtrs(state);
+		if (!file)
+			return false;
 		
-		if (StateSaver::loadState(state, filepath)) {
-			p_->cpu.loadState(state);
+		const std::size_t size = file->size();
+		const unsigned char *data = file->mmapConst();
+		
+		if (!data) {
+			if (p_->stateBuf.size() < size)
+				p_->stateBuf.resize(size);
+			
+			data = &p_->stateBuf[0];
 			
+			if (file->readUpTo(&p_->stateBuf[0], size) != size) {
+				delete file;
+				return false;
+			}
+		}
+		
+		bool ok;
+		
+		if (StateSaver::isBufferState(data, size)) {
+			ok = loadState(data, size);
+		} else {
+			// older iostream based state
+			p_->cpu.saveSavedata();
+			
+			SaveState state;
+			p_->cpu.setStatePtrs(state);
+			
+			if ((ok = StateSaver::loadState(state, filepath)))
+				p_->cpu.loadState(state);
+		}
+		
+		delete file;
+		
 #ifndef GAMBATTE_NO_OSD
-			if (osdMessage)
-				p_->cpu.setOsdElement(newStateLoadedOsdElement(p_->stateNo));
+		if (ok && osdMessage)
+			p_->cpu.setOsdElement(newStateLoadedOsdElement(p_->stateNo));
 #endif
-			return true;
-		}
+		return ok;
 	}
 	return false;
 }
@@ -173,11 +209,51 @@ bool GB::loadState() {
 }
 
 bool GB::saveState(const gambatte::PixelType *const videoBuf, const int pitch, const std::string &filepath) {
+	if (p_->cpu.loaded()) {
+		const std::size_t size = stateSize(videoBuf);
+		
+		if (p_->stateBuf.size() < size)
+			p_->stateBuf.resize(size);
+		
+		if (!saveState(videoBuf, pitch, &p_->stateBuf[0], size))
+			return false;
+		
+		return IoSys::writeToNewFile(filepath.c_str(), &p_->stateBuf[0], size) == OK;
+	}
+	return false;
+}
+
+std::size_t GB::stateSize(const bool thumbnail) const {
+	if (!p_->cpu.loaded())
+		return 0;
+	
+	SaveState state;
+	p_->cpu.setStatePtrs(state);
+	return StateSaver::stateSize(state, thumbnail);
+}
+
+std::size_t GB::saveState(const gambatte::PixelType *const videoBuf, const int pitch,
+		unsigned char *const buf, const std::size_t size) {
 	if (p_->cpu.loaded()) {
 		SaveState state;
 		p_->cpu.setStatePtrs(state);
 		p_->cpu.saveState(state);
-		return StateSaver::saveState(state, videoBuf, pitch, filepath);
+		return StateSaver::saveState(state, videoBuf, pitch, buf, size);
+	}
+	return 0;
+}
+
+bool GB::loadState(const unsigned char *const buf, const std::size_t size) {
+	if (p_->cpu.loaded()) {
+		p_->cpu.saveSavedata();
+		
+		SaveState state;
+		p_->cpu.setStatePtrs(state);
+		
+		if (StateSaver::loadState(state, buf, size)) {
+			p_->cpu.loadState(state);
+			return true;
+		}
 	}
 	return false;
 }
@@ -144,6 +144,8 @@ public:
 	
 	void setSoundBuffer(uint_least32_t *const buf) { sound.setBuffer(buf); }
 	unsigned fillSoundBuffer(unsigned long cc);
+	void setSoundDecimation(unsigned shift) { sound.setDecimation(shift); }
+	unsigned soundDecimation() const { return sound.decimation(); }
 	
 	void setVideoBuffer(PixelType *const videoBuf, const int pitch) {
 		display.setVideoBuffer(videoBuf, pitch);
@@ -22,6 +22,7 @@
 namespace gambatte {
 
 class SaverList;
+class StateSaver;
 
 struct SaveState {
 	template<typename T>
@@ -36,6 +37,7 @@ struct SaveState {
 		void set(T *ptr, const unsigned long sz) { this->ptr = ptr; this->sz = sz; }
 		
 		friend class SaverList;
+		friend class StateSaver;
 		friend void setInitState(SaveState &, bool, bool);
 	};
 
@@ -18,7 +18,6 @@
  ***************************************************************************/
 #include "sound.h"
 #include "savestate.h"
-#include <cstring>
 #include <algorithm>
 
 /*
@@ -46,7 +45,7 @@ PSG::PSG()
 : buffer(0),
   lastUpdate(0),
   soVol(0),
-  rsum(0x8000), // initialize to 0x8000 to prevent borrows from high word, xor away later
+  cicPos(0),
   bufferPos(0),
   enabled(false)
 {
@@ -90,23 +89,26 @@ void PSG::loadState(const SaveState &state) {
 }
 
 void PSG::accumulate_channels(const unsigned long cycles) {
-	uint_least32_t *const buf = buffer + bufferPos;
-	
-	std::memset(buf, 0, cycles * sizeof(uint_least32_t));
-	ch1.update(buf, soVol, cycles);
-	ch2.update(buf, soVol, cycles);
-	ch3.update(buf, soVol, cycles);
-	ch4.update(buf, soVol, cycles);
+	ch1.update(cic, cicPos, soVol, cycles);
+	ch2.update(cic, cicPos, soVol, cycles);
+	ch3.update(cic, cicPos, soVol, cycles);
+	ch4.update(cic, cicPos, soVol, cycles);
 }
 
 void PSG::generate_samples(const unsigned long cycleCounter, const unsigned doubleSpeed) {
-	const unsigned long cycles = (cycleCounter - lastUpdate) >> (1 + doubleSpeed);
+	unsigned long cycles = (cycleCounter - lastUpdate) >> (1 + doubleSpeed);
 	lastUpdate += cycles << (1 + doubleSpeed);
-
-	if (cycles)
-		accumulate_channels(cycles);
 	
-	bufferPos += cycles;
+	while (cycles) {
+		const unsigned long n = std::min(cycles, cic.room(cicPos));
+		
+		accumulate_channels(n);
+		cicPos += n;
+		cycles -= n;
+		
+		if (!cic.room(cicPos))
+			bufferPos += cic.flush(buffer + bufferPos, cicPos);
+	}
 }
 
 void PSG::resetCounter(const unsigned long newCc, const unsigned long oldCc, const unsigned doubleSpeed) {
@@ -115,41 +117,7 @@ void PSG::resetCounter(const unsigned long newCc, const unsigned long oldCc, con
 }
 
 unsigned PSG::fillBuffer() {
-	uint_least32_t sum = rsum;
-	uint_least32_t *b = buffer;
-	unsigned n = bufferPos;
-	
-	if (unsigned n2 = n >> 3) {
-		n -= n2 << 3;
-		
-		do {
-			sum += b[0];
-			b[0] = sum ^ 0x8000;
-			sum += b[1];
-			b[1] = sum ^ 0x8000;
-			sum += b[2];
-			b[2] = sum ^ 0x8000;
-			sum += b[3];
-			b[3] = sum ^ 0x8000;
-			sum += b[4];
-			b[4] = sum ^ 0x8000;
-			sum += b[5];
-			b[5] = sum ^ 0x8000;
-			sum += b[6];
-			b[6] = sum ^ 0x8000;
-			sum += b[7];
-			b[7] = sum ^ 0x8000;
-			
-			b += 8;
-		} while (--n2);
-	}
-	
-	while (n--) {
-		sum += *b;
-		*b++ = sum ^ 0x8000; // xor away the initial rsum value of 0x8000 (which prevents borrows from the high word) from the low word
-	}
-	
-	rsum = sum;
+	bufferPos += cic.flush(buffer + bufferPos, cicPos);
 	
 	return bufferPos;
 }
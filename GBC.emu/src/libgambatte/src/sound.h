@@ -23,6 +23,7 @@
 #include "sound/channel2.h"
 #include "sound/channel3.h"
 #include "sound/channel4.h"
+#include "sound/cic_accumulator.h"
 
 namespace gambatte {
 
@@ -32,12 +33,13 @@ class PSG {
 	Channel3 ch3;
 	Channel4 ch4;
 		
+	CicAccumulator cic;
+	
 	uint_least32_t *buffer;
 	
 	unsigned long lastUpdate;
 	unsigned long soVol;
-	
-	uint_least32_t rsum;
+	unsigned long cicPos; // full rate samples accumulated into the current cic block
 	
 	unsigned bufferPos;
 	
@@ -57,6 +59,8 @@ public:
 	void resetCounter(unsigned long newCc, unsigned long oldCc, unsigned doubleSpeed);
 	unsigned fillBuffer();
 	void setBuffer(uint_least32_t *const buf) { buffer = buf; bufferPos = 0; }
+	void setDecimation(unsigned shift) { cic.setShift(shift); cicPos = 0; }
+	unsigned decimation() const { return cic.shift(); }
 	
 	bool isEnabled() const { return enabled; }
 	void setEnabled(bool value) { enabled = value; }
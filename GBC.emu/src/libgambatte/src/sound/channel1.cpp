@@ -215,7 +215,7 @@ void Channel1::loadState(const SaveState &state) {
 	master = state.spu.ch1.master;
 }
 
-void Channel1::update(uint_least32_t *buf, const unsigned long soBaseVol, unsigned long cycles) {
+void Channel1::update(CicAccumulator &acc, unsigned long pos, const unsigned long soBaseVol, unsigned long cycles) {
 	const unsigned long outBase = envelopeUnit.dacIsOn() ? soBaseVol & soMask : 0;
 	const unsigned long outLow = outBase * (0 - 15ul);
 	const unsigned long endCycles = cycleCounter + cycles;
@@ -226,9 +226,9 @@ void Channel1::update(uint_least32_t *buf, const unsigned long soBaseVol, unsign
 		unsigned long out = dutyUnit.isHighState() ? outHigh : outLow;
 		
 		while (dutyUnit.getCounter() <= nextMajorEvent) {
-			*buf = out - prevOut;
+			acc.add(pos, out - prevOut);
 			prevOut = out;
-			buf += dutyUnit.getCounter() - cycleCounter;
+			pos += dutyUnit.getCounter() - cycleCounter;
 			cycleCounter = dutyUnit.getCounter();
 			
 			dutyUnit.event();
@@ -236,9 +236,9 @@ void Channel1::update(uint_least32_t *buf, const unsigned long soBaseVol, unsign
 		}
 		
 		if (cycleCounter < nextMajorEvent) {
-			*buf = out - prevOut;
+			acc.add(pos, out - prevOut);
 			prevOut = out;
-			buf += nextMajorEvent - cycleCounter;
+			pos += nextMajorEvent - cycleCounter;
 			cycleCounter = nextMajorEvent;
 		}
 		
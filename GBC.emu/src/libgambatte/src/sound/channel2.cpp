@@ -119,7 +119,7 @@ void Channel2::loadState(const SaveState &state) {
 	master = state.spu.ch2.master;
 }
 
-void Channel2::update(uint_least32_t *buf, const unsigned long soBaseVol, unsigned long cycles) {
+void Channel2::update(CicAccumulator &acc, unsigned long pos, const unsigned long soBaseVol, unsigned long cycles) {
 	const unsigned long outBase = envelopeUnit.dacIsOn() ? soBaseVol & soMask : 0;
 	const unsigned long outLow = outBase * (0 - 15ul);
 	const unsigned long endCycles = cycleCounter + cycles;
@@ -130,9 +130,9 @@ void Channel2::update(uint_least32_t *buf, const unsigned long soBaseVol, unsign
 		unsigned long out = dutyUnit.isHighState() ? outHigh : outLow;
 		
 		while (dutyUnit.getCounter() <= nextMajorEvent) {
-			*buf += out - prevOut;
+			acc.add(pos, out - prevOut);
 			prevOut = out;
-			buf += dutyUnit.getCounter() - cycleCounter;
+			pos += dutyUnit.getCounter() - cycleCounter;
 			cycleCounter = dutyUnit.getCounter();
 			
 			dutyUnit.event();
@@ -140,9 +140,9 @@ void Channel2::update(uint_least32_t *buf, const unsigned long soBaseVol, unsign
 		}
 		
 		if (cycleCounter < nextMajorEvent) {
-			*buf += out - prevOut;
+			acc.add(pos, out - prevOut);
 			prevOut = out;
-			buf += nextMajorEvent - cycleCounter;
+			pos += nextMajorEvent - cycleCounter;
 			cycleCounter = nextMajorEvent;
 		}
 		
@@ -24,6 +24,7 @@
 #include "duty_unit.h"
 #include "envelope_unit.h"
 #include "static_output_tester.h"
+#include "cic_accumulator.h"
 
 namespace gambatte {
 
@@ -60,7 +61,7 @@ public:
 	// void deactivate() { disableMaster(); setEvent(); }
 	bool isActive() const { return master; }
 	
-	void update(uint_least32_t *buf, unsigned long soBaseVol, unsigned long cycles);
+	void update(CicAccumulator &acc, unsigned long pos, unsigned long soBaseVol, unsigned long cycles);
 	
 	void reset();
 	void init(bool cgb);
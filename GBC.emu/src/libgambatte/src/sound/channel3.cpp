@@ -143,7 +143,7 @@ void Channel3::updateWaveCounter(const unsigned long cc) {
 	}
 }
 
-void Channel3::update(uint_least32_t *buf, const unsigned long soBaseVol, unsigned long cycles) {
+void Channel3::update(CicAccumulator &acc, unsigned long pos, const unsigned long soBaseVol, unsigned long cycles) {
 	const unsigned long outBase = (nr0/* & 0x80*/) ? soBaseVol & soMask : 0;
 	
 	if (outBase && rShift != 4) {
@@ -154,9 +154,9 @@ void Channel3::update(uint_least32_t *buf, const unsigned long soBaseVol, unsign
 			unsigned long out = outBase * (master ? ((sampleBuf >> (~wavePos << 2 & 4) & 0xF) >> rShift) * 2 - 15ul : 0 - 15ul);
 		
 			while (waveCounter <= nextMajorEvent) {
-				*buf += out - prevOut;
+				acc.add(pos, out - prevOut);
 				prevOut = out;
-				buf += waveCounter - cycleCounter;
+				pos += waveCounter - cycleCounter;
 				cycleCounter = waveCounter;
 			
 				lastReadTime = waveCounter;
@@ -168,9 +168,9 @@ void Channel3::update(uint_least32_t *buf, const unsigned long soBaseVol, unsign
 			}
 		
 			if (cycleCounter < nextMajorEvent) {
-				*buf += out - prevOut;
+				acc.add(pos, out - prevOut);
 				prevOut = out;
-				buf += nextMajorEvent - cycleCounter;
+				pos += nextMajorEvent - cycleCounter;
 				cycleCounter = nextMajorEvent;
 			}
 		
@@ -183,7 +183,7 @@ void Channel3::update(uint_least32_t *buf, const unsigned long soBaseVol, unsign
 		if (outBase) {
 			const unsigned long out = outBase * (0 - 15ul);
 			
-			*buf += out - prevOut;
+			acc.add(pos, out - prevOut);
 			prevOut = out;
 		}
 		
@@ -22,6 +22,7 @@
 #include "gbint.h"
 #include "master_disabler.h"
 #include "length_counter.h"
+#include "cic_accumulator.h"
 
 namespace gambatte {
 
@@ -73,7 +74,7 @@ public:
 	void setNr3(unsigned data) { nr3 = data; }
 	void setNr4(unsigned data);
 	void setSo(unsigned long soMask);
-	void update(uint_least32_t *buf, unsigned long soBaseVol, unsigned long cycles);
+	void update(CicAccumulator &acc, unsigned long pos, unsigned long soBaseVol, unsigned long cycles);
 	
 	unsigned waveRamRead(unsigned index) const {
 		if (master) {
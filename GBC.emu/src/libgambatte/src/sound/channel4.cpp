@@ -258,7 +258,7 @@ void Channel4::loadState(const SaveState &state) {
 	master = state.spu.ch4.master;
 }
 
-void Channel4::update(uint_least32_t *buf, const unsigned long soBaseVol, unsigned long cycles) {
+void Channel4::update(CicAccumulator &acc, unsigned long pos, const unsigned long soBaseVol, unsigned long cycles) {
 	const unsigned long outBase = envelopeUnit.dacIsOn() ? soBaseVol & soMask : 0;
 	const unsigned long outLow = outBase * (0 - 15ul);
 	const unsigned long endCycles = cycleCounter + cycles;
@@ -269,9 +269,9 @@ void Channel4::update(uint_least32_t *buf, const unsigned long soBaseVol, unsign
 		unsigned long out = lfsr.isHighState() ? outHigh : outLow;
 		
 		while (lfsr.getCounter() <= nextMajorEvent) {
-			*buf += out - prevOut;
+			acc.add(pos, out - prevOut);
 			prevOut = out;
-			buf += lfsr.getCounter() - cycleCounter;
+			pos += lfsr.getCounter() - cycleCounter;
 			cycleCounter = lfsr.getCounter();
 			
 			lfsr.event();
@@ -279,9 +279,9 @@ void Channel4::update(uint_least32_t *buf, const unsigned long soBaseVol, unsign
 		}
 		
 		if (cycleCounter < nextMajorEvent) {
-			*buf += out - prevOut;
+			acc.add(pos, out - prevOut);
 			prevOut = out;
-			buf += nextMajorEvent - cycleCounter;
+			pos += nextMajorEvent - cycleCounter;
 			cycleCounter = nextMajorEvent;
 		}
 		
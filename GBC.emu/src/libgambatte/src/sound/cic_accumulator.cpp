@@ -0,0 +1,78 @@
+/*  This file is part of GBC.emu.
+
+	GBC.emu is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License version 2 as
+	published by the Free Software Foundation, like the rest of libgambatte.
+
+	GBC.emu is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License version 2 for more details.
+
+	You should have received a copy of the GNU General Public License
+	version 2 along with GBC.emu.  If not, see <http://www.gnu.org/licenses/> */
+#include "cic_accumulator.h"
+#include <cstring>
+
+namespace gambatte {
+
+CicAccumulator::CicAccumulator() : shift_(0) {
+	std::memset(acc, 0, sizeof acc);
+	sum[0] = sum[1] = 0;
+	setShift(0);
+}
+
+void CicAccumulator::setShift(const unsigned shift) {
+	const unsigned newShift = shift > MAX_SHIFT ? static_cast<unsigned>(MAX_SHIFT) : shift;
+
+	// fold pending changes into the running sums so the output level carries over
+	for (unsigned i = 0; i < (BLOCK_SAMPLES + 4) * 2; i += 2) {
+		sum[0] += acc[i];
+		sum[1] += acc[i + 1];
+	}
+
+	std::memset(acc, 0, sizeof acc);
+	sum[0] = (sum[0] >> shift_ * 2) * (1l << newShift * 2);
+	sum[1] = (sum[1] >> shift_ * 2) * (1l << newShift * 2);
+	shift_ = newShift;
+
+	// A level change at offset r into an output period of div samples reaches
+	// sum(tri[0..div-1-r]) of the first boxcar^2 window (tri = 1, 2, .., div, .., 2, 1),
+	// sum(tri[0..2*div-1-r]) of the next, and all div^2 of the ones after.
+	const long div = 1l << newShift;
+
+	for (long r = 0; r < div; ++r) {
+		const long first = (div - r) * (div - r + 1) / 2;
+		const long second = div * (div + 1) / 2 + (div - 1 + r) * (div - r) / 2;
+
+		weights[r * 3    ] = first;
+		weights[r * 3 + 1] = second - first;
+		weights[r * 3 + 2] = div * div - second;
+	}
+}
+
+unsigned CicAccumulator::flush(uint_least32_t *const out, unsigned long &pos) {
+	const unsigned n = pos >> shift_;
+	const unsigned scale = shift_ * 2;
+	const long round = (1l << scale) >> 1;
+	long s0 = sum[0];
+	long s1 = sum[1];
+
+	for (unsigned i = 0; i < n; ++i) {
+		s0 += acc[i * 2];
+		s1 += acc[i * 2 + 1];
+		out[i] = ((s0 + round) >> scale & 0xFFFF) | ((s1 + round) >> scale & 0xFFFF) << 16;
+	}
+
+	sum[0] = s0;
+	sum[1] = s1;
+
+	// the changes of the last period can still reach two periods further
+	std::memmove(acc, acc + n * 2, 6 * sizeof *acc);
+	std::memset(acc + 6, 0, n * 2 * sizeof *acc);
+	pos -= static_cast<unsigned long>(n) << shift_;
+
+	return n;
+}
+
+}
@@ -0,0 +1,75 @@
+/*  This file is part of GBC.emu.
+
+	GBC.emu is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License version 2 as
+	published by the Free Software Foundation, like the rest of libgambatte.
+
+	GBC.emu is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License version 2 for more details.
+
+	You should have received a copy of the GNU General Public License
+	version 2 along with GBC.emu.  If not, see <http://www.gnu.org/licenses/> */
+#ifndef SOUND_CIC_ACCUMULATOR_H
+#define SOUND_CIC_ACCUMULATOR_H
+
+#include "gbint.h"
+
+namespace gambatte {
+
+/** Second order CIC decimator fed directly with the output level changes of the channels.
+  *
+  * The channels only change their output at duty/wave/lfsr steps, so instead of filtering
+  * every 2 MiHz sample, each change is spread over the (at most) three decimated samples whose
+  * boxcar^2 window covers it, with weights that depend on where in the window it lands.
+  * The weights of a change sum to div^2, so the integrated sum stays exact and is
+  * scaled down when samples are written out. With a shift of 0 the output equals the
+  * undecimated integrated channel output.
+  */
+class CicAccumulator {
+public:
+	enum { MAX_SHIFT = 5 };
+	enum { BLOCK_SAMPLES = 256 };
+
+	CicAccumulator();
+	void setShift(unsigned shift);
+	unsigned shift() const { return shift_; }
+
+	/** Number of full rate samples that can be added past 'pos' before flush() is needed. */
+	unsigned long room(const unsigned long pos) const { return (static_cast<unsigned long>(BLOCK_SAMPLES) << shift_) - pos; }
+
+	/** Adds a packed stereo level change at full rate sample position 'pos' of the current block. */
+	void add(const unsigned long pos, const uint_least32_t delta) {
+		if (delta) {
+			const long lo = static_cast<long>((delta & 0xFFFF) ^ 0x8000) - 0x8000;
+			const long hi = static_cast<long>(((delta - static_cast<uint_least32_t>(lo)) >> 16 & 0xFFFF) ^ 0x8000) - 0x8000;
+			long *const a = acc + (pos >> shift_) * 2;
+			const long *const w = weights + (pos & ((1ul << shift_) - 1)) * 3;
+
+			a[0] += lo * w[0];
+			a[1] += hi * w[0];
+			a[2] += lo * w[1];
+			a[3] += hi * w[1];
+			a[4] += lo * w[2];
+			a[5] += hi * w[2];
+		}
+	}
+
+	/** Writes the samples completed before full rate position 'pos' to 'out' as packed stereo,
+	  * and moves the remainder to the start of the block.
+	  *
+	  * @return number of samples written
+	  */
+	unsigned flush(uint_least32_t *out, unsigned long &pos);
+
+private:
+	long acc[(BLOCK_SAMPLES + 4) * 2];
+	long weights[(1 << MAX_SHIFT) * 3];
+	long sum[2];
+	unsigned shift_;
+};
+
+}
+
+#endif
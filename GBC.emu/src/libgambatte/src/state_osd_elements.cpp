@@ -132,8 +132,20 @@ life(4 * 60) {
 	std::ifstream file(fileName.c_str(), std::ios_base::binary);
 	
 	if (file.is_open()) {
-		file.ignore(5);
-		file.read(reinterpret_cast<char*>(pixels), sizeof pixels);
+		// buffer states start with a tag, older ones with a zero version byte
+		if (file.peek() == 'G') {
+			unsigned char header[StateSaver::BUF_HEADER_SIZE];
+			file.read(reinterpret_cast<char*>(header), sizeof header);
+			
+			if (StateSaver::isBufferState(header, file.gcount()) && StateSaver::hasThumbnail(header)) {
+				file.ignore(StateSaver::thumbnailOffset() - sizeof header);
+				file.read(reinterpret_cast<char*>(pixels), sizeof pixels);
+			} else
+				std::memset(pixels, 0, sizeof pixels);
+		} else {
+			file.ignore(5);
+			file.read(reinterpret_cast<char*>(pixels), sizeof pixels);
+		}
 	} else {
 		std::memset(pixels, 0, sizeof pixels);
 		
@@ -467,3 +467,394 @@ bool StateSaver::loadState(SaveState &state, const std::string &filename) {
 }
 
 }
+
+namespace {
+
+using namespace gambatte;
+
+enum { BUFSTATE_VERSION = 2 };
+enum { BUFSTATE_THUMBNAIL = 1 }; // header flags
+
+#define SECTION_ID(a, b, c, d) ((a) | (b) << 8 | (c) << 16 | (unsigned long)(d) << 24)
+
+static const unsigned long bufStateMagic = SECTION_ID(G, B, S, T);
+static const std::size_t headerSize = StateSaver::BUF_HEADER_SIZE;
+static const std::size_t sectionHeaderSize = 8;
+
+template<typename T> struct IsBool { enum { value = 0 }; };
+template<> struct IsBool<bool> { enum { value = 1 }; };
+
+// A SaveState member stored as count little endian values of at most 4 bytes
+struct Field {
+	unsigned short offset;
+	unsigned char size;
+	unsigned char count;
+	bool isBool;
+	
+	unsigned width() const { return size > 4 ? 4 : size; }
+};
+
+#define FIELD(m) { offsetof(SaveState, m), sizeof(((SaveState*)0)->m), 1, \
+	IsBool<__typeof__(((SaveState*)0)->m)>::value }
+#define FIELDARRAY(m) { offsetof(SaveState, m), sizeof(((SaveState*)0)->m[0]), \
+	sizeof(((SaveState*)0)->m) / sizeof(((SaveState*)0)->m[0]), 0 }
+
+static const Field cpuFields[] = {
+	FIELD(cpu.cycleCounter), FIELD(cpu.PC), FIELD(cpu.SP),
+	FIELD(cpu.A), FIELD(cpu.B), FIELD(cpu.C), FIELD(cpu.D),
+	FIELD(cpu.E), FIELD(cpu.F), FIELD(cpu.H), FIELD(cpu.L),
+	FIELD(cpu.skip)
+};
+
+static const Field memFields[] = {
+	FIELD(mem.divLastUpdate), FIELD(mem.timaLastUpdate), FIELD(mem.tmatime),
+	FIELD(mem.nextSerialtime), FIELD(mem.lastOamDmaUpdate), FIELD(mem.minIntTime),
+	FIELD(mem.unhaltTime), FIELD(mem.rombank), FIELD(mem.dmaSource),
+	FIELD(mem.dmaDestination), FIELD(mem.rambank), FIELD(mem.oamDmaPos),
+	FIELD(mem.IME), FIELD(mem.halted), FIELD(mem.enableRam),
+	FIELD(mem.rambankMode), FIELD(mem.hdmaTransfer)
+};
+
+static const Field ppuFields[] = {
+	FIELD(ppu.videoCycles), FIELD(ppu.enableDisplayM0Time), FIELD(ppu.lastM0Time),
+	FIELD(ppu.nextM0Irq), FIELD(ppu.tileword), FIELD(ppu.ntileword),
+	FIELDARRAY(ppu.spAttribList), FIELDARRAY(ppu.spByte0List), FIELDARRAY(ppu.spByte1List),
+	FIELD(ppu.winYPos), FIELD(ppu.xpos), FIELD(ppu.endx),
+	FIELD(ppu.reg0), FIELD(ppu.reg1), FIELD(ppu.attrib),
+	FIELD(ppu.nattrib), FIELD(ppu.state), FIELD(ppu.nextSprite),
+	FIELD(ppu.currentSprite), FIELD(ppu.lyc), FIELD(ppu.m0lyc),
+	FIELD(ppu.oldWy), FIELD(ppu.winDrawState), FIELD(ppu.wscx),
+	FIELD(ppu.weMaster), FIELD(ppu.pendingLcdstatIrq)
+};
+
+static const Field spuFields[] = {
+	FIELD(spu.cycleCounter),
+	FIELD(spu.ch1.sweep.counter), FIELD(spu.ch1.sweep.shadow), FIELD(spu.ch1.sweep.nr0),
+	FIELD(spu.ch1.sweep.negging), FIELD(spu.ch1.duty.nextPosUpdate), FIELD(spu.ch1.duty.nr3),
+	FIELD(spu.ch1.duty.pos), FIELD(spu.ch1.env.counter), FIELD(spu.ch1.env.volume),
+	FIELD(spu.ch1.lcounter.counter), FIELD(spu.ch1.lcounter.lengthCounter),
+	FIELD(spu.ch1.nr4), FIELD(spu.ch1.master),
+	FIELD(spu.ch2.duty.nextPosUpdate), FIELD(spu.ch2.duty.nr3), FIELD(spu.ch2.duty.pos),
+	FIELD(spu.ch2.env.counter), FIELD(spu.ch2.env.volume),
+	FIELD(spu.ch2.lcounter.counter), FIELD(spu.ch2.lcounter.lengthCounter),
+	FIELD(spu.ch2.nr4), FIELD(spu.ch2.master),
+	FIELD(spu.ch3.lcounter.counter), FIELD(spu.ch3.lcounter.lengthCounter),
+	FIELD(spu.ch3.waveCounter), FIELD(spu.ch3.lastReadTime), FIELD(spu.ch3.nr3),
+	FIELD(spu.ch3.nr4), FIELD(spu.ch3.wavePos), FIELD(spu.ch3.sampleBuf),
+	FIELD(spu.ch3.master),
+	FIELD(spu.ch4.lfsr.counter), FIELD(spu.ch4.lfsr.reg),
+	FIELD(spu.ch4.env.counter), FIELD(spu.ch4.env.volume),
+	FIELD(spu.ch4.lcounter.counter), FIELD(spu.ch4.lcounter.lengthCounter),
+	FIELD(spu.ch4.nr4), FIELD(spu.ch4.master)
+};
+
+static const Field rtcFields[] = {
+	FIELD(rtc.baseTime), FIELD(rtc.haltTime), FIELD(rtc.dataDh),
+	FIELD(rtc.dataDl), FIELD(rtc.dataH), FIELD(rtc.dataM),
+	FIELD(rtc.dataS), FIELD(rtc.lastLatchData)
+};
+
+#undef FIELD
+#undef FIELDARRAY
+
+struct FieldSection {
+	unsigned long id;
+	const Field *fields;
+	unsigned count;
+	
+	std::size_t size() const {
+		std::size_t sz = 0;
+		
+		for (unsigned i = 0; i < count; ++i)
+			sz += fields[i].width() * fields[i].count;
+		
+		return sz;
+	}
+};
+
+#define SECTION(id, fields) { id, fields, sizeof(fields) / sizeof(fields[0]) }
+
+static const FieldSection fieldSections[] = {
+	SECTION(SECTION_ID(C, P, U, SP), cpuFields),
+	SECTION(SECTION_ID(M, E, M, SP), memFields),
+	SECTION(SECTION_ID(P, P, U, SP), ppuFields),
+	SECTION(SECTION_ID(S, P, U, SP), spuFields),
+	SECTION(SECTION_ID(R, T, C, SP), rtcFields)
+};
+
+#undef SECTION
+
+enum {
+	SEC_THUMB = SECTION_ID(T, H, M, B),
+	SEC_VRAM = SECTION_ID(V, R, A, M),
+	SEC_SRAM = SECTION_ID(S, R, A, M),
+	SEC_WRAM = SECTION_ID(W, R, A, M),
+	SEC_HRAM = SECTION_ID(H, R, A, M),
+	SEC_BGP = SECTION_ID(B, G, P, SP),
+	SEC_OBJP = SECTION_ID(O, B, J, P),
+	SEC_OAMBUF = SECTION_ID(O, A, M, B),
+	SEC_OAMSZBUF = SECTION_ID(O, A, M, S),
+	SEC_WAVE = SECTION_ID(W, A, V, E)
+};
+
+static const unsigned fieldSectionCount = sizeof(fieldSections) / sizeof(fieldSections[0]);
+static const unsigned ptrSectionCount = 9;
+
+static void put32le(unsigned char *out, unsigned long v) {
+	out[0] = v & 0xFF;
+	out[1] = v >> 8 & 0xFF;
+	out[2] = v >> 16 & 0xFF;
+	out[3] = v >> 24 & 0xFF;
+}
+
+static unsigned long get32le(const unsigned char *in) {
+	return in[0] | in[1] << 8 | in[2] << 16 | static_cast<unsigned long>(in[3]) << 24;
+}
+
+static unsigned char * putSectionHeader(unsigned char *out, unsigned long id, std::size_t size) {
+	put32le(out, id);
+	put32le(out + 4, size);
+	return out + sectionHeaderSize;
+}
+
+static unsigned char * putFields(unsigned char *out, const SaveState &state, const FieldSection &sec) {
+	for (unsigned i = 0; i < sec.count; ++i) {
+		const Field &f = sec.fields[i];
+		const unsigned char *src = reinterpret_cast<const unsigned char*>(&state) + f.offset;
+		
+		for (unsigned n = 0; n < f.count; ++n, src += f.size) {
+			unsigned long v;
+			
+			switch (f.size) {
+			case 1: v = *src; break;
+			case 2: v = *reinterpret_cast<const unsigned short*>(src); break;
+			default: v = *reinterpret_cast<const unsigned long*>(src); break;
+			}
+			
+			for (unsigned b = 0; b < f.width(); ++b)
+				*out++ = v >> b * 8 & 0xFF;
+		}
+	}
+	
+	return out;
+}
+
+static void getFields(SaveState &state, const unsigned char *in, const FieldSection &sec) {
+	for (unsigned i = 0; i < sec.count; ++i) {
+		const Field &f = sec.fields[i];
+		unsigned char *dst = reinterpret_cast<unsigned char*>(&state) + f.offset;
+		
+		for (unsigned n = 0; n < f.count; ++n, dst += f.size) {
+			unsigned long v = 0;
+			
+			for (unsigned b = 0; b < f.width(); ++b)
+				v |= static_cast<unsigned long>(*in++) << b * 8;
+			
+			switch (f.size) {
+			case 1:
+				if (f.isBool)
+					*reinterpret_cast<bool*>(dst) = v;
+				else
+					*dst = v;
+				break;
+			case 2: *reinterpret_cast<unsigned short*>(dst) = v; break;
+			default: *reinterpret_cast<unsigned long*>(dst) = v; break;
+			}
+		}
+	}
+}
+
+// 4x4 box filter. The color channels are spread out in a word with enough
+// headroom between them to sum 16 pixels at once.
+static void writeThumbnail(PixelType *out, const PixelType *pixels, const int pitch) {
+	for (unsigned h = StateSaver::SS_HEIGHT; h--; pixels += pitch * StateSaver::SS_DIV) {
+		for (unsigned x = 0; x < StateSaver::SS_WIDTH; ++x) {
+			const PixelType *p = pixels + x * StateSaver::SS_DIV;
+			
+			if (usingRGB565Color) {
+				uint_least32_t sum = 0;
+				
+				for (unsigned y = 0; y < StateSaver::SS_DIV; ++y, p += pitch) {
+					for (unsigned i = 0; i < StateSaver::SS_DIV; ++i)
+						sum += (p[i] | static_cast<uint_least32_t>(p[i]) << 16) & 0x07E0F81F;
+				}
+				
+				sum = sum >> 4 & 0x07E0F81F;
+				*out++ = (sum & 0xF81F) | (sum >> 16 & 0x07E0);
+			} else {
+				uint_least32_t rb = 0, g = 0;
+				
+				for (unsigned y = 0; y < StateSaver::SS_DIV; ++y, p += pitch) {
+					for (unsigned i = 0; i < StateSaver::SS_DIV; ++i) {
+						rb += p[i] & 0xFF00FF;
+						g += p[i] & 0x00FF00;
+					}
+				}
+				
+				*out++ = (rb >> 4 & 0xFF00FF) | (g >> 4 & 0x00FF00);
+			}
+		}
+	}
+}
+
+} // anon namespace
+
+namespace gambatte {
+
+#define PTR_SECTIONS(state) { \
+	{ SEC_VRAM, &state.mem.vram }, \
+	{ SEC_SRAM, &state.mem.sram }, \
+	{ SEC_WRAM, &state.mem.wram }, \
+	{ SEC_HRAM, &state.mem.ioamhram }, \
+	{ SEC_BGP, &state.ppu.bgpData }, \
+	{ SEC_OBJP, &state.ppu.objpData }, \
+	{ SEC_OAMBUF, &state.ppu.oamReaderBuf }, \
+	{ SEC_WAVE, &state.spu.ch3.waveRam } \
+}
+
+std::size_t StateSaver::stateSize(const SaveState &state, const bool thumbnail) {
+	std::size_t sz = headerSize + (fieldSectionCount + ptrSectionCount) * sectionHeaderSize;
+	
+	if (thumbnail)
+		sz += sectionHeaderSize + SS_THUMB_SIZE;
+	
+	for (unsigned i = 0; i < fieldSectionCount; ++i)
+		sz += fieldSections[i].size();
+	
+	const struct { unsigned long id; const SaveState::Ptr<unsigned char> *ptr; } ptrs[] = PTR_SECTIONS(state);
+	
+	for (unsigned i = 0; i < sizeof(ptrs) / sizeof(ptrs[0]); ++i)
+		sz += ptrs[i].ptr->getSz();
+	
+	return sz + state.ppu.oamReaderSzbuf.getSz();
+}
+
+std::size_t StateSaver::saveState(const SaveState &state,
+		const PixelType *const videoBuf, const int pitch,
+		unsigned char *const buf, const std::size_t bufSize) {
+	const std::size_t sz = stateSize(state, videoBuf);
+	
+	if (bufSize < sz)
+		return 0;
+	
+	put32le(buf, bufStateMagic);
+	put32le(buf + 4, BUFSTATE_VERSION);
+	put32le(buf + 8, sz);
+	put32le(buf + 12, videoBuf ? BUFSTATE_THUMBNAIL : 0);
+	unsigned char *out = buf + headerSize;
+	
+	if (videoBuf) {
+		out = putSectionHeader(out, SEC_THUMB, SS_THUMB_SIZE);
+		PixelType thumb[SS_WIDTH * SS_HEIGHT];
+		writeThumbnail(thumb, videoBuf, pitch);
+		std::memcpy(out, thumb, SS_THUMB_SIZE);
+		out += SS_THUMB_SIZE;
+	}
+	
+	for (unsigned i = 0; i < fieldSectionCount; ++i) {
+		out = putSectionHeader(out, fieldSections[i].id, fieldSections[i].size());
+		out = putFields(out, state, fieldSections[i]);
+	}
+	
+	const struct { unsigned long id; const SaveState::Ptr<unsigned char> *ptr; } ptrs[] = PTR_SECTIONS(state);
+	
+	for (unsigned i = 0; i < sizeof(ptrs) / sizeof(ptrs[0]); ++i) {
+		out = putSectionHeader(out, ptrs[i].id, ptrs[i].ptr->getSz());
+		std::memcpy(out, ptrs[i].ptr->get(), ptrs[i].ptr->getSz());
+		out += ptrs[i].ptr->getSz();
+	}
+	
+	out = putSectionHeader(out, SEC_OAMSZBUF, state.ppu.oamReaderSzbuf.getSz());
+	
+	for (unsigned long i = 0; i < state.ppu.oamReaderSzbuf.getSz(); ++i)
+		*out++ = state.ppu.oamReaderSzbuf.get()[i];
+	
+	return sz;
+}
+
+bool StateSaver::isBufferState(const unsigned char *const buf, const std::size_t size) {
+	return size >= headerSize && get32le(buf) == bufStateMagic;
+}
+
+bool StateSaver::hasThumbnail(const unsigned char *const header) {
+	return get32le(header + 4) == BUFSTATE_VERSION && (get32le(header + 12) & BUFSTATE_THUMBNAIL);
+}
+
+// Returns a bit per field section followed by a bit per pointer section for
+// each section found, or 0 if the section list is malformed or a section isn't
+// the size this emulator state has. Nothing is copied into state unless apply
+// is set, the pointers in it refer to live emulator memory.
+unsigned long StateSaver::readSections(SaveState &state, const unsigned char *in,
+		const unsigned char *const end, const bool apply) {
+	const struct { unsigned long id; SaveState::Ptr<unsigned char> *ptr; } ptrs[] = PTR_SECTIONS(state);
+	unsigned long found = 0;
+	
+	while (end - in >= static_cast<std::ptrdiff_t>(sectionHeaderSize)) {
+		const unsigned long id = get32le(in);
+		const std::size_t secSize = get32le(in + 4);
+		in += sectionHeaderSize;
+		
+		if (secSize > static_cast<std::size_t>(end - in))
+			return 0;
+		
+		for (unsigned i = 0; i < fieldSectionCount; ++i) {
+			if (id == fieldSections[i].id) {
+				if (secSize != fieldSections[i].size())
+					return 0;
+				
+				if (apply)
+					getFields(state, in, fieldSections[i]);
+				
+				found |= 1ul << i;
+			}
+		}
+		
+		for (unsigned i = 0; i < sizeof(ptrs) / sizeof(ptrs[0]); ++i) {
+			if (id == ptrs[i].id) {
+				if (secSize != ptrs[i].ptr->getSz())
+					return 0;
+				
+				if (apply)
+					std::memcpy(ptrs[i].ptr->ptr, in, secSize);
+				
+				found |= 1ul << (fieldSectionCount + i);
+			}
+		}
+		
+		if (id == SEC_OAMSZBUF) {
+			if (secSize != state.ppu.oamReaderSzbuf.getSz())
+				return 0;
+			
+			if (apply) {
+				for (std::size_t i = 0; i < secSize; ++i)
+					state.ppu.oamReaderSzbuf.ptr[i] = in[i];
+			}
+			
+			found |= 1ul << (fieldSectionCount + ptrSectionCount - 1);
+		}
+		
+		in += secSize;
+	}
+	
+	return found;
+}
+
+bool StateSaver::loadState(SaveState &state, const unsigned char *const buf, const std::size_t size) {
+	if (!isBufferState(buf, size) || get32le(buf + 4) != BUFSTATE_VERSION || get32le(buf + 8) > size)
+		return false;
+	
+	const unsigned char *const end = buf + get32le(buf + 8);
+	
+	if (readSections(state, buf + headerSize, end, false) != (1ul << (fieldSectionCount + ptrSectionCount)) - 1)
+		return false;
+	
+	readSections(state, buf + headerSize, end, true);
+	state.cpu.cycleCounter &= 0x7FFFFFFF;
+	state.spu.cycleCounter &= 0x7FFFFFFF;
+	
+	return true;
+}
+
+#undef PTR_SECTIONS
+
+}
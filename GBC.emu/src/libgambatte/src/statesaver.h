@@ -21,6 +21,7 @@
 
 #include "gbint.h"
 #include <string>
+#include <cstddef>
 
 namespace gambatte {
 
@@ -28,6 +29,8 @@ struct SaveState;
 
 class StateSaver {
 	StateSaver();
+	static unsigned long readSections(SaveState &state, const unsigned char *in,
+			const unsigned char *end, bool apply);
 	
 public:
 	enum { SS_SHIFT = 2 };
@@ -35,9 +38,24 @@ public:
 	enum { SS_WIDTH = 160 >> SS_SHIFT };
 	enum { SS_HEIGHT = 144 >> SS_SHIFT };
 	
+	enum { SS_THUMB_SIZE = SS_WIDTH * SS_HEIGHT * sizeof(PixelType) };
+	
 	static bool saveState(const SaveState &state,
 			const PixelType *videoBuf, int pitch, const std::string &filename);
 	static bool loadState(SaveState &state, const std::string &filename);
+	
+	// Fixed layout states held in memory: a versioned header followed by
+	// tagged sections, each loaded with a bounds checked copy. The thumbnail
+	// is only stored if videoBuf isn't 0, hasThumbnail() tells from the header.
+	enum { BUF_HEADER_SIZE = 16 };
+	
+	static std::size_t stateSize(const SaveState &state, bool thumbnail);
+	static std::size_t saveState(const SaveState &state,
+			const PixelType *videoBuf, int pitch, unsigned char *buf, std::size_t bufSize);
+	static bool loadState(SaveState &state, const unsigned char *buf, std::size_t size);
+	static bool isBufferState(const unsigned char *buf, std::size_t size);
+	static bool hasThumbnail(const unsigned char *header);
+	static std::size_t thumbnailOffset() { return BUF_HEADER_SIZE + 8; }
 };
 
 }
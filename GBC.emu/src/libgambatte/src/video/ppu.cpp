@@ -100,6 +100,10 @@ namespace M3Loop {
 
 #undef DECLARE_FUNC
 
+namespace M3Loop {
+	static bool renderFullLine(PPUPriv &p);
+}
+
 enum { WIN_DRAW_START = 1, WIN_DRAW_STARTED = 2 };
 
 enum { M2_DS_OFFSET = 3 };
@@ -206,6 +210,9 @@ namespace M3Start {
 		} else
 			p.winDrawState = 0;
 		
+		if (M3Loop::renderFullLine(p))
+			return;
+		
 		p.nextCallPtr = &f1_;
 		f1(p);
 	}
@@ -1448,6 +1455,124 @@ namespace M2 {
 	}
 }
 
+namespace M3Loop {
+	// Renders all of mode 3 at once when the cycles available reach past its end and the
+	// window can't start on this line. Register, VRAM, OAM and palette writes all update
+	// the PPU before taking effect, so a line with mid-line writes runs out of cycles
+	// before xpos 168 and is left to the state machine above. The mode 3 length comes
+	// from the same prediction used for the m0 time, so timing is unaffected.
+	static bool renderFullLine(PPUPriv &p) {
+		const unsigned ly = p.lyCounter.ly();
+		
+		// mode 3 is at least 167 cycles
+		if (p.cycles <= 167 || p.winDrawState
+				|| (p.wx < 167 && (p.weMaster || (p.wy2 == ly && (p.lcdc & 0x20))))) {
+			return false;
+		}
+		
+		const long m3cycles = M3Start::predictCyclesUntilXpos_f1(p, 0, ly, p.weMaster, p.winDrawState, 167, 0);
+		
+		if (p.cycles <= m3cycles)
+			return false;
+		
+		PixelType *const fbline = p.framebuf.fbline();
+		const unsigned fine = p.scx & 7;
+		const unsigned twmask = ((p.lcdc & 1) | p.cgb) * 3;
+		unsigned short tilewords[21];
+		unsigned char tileattribs[21];
+		
+		{
+			// the partially visible first and last tiles go through edgebuf
+			PixelType edgebuf[16];
+			const unsigned bgy = (p.scy + ly) & 0xFF;
+			const unsigned tileline = bgy & 7;
+			const unsigned tileIndexSign = ~p.lcdc << 3 & 0x80;
+			const unsigned char *const tileMapLine = p.vram + (p.lcdc << 7 & 0x400) + (bgy & 0xF8) * 4 + 0x1800;
+			const unsigned char *const tileData = p.vram + tileIndexSign * 32;
+			unsigned tileMapXpos = p.scx >> 3;
+			
+			for (unsigned n = 0; n < 21; ++n) {
+				PixelType *const dst = n == 0 ? edgebuf : n == 20 ? edgebuf + 8 : fbline + n * 8 - fine;
+				const unsigned tmxpos = tileMapXpos++ & 0x1F;
+				const unsigned tno    = tileMapLine[tmxpos];
+				const unsigned attrib = p.cgb ? tileMapLine[tmxpos + 0x2000] : 0;
+				const unsigned char *const td = tileData + (attrib << 10 & 0x2000) + tno * 16
+						- (tno & tileIndexSign) * 32 + ((attrib & 0x40) ? tileline ^ 7 : tileline) * 2;
+				const unsigned tileword = (expand_lut + (attrib << 3 & 0x100))[td[0]]
+				                        + (expand_lut + (attrib << 3 & 0x100))[td[1]] * 2;
+				const PixelType *const bgPalette = p.bgPalette + (attrib & 7) * 4;
+				
+				dst[0] = bgPalette[tileword       & twmask];
+				dst[1] = bgPalette[tileword >>  2 & twmask];
+				dst[2] = bgPalette[tileword >>  4 & twmask];
+				dst[3] = bgPalette[tileword >>  6 & twmask];
+				dst[4] = bgPalette[tileword >>  8 & twmask];
+				dst[5] = bgPalette[tileword >> 10 & twmask];
+				dst[6] = bgPalette[tileword >> 12 & twmask];
+				dst[7] = bgPalette[tileword >> 14 & twmask];
+				tilewords[n] = tileword;
+				tileattribs[n] = attrib;
+			}
+			
+			std::memcpy(fbline, edgebuf + fine, (8 - fine) * sizeof(PixelType));
+			std::memcpy(fbline + 160 - fine, edgebuf + 8, fine * sizeof(PixelType));
+		}
+		
+		const unsigned numSprites = p.spriteMapper.numSprites(ly);
+		
+		if ((p.lcdc & 2) && numSprites) {
+			// The sprite that wins a pixel is the first one in x order on dmg and the one with
+			// the lowest oam position on cgb, its priority bits decide between it and the bg.
+			const unsigned char *const sprites = p.spriteMapper.sprites(ly);
+			const unsigned bgpriEnable = p.cgb ? p.lcdc & 1 : 1;
+			unsigned char owner[160];
+			std::memset(owner, 0xFF, sizeof owner);
+			
+			for (unsigned i = 0; i < numSprites; ++i) {
+				const unsigned pos = sprites[i];
+				const int spx = p.spriteMapper.posbuf()[pos + 1];
+				
+				if (spx >= 168)
+					continue;
+				
+				const unsigned id     = p.cgb ? pos * 2 : i;
+				const unsigned tno    = p.spriteMapper.oamram()[pos * 2 + 2] * 16;
+				const unsigned attrib = p.spriteMapper.oamram()[pos * 2 + 3];
+				const unsigned line   = ly + 16u - p.spriteMapper.posbuf()[pos];
+				const unsigned spline = ((attrib & 0x40) ? line ^ 15 : line) * 2;
+				const unsigned char *const sd = p.vram + (attrib << 10 & p.cgb * 0x2000)
+						+ ((p.lcdc & 4) ? (tno & ~16) | spline : tno | (spline & ~16));
+				const unsigned spword = expand_lut[sd[0] + (attrib << 3 & 0x100)]
+				                      + expand_lut[sd[1] + (attrib << 3 & 0x100)] * 2;
+				const PixelType *const spPalette = p.spPalette + (p.cgb ? (attrib & 7) * 4 : attrib >> 2 & 4);
+				const int xstart = spx < 8 ? 8 - spx : 0;
+				const int xend = spx > 160 ? 168 - spx : 8;
+				
+				for (int k = xstart; k < xend; ++k) {
+					const unsigned spdata = spword >> k * 2 & 3;
+					const int x = spx - 8 + k;
+					
+					if (spdata && id < owner[x]) {
+						const unsigned bgx = x + fine;
+						const unsigned tw = tilewords[bgx >> 3] >> (bgx & 7) * 2 & twmask;
+						const unsigned bgattrib = tileattribs[bgx >> 3];
+						
+						owner[x] = id;
+						fbline[x] = tw && ((attrib | bgattrib) & 0x80) && bgpriEnable
+								? p.bgPalette[(bgattrib & 7) * 4 + tw] : spPalette[spdata];
+					}
+				}
+			}
+		}
+		
+		p.cycles -= m3cycles;
+		p.xpos = 168;
+		xpos168(p);
+		
+		return true;
+	}
+}
+
 } // anon namespace
 
 namespace gambatte {
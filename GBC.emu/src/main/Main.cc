@@ -428,6 +428,7 @@ void EmuSystem::clearInputBuffers()
 
 static float audioFramesPerUpdateScaler;
 static Resampler *resampler = 0;
+static uint soundShift = 0;
 
 void EmuSystem::configAudioRate()
 {
@@ -441,17 +442,24 @@ void EmuSystem::configAudioRate()
 	#else
 	long outputRate = float(optionSoundRate)*.9965;
 	#endif
+	// lower gambatte's internal rate as far as possible while staying above
+	// twice the output rate, leaving the resampler a fraction of the samples
+	uint shift = 0;
+	while(shift < 5 && (2097152 >> (shift + 1)) >= outputRate * 2)
+		shift++;
 	audioFramesPerUpdateScaler = outputRate/2097152.;
 	iterateTimes(ResamplerInfo::num(), i)
 	{
 		ResamplerInfo r = ResamplerInfo::get(i);
 		logMsg("%d %s", i, r.desc);
 	}
-	if(!resampler || resampler->outRate() != outputRate)
+	if(!resampler || resampler->outRate() != outputRate || shift != soundShift)
 	{
-		logMsg("setting up resampler for output rate %ldHz", outputRate);
+		logMsg("setting up resampler for output rate %ldHz from %dHz", outputRate, 2097152 >> shift);
 		delete resampler;
-		resampler = ResamplerInfo::get(1).create(2097152, outputRate, 35112 + 2064);
+		soundShift = shift;
+		gbEmu.setSoundDecimation(shift);
+		resampler = ResamplerInfo::get(1).create(2097152 >> shift, outputRate, (35112 + 2064) >> shift);
 	}
 }
 
@@ -499,7 +507,9 @@ void EmuSystem::runFrame(bool renderGfx, bool processGfx, bool renderAudio)
 	if(renderGfx)
 		renderToScreen = 1;
 
-	samples = 35112;
+	// round up so a whole video frame always fits in the requested samples
+	const uint frameSamples = (35112 + (1 << soundShift) - 1) >> soundShift;
+	samples = frameSamples;
 	int frameSample = gbEmu.runFor(processGfx ? screenBuff : 0, 160, (uint_least32_t*)snd, samples);
 	if(renderAudio)
 	{
@@ -508,16 +518,16 @@ void EmuSystem::runFrame(bool renderGfx, bool processGfx, bool renderAudio)
 			logMsg("no emulated frame with %d samples", samples);
 		}
 		//else logMsg("emulated frame at %d with %d samples", frameSample, samples);
-		if(unlikely(samples < 34000))
+		if(unlikely(samples < (34000 >> soundShift)))
 		{
 			uint repeatPos = IG::max((int)samples-1, 0);
 			uint32 *sndFrame = (uint32*)snd;
 			logMsg("only %d, repeat %d", samples, (int)sndFrame[repeatPos]);
-			for(uint i = samples; i < 35112; i++)
+			for(uint i = samples; i < frameSamples; i++)
 			{
 				sndFrame[i] = sndFrame[repeatPos];
 			}
-			samples = 35112;
+			samples = frameSamples;
 		}
 		// video rendered in runFor()
 		writeAudio((const int16*)snd, samples);
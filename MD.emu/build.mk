@@ -25,6 +25,8 @@ GPLUS_SRC += $(GPLUS)/system.cc $(GPLUS)/genesis.cc $(GPLUS)/io_ctrl.cc $(GPLUS)
 $(GPLUS)/mem68k.cc $(GPLUS)/membnk.cc $(GPLUS)/memz80.cc $(GPLUS)/state.cc $(GPLUS)/vdp_ctrl.cc \
 $(GPLUS)/vdp_render.cc
 
+GPLUS_SRC += $(GPLUS)/ntsc/md_ntsc.cc $(GPLUS)/ntsc/sms_ntsc.cc $(GPLUS)/ntsc/ntsc_output.cc
+
 ifeq ($(ENV), android)
  #GPLUS_SRC += $(GPLUS)/m68k/cyclone/Cyclone.s $(GPLUS)/m68k/cyclone/m68k.cc
  GPLUS_SRC += $(GPLUS)/m68k/musashi/m68kcpu.cc
@@ -50,7 +52,7 @@ $(GPLUS)/input_hw/sportspad.cc $(GPLUS)/input_hw/paddle.cc
 
 # Sega CD support
 
-GPLUS_SRC += scd/scd.cc scd/LC89510.cc scd/cd_sys.cc scd/gfx_cd.cc scd/pcm.cc scd/cd_file.cc \
+GPLUS_SRC += scd/scd.cc scd/LC89510.cc scd/cd_sys.cc scd/gfx_cd.cc scd/pcm.cc scd/cd_file.cc scd/cd_stream.cc \
 scd/memMain.cc scd/memSub.cc
 
 SRC += $(GPLUS_SRC) fileio/fileio.cc
@@ -0,0 +1,265 @@
+/* md_ntsc 0.1.2. http://www.slack.net/~ant/ */
+
+/* Added a custom blitter to double the height md_ntsc_blit_y2 -- AamirM */
+/* Added a custom blitter to work with Genesis Plus GX -- EkeEke*/
+/* Back to the row blitter with a SIMD version for 16-bit RGB input */
+
+#include "md_ntsc.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/* Copyright (C) 2006 Shay Green. This module is free software; you
+can redistribute it and/or modify it under the terms of the GNU Lesser
+General Public License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version. This
+module is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details. You should have received a copy of the GNU Lesser General Public
+License along with this module; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA */
+
+md_ntsc_setup_t const md_ntsc_monochrome = { 0,-1, 0, 0,.2,  0, 0,-.2,-.2,-1, 0,  0 };
+md_ntsc_setup_t const md_ntsc_composite  = { 0, 0, 0, 0, 0,  0, 0,  0,  0, 0, 0,  0 };
+md_ntsc_setup_t const md_ntsc_svideo     = { 0, 0, 0, 0, 0,  0,.2, -1, -1, 0, 0,  0 };
+md_ntsc_setup_t const md_ntsc_rgb        = { 0, 0, 0, 0,.2,  0,.7, -1, -1,-1, 0,  0 };
+
+#define alignment_count 2
+#define burst_count     1
+#define rescale_in      1
+#define rescale_out     1
+
+#define artifacts_mid   0.40f
+#define fringing_mid    0.30f
+#define std_decoder_hue 0
+
+#define gamma_size      8
+#define artifacts_max   1.00f
+#define LUMA_CUTOFF     0.1974
+
+#include "md_ntsc_impl.h"
+
+/* 2 input pixels -> 4 composite samples */
+pixel_info_t const md_ntsc_pixels [alignment_count] = {
+  { PIXEL_OFFSET( -4, -9 ), { 0.1f, 0.9f, 0.9f, 0.1f } },
+  { PIXEL_OFFSET( -2, -7 ), { 0.1f, 0.9f, 0.9f, 0.1f } },
+};
+
+static void correct_errors( md_ntsc_rgb_t color, md_ntsc_rgb_t* out )
+{
+  unsigned i;
+  for ( i = 0; i < rgb_kernel_size / 4; i++ )
+  {
+    md_ntsc_rgb_t error = color -
+        out [i    ] - out [i + 2    +16] - out [i + 4    ] - out [i + 6    +16] -
+        out [i + 8] - out [(i+10)%16+16] - out [(i+12)%16] - out [(i+14)%16+16];
+    CORRECT_ERROR( i + 6 + 16 );
+    /*DISTRIBUTE_ERROR( 2+16, 4, 6+16 );*/
+  }
+}
+
+void md_ntsc_init( md_ntsc_t* ntsc, md_ntsc_setup_t const* setup )
+{
+  int entry;
+  init_t impl;
+  if ( !setup )
+    setup = &md_ntsc_composite;
+  init( &impl, setup );
+
+  for ( entry = 0; entry < md_ntsc_palette_size; entry++ )
+  {
+    float bb = impl.to_float [entry >> 6 & 7];
+    float gg = impl.to_float [entry >> 3 & 7];
+    float rr = impl.to_float [entry      & 7];
+
+    float y, i, q = RGB_TO_YIQ( rr, gg, bb, y, i );
+
+    int r, g, b = YIQ_TO_RGB( y, i, q, impl.to_rgb, int, r, g );
+    md_ntsc_rgb_t rgb = PACK_RGB( r, g, b );
+
+    if ( setup->palette_out )
+      RGB_PALETTE_OUT( rgb, &setup->palette_out [entry * 3] );
+
+    if ( ntsc )
+    {
+      gen_kernel( &impl, y, i, q, ntsc->table [entry] );
+      correct_errors( rgb, ntsc->table [entry] );
+#ifdef MD_NTSC_SIMD
+      {
+        int half, n;
+        for ( half = 0; half < 2; half++ )
+        {
+          md_ntsc_rgb_t* padded = ntsc->padded [entry] [half];
+          padded [0] = padded [1] = padded [18] = padded [19] = 0;
+          for ( n = 0; n < 16; n++ )
+            padded [n + 2] = ntsc->table [entry] [half * 16 + n];
+        }
+      }
+#endif
+    }
+  }
+}
+
+#ifndef MD_NTSC_NO_BLITTERS
+#ifdef MD_NTSC_SIMD
+enum { md_ntsc_simd_max_width = 512 };
+
+/* Output pixel x of a row is the sum of entry (x - 2 * p) of the half selected
+by the parity of p over input pixels p with 2 * p <= x < 2 * p + 16, where the
+row is padded with 5 black pixels in front and 3 behind. Each group of 4
+outputs then takes a 4-wide load from the padded table of 9 input pixels. */
+static void md_ntsc_blit_row_simd( md_ntsc_t const* ntsc, MD_NTSC_IN_T const* line_in,
+    int in_width, md_ntsc_out_t* restrict line_out )
+{
+  md_ntsc_rgb_t const* kernel [md_ntsc_simd_max_width + 8];
+  int const row_width = in_width + 8;
+  int p, x;
+  for ( p = 0; p < row_width; p++ )
+  {
+    unsigned const pixel = (p >= 5 && p < in_width + 5) ? MD_NTSC_ADJ_IN( line_in [p - 5] ) : 0;
+    kernel [p] = ntsc->padded [MD_NTSC_RGB16_INDEX( pixel )] [p & 1];
+  }
+
+  for ( x = 16; x < in_width * 2 + 16; x += 8 )
+  {
+    md_ntsc_rgb_t const* const* k0 = &kernel [x / 2 + 1];
+    md_ntsc_rgb_t const* const* k1 = &kernel [x / 2 + 3];
+#if defined(__SSE2__)
+    __m128i const mask = _mm_set1_epi32( md_ntsc_clamp_mask );
+    __m128i const add = _mm_set1_epi32( md_ntsc_clamp_add );
+    __m128i raw0 = _mm_loadu_si128( (__m128i const*) k0 [0] );
+    __m128i raw1 = _mm_loadu_si128( (__m128i const*) k1 [0] );
+    __m128i sub, clamp, out0, out1;
+    for ( p = 1; p < 9; p++ )
+    {
+      raw0 = _mm_add_epi32( raw0, _mm_loadu_si128( (__m128i const*) (k0 [-p] + p * 2) ) );
+      raw1 = _mm_add_epi32( raw1, _mm_loadu_si128( (__m128i const*) (k1 [-p] + p * 2) ) );
+    }
+
+    sub = _mm_and_si128( _mm_srli_epi32( raw0, 9 ), mask );
+    clamp = _mm_sub_epi32( add, sub );
+    raw0 = _mm_and_si128( _mm_or_si128( raw0, clamp ), _mm_sub_epi32( clamp, sub ) );
+    sub = _mm_and_si128( _mm_srli_epi32( raw1, 9 ), mask );
+    clamp = _mm_sub_epi32( add, sub );
+    raw1 = _mm_and_si128( _mm_or_si128( raw1, clamp ), _mm_sub_epi32( clamp, sub ) );
+
+    out0 = _mm_or_si128( _mm_or_si128(
+        _mm_and_si128( _mm_srli_epi32( raw0, 13 ), _mm_set1_epi32( 0xF800 ) ),
+        _mm_and_si128( _mm_srli_epi32( raw0, 8 ), _mm_set1_epi32( 0x07E0 ) ) ),
+        _mm_and_si128( _mm_srli_epi32( raw0, 4 ), _mm_set1_epi32( 0x001F ) ) );
+    out1 = _mm_or_si128( _mm_or_si128(
+        _mm_and_si128( _mm_srli_epi32( raw1, 13 ), _mm_set1_epi32( 0xF800 ) ),
+        _mm_and_si128( _mm_srli_epi32( raw1, 8 ), _mm_set1_epi32( 0x07E0 ) ) ),
+        _mm_and_si128( _mm_srli_epi32( raw1, 4 ), _mm_set1_epi32( 0x001F ) ) );
+    /* sign extend so the saturating pack keeps all 16 bits */
+    out0 = _mm_srai_epi32( _mm_slli_epi32( out0, 16 ), 16 );
+    out1 = _mm_srai_epi32( _mm_slli_epi32( out1, 16 ), 16 );
+    _mm_storeu_si128( (__m128i*) line_out, _mm_packs_epi32( out0, out1 ) );
+#else
+    uint32x4_t const mask = vdupq_n_u32( md_ntsc_clamp_mask );
+    uint32x4_t const add = vdupq_n_u32( md_ntsc_clamp_add );
+    uint32x4_t raw0 = vld1q_u32( k0 [0] );
+    uint32x4_t raw1 = vld1q_u32( k1 [0] );
+    uint32x4_t sub, clamp, out0, out1;
+    for ( p = 1; p < 9; p++ )
+    {
+      raw0 = vaddq_u32( raw0, vld1q_u32( k0 [-p] + p * 2 ) );
+      raw1 = vaddq_u32( raw1, vld1q_u32( k1 [-p] + p * 2 ) );
+    }
+
+    sub = vandq_u32( vshrq_n_u32( raw0, 9 ), mask );
+    clamp = vsubq_u32( add, sub );
+    raw0 = vandq_u32( vorrq_u32( raw0, clamp ), vsubq_u32( clamp, sub ) );
+    sub = vandq_u32( vshrq_n_u32( raw1, 9 ), mask );
+    clamp = vsubq_u32( add, sub );
+    raw1 = vandq_u32( vorrq_u32( raw1, clamp ), vsubq_u32( clamp, sub ) );
+
+    out0 = vorrq_u32( vorrq_u32(
+        vandq_u32( vshrq_n_u32( raw0, 13 ), vdupq_n_u32( 0xF800 ) ),
+        vandq_u32( vshrq_n_u32( raw0, 8 ), vdupq_n_u32( 0x07E0 ) ) ),
+        vandq_u32( vshrq_n_u32( raw0, 4 ), vdupq_n_u32( 0x001F ) ) );
+    out1 = vorrq_u32( vorrq_u32(
+        vandq_u32( vshrq_n_u32( raw1, 13 ), vdupq_n_u32( 0xF800 ) ),
+        vandq_u32( vshrq_n_u32( raw1, 8 ), vdupq_n_u32( 0x07E0 ) ) ),
+        vandq_u32( vshrq_n_u32( raw1, 4 ), vdupq_n_u32( 0x001F ) ) );
+    vst1q_u16( line_out, vcombine_u16( vmovn_u32( out0 ), vmovn_u32( out1 ) ) );
+#endif
+    line_out += 8;
+  }
+}
+#endif
+
+void md_ntsc_blit( md_ntsc_t const* ntsc, MD_NTSC_IN_T const* input, long in_row_width,
+    int in_width, int in_height, void* rgb_out, long out_pitch )
+{
+  int const chunk_count = in_width / md_ntsc_in_chunk - 1;
+  while ( in_height-- )
+  {
+    MD_NTSC_IN_T const* line_in = input;
+    md_ntsc_out_t* restrict line_out = (md_ntsc_out_t*) rgb_out;
+    input += in_row_width;
+    rgb_out = (char*) rgb_out + out_pitch;
+
+#ifdef MD_NTSC_SIMD
+    if ( !(in_width % md_ntsc_in_chunk) && in_width <= md_ntsc_simd_max_width )
+    {
+      md_ntsc_blit_row_simd( ntsc, line_in, in_width, line_out );
+      continue;
+    }
+#endif
+
+    {
+      MD_NTSC_BEGIN_ROW( ntsc, md_ntsc_black,
+            MD_NTSC_ADJ_IN( line_in [0] ),
+            MD_NTSC_ADJ_IN( line_in [1] ),
+            MD_NTSC_ADJ_IN( line_in [2] ) );
+      int n;
+      line_in += 3;
+
+      for ( n = chunk_count; n; --n )
+      {
+        /* order of input and output pixels must not be altered */
+        MD_NTSC_COLOR_IN( 0, ntsc, MD_NTSC_ADJ_IN( line_in [0] ) );
+        MD_NTSC_RGB_OUT( 0, line_out [0], MD_NTSC_OUT_DEPTH );
+        MD_NTSC_RGB_OUT( 1, line_out [1], MD_NTSC_OUT_DEPTH );
+
+        MD_NTSC_COLOR_IN( 1, ntsc, MD_NTSC_ADJ_IN( line_in [1] ) );
+        MD_NTSC_RGB_OUT( 2, line_out [2], MD_NTSC_OUT_DEPTH );
+        MD_NTSC_RGB_OUT( 3, line_out [3], MD_NTSC_OUT_DEPTH );
+
+        MD_NTSC_COLOR_IN( 2, ntsc, MD_NTSC_ADJ_IN( line_in [2] ) );
+        MD_NTSC_RGB_OUT( 4, line_out [4], MD_NTSC_OUT_DEPTH );
+        MD_NTSC_RGB_OUT( 5, line_out [5], MD_NTSC_OUT_DEPTH );
+
+        MD_NTSC_COLOR_IN( 3, ntsc, MD_NTSC_ADJ_IN( line_in [3] ) );
+        MD_NTSC_RGB_OUT( 6, line_out [6], MD_NTSC_OUT_DEPTH );
+        MD_NTSC_RGB_OUT( 7, line_out [7], MD_NTSC_OUT_DEPTH );
+
+        line_in  += 4;
+        line_out += 8;
+      }
+
+      /* finish final pixels */
+      MD_NTSC_COLOR_IN( 0, ntsc, MD_NTSC_ADJ_IN( line_in [0] ) );
+      MD_NTSC_RGB_OUT( 0, line_out [0], MD_NTSC_OUT_DEPTH );
+      MD_NTSC_RGB_OUT( 1, line_out [1], MD_NTSC_OUT_DEPTH );
+
+      MD_NTSC_COLOR_IN( 1, ntsc, md_ntsc_black );
+      MD_NTSC_RGB_OUT( 2, line_out [2], MD_NTSC_OUT_DEPTH );
+      MD_NTSC_RGB_OUT( 3, line_out [3], MD_NTSC_OUT_DEPTH );
+
+      MD_NTSC_COLOR_IN( 2, ntsc, md_ntsc_black );
+      MD_NTSC_RGB_OUT( 4, line_out [4], MD_NTSC_OUT_DEPTH );
+      MD_NTSC_RGB_OUT( 5, line_out [5], MD_NTSC_OUT_DEPTH );
+
+      MD_NTSC_COLOR_IN( 3, ntsc, md_ntsc_black );
+      MD_NTSC_RGB_OUT( 6, line_out [6], MD_NTSC_OUT_DEPTH );
+      MD_NTSC_RGB_OUT( 7, line_out [7], MD_NTSC_OUT_DEPTH );
+    }
+  }
+}
+#endif
@@ -49,8 +49,8 @@ void md_ntsc_init( md_ntsc_t* ntsc, md_ntsc_setup_t const* setup );
 and output RGB depth is set by MD_NTSC_OUT_DEPTH. Both default to 16-bit RGB.
 In_row_width is the number of pixels to get to the next input row. Out_pitch
 is the number of *bytes* to get to the next output row. */
-void md_ntsc_blit( md_ntsc_t const* ntsc, MD_NTSC_IN_T const* table, unsigned char* input,
-    int in_width, int vline);
+void md_ntsc_blit( md_ntsc_t const* ntsc, MD_NTSC_IN_T const* input, long in_row_width,
+    int in_width, int in_height, void* rgb_out, long out_pitch );
 
 /* Number of output pixels written by blitter for given input width. */
 #define MD_NTSC_OUT_WIDTH( in_width ) \
@@ -106,9 +106,19 @@ statement in a block (unless you're using C++). */
 
 /* private */
 enum { md_ntsc_entry_size = 2 * 16 };
-typedef unsigned long md_ntsc_rgb_t;
+typedef unsigned int md_ntsc_rgb_t; /* only the low 32 bits are ever used */
+
+#if defined(__SSE2__) || defined(__ARM_NEON__) || defined(__ARM_NEON)
+  #define MD_NTSC_SIMD 1
+#endif
+
 struct md_ntsc_t {
   md_ntsc_rgb_t table [md_ntsc_palette_size] [md_ntsc_entry_size];
+#ifdef MD_NTSC_SIMD
+  /* each 16 entry half of table with 2 zero entries on both sides, so any 4
+  adjacent outputs can be summed with one 4-wide load per input pixel */
+  md_ntsc_rgb_t padded [md_ntsc_palette_size] [2] [20];
+#endif
 };
 
 #define MD_NTSC_BGR9( ntsc, n ) (ntsc)->table [n & 0x1FF]
@@ -118,6 +128,10 @@ struct md_ntsc_t {
   ((n << 9 & 0x3800) | (n & 0x0700) | (n >> 8 & 0x00E0)) *\
   (md_ntsc_entry_size * sizeof (md_ntsc_rgb_t) / 32))
 
+/* palette index of a 16-bit RGB pixel */
+#define MD_NTSC_RGB16_INDEX( n ) \
+  (((n << 9 & 0x3800) | (n & 0x0700) | (n >> 8 & 0x00E0)) >> 5)
+
 /* common ntsc macros */
 #define md_ntsc_rgb_builder    ((1L << 21) | (1 << 11) | (1 << 1))
 #define md_ntsc_clamp_mask     (md_ntsc_rgb_builder * 3 / 2)
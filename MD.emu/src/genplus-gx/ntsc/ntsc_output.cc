@@ -0,0 +1,284 @@
+#define thisModuleName "ntscOutput"
+#include "shared.h"
+#include "ntsc_output.h"
+#include "md_ntsc.h"
+#include "sms_ntsc.h"
+#include <logger/interface.h>
+#include <util/thread/pthread.hh>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const uint maxWorkers = 3;
+static const int batchLines = 16; // lines per job, small enough to spread a frame over all workers
+static const uint jobSlots = 32; // ring of queued jobs, power of 2
+
+uint16 ntscBitmap[ntscMaxWidth * ntscMaxHeight] __attribute__ ((aligned (16)));
+bool ntscOutputActive = 0;
+
+static md_ntsc_setup_t const *mdSetup[] { &md_ntsc_composite, &md_ntsc_svideo, &md_ntsc_rgb, &md_ntsc_monochrome };
+static sms_ntsc_setup_t const *smsSetup[] { &sms_ntsc_composite, &sms_ntsc_svideo, &sms_ntsc_rgb, &sms_ntsc_monochrome };
+
+struct NtscJob
+{
+	int line = 0, lines = 0;
+	int width = 0;
+	bool sms = 0;
+	const void *ntsc = nullptr;
+};
+
+struct NtscOutput
+{
+	constexpr NtscOutput() { }
+	uint preset = NTSC_OFF;
+	md_ntsc_t *mdTable[4] {nullptr};
+	sms_ntsc_t *smsTable[4] {nullptr};
+
+	// lines collected by the emulation thread, not yet queued
+	NtscJob batch;
+	int lastLine = -1;
+	uint frameWidth = 0;
+
+	uint workers = 0;
+	bool quit = false;
+	ThreadPThread thread[maxWorkers];
+	MutexPThread mutex;
+	CondVarPThread workCond, doneCond;
+
+	// job ring, all fields guarded by the mutex
+	NtscJob job[jobSlots];
+	uint jobsQueued = 0, jobsTaken = 0, jobsDone = 0;
+};
+
+static NtscOutput output;
+
+static uint outputWidth(int width, bool sms)
+{
+	return sms ? SMS_NTSC_OUT_WIDTH(width) : MD_NTSC_OUT_WIDTH(width);
+}
+
+static void runJob(const NtscJob &job)
+{
+	auto in = (const uint16*)&bitmap.data[job.line * bitmap.pitch];
+	auto out = &ntscBitmap[job.line * ntscMaxWidth];
+	if(job.sms)
+		sms_ntsc_blit((const sms_ntsc_t*)job.ntsc, in, bitmap.pitch / 2, job.width, job.lines, out, ntscMaxWidth * 2);
+	else
+		md_ntsc_blit((const md_ntsc_t*)job.ntsc, in, bitmap.pitch / 2, job.width, job.lines, out, ntscMaxWidth * 2);
+	// clear what a wider line of the previous frame left behind
+	uint width = outputWidth(job.width, job.sms);
+	if(width < ntscMaxWidth)
+	{
+		iterateTimes(job.lines, i)
+		{
+			memset(&out[i * ntscMaxWidth + width], 0, (ntscMaxWidth - width) * 2);
+		}
+	}
+}
+
+static int workerThread(ThreadPThread &thread)
+{
+	auto &s = *(NtscOutput*)thread.arg;
+	s.mutex.lock();
+	for(;;)
+	{
+		while(!s.quit && s.jobsTaken == s.jobsQueued)
+			s.workCond.wait();
+		if(s.quit)
+			break;
+		NtscJob job = s.job[s.jobsTaken++ % jobSlots];
+		s.mutex.unlock();
+		runJob(job);
+		s.mutex.lock();
+		if(++s.jobsDone == s.jobsQueued)
+			s.doneCond.signal();
+	}
+	s.mutex.unlock();
+	return 0;
+}
+
+// Runs jobs no worker has taken yet on the calling thread, mutex must be held
+static void helpWithJobs(NtscOutput &s)
+{
+	while(s.jobsTaken != s.jobsQueued)
+	{
+		NtscJob job = s.job[s.jobsTaken++ % jobSlots];
+		s.mutex.unlock();
+		runJob(job);
+		s.mutex.lock();
+		s.jobsDone++;
+	}
+}
+
+static void queueBatch(NtscOutput &s)
+{
+	if(!s.batch.lines)
+		return;
+	if(!s.workers)
+		runJob(s.batch);
+	else
+	{
+		s.mutex.lock();
+		if(s.jobsQueued - s.jobsTaken == jobSlots)
+			helpWithJobs(s);
+		s.job[s.jobsQueued++ % jobSlots] = s.batch;
+		s.workCond.signal();
+		s.mutex.unlock();
+	}
+	s.batch.lines = 0;
+}
+
+static void waitForJobs(NtscOutput &s)
+{
+	queueBatch(s);
+	if(s.workers)
+	{
+		s.mutex.lock();
+		helpWithJobs(s);
+		while(s.jobsDone != s.jobsQueued)
+			s.doneCond.wait();
+		s.mutex.unlock();
+	}
+	s.lastLine = -1;
+}
+
+static uint workerCount()
+{
+	#ifdef CONFIG_BASE_PS3
+	return 1;
+	#else
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	// the emulation thread takes one core and also helps finish each frame
+	return cpus > 1 ? IG::min((uint)cpus - 1, maxWorkers) : 0;
+	#endif
+}
+
+static void startWorkers(NtscOutput &s)
+{
+	uint workers = workerCount();
+	if(!workers)
+	{
+		logMsg("single core, filtering on the emulation thread");
+		return;
+	}
+	s.quit = false;
+	s.jobsQueued = s.jobsTaken = s.jobsDone = 0;
+	s.mutex.create();
+	s.workCond.create(&s.mutex);
+	s.doneCond.create(&s.mutex);
+	iterateTimes(workers, i)
+	{
+		if(!s.thread[i].create(0, workerThread, &s))
+		{
+			logWarn("unable to start NTSC filter thread %d", i);
+			break;
+		}
+		s.workers++;
+	}
+	if(!s.workers)
+	{
+		logWarn("filtering on the emulation thread");
+		s.workCond.destroy();
+		s.doneCond.destroy();
+		s.mutex.destroy();
+		return;
+	}
+	logMsg("started %d NTSC filter threads", s.workers);
+}
+
+static void stopWorkers(NtscOutput &s)
+{
+	if(!s.workers)
+		return;
+	s.mutex.lock();
+	s.quit = true;
+	s.workCond.broadcast();
+	s.mutex.unlock();
+	iterateTimes(s.workers, i)
+	{
+		s.thread[i].join();
+	}
+	s.workers = 0;
+	s.workCond.destroy();
+	s.doneCond.destroy();
+	s.mutex.destroy();
+}
+
+void ntscOutputSetup(uint preset)
+{
+	auto &s = output;
+	if(preset > NTSC_MONOCHROME)
+		preset = NTSC_OFF;
+	if(ntscOutputActive)
+		waitForJobs(s);
+	s.preset = preset;
+	if(preset == NTSC_OFF)
+	{
+		stopWorkers(s);
+		ntscOutputActive = 0;
+		return;
+	}
+	auto &table = s.mdTable[preset - 1];
+	if(!table)
+	{
+		table = (md_ntsc_t*)malloc(sizeof(md_ntsc_t));
+		md_ntsc_init(table, mdSetup[preset - 1]);
+	}
+	if(!ntscOutputActive)
+		startWorkers(s);
+	ntscOutputActive = 1;
+}
+
+static const void *ntscTable(NtscOutput &s, bool sms)
+{
+	if(!sms)
+		return s.mdTable[s.preset - 1];
+	// only built once a Mode 4 game shows up, the tables are much larger
+	auto &table = s.smsTable[s.preset - 1];
+	if(!table)
+	{
+		table = (sms_ntsc_t*)malloc(sizeof(sms_ntsc_t));
+		sms_ntsc_init(table, smsSetup[s.preset - 1]);
+	}
+	return table;
+}
+
+void ntscOutputLine(int line, int width, bool sms)
+{
+	auto &s = output;
+	if(line >= (int)ntscMaxHeight)
+		return;
+	// keep the output within the bitmap
+	if(sms)
+		width = IG::min(width, SMS_NTSC_IN_WIDTH((int)ntscMaxWidth));
+	else
+		width = IG::min(width, (int)ntscMaxWidth / 2);
+
+	auto &b = s.batch;
+	if(b.lines && line >= b.line && line < b.line + b.lines)
+		return; // remapped again after a mid-line palette change, filtered when queued
+	if(line <= s.lastLine)
+		waitForJobs(s); // previous frame wasn't shown, don't let it get overwritten while filtered
+	s.lastLine = line;
+	// the line being remapped stays in the batch until the next one starts
+	if(b.lines && (line != b.line + b.lines || b.lines == batchLines || width != b.width || sms != b.sms))
+		queueBatch(s);
+	if(!b.lines)
+	{
+		b.line = line;
+		b.width = width;
+		b.sms = sms;
+		b.ntsc = ntscTable(s, sms);
+		s.frameWidth = outputWidth(width, sms);
+	}
+	b.lines++;
+}
+
+uint ntscOutputFinish()
+{
+	auto &s = output;
+	waitForJobs(s);
+	return s.frameWidth;
+}
+
+#undef thisModuleName
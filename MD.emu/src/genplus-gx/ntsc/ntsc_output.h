@@ -0,0 +1,30 @@
+#pragma once
+
+#include <engine-globals.h>
+
+// NTSC composite video output stage using the md_ntsc/sms_ntsc filters.
+//
+// remap_line() passes every finished framebuffer line to ntscOutputLine(),
+// which groups consecutive lines into batches for a few worker threads to
+// expand into ntscBitmap while emulation continues with the next lines.
+// Mode 5 lines go through md_ntsc (4 pixels to 8), Mode 4 lines through
+// sms_ntsc (3 pixels to 7). Filter tables are built once per preset and kept
+// for when the preset is selected again.
+
+enum { NTSC_OFF, NTSC_COMPOSITE, NTSC_SVIDEO, NTSC_RGB, NTSC_MONOCHROME };
+
+static const uint ntscMaxWidth = 640, ntscMaxHeight = 240;
+
+extern uint16 ntscBitmap[ntscMaxWidth * ntscMaxHeight];
+extern bool ntscOutputActive;
+
+// Switches to a preset, NTSC_OFF stops the worker threads
+void ntscOutputSetup(uint preset);
+
+// Adds framebuffer line of width pixels, called before it's remapped to RGB565.
+// Lines are only handed to the workers once the next line has started.
+void ntscOutputLine(int line, int width, bool sms);
+
+// Waits for the queued lines of the frame, helping with those no worker
+// has started yet, and returns the width of the filtered image
+uint ntscOutputFinish();
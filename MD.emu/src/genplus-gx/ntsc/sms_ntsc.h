@@ -49,8 +49,8 @@ void sms_ntsc_init( sms_ntsc_t* ntsc, sms_ntsc_setup_t const* setup );
 and output RGB depth is set by SMS_NTSC_OUT_DEPTH. Both default to 16-bit RGB.
 In_row_width is the number of pixels to get to the next input row. Out_pitch
 is the number of *bytes* to get to the next output row. */
-void sms_ntsc_blit( sms_ntsc_t const* ntsc, SMS_NTSC_IN_T const* table, unsigned char* input,
-    int in_width, int vline);
+void sms_ntsc_blit( sms_ntsc_t const* ntsc, SMS_NTSC_IN_T const* input, long in_row_width,
+    int in_width, int in_height, void* rgb_out, long out_pitch );
 
 /* Number of output pixels written by blitter for given input width. */
 #define SMS_NTSC_OUT_WIDTH( in_width ) \
@@ -90,7 +90,7 @@ statement in a block (unless you're using C++). */
 
 /* private */
 enum { sms_ntsc_entry_size = 3 * 14 };
-typedef unsigned long sms_ntsc_rgb_t;
+typedef unsigned int sms_ntsc_rgb_t; /* only the low 32 bits are ever used */
 struct sms_ntsc_t {
   sms_ntsc_rgb_t table [sms_ntsc_palette_size] [sms_ntsc_entry_size];
 };
@@ -23,6 +23,7 @@
 
 #include "shared.h"
 #include "Fir_Resampler.h"
+#include <util/thread/pthread.hh>
 
 /* Cycle-accurate samples */
 static unsigned int psg_cycles_ratio;
@@ -35,6 +36,144 @@ static void (*YM_Reset)(void);
 static void (*YM_Update)(FMSampleType *buffer, int length);
 static void (*YM_Write)(unsigned int a, unsigned int v);
 
+/* YM2612 synthesis thread                                                               */
+/*                                                                                      */
+/* When enabled, FM register writes & sample runs are queued as commands and the chip   */
+/* is updated on a worker thread while the CPUs keep running. Timers & status are run   */
+/* here on a copy of the timer state (YM2612Timers*) that sees the same writes & sample  */
+/* counts, so status reads return the same values as in synchronous mode.              */
+/* The queue is drained at the end of each frame & before the chip state is accessed    */
+/* directly (init, reset, state load/save).                                            */
+#define FM_QUEUE_SIZE 4096  /* commands, power of 2 */
+#define FM_QUEUE_BATCH 64   /* commands handed over at once */
+
+#define FM_CMD_RUN   0
+#define FM_CMD_WRITE 1
+
+typedef struct
+{
+  uint8 type;
+  uint8 address;
+  uint8 data;
+  unsigned int length;
+  FMSampleType *buffer;
+} t_fm_cmd;
+
+static struct
+{
+  int enabled;          /* worker thread is running */
+  int quit;
+  unsigned int written; /* commands stored in the queue */
+  unsigned int queued;  /* commands handed to the worker */
+  unsigned int done;    /* commands run by the worker */
+  unsigned int freed;   /* last value of done seen by the emulation thread */
+  ThreadPThread thread;
+  MutexPThread mutex;
+  CondVarPThread workCond, doneCond;
+  t_fm_cmd cmd[FM_QUEUE_SIZE];
+} fm_thread;
+
+/* YM2612 is updated through the worker thread */
+static int fm_async;
+
+static int fm_worker(ThreadPThread &thread)
+{
+  fm_thread.mutex.lock();
+  for(;;)
+  {
+    while (fm_thread.done == fm_thread.queued && !fm_thread.quit)
+      fm_thread.workCond.wait();
+    if (fm_thread.done == fm_thread.queued)
+      break; /* quit requested & queue is empty */
+
+    unsigned int i = fm_thread.done;
+    unsigned int end = fm_thread.queued;
+    fm_thread.mutex.unlock();
+
+    for (; i != end; i++)
+    {
+      t_fm_cmd *cmd = &fm_thread.cmd[i & (FM_QUEUE_SIZE - 1)];
+      if (cmd->type == FM_CMD_RUN)
+        YM2612Update(cmd->buffer, cmd->length);
+      else
+        YM2612Write(cmd->address, cmd->data);
+    }
+
+    fm_thread.mutex.lock();
+    fm_thread.done = end;
+    fm_thread.doneCond.signal();
+  }
+  fm_thread.mutex.unlock();
+  return 0;
+}
+
+/* Hand the stored commands to the worker */
+static void fm_queue_flush(void)
+{
+  if (fm_thread.written != fm_thread.queued)
+  {
+    fm_thread.mutex.lock();
+    fm_thread.queued = fm_thread.written;
+    fm_thread.workCond.signal();
+    fm_thread.mutex.unlock();
+  }
+}
+
+/* Wait until the worker has run all commands, the chip state can then be accessed */
+static void fm_queue_drain(void)
+{
+  if (!fm_thread.enabled)
+    return;
+
+  fm_queue_flush();
+  fm_thread.mutex.lock();
+  while (fm_thread.done != fm_thread.queued)
+    fm_thread.doneCond.wait();
+  fm_thread.freed = fm_thread.done;
+  fm_thread.mutex.unlock();
+}
+
+static t_fm_cmd *fm_queue_cmd(void)
+{
+  /* wait for a free slot if the worker is a whole queue behind */
+  if (fm_thread.written - fm_thread.freed == FM_QUEUE_SIZE)
+  {
+    fm_queue_flush();
+    fm_thread.mutex.lock();
+    while (fm_thread.written - fm_thread.done == FM_QUEUE_SIZE)
+      fm_thread.doneCond.wait();
+    fm_thread.freed = fm_thread.done;
+    fm_thread.mutex.unlock();
+  }
+
+  return &fm_thread.cmd[fm_thread.written & (FM_QUEUE_SIZE - 1)];
+}
+
+static void fm_queue_add(void)
+{
+  fm_thread.written++;
+  if (fm_thread.written - fm_thread.queued >= FM_QUEUE_BATCH)
+    fm_queue_flush();
+}
+
+/* Run FM chip for the given number of samples */
+static inline void fm_run(FMSampleType *buffer, int length)
+{
+  if (fm_async)
+  {
+    t_fm_cmd *cmd = fm_queue_cmd();
+    cmd->type = FM_CMD_RUN;
+    cmd->length = length;
+    cmd->buffer = buffer;
+    fm_queue_add();
+    YM2612TimersUpdate(length);
+  }
+  else
+  {
+    YM_Update(buffer, length);
+  }
+}
+
 /* Run FM chip for required M-cycles */
 static inline void fm_update(unsigned int cycles)
 {
@@ -71,7 +210,7 @@ static inline void fm_update(unsigned int cycles)
     }
 
     /* run FM chip & get samples */
-    YM_Update(buffer, cnt);
+    fm_run(buffer, cnt);
   }
 }
 
@@ -107,6 +246,8 @@ static inline void psg_update(unsigned int cycles)
 /* Initialize sound chips emulation */
 void sound_init(void)
 {
+  fm_queue_drain();
+
   /* Number of M-cycles executed per second.                                              */
   /*                                                                                      */
   /* The original Genesis would run exactly 53693175 M-cycles (53203424 for PAL), with    */
@@ -171,8 +312,12 @@ void sound_init(void)
 	fm_cycles_ratio = 144 * 7 * (1 << 11);
 	Fir_Resampler_time_ratio(mclk / (SysDDec)snd.sample_rate / (144.0 * 7.0), config_rolloff);
 	}
+
+	YM2612TimersSync();
   }
 
+  fm_async = fm_thread.enabled && (YM_Update == YM2612Update);
+
 #ifdef LOGSOUND
   error("%d mcycles per PSG samples\n", psg_cycles_ratio);
   error("%d mcycles per FM samples\n", fm_cycles_ratio);
@@ -182,7 +327,9 @@ void sound_init(void)
 /* Reset sound chips emulation */
 void sound_reset(void)
 {
+  fm_queue_drain();
   YM_Reset();
+  if (fm_async) YM2612TimersSync();
   SN76489_Reset();
   fm_cycles_count = 0;
   psg_cycles_count = 0;
@@ -193,6 +340,8 @@ void sound_restore()
   int size;
   uint8 *ptr, *temp;
 
+  fm_queue_drain();
+
   /* save YM context */
   #ifndef NO_SYSTEM_PBC
   if (system_hw == SYSTEM_PBC)
@@ -227,6 +376,7 @@ void sound_restore()
     #endif
     {
     	YM2612Restore(temp);
+    	YM2612TimersSync();
     }
     free(temp);
   }
@@ -235,7 +385,9 @@ void sound_restore()
 int sound_context_save(uint8 *state)
 {
   int bufferptr = 0;
-  
+
+  fm_queue_drain();
+
   #ifndef NO_SYSTEM_PBC
   if (system_hw == SYSTEM_PBC)
   {
@@ -258,6 +410,8 @@ int sound_context_load(uint8 *state, char *version)
 {
   int bufferptr = 0;
 
+  fm_queue_drain();
+
   #ifndef NO_SYSTEM_PBC
   //if ((system_hw != SYSTEM_PBC) || (version[15] == 0x30))
   if ((system_hw == SYSTEM_PBC) & (version[15] != 0x30))
@@ -268,6 +422,7 @@ int sound_context_load(uint8 *state, char *version)
   #endif
   {
 	  bufferptr = YM2612LoadContext(state);
+	  YM2612TimersSync();
   }
 
   load_param(SN76489_GetContextPtr(),SN76489_GetContextSize());
@@ -305,7 +460,7 @@ int sound_update(unsigned int cycles)
       /* FM chip is late for one (or two) samples */
       do
       {
-        YM_Update(Fir_Resampler_buffer(), 1);
+        fm_run(Fir_Resampler_buffer(), 1);
         Fir_Resampler_write(2);
         avail = Fir_Resampler_avail();
       }
@@ -318,6 +473,9 @@ int sound_update(unsigned int cycles)
     }
   }
 
+  /* FM samples are read by the caller */
+  fm_queue_drain();
+
 #ifdef LOGSOUND
   if (config_hq_fm)
     error("%d FM samples (%d) available\n",Fir_Resampler_avail(), Fir_Resampler_written() >> 1);
@@ -346,21 +504,89 @@ int sound_update(unsigned int cycles)
 void fm_reset(unsigned int cycles)
 {
   fm_update(cycles << 11);
+  fm_queue_drain();
   YM_Reset();
+  if (fm_async) YM2612TimersSync();
 }
 
 /* Write FM chip */
 void fm_write(unsigned int cycles, unsigned int address, unsigned int data)
 {
   if (address & 1) fm_update(cycles << 11);
-  YM_Write(address, data);
+  if (fm_async)
+  {
+    t_fm_cmd *cmd = fm_queue_cmd();
+    cmd->type = FM_CMD_WRITE;
+    cmd->address = address;
+    cmd->data = data;
+    fm_queue_add();
+    YM2612TimersWrite(address, data);
+  }
+  else
+  {
+    YM_Write(address, data);
+  }
 }
 
 /* Read FM status (YM2612 only) */
 unsigned int fm_read(unsigned int cycles, unsigned int address)
 {
   fm_update(cycles << 11);
-  return YM2612Read();
+  return fm_async ? YM2612TimersRead() : YM2612Read();
+}
+
+/* Pass the FM samples up to this point to the worker thread, so it can */
+/* run in parallel with the rest of the frame                           */
+void fm_sync(unsigned int cycles)
+{
+  if (fm_async)
+  {
+    fm_update(cycles << 11);
+    fm_queue_flush();
+  }
+}
+
+/* Start or stop the YM2612 synthesis thread */
+void fm_set_threaded(int enable)
+{
+  if (enable == fm_thread.enabled)
+    return;
+
+  if (enable)
+  {
+    fm_thread.mutex.create();
+    fm_thread.workCond.create(&fm_thread.mutex);
+    fm_thread.doneCond.create(&fm_thread.mutex);
+    fm_thread.quit = 0;
+    fm_thread.written = fm_thread.queued = fm_thread.done = fm_thread.freed = 0;
+    if (!fm_thread.thread.create(0, fm_worker, &fm_thread))
+    {
+      logWarn("unable to start FM thread, running YM2612 synchronously");
+      fm_thread.workCond.destroy();
+      fm_thread.doneCond.destroy();
+      fm_thread.mutex.destroy();
+      return;
+    }
+    fm_thread.enabled = 1;
+
+    /* timer state is read from the copy from now on */
+    YM2612TimersSync();
+  }
+  else
+  {
+    fm_queue_drain();
+    fm_thread.mutex.lock();
+    fm_thread.quit = 1;
+    fm_thread.workCond.signal();
+    fm_thread.mutex.unlock();
+    fm_thread.thread.join();
+    fm_thread.enabled = 0;
+    fm_thread.workCond.destroy();
+    fm_thread.doneCond.destroy();
+    fm_thread.mutex.destroy();
+  }
+
+  fm_async = fm_thread.enabled && (YM_Update == YM2612Update);
 }
 
 /* Write PSG chip */
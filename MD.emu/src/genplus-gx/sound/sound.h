@@ -34,6 +34,8 @@ extern int sound_update(unsigned int cycles);
 extern void fm_reset(unsigned int cycles);
 extern void fm_write(unsigned int cycles, unsigned int address, unsigned int data);
 extern unsigned int fm_read(unsigned int cycles, unsigned int address);
+extern void fm_sync(unsigned int cycles);
+extern void fm_set_threaded(int enable);
 extern void psg_write(unsigned int cycles, unsigned int data);
 
 #endif /* _SOUND_H_ */
@@ -133,6 +133,14 @@
 
 #include "shared.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define YM2612_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define YM2612_NEON
+#endif
+
 /* compiler dependence */
 #ifndef INLINE
 #define INLINE static __inline__
@@ -175,7 +183,7 @@
 *   TL_RES_LEN - sinus resolution (X axis)
 */
 #define TL_TAB_LEN (13*2*TL_RES_LEN)
-static signed int tl_tab[TL_TAB_LEN];
+static signed int tl_tab[TL_TAB_LEN + 1]; /* last entry stays 0, for indexes clamped to TL_TAB_LEN */
 
 #define ENV_QUIET    (TL_TAB_LEN>>3)
 
@@ -629,6 +637,60 @@ typedef struct
 /* emulated chip */
 static YM2612 ym2612;
 
+/* Operator state used for synthesis, in SoA form so one operator of every */
+/* channel is calculated at once. Rows are slots in CH->SLOT order (which  */
+/* is also the calculation order: SLOT1, SLOT3, SLOT2, SLOT4), lanes are   */
+/* channels. Phase, EG output, AM enable, op1 outputs and MEM only live    */
+/* here, pack_ops() copies them to the YM2612 struct for the saved context */
+/* and unpack_ops() back.                                                  */
+#define OPS_LANES 8
+
+/* where MEM, op1, op3 (M2) and op2 (C1) outputs go (see setup_connection) */
+#define TO_M2   0x01
+#define TO_C1   0x02
+#define TO_C2   0x04
+#define TO_MEM  0x08
+#define TO_OUT  0x10
+
+static const UINT8 algo_routing[8][4] =
+{
+  /* MEM     op1                    op3     op2 */
+  { TO_M2,  TO_C1,                 TO_C2,  TO_MEM },
+  { TO_M2,  TO_MEM,                TO_C2,  TO_MEM },
+  { TO_M2,  TO_C2,                 TO_C2,  TO_MEM },
+  { TO_C2,  TO_C1,                 TO_C2,  TO_MEM },
+  { TO_MEM, TO_C1,                 TO_C2,  TO_OUT },
+  { TO_M2,  TO_C1 | TO_C2 | TO_MEM, TO_OUT, TO_OUT },
+  { TO_MEM, TO_C1,                 TO_OUT, TO_OUT },
+  { TO_MEM, TO_OUT,                TO_OUT, TO_OUT }
+};
+
+typedef struct
+{
+  UINT32  phase[4][OPS_LANES];    /* phase counters */
+  UINT32  Incr[4][OPS_LANES];     /* phase steps with LFO PM applied, 0 if not calculated */
+  UINT32  vol_out[4][OPS_LANES];  /* EG outputs (without AM from LFO) */
+  UINT32  AMmask[4][OPS_LANES];   /* AM enable flags */
+  UINT32  AM[OPS_LANES];          /* LFO AM level of each channel */
+  INT32   op1_out[2][OPS_LANES];  /* op1 outputs for feedback */
+  INT32   mem_value[OPS_LANES];   /* delayed samples (MEM) */
+  INT32   active[OPS_LANES];      /* ~0 if the channel is calculated (not DAC or unused) */
+
+  /* ~0 where an output goes to an input, from algo_routing */
+  INT32   mem_to[3][OPS_LANES];   /* MEM to m2, c2, mem */
+  INT32   op1_to[4][OPS_LANES];   /* op1 to c1, c2, mem, out */
+  INT32   op3_to[2][OPS_LANES];   /* op3 to c2, out */
+  INT32   op2_to[2][OPS_LANES];   /* op2 to mem, out */
+
+  UINT32  LFO_PM;                 /* LFO PM step Incr is valid for (~0 = none) */
+  UINT32  LFO_AM;                 /* LFO AM step AM is valid for (~0 = none) */
+} FM_OPS;
+
+static FM_OPS ops __attribute__ ((aligned(16)));
+
+/* copy of the timer state for YM2612Timers* functions */
+static FM_ST timer_st;
+
 /* current chip state */
 static INT32  m2,c1,c2;   /* Phase Modulation input for operators 2,3,4 */
 static INT32  mem;        /* one sample delay memory */
@@ -643,11 +705,12 @@ static INT32  out_fm[8];  /* outputs of working channels */
 INLINE void FM_KEYON(FM_CH *CH , int s )
 {
   FM_SLOT *SLOT = &CH->SLOT[s];
+  int c = CH - ym2612.CH;
 
   if (!SLOT->key && !ym2612.OPN.SL3.key_csm)
   {
     /* restart Phase Generator */
-    SLOT->phase = 0;
+    ops.phase[s][c] = 0;
 
     /* reset SSG-EG inversion flag */
     SLOT->ssgn = 0;
@@ -667,9 +730,9 @@ INLINE void FM_KEYON(FM_CH *CH , int s )
 
     /* recalculate EG output */
     if ((SLOT->ssg&0x08) && (SLOT->ssgn ^ (SLOT->ssg&0x04)))
-      SLOT->vol_out = ((UINT32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
+      ops.vol_out[s][c] = ((UINT32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
     else
-      SLOT->vol_out = (UINT32)SLOT->volume + SLOT->tl;
+      ops.vol_out[s][c] = (UINT32)SLOT->volume + SLOT->tl;
   }
 
   SLOT->key = 1;
@@ -678,6 +741,7 @@ INLINE void FM_KEYON(FM_CH *CH , int s )
 INLINE void FM_KEYOFF(FM_CH *CH , int s )
 {
   FM_SLOT *SLOT = &CH->SLOT[s];
+  int c = CH - ym2612.CH;
 
   if (SLOT->key && !ym2612.OPN.SL3.key_csm)
   {
@@ -700,7 +764,7 @@ INLINE void FM_KEYOFF(FM_CH *CH , int s )
         }
 
         /* recalculate EG output */
-        SLOT->vol_out = (UINT32)SLOT->volume + SLOT->tl;
+        ops.vol_out[s][c] = (UINT32)SLOT->volume + SLOT->tl;
       }
     }
   }
@@ -711,11 +775,12 @@ INLINE void FM_KEYOFF(FM_CH *CH , int s )
 INLINE void FM_KEYON_CSM(FM_CH *CH , int s )
 {
   FM_SLOT *SLOT = &CH->SLOT[s];
+  int c = CH - ym2612.CH;
 
   if (!SLOT->key && !ym2612.OPN.SL3.key_csm)
   {
     /* restart Phase Generator */
-    SLOT->phase = 0;
+    ops.phase[s][c] = 0;
 
     /* reset SSG-EG inversion flag */
     SLOT->ssgn = 0;
@@ -735,15 +800,16 @@ INLINE void FM_KEYON_CSM(FM_CH *CH , int s )
 
     /* recalculate EG output */
     if ((SLOT->ssg&0x08) && (SLOT->ssgn ^ (SLOT->ssg&0x04)))
-      SLOT->vol_out = ((UINT32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
+      ops.vol_out[s][c] = ((UINT32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
     else
-      SLOT->vol_out = (UINT32)SLOT->volume + SLOT->tl;
+      ops.vol_out[s][c] = (UINT32)SLOT->volume + SLOT->tl;
   }
 }
 
 INLINE void FM_KEYOFF_CSM(FM_CH *CH , int s )
 {
   FM_SLOT *SLOT = &CH->SLOT[s];
+  int c = CH - ym2612.CH;
   if (!SLOT->key)
   {
     if (SLOT->state>EG_REL)
@@ -765,7 +831,7 @@ INLINE void FM_KEYOFF_CSM(FM_CH *CH , int s )
         }
 
         /* recalculate EG output */
-        SLOT->vol_out = (UINT32)SLOT->volume + SLOT->tl;
+        ops.vol_out[s][c] = (UINT32)SLOT->volume + SLOT->tl;
       }
     }
   }
@@ -782,48 +848,98 @@ INLINE void CSMKeyControll(FM_CH *CH)
   ym2612.OPN.SL3.key_csm = 1;
 }
 
-INLINE void INTERNAL_TIMER_A()
+/* timers only depend on the FM_ST state, so they can also be run on */
+/* the copy used for status reads in threaded mode                   */
+INLINE int TIMER_A(FM_ST *ST)
 {
-  if (ym2612.OPN.ST.mode & 0x01)
+  if (ST->mode & 0x01)
   {
-    if ((ym2612.OPN.ST.TAC -= ym2612.OPN.ST.TimerBase) <= 0)
+    if ((ST->TAC -= ST->TimerBase) <= 0)
     {
       /* set status (if enabled) */
-      if (ym2612.OPN.ST.mode & 0x04)
-        ym2612.OPN.ST.status |= 0x01;
+      if (ST->mode & 0x04)
+        ST->status |= 0x01;
 
       /* reload the counter */
-      if (ym2612.OPN.ST.TAL)
-        ym2612.OPN.ST.TAC += ym2612.OPN.ST.TAL;
+      if (ST->TAL)
+        ST->TAC += ST->TAL;
       else
-        ym2612.OPN.ST.TAC = ym2612.OPN.ST.TAL;
+        ST->TAC = ST->TAL;
 
-      /* CSM mode auto key on */
-      if ((ym2612.OPN.ST.mode & 0xC0) == 0x80)
-        CSMKeyControll(&ym2612.CH[2]);
+      return 1;
     }
   }
+  return 0;
 }
 
-INLINE void INTERNAL_TIMER_B(int step)
+INLINE void TIMER_B(FM_ST *ST, int step)
 {
-  if (ym2612.OPN.ST.mode & 0x02)
+  if (ST->mode & 0x02)
   {
-    if ((ym2612.OPN.ST.TBC -= (ym2612.OPN.ST.TimerBase * step)) <= 0)
+    if ((ST->TBC -= (ST->TimerBase * step)) <= 0)
     {
       /* set status (if enabled) */
-      if (ym2612.OPN.ST.mode & 0x08)
-        ym2612.OPN.ST.status |= 0x02;
+      if (ST->mode & 0x08)
+        ST->status |= 0x02;
 
       /* reload the counter */
-      if (ym2612.OPN.ST.TBL)
-        ym2612.OPN.ST.TBC += ym2612.OPN.ST.TBL;
+      if (ST->TBL)
+        ST->TBC += ST->TBL;
       else
-        ym2612.OPN.ST.TBC = ym2612.OPN.ST.TBL;
+        ST->TBC = ST->TBL;
     }
   }
 }
 
+INLINE void INTERNAL_TIMER_A()
+{
+  if (TIMER_A(&ym2612.OPN.ST))
+  {
+    /* CSM mode auto key on */
+    if ((ym2612.OPN.ST.mode & 0xC0) == 0x80)
+      CSMKeyControll(&ym2612.CH[2]);
+  }
+}
+
+INLINE void INTERNAL_TIMER_B(int step)
+{
+  TIMER_B(&ym2612.OPN.ST, step);
+}
+
+/* timer registers 0x24-0x26 */
+INLINE void set_timer_reg(FM_ST *ST, int r, int v)
+{
+  switch(r){
+    case 0x24:  /* timer A High 8*/
+      ST->TA = (ST->TA & 0x03)|(((int)v)<<2);
+      ST->TAL = (1024 - ST->TA) << TIMER_SH;
+      break;
+    case 0x25:  /* timer A Low 2*/
+      ST->TA = (ST->TA & 0x3fc)|(v&3);
+      ST->TAL = (1024 - ST->TA) << TIMER_SH;
+      break;
+    case 0x26:  /* timer B */
+      ST->TB = v;
+      ST->TBL = (256 - ST->TB) << (TIMER_SH + 4);
+      break;
+  }
+}
+
+/* timer part of the mode register */
+INLINE void set_timers_st(FM_ST *ST, int v)
+{
+  /* reload Timers */
+  if ((v&1) && !(ST->mode&1))
+    ST->TAC = ST->TAL;
+  if ((v&2) && !(ST->mode&2))
+    ST->TBC = ST->TBL;
+
+  /* reset Timers flags */
+  ST->status &= (~v >> 4);
+
+  ST->mode = v;
+}
+
 /* OPN Mode Register Write */
 INLINE void set_timers(int v )
 {
@@ -853,16 +969,7 @@ INLINE void set_timers(int v )
     }
   }
 
-  /* reload Timers */
-  if ((v&1) && !(ym2612.OPN.ST.mode&1))
-    ym2612.OPN.ST.TAC = ym2612.OPN.ST.TAL;
-  if ((v&2) && !(ym2612.OPN.ST.mode&2))
-    ym2612.OPN.ST.TBC = ym2612.OPN.ST.TBL;
-  
-  /* reset Timers flags */
-  ym2612.OPN.ST.status &= (~v >> 4); 
-
-  ym2612.OPN.ST.mode = v;
+  set_timers_st(&ym2612.OPN.ST, v);
 }
 
 /* set algorithm connection */
@@ -950,6 +1057,20 @@ INLINE void setup_connection( FM_CH *CH, int ch )
   }
 
   CH->connect4 = carrier;
+
+  /* same connections as masks for the SoA operators */
+  const UINT8 *route = algo_routing[CH->ALGO];
+  ops.mem_to[0][ch] = (route[0] & TO_M2)  ? ~0 : 0;
+  ops.mem_to[1][ch] = (route[0] & TO_C2)  ? ~0 : 0;
+  ops.mem_to[2][ch] = (route[0] & TO_MEM) ? ~0 : 0;
+  ops.op1_to[0][ch] = (route[1] & TO_C1)  ? ~0 : 0;
+  ops.op1_to[1][ch] = (route[1] & TO_C2)  ? ~0 : 0;
+  ops.op1_to[2][ch] = (route[1] & TO_MEM) ? ~0 : 0;
+  ops.op1_to[3][ch] = (route[1] & TO_OUT) ? ~0 : 0;
+  ops.op3_to[0][ch] = (route[2] & TO_C2)  ? ~0 : 0;
+  ops.op3_to[1][ch] = (route[2] & TO_OUT) ? ~0 : 0;
+  ops.op2_to[0][ch] = (route[3] & TO_MEM) ? ~0 : 0;
+  ops.op2_to[1][ch] = (route[3] & TO_OUT) ? ~0 : 0;
 }
 
 /* set detune & multiple */
@@ -961,15 +1082,15 @@ INLINE void set_det_mul(FM_CH *CH,FM_SLOT *SLOT,int v)
 }
 
 /* set total level */
-INLINE void set_tl(FM_SLOT *SLOT , int v)
+INLINE void set_tl(FM_SLOT *SLOT , UINT32 *vol_out , int v)
 {
   SLOT->tl = (v&0x7f)<<(ENV_BITS-7); /* 7bit TL */
 
   /* recalculate EG output */
   if ((SLOT->ssg&0x08) && (SLOT->ssgn ^ (SLOT->ssg&0x04)) && (SLOT->state > EG_REL))
-    SLOT->vol_out = ((UINT32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
+    *vol_out = ((UINT32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
   else
-    SLOT->vol_out = (UINT32)SLOT->volume + SLOT->tl;
+    *vol_out = (UINT32)SLOT->volume + SLOT->tl;
 }
 
 /* set attack rate & key scale  */
@@ -1066,8 +1187,9 @@ INLINE void advance_lfo()
 }
 
 
-INLINE void advance_eg_channel(FM_SLOT *SLOT)
+INLINE void advance_eg_channel(FM_SLOT *SLOT, int c)
 {
+  UINT32 *vol_out = &ops.vol_out[0][c];
   unsigned int i = 4; /* four operators per channel */
 
   do
@@ -1089,9 +1211,9 @@ INLINE void advance_eg_channel(FM_SLOT *SLOT)
 
           /* recalculate EG output */
           if ((SLOT->ssg&0x08) && (SLOT->ssgn ^ (SLOT->ssg&0x04)))  /* SSG-EG Output Inversion */
-            SLOT->vol_out = ((UINT32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
+            *vol_out = ((UINT32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
           else
-            SLOT->vol_out = (UINT32)SLOT->volume + SLOT->tl;
+            *vol_out = (UINT32)SLOT->volume + SLOT->tl;
         }
         break;
 
@@ -1108,9 +1230,9 @@ INLINE void advance_eg_channel(FM_SLOT *SLOT)
 
               /* recalculate EG output */
               if (SLOT->ssgn ^ (SLOT->ssg&0x04))   /* SSG-EG Output Inversion */
-                SLOT->vol_out = ((UINT32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
+                *vol_out = ((UINT32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
               else
-                SLOT->vol_out = (UINT32)SLOT->volume + SLOT->tl;
+                *vol_out = (UINT32)SLOT->volume + SLOT->tl;
             }
           }
           else
@@ -1119,7 +1241,7 @@ INLINE void advance_eg_channel(FM_SLOT *SLOT)
             SLOT->volume += eg_inc[SLOT->eg_sel_d1r + ((ym2612.OPN.eg_cnt>>SLOT->eg_sh_d1r)&7)];
 
             /* recalculate EG output */
-            SLOT->vol_out = (UINT32)SLOT->volume + SLOT->tl;
+            *vol_out = (UINT32)SLOT->volume + SLOT->tl;
           }
 
           /* check phase transition*/
@@ -1141,9 +1263,9 @@ INLINE void advance_eg_channel(FM_SLOT *SLOT)
 
               /* recalculate EG output */
               if (SLOT->ssgn ^ (SLOT->ssg&0x04))   /* SSG-EG Output Inversion */
-                SLOT->vol_out = ((UINT32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
+                *vol_out = ((UINT32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
               else
-                SLOT->vol_out = (UINT32)SLOT->volume + SLOT->tl;
+                *vol_out = (UINT32)SLOT->volume + SLOT->tl;
             }
           }
           else
@@ -1157,7 +1279,7 @@ INLINE void advance_eg_channel(FM_SLOT *SLOT)
               /* do not change SLOT->state (verified on real chip) */
 
             /* recalculate EG output */
-            SLOT->vol_out = (UINT32)SLOT->volume + SLOT->tl;
+            *vol_out = (UINT32)SLOT->volume + SLOT->tl;
           }
         }
         break;
@@ -1193,13 +1315,14 @@ INLINE void advance_eg_channel(FM_SLOT *SLOT)
           }
 
           /* recalculate EG output */
-          SLOT->vol_out = (UINT32)SLOT->volume + SLOT->tl;
+          *vol_out = (UINT32)SLOT->volume + SLOT->tl;
 
         }
         break;
     }
 
     SLOT++;
+    vol_out += OPS_LANES;
     i--;
   } while (i);
 }
@@ -1207,8 +1330,10 @@ INLINE void advance_eg_channel(FM_SLOT *SLOT)
 /* SSG-EG update process */
 /* The behavior is based upon Nemesis tests on real hardware */
 /* This is actually executed before each samples */
-INLINE void update_ssg_eg_channel(FM_SLOT *SLOT)
+INLINE void update_ssg_eg_channel(FM_SLOT *SLOT, int c)
 {
+  UINT32 *phase = &ops.phase[0][c];
+  UINT32 *vol_out = &ops.vol_out[0][c];
   unsigned int i = 4; /* four operators per channel */
 
   do
@@ -1234,7 +1359,7 @@ INLINE void update_ssg_eg_channel(FM_SLOT *SLOT)
         if (SLOT->ssg & 0x02)
           SLOT->ssgn ^= 4;
         else
-          SLOT->phase = 0;
+          *phase = 0;
 
         /* same as Key ON */
         if (SLOT->state != EG_ATT)
@@ -1254,22 +1379,25 @@ INLINE void update_ssg_eg_channel(FM_SLOT *SLOT)
 
       /* recalculate EG output */
       if (SLOT->ssgn ^ (SLOT->ssg&0x04))
-        SLOT->vol_out = ((UINT32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
+        *vol_out = ((UINT32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
       else
-        SLOT->vol_out = (UINT32)SLOT->volume + SLOT->tl;
+        *vol_out = (UINT32)SLOT->volume + SLOT->tl;
     }
 
     /* next slot */
     SLOT++;
+    phase += OPS_LANES;
+    vol_out += OPS_LANES;
     i--;
    } while (i);
 }
 
-INLINE void update_phase_lfo_slot(FM_SLOT *SLOT , INT32 pms, UINT32 block_fnum)
+/* phase increment of a slot with LFO PM applied */
+INLINE UINT32 pm_incr(FM_SLOT *SLOT , INT32 pms, UINT32 block_fnum)
 {
   UINT32 fnum_lfo   = ((block_fnum & 0x7f0) >> 4) * 32 * 8;
   INT32  lfo_fn_table_index_offset = lfo_pm_table[ fnum_lfo + pms + ym2612.OPN.LFO_PM ];
-  
+
   if (lfo_fn_table_index_offset)  /* LFO phase modulation active */
   {
     block_fnum = block_fnum*2 + lfo_fn_table_index_offset;
@@ -1282,63 +1410,54 @@ INLINE void update_phase_lfo_slot(FM_SLOT *SLOT , INT32 pms, UINT32 block_fnum)
 
     /* (frequency) phase increment counter */
     int fc = (ym2612.OPN.fn_table[fn]>>(7-blk)) + SLOT->DT[kc];
-      
+
     /* (frequency) phase overflow (credits to Nemesis) */
     if (fc < 0) fc += ym2612.OPN.fn_max;
 
-    /* update phase */
-    SLOT->phase += (fc * SLOT->mul) >> 1;
-  }
-  else  /* LFO phase modulation  = zero */
-  {
-    SLOT->phase += SLOT->Incr;
+    return (fc * SLOT->mul) >> 1;
   }
+
+  /* LFO phase modulation  = zero */
+  return SLOT->Incr;
 }
 
-INLINE void update_phase_lfo_channel(FM_CH *CH)
+/* recalculate the SoA phase increments for the current LFO PM step */
+INLINE void update_ops_incr()
 {
-  UINT32 block_fnum = CH->block_fnum;
-  
-  UINT32 fnum_lfo   = ((block_fnum & 0x7f0) >> 4) * 32 * 8;
-  INT32  lfo_fn_table_index_offset = lfo_pm_table[ fnum_lfo + CH->pms + ym2612.OPN.LFO_PM ];
+  int c;
 
-  if (lfo_fn_table_index_offset)  /* LFO phase modulation active */
+  for (c = 0; c < 6; c++)
   {
-    block_fnum = block_fnum*2 + lfo_fn_table_index_offset;
-
-    UINT8 blk = (block_fnum&0x7000) >> 12;
-    UINT32 fn  = block_fnum & 0xfff;
-    
-    /* keyscale code */
-    int kc = (blk<<2) | opn_fktable[fn >> 8];
-
-     /* (frequency) phase increment counter */
-    int fc = (ym2612.OPN.fn_table[fn]>>(7-blk));
-
-    /* (frequency) phase overflow (credits to Nemesis) */
-    int finc = fc + CH->SLOT[SLOT1].DT[kc];
-    if (finc < 0) finc += ym2612.OPN.fn_max;
-    CH->SLOT[SLOT1].phase += (finc*CH->SLOT[SLOT1].mul) >> 1;
-
-    finc = fc + CH->SLOT[SLOT2].DT[kc];
-    if (finc < 0) finc += ym2612.OPN.fn_max;
-    CH->SLOT[SLOT2].phase += (finc*CH->SLOT[SLOT2].mul) >> 1;
-
-    finc = fc + CH->SLOT[SLOT3].DT[kc];
-    if (finc < 0) finc += ym2612.OPN.fn_max;
-    CH->SLOT[SLOT3].phase += (finc*CH->SLOT[SLOT3].mul) >> 1;
+    FM_CH *CH = &ym2612.CH[c];
 
-    finc = fc + CH->SLOT[SLOT4].DT[kc];
-    if (finc < 0) finc += ym2612.OPN.fn_max;
-    CH->SLOT[SLOT4].phase += (finc*CH->SLOT[SLOT4].mul) >> 1;
-  }
-  else  /* LFO phase modulation  = zero */
-  {
-    CH->SLOT[SLOT1].phase += CH->SLOT[SLOT1].Incr;
-    CH->SLOT[SLOT2].phase += CH->SLOT[SLOT2].Incr;
-    CH->SLOT[SLOT3].phase += CH->SLOT[SLOT3].Incr;
-    CH->SLOT[SLOT4].phase += CH->SLOT[SLOT4].Incr;
+    if (!ops.active[c])
+    {
+      ops.Incr[SLOT1][c] = ops.Incr[SLOT2][c] = ops.Incr[SLOT3][c] = ops.Incr[SLOT4][c] = 0;
+    }
+    else if (!CH->pms)  /* no LFO phase modulation */
+    {
+      ops.Incr[SLOT1][c] = CH->SLOT[SLOT1].Incr;
+      ops.Incr[SLOT3][c] = CH->SLOT[SLOT3].Incr;
+      ops.Incr[SLOT2][c] = CH->SLOT[SLOT2].Incr;
+      ops.Incr[SLOT4][c] = CH->SLOT[SLOT4].Incr;
+    }
+    else if ((ym2612.OPN.ST.mode & 0xC0) && (c == 2))  /* 3 slot mode */
+    {
+      ops.Incr[SLOT1][c] = pm_incr(&CH->SLOT[SLOT1], CH->pms, ym2612.OPN.SL3.block_fnum[1]);
+      ops.Incr[SLOT3][c] = pm_incr(&CH->SLOT[SLOT3], CH->pms, ym2612.OPN.SL3.block_fnum[0]);
+      ops.Incr[SLOT2][c] = pm_incr(&CH->SLOT[SLOT2], CH->pms, ym2612.OPN.SL3.block_fnum[2]);
+      ops.Incr[SLOT4][c] = pm_incr(&CH->SLOT[SLOT4], CH->pms, CH->block_fnum);
+    }
+    else
+    {
+      ops.Incr[SLOT1][c] = pm_incr(&CH->SLOT[SLOT1], CH->pms, CH->block_fnum);
+      ops.Incr[SLOT3][c] = pm_incr(&CH->SLOT[SLOT3], CH->pms, CH->block_fnum);
+      ops.Incr[SLOT2][c] = pm_incr(&CH->SLOT[SLOT2], CH->pms, CH->block_fnum);
+      ops.Incr[SLOT4][c] = pm_incr(&CH->SLOT[SLOT4], CH->pms, CH->block_fnum);
+    }
   }
+
+  ops.LFO_PM = ym2612.OPN.LFO_PM;
 }
 
 /* update phase increment and envelope generator */
@@ -1396,97 +1515,148 @@ INLINE void refresh_fc_eg_chan(FM_CH *CH )
   }
 }
 
-#define volume_calc(OP) ((OP)->vol_out + (AM & (OP)->AMmask))
-
-INLINE signed int op_calc(UINT32 phase, unsigned int env, signed int pm)
+/* lanes of operator rows calculated at once: four channels with SIMD, */
+/* one without                                                         */
+#if defined(YM2612_SSE2)
+#define OPS_WIDTH 4
+typedef __m128i OPS_VEC;
+#define vec_load(p)      _mm_load_si128((const __m128i *)(p))
+#define vec_store(p,a)   _mm_store_si128((__m128i *)(p), a)
+#define vec_set1(x)      _mm_set1_epi32(x)
+#define vec_add(a,b)     _mm_add_epi32(a, b)
+#define vec_and(a,b)     _mm_and_si128(a, b)
+#define vec_sel(m,a,b)   _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b))
+#define vec_shl(a,n)     _mm_slli_epi32(a, n)
+#define vec_shr(a,n)     _mm_srli_epi32(a, n)
+INLINE OPS_VEC vec_min(OPS_VEC a, OPS_VEC b)  /* unsigned */
 {
-  UINT32 p;
-
-  p = (env<<3) + sin_tab[ ( ((signed int)((phase & ~FREQ_MASK) + (pm<<15))) >> FREQ_SH ) & SIN_MASK ];
-
-  if (p >= TL_TAB_LEN)
-    return 0;
-  return tl_tab[p];
+  OPS_VEC sign = _mm_set1_epi32(0x80000000);
+  return vec_sel(_mm_cmpgt_epi32(_mm_xor_si128(a, sign), _mm_xor_si128(b, sign)), b, a);
 }
-
-INLINE signed int op_calc1(UINT32 phase, unsigned int env, signed int pm)
+#define vec_make(a,b,c,d) _mm_set_epi32(d, c, b, a)
+#elif defined(YM2612_NEON)
+#define OPS_WIDTH 4
+typedef int32x4_t OPS_VEC;
+#define vec_load(p)      vld1q_s32((const int32_t *)(p))
+#define vec_store(p,a)   vst1q_s32((int32_t *)(p), a)
+#define vec_set1(x)      vdupq_n_s32(x)
+#define vec_add(a,b)     vaddq_s32(a, b)
+#define vec_and(a,b)     vandq_s32(a, b)
+#define vec_sel(m,a,b)   vbslq_s32(vreinterpretq_u32_s32(m), a, b)
+#define vec_shl(a,n)     vshlq_n_s32(a, n)
+#define vec_shr(a,n)     vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(a), n))
+#define vec_min(a,b)     vreinterpretq_s32_u32(vminq_u32(vreinterpretq_u32_s32(a), vreinterpretq_u32_s32(b)))
+INLINE OPS_VEC vec_make(INT32 a, INT32 b, INT32 c, INT32 d)
 {
-  UINT32 p;
-
-  p = (env<<3) + sin_tab[ ( ((signed int)((phase & ~FREQ_MASK) + pm      )) >> FREQ_SH ) & SIN_MASK ];
-
-  if (p >= TL_TAB_LEN)
-    return 0;
-  return tl_tab[p];
+  INT32 v[4] = { a, b, c, d };
+  return vld1q_s32(v);
 }
+#else
+#define OPS_WIDTH 1
+typedef INT32 OPS_VEC;
+#define vec_load(p)      (*(const INT32 *)(p))
+#define vec_store(p,a)   (*(INT32 *)(p) = (a))
+#define vec_set1(x)      ((INT32)(x))
+#define vec_add(a,b)     ((a) + (b))
+#define vec_and(a,b)     ((a) & (b))
+#define vec_sel(m,a,b)   (((m) & (a)) | (~(m) & (b)))
+#define vec_shl(a,n)     ((INT32)((UINT32)(a) << (n)))
+#define vec_shr(a,n)     ((INT32)((UINT32)(a) >> (n)))
+#define vec_min(a,b)     (((UINT32)(a) < (UINT32)(b)) ? (a) : (b))
+#define vec_make(a,b,c,d) (a)
+#endif
 
-INLINE void chan_calc(FM_CH *CH)
+/* one operator of OPS_WIDTH channels: env is the attenuation with AM,  */
+/* pm the phase modulation already shifted. Table lookups are done in   */
+/* scalar code for the first lanes only, the others output 0.           */
+INLINE OPS_VEC op_calc(OPS_VEC phase, OPS_VEC env, OPS_VEC pm, int lanes)
 {
-  UINT32 AM = ym2612.OPN.LFO_AM >> CH->ams;
+  INT32 idx[OPS_WIDTH] __attribute__ ((aligned(16)));
+  UINT32 att[OPS_WIDTH] __attribute__ ((aligned(16)));
+  INT32 out[4] = { 0, 0, 0, 0 };
+  int l;
 
-  m2 = c1 = c2 = mem = 0;
+  vec_store(idx, vec_and(vec_shr(vec_add(vec_and(phase, vec_set1(~FREQ_MASK)), pm), FREQ_SH), vec_set1(SIN_MASK)));
 
-  *CH->mem_connect = CH->mem_value;  /* restore delayed sample (MEM) value to m2 or c2 */
+  /* EG outputs of ENV_QUIET and over (or wrapped below 0) give 0 */
+  vec_store(att, vec_shl(vec_min(env, vec_set1(ENV_QUIET)), 3));
 
-  unsigned int eg_out = volume_calc(&CH->SLOT[SLOT1]);
+  for (l = 0; l < lanes; l++)
   {
-    INT32 out = CH->op1_out[0] + CH->op1_out[1];
-    CH->op1_out[0] = CH->op1_out[1];
-
-    if( !CH->connect1 ){
-      /* algorithm 5  */
-      mem = c1 = c2 = CH->op1_out[0];
-    }else{
-      /* other algorithms */
-      *CH->connect1 += CH->op1_out[0];
-    }
-
-    CH->op1_out[1] = 0;
-    if( eg_out < ENV_QUIET )  /* SLOT 1 */
-    {
-      if (!CH->FB)
-        out=0;
-
-      CH->op1_out[1] = op_calc1(CH->SLOT[SLOT1].phase, eg_out, (out<<CH->FB) );
-    }
+    UINT32 p = att[l] + sin_tab[idx[l]];
+    out[l] = tl_tab[(p < TL_TAB_LEN) ? p : TL_TAB_LEN];
   }
 
-  eg_out = volume_calc(&CH->SLOT[SLOT3]);
-  if( eg_out < ENV_QUIET )    /* SLOT 3 */
-    *CH->connect3 += op_calc(CH->SLOT[SLOT3].phase, eg_out, m2);
-
-  eg_out = volume_calc(&CH->SLOT[SLOT2]);
-  if( eg_out < ENV_QUIET )    /* SLOT 2 */
-    *CH->connect2 += op_calc(CH->SLOT[SLOT2].phase, eg_out, c1);
-
-  eg_out = volume_calc(&CH->SLOT[SLOT4]);
-  if( eg_out < ENV_QUIET )    /* SLOT 4 */
-    *CH->connect4 += op_calc(CH->SLOT[SLOT4].phase, eg_out, c2);
+  return vec_make(out[0], out[1], out[2], out[3]);
+}
 
+/* calculate channels k to k+lanes-1, outputs go to out_fm */
+INLINE void chan_calc(int k, int lanes, const INT32 *pm1)
+{
+  OPS_VEC active = vec_load(&ops.active[k]);
+  OPS_VEC AM = vec_load(&ops.AM[k]);
+
+  /* restore delayed sample (MEM) value to m2 or c2 */
+  OPS_VEC mem_value = vec_load(&ops.mem_value[k]);
+  OPS_VEC m2  = vec_and(mem_value, vec_load(&ops.mem_to[0][k]));
+  OPS_VEC c2  = vec_and(mem_value, vec_load(&ops.mem_to[1][k]));
+  OPS_VEC mem = vec_and(mem_value, vec_load(&ops.mem_to[2][k]));
+
+  /* SLOT 1, previous output goes to the other operators */
+  OPS_VEC out = vec_load(&ops.op1_out[1][k]);
+  OPS_VEC c1  = vec_and(out, vec_load(&ops.op1_to[0][k]));
+  c2  = vec_add(c2, vec_and(out, vec_load(&ops.op1_to[1][k])));
+  mem = vec_add(mem, vec_and(out, vec_load(&ops.op1_to[2][k])));
+  vec_store(&ops.op1_out[0][k], vec_sel(active, out, vec_load(&ops.op1_out[0][k])));
+  OPS_VEC env = vec_add(vec_load(&ops.vol_out[0][k]), vec_and(AM, vec_load(&ops.AMmask[0][k])));
+  vec_store(&ops.op1_out[1][k], vec_sel(active, op_calc(vec_load(&ops.phase[0][k]), env, vec_load(&pm1[k]), lanes), out));
+  out = vec_and(out, vec_load(&ops.op1_to[3][k]));
+
+  /* SLOT 3 */
+  env = vec_add(vec_load(&ops.vol_out[1][k]), vec_and(AM, vec_load(&ops.AMmask[1][k])));
+  OPS_VEC op = op_calc(vec_load(&ops.phase[1][k]), env, vec_shl(m2, 15), lanes);
+  c2  = vec_add(c2, vec_and(op, vec_load(&ops.op3_to[0][k])));
+  out = vec_add(out, vec_and(op, vec_load(&ops.op3_to[1][k])));
+
+  /* SLOT 2 */
+  env = vec_add(vec_load(&ops.vol_out[2][k]), vec_and(AM, vec_load(&ops.AMmask[2][k])));
+  op  = op_calc(vec_load(&ops.phase[2][k]), env, vec_shl(c1, 15), lanes);
+  mem = vec_add(mem, vec_and(op, vec_load(&ops.op2_to[0][k])));
+  out = vec_add(out, vec_and(op, vec_load(&ops.op2_to[1][k])));
+
+  /* SLOT 4 */
+  env = vec_add(vec_load(&ops.vol_out[3][k]), vec_and(AM, vec_load(&ops.AMmask[3][k])));
+  out = vec_add(out, op_calc(vec_load(&ops.phase[3][k]), env, vec_shl(c2, 15), lanes));
+  vec_store(&out_fm[k], out);
 
   /* store current MEM */
-  CH->mem_value = mem;
+  vec_store(&ops.mem_value[k], vec_sel(active, mem, mem_value));
 
   /* update phase counters AFTER output calculations */
-  if(CH->pms)
-  {
-    /* add support for 3 slot mode */
-    if ((ym2612.OPN.ST.mode & 0xC0) && (CH == &ym2612.CH[2]))
-    {
-      update_phase_lfo_slot(&CH->SLOT[SLOT1], CH->pms, ym2612.OPN.SL3.block_fnum[1]);
-      update_phase_lfo_slot(&CH->SLOT[SLOT2], CH->pms, ym2612.OPN.SL3.block_fnum[2]);
-      update_phase_lfo_slot(&CH->SLOT[SLOT3], CH->pms, ym2612.OPN.SL3.block_fnum[0]);
-      update_phase_lfo_slot(&CH->SLOT[SLOT4], CH->pms, CH->block_fnum);
-    }
-    else update_phase_lfo_channel(CH);
-  }
-  else  /* no LFO phase modulation */
-  {
-    CH->SLOT[SLOT1].phase += CH->SLOT[SLOT1].Incr;
-    CH->SLOT[SLOT2].phase += CH->SLOT[SLOT2].Incr;
-    CH->SLOT[SLOT3].phase += CH->SLOT[SLOT3].Incr;
-    CH->SLOT[SLOT4].phase += CH->SLOT[SLOT4].Incr;
-  }
+  vec_store(&ops.phase[0][k], vec_add(vec_load(&ops.phase[0][k]), vec_load(&ops.Incr[0][k])));
+  vec_store(&ops.phase[1][k], vec_add(vec_load(&ops.phase[1][k]), vec_load(&ops.Incr[1][k])));
+  vec_store(&ops.phase[2][k], vec_add(vec_load(&ops.phase[2][k]), vec_load(&ops.Incr[2][k])));
+  vec_store(&ops.phase[3][k], vec_add(vec_load(&ops.phase[3][k]), vec_load(&ops.Incr[3][k])));
+}
+
+/* calculate FM of the six channels */
+INLINE void chan_calc_all()
+{
+  INT32 pm1[OPS_LANES] __attribute__ ((aligned(16)));
+  int c;
+
+  /* op1 self-feedback */
+  for (c = 0; c < 6; c++)
+    pm1[c] = ym2612.CH[c].FB ? (ops.op1_out[0][c] + ops.op1_out[1][c]) << ym2612.CH[c].FB : 0;
+  pm1[6] = pm1[7] = 0;
+
+#if OPS_WIDTH == 4
+  chan_calc(0, 4, pm1);
+  chan_calc(4, 2, pm1);
+#else
+  for (c = 0; c < 6; c++)
+    chan_calc(c, 1, pm1);
+#endif
 }
 
 /* write a OPN mode register 0x20-0x2f */
@@ -1520,16 +1690,9 @@ INLINE void OPNWriteMode(int r, int v)
 
       break;
     case 0x24:  /* timer A High 8*/
-      ym2612.OPN.ST.TA = (ym2612.OPN.ST.TA & 0x03)|(((int)v)<<2);
-      ym2612.OPN.ST.TAL = (1024 - ym2612.OPN.ST.TA) << TIMER_SH;
-      break;
     case 0x25:  /* timer A Low 2*/
-      ym2612.OPN.ST.TA = (ym2612.OPN.ST.TA & 0x3fc)|(v&3);
-      ym2612.OPN.ST.TAL = (1024 - ym2612.OPN.ST.TA) << TIMER_SH;
-      break;
     case 0x26:  /* timer B */
-      ym2612.OPN.ST.TB = v;
-      ym2612.OPN.ST.TBL = (256 - ym2612.OPN.ST.TB) << (TIMER_SH + 4);
+      set_timer_reg(&ym2612.OPN.ST, r, v);
       break;
     case 0x27:  /* mode, timer control */
       set_timers(v);
@@ -1553,6 +1716,7 @@ INLINE void OPNWriteReg(int r, int v)
 {
   FM_CH *CH;
   FM_SLOT *SLOT;
+  int s;
 
   UINT8 c = OPN_CHAN(r);
 
@@ -1563,6 +1727,7 @@ INLINE void OPNWriteReg(int r, int v)
   CH = &ym2612.CH[c];
 
   SLOT = &(CH->SLOT[OPN_SLOT(r)]);
+  s = OPN_SLOT(r);
 
   switch( r & 0xf0 ) {
     case 0x30:  /* DET , MUL */
@@ -1570,7 +1735,7 @@ INLINE void OPNWriteReg(int r, int v)
       break;
 
     case 0x40:  /* TL */
-      set_tl(SLOT,v);
+      set_tl(SLOT,&ops.vol_out[s][c],v);
       break;
 
     case 0x50:  /* KS, AR */
@@ -1579,7 +1744,7 @@ INLINE void OPNWriteReg(int r, int v)
 
     case 0x60:  /* bit7 = AM ENABLE, DR */
       set_dr(SLOT,v);
-      SLOT->AMmask = (v&0x80) ? ~0 : 0;
+      ops.AMmask[s][c] = (v&0x80) ? ~0 : 0;
       break;
 
     case 0x70:  /*     SR */
@@ -1597,9 +1762,9 @@ INLINE void OPNWriteReg(int r, int v)
       if (SLOT->state > EG_REL)
       {
         if ((SLOT->ssg&0x08) && (SLOT->ssgn ^ (SLOT->ssg&0x04)))
-          SLOT->vol_out = ((UINT32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
+          ops.vol_out[s][c] = ((UINT32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
         else
-          SLOT->vol_out = (UINT32)SLOT->volume + SLOT->tl;
+          ops.vol_out[s][c] = (UINT32)SLOT->volume + SLOT->tl;
       }
 
       /* SSG-EG envelope shapes :
@@ -1810,18 +1975,18 @@ static void reset_channels(FM_CH *CH , int num )
 
   for( c = 0 ; c < num ; c++ )
   {
-    CH[c].mem_value   = 0;
-    CH[c].op1_out[0]  = 0;
-    CH[c].op1_out[1]  = 0;
+    ops.mem_value[c]  = 0;
+    ops.op1_out[0][c] = 0;
+    ops.op1_out[1][c] = 0;
     for(s = 0 ; s < 4 ; s++ )
     {
       CH[c].SLOT[s].Incr    = -1;
       CH[c].SLOT[s].key     = 0;
-      CH[c].SLOT[s].phase   = 0;
       CH[c].SLOT[s].ssgn    = 0;
       CH[c].SLOT[s].state   = EG_OFF;
       CH[c].SLOT[s].volume  = MAX_ATT_INDEX;
-      CH[c].SLOT[s].vol_out = MAX_ATT_INDEX;
+      ops.phase[s][c]       = 0;
+      ops.vol_out[s][c]     = MAX_ATT_INDEX;
     }
   }
 }
@@ -1933,6 +2098,7 @@ static void init_tables(void)
 void YM2612Init(SysDDec clock, int rate)
 {
   memset(&ym2612,0,sizeof(YM2612));
+  memset(&ops,0,sizeof(ops));
   init_tables();
   ym2612.OPN.ST.clock = clock;
   ym2612.OPN.ST.rate = rate;
@@ -2032,11 +2198,72 @@ unsigned int YM2612Read(void)
   return ym2612.OPN.ST.status & 0xff;
 }
 
+/* Timers & status only, run on a copy of the timer state.                 */
+/* Used to answer status reads on the emulation thread while the chip      */
+/* itself is updated on the FM thread with the same writes & sample counts */
+void YM2612TimersSync(void)
+{
+  timer_st = ym2612.OPN.ST;
+}
+
+void YM2612TimersWrite(unsigned int a, unsigned int v)
+{
+  v &= 0xff;
+
+  switch( a )
+  {
+    case 0:  /* address port 0 */
+      timer_st.address = v;
+      break;
+
+    case 2:  /* address port 1 */
+      timer_st.address = v | 0x100;
+      break;
+
+    default:  /* data port */
+      if (timer_st.address == 0x27)
+        set_timers_st(&timer_st, v);
+      else
+        set_timer_reg(&timer_st, timer_st.address, v);
+      break;
+  }
+}
+
+void YM2612TimersUpdate(int length)
+{
+  int i;
+
+  for(i=0; i < length ; i++)
+    TIMER_A(&timer_st);
+
+  TIMER_B(&timer_st, length);
+}
+
+unsigned int YM2612TimersRead(void)
+{
+  return timer_st.status & 0xff;
+}
+
 /* Generate 16 bits samples for ym2612 */
 void YM2612Update(FMSampleType *buffer, int length)
 {
-  int i;
+  int i,c;
   long int lt,rt;
+  unsigned int ssg_chans = 0;
+
+  /* registers may have changed since the last update */
+  ops.LFO_PM = ~0;
+  ops.LFO_AM = ~0;
+
+  for (i = 0; i < 6; i++)
+  {
+    ops.active[i] = ~0;
+
+    /* channels with SSG-EG enabled on any slot */
+    if ((ym2612.CH[i].SLOT[0].ssg | ym2612.CH[i].SLOT[1].ssg |
+         ym2612.CH[i].SLOT[2].ssg | ym2612.CH[i].SLOT[3].ssg) & 0x08)
+      ssg_chans |= 1 << i;
+  }
 
   /* refresh PG increments and EG rates if required */
   refresh_fc_eg_chan(&ym2612.CH[0]);
@@ -2059,37 +2286,43 @@ void YM2612Update(FMSampleType *buffer, int length)
   refresh_fc_eg_chan(&ym2612.CH[4]);
   refresh_fc_eg_chan(&ym2612.CH[5]);
 
+  /* channel 6 output is replaced in DAC mode */
+  if (ym2612.dacen)
+    ops.active[5] = 0;
+
   /* buffering */
   for(i=0; i < length ; i++)
   {
-    /* clear outputs */
-    out_fm[0] = 0;
-    out_fm[1] = 0;
-    out_fm[2] = 0;
-    out_fm[3] = 0;
-    out_fm[4] = 0;
-    out_fm[5] = 0;
-
     /* update SSG-EG output */
-    update_ssg_eg_channel(&ym2612.CH[0].SLOT[SLOT1]);
-    update_ssg_eg_channel(&ym2612.CH[1].SLOT[SLOT1]);
-    update_ssg_eg_channel(&ym2612.CH[2].SLOT[SLOT1]);
-    update_ssg_eg_channel(&ym2612.CH[3].SLOT[SLOT1]);
-    update_ssg_eg_channel(&ym2612.CH[4].SLOT[SLOT1]);
-    update_ssg_eg_channel(&ym2612.CH[5].SLOT[SLOT1]);
+    if (ssg_chans)
+    {
+      if (ssg_chans & 0x01) update_ssg_eg_channel(&ym2612.CH[0].SLOT[SLOT1],0);
+      if (ssg_chans & 0x02) update_ssg_eg_channel(&ym2612.CH[1].SLOT[SLOT1],1);
+      if (ssg_chans & 0x04) update_ssg_eg_channel(&ym2612.CH[2].SLOT[SLOT1],2);
+      if (ssg_chans & 0x08) update_ssg_eg_channel(&ym2612.CH[3].SLOT[SLOT1],3);
+      if (ssg_chans & 0x10) update_ssg_eg_channel(&ym2612.CH[4].SLOT[SLOT1],4);
+      if (ssg_chans & 0x20) update_ssg_eg_channel(&ym2612.CH[5].SLOT[SLOT1],5);
+    }
+
+    /* LFO AM level changed */
+    if (ops.LFO_AM != ym2612.OPN.LFO_AM)
+    {
+      for (c = 0; c < 6; c++)
+        ops.AM[c] = ym2612.OPN.LFO_AM >> ym2612.CH[c].ams;
+      ops.LFO_AM = ym2612.OPN.LFO_AM;
+    }
+
+    /* LFO PM step changed */
+    if (ops.LFO_PM != ym2612.OPN.LFO_PM)
+      update_ops_incr();
 
     /* calculate FM */
-    chan_calc(&ym2612.CH[0]);
-    chan_calc(&ym2612.CH[1]);
-    chan_calc(&ym2612.CH[2]);
-    chan_calc(&ym2612.CH[3]);
-    chan_calc(&ym2612.CH[4]);
+    chan_calc_all();
     if (ym2612.dacen)
     {
       /* DAC Mode */
       out_fm[5] = ym2612.dacout;
     }
-    else chan_calc(&ym2612.CH[5]);
 
     /* advance LFO */
     advance_lfo();
@@ -2101,12 +2334,12 @@ void YM2612Update(FMSampleType *buffer, int length)
       ym2612.OPN.eg_timer -= ym2612.OPN.eg_timer_overflow;
       ym2612.OPN.eg_cnt++;
 
-      advance_eg_channel(&ym2612.CH[0].SLOT[SLOT1]);
-      advance_eg_channel(&ym2612.CH[1].SLOT[SLOT1]);
-      advance_eg_channel(&ym2612.CH[2].SLOT[SLOT1]);
-      advance_eg_channel(&ym2612.CH[3].SLOT[SLOT1]);
-      advance_eg_channel(&ym2612.CH[4].SLOT[SLOT1]);
-      advance_eg_channel(&ym2612.CH[5].SLOT[SLOT1]);
+      advance_eg_channel(&ym2612.CH[0].SLOT[SLOT1],0);
+      advance_eg_channel(&ym2612.CH[1].SLOT[SLOT1],1);
+      advance_eg_channel(&ym2612.CH[2].SLOT[SLOT1],2);
+      advance_eg_channel(&ym2612.CH[3].SLOT[SLOT1],3);
+      advance_eg_channel(&ym2612.CH[4].SLOT[SLOT1],4);
+      advance_eg_channel(&ym2612.CH[5].SLOT[SLOT1],5);
     }
 
     /* 14-bit DAC inputs (range is -8192;+8192) */
@@ -2167,8 +2400,47 @@ void YM2612Update(FMSampleType *buffer, int length)
   INTERNAL_TIMER_B(length);
 }
 
+/* copy the SoA operator state to the YM2612 struct */
+static void pack_ops(void)
+{
+  int c,s;
+
+  for( c = 0 ; c < 6 ; c++ )
+  {
+    ym2612.CH[c].mem_value  = ops.mem_value[c];
+    ym2612.CH[c].op1_out[0] = ops.op1_out[0][c];
+    ym2612.CH[c].op1_out[1] = ops.op1_out[1][c];
+    for(s = 0 ; s < 4 ; s++ )
+    {
+      ym2612.CH[c].SLOT[s].phase   = ops.phase[s][c];
+      ym2612.CH[c].SLOT[s].vol_out = ops.vol_out[s][c];
+      ym2612.CH[c].SLOT[s].AMmask  = ops.AMmask[s][c];
+    }
+  }
+}
+
+/* copy the operator state of the YM2612 struct to the SoA one */
+static void unpack_ops(void)
+{
+  int c,s;
+
+  for( c = 0 ; c < 6 ; c++ )
+  {
+    ops.mem_value[c]  = ym2612.CH[c].mem_value;
+    ops.op1_out[0][c] = ym2612.CH[c].op1_out[0];
+    ops.op1_out[1][c] = ym2612.CH[c].op1_out[1];
+    for(s = 0 ; s < 4 ; s++ )
+    {
+      ops.phase[s][c]   = ym2612.CH[c].SLOT[s].phase;
+      ops.vol_out[s][c] = ym2612.CH[c].SLOT[s].vol_out;
+      ops.AMmask[s][c]  = ym2612.CH[c].SLOT[s].AMmask;
+    }
+  }
+}
+
 unsigned char *YM2612GetContextPtr(void)
 {
+  pack_ops();
   return (unsigned char *)&ym2612;
 }
 
@@ -2198,6 +2470,7 @@ void YM2612Restore(unsigned char *buffer)
   setup_connection(&ym2612.CH[3],3);
   setup_connection(&ym2612.CH[4],4);
   setup_connection(&ym2612.CH[5],5);
+  unpack_ops();
 
   /* restore TL table (DAC resolution might have been modified) */
   init_tables();
@@ -2234,6 +2507,7 @@ int YM2612SaveContext(unsigned char *state)
   int bufferptr = sizeof(YM2612);
 
   /* save YM2612 context */
+  pack_ops();
   memcpy(state, &ym2612, sizeof(YM2612));
 
   /* save DT table index for each channel slots */
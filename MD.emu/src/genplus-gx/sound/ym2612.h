@@ -29,4 +29,10 @@ extern void YM2612Restore(unsigned char *buffer);
 extern int YM2612LoadContext(unsigned char *state);
 extern int YM2612SaveContext(unsigned char *state);
 
+/* timers & status only, on a separate copy of the timer state */
+extern void YM2612TimersSync(void);
+extern void YM2612TimersWrite(unsigned int a, unsigned int v);
+extern void YM2612TimersUpdate(int length);
+extern unsigned int YM2612TimersRead(void);
+
 #endif /* _YM2612_ */
@@ -29,6 +29,7 @@
 #ifndef NO_SCD
 #include <scd/scd.h>
 #include <scd/pcm.h>
+#include <scd/cd_stream.h>
 #endif
 
 /* Global variables */
@@ -174,6 +175,9 @@ int audio_update (void)
 	{
 		scd_pcm_update(cdPCMBuff, size, 1);
 	}
+	int16 cdDABuff[size*2];
+	int16 *cdDA = cdDABuff;
+	fbool doCDDA = sCD.isActive && cdStreamMixAudio(cdDABuff, size, snd.sample_rate);
 	#endif
 
   if (config_hq_fm)
@@ -219,6 +223,11 @@ int audio_update (void)
 			l += *cdPCM++;
 			r += *cdPCM++;
 		}
+		if(doCDDA)
+		{
+			l += *cdDA++;
+			r += *cdDA++;
+		}
 		#endif
 
     /* filtering */
@@ -523,6 +532,12 @@ static void system_frame_md(int do_skip, uint renderGfx)
 
     /* update line cycle count */
     mcycles_vdp += MCYCLES_PER_LINE;
+
+    /* let the FM thread catch up */
+    if (!(line & 15))
+    {
+      fm_sync(mcycles_vdp);
+    }
   }
   while (++line < bitmap.viewport.h);
 
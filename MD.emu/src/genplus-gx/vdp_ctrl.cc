@@ -28,15 +28,12 @@
 #include <scd/scd.h>
 #endif
 
-/* Mark a pattern as dirty */
+/* Mark a pattern as dirty, it gets expanded when next drawn */
 #define MARK_BG_DIRTY(addr)                         \
 {                                                   \
   name = (addr >> 5) & 0x7FF;                       \
-  if(bg_name_dirty[name] == 0)                      \
-  {                                                 \
-    bg_name_list[bg_list_index++] = name;           \
-  }                                                 \
   bg_name_dirty[name] |= (1 << ((addr >> 2) & 7));  \
+  bg_cache_gen++;                                   \
 }
 
 /* VDP context */
@@ -56,10 +53,9 @@ uint16 ntbb;                      /* Name table B base address */
 uint16 ntwb;                      /* Name table W base address */
 uint16 satb;                      /* Sprite attribute table base address */
 uint16 hscb;                      /* Horizontal scroll table base address */
-uint8 bg_name_dirty[0x800] __attribute__ ((aligned (4)));       /* 1= This pattern is dirty */
-uint16 bg_name_list[0x800] __attribute__ ((aligned (4)));       /* List of modified pattern indices */
-uint16 bg_list_index;             /* # of modified patterns in list */
-uint8 bg_pattern_cache[0x80000] __attribute__ ((aligned (4)));  /* Cached and flipped patterns */
+uint8 bg_name_dirty[0x800] __attribute__ ((aligned (4)));       /* Modified lines of each pattern */
+uint32 bg_cache_gen;              /* Incremented on any VRAM write or cache invalidation */
+uint8 bg_pattern_cache[0x80000] __attribute__ ((aligned (16))); /* Cached and flipped patterns */
 uint8 hscroll_mask;               /* Horizontal Scrolling line mask */
 uint8 playfield_shift;            /* Width of planes A, B (in bits) */
 uint8 playfield_col_mask;         /* Playfield column mask */
@@ -236,9 +232,8 @@ void vdp_reset(void)
   sat_addr_mask       = 0x01FF;
 
   /* clear pattern cache */
-  bg_list_index = 0;
+  bg_cache_gen++;
   memset ((char *) bg_name_dirty, 0, sizeof (bg_name_dirty));
-  memset ((char *) bg_name_list, 0, sizeof (bg_name_list));
   memset ((char *) bg_pattern_cache, 0, sizeof (bg_pattern_cache));
 
   /* default HVC */
@@ -367,8 +362,6 @@ int vdp_context_load(uint8 *state)
   if (reg[1] & 0x04)
   {
     /* Mode 5 */
-    bg_list_index = 0x800;
-
     /* reinitialize palette */
     color_update_m5(0, cram.getS(border << 1));
     for(i = 1; i < 0x40; i++)
@@ -379,8 +372,6 @@ int vdp_context_load(uint8 *state)
   else
   {
     /* Mode 4 */
-    bg_list_index = 0x200;
-
     /* reinitialize palette */
     for(i = 0; i < 0x20; i ++)
     {
@@ -390,11 +381,8 @@ int vdp_context_load(uint8 *state)
   }
 
   /* invalidate cache */
-  for (i=0;i<bg_list_index;i++)
-  {
-    bg_name_list[i]=i;
-    bg_name_dirty[i]=0xFF;
-  }
+  memset(bg_name_dirty, 0xFF, sizeof(bg_name_dirty));
+  bg_cache_gen++;
 
   return bufferptr;
 }
@@ -1345,9 +1333,6 @@ static void vdp_reg_w(unsigned int r, unsigned int d, unsigned int cycles)
               /* Latch current HVC */
               hvc_latch = vdp_hvc_r(cycles) | 0x10000;
             }
-
-            /* max tiles to invalidate */
-            bg_list_index = 0x800;
           }
           else
           {
@@ -1384,17 +1369,11 @@ static void vdp_reg_w(unsigned int r, unsigned int d, unsigned int cycles)
 
             /* Latch current HVC */
             hvc_latch = vdp_hvc_r(cycles) | 0x10000;
-
-            /* max tiles to invalidate */
-            bg_list_index = 0x200;
           }
 
           /* Invalidate pattern cache */
-          for (i=0;i<bg_list_index;i++)
-          {
-            bg_name_list[i] = i;
-            bg_name_dirty[i] = 0xFF;
-          }
+          memset(bg_name_dirty, 0xFF, sizeof(bg_name_dirty));
+          bg_cache_gen++;
 
           /* Update vertical counter max value */
           vc_max = vc_table[(d >> 2) & 3][vdp_pal];
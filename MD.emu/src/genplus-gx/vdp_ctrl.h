@@ -68,9 +68,8 @@ extern uint16 ntwb;
 extern uint16 satb;
 extern uint16 hscb;
 extern uint8 bg_name_dirty[0x800] __attribute__ ((aligned (4)));
-extern uint16 bg_name_list[0x800] __attribute__ ((aligned (4)));
-extern uint16 bg_list_index;
-extern uint8 bg_pattern_cache[0x80000] __attribute__ ((aligned (4)));
+extern uint32 bg_cache_gen;
+extern uint8 bg_pattern_cache[0x80000] __attribute__ ((aligned (16)));
 extern uint8 hscroll_mask;
 extern uint8 playfield_shift;
 extern uint8 playfield_col_mask;
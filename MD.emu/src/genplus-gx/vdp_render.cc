@@ -23,13 +23,14 @@
 
 #include "shared.h"
 
-#ifdef NGC
-#include "md_ntsc.h"
-#include "sms_ntsc.h"
+#ifdef SUPPORT_16BPP_RENDER
+#include "ntsc/ntsc_output.h"
+#endif
 
-/*** NTSC Filters ***/
-extern md_ntsc_t *md_ntsc;
-extern sms_ntsc_t *sms_ntsc;
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
 #endif
 
 /* Pixel priority look-up tables information */
@@ -86,39 +87,38 @@ static __inline__ void WRITE_LONG(void *address, uint32 data)
 #endif  /* ALIGN_LONG */
 
 
-/* Draw 2-cell column (8-pixels high) */
 /*
-   Pattern cache base address: VHN NNNNNNNN NNYYYxxx
+   Pattern cache address: NNNNNNNN NNNVHYYY xxx
    with :
       x = Pattern Pixel (0-7)
       Y = Pattern Row (0-7)
-      N = Pattern Number (0-2047) from pattern attribute
-      H = Horizontal Flip bit from pattern attribute
-      V = Vertical Flip bit from pattern attribute
+      H = Horizontal Flip bit
+      V = Vertical Flip bit
+      N = Pattern Number (0-2047)
+
+   All four flipped versions of a pattern are packed in 256 bytes and expanded
+   together from VRAM the first time the pattern is drawn after a write to it.
 */
+
+/* Draw 2-cell column (8-pixels high) */
 #define GET_LSB_TILE(ATTR, LINE) \
   atex = atex_table[(ATTR >> 13) & 7]; \
-  src = (uint32 *)&bg_pattern_cache[(ATTR & 0x00001FFF) << 6 | (LINE)];
+  src = (uint32 *)get_pattern_line(ATTR & 0x7FF, (ATTR & 0x1800) >> 5 | (LINE));
 #define GET_MSB_TILE(ATTR, LINE) \
   atex = atex_table[(ATTR >> 29) & 7]; \
-  src = (uint32 *)&bg_pattern_cache[(ATTR & 0x1FFF0000) >> 10 | (LINE)];
+  src = (uint32 *)get_pattern_line((ATTR >> 16) & 0x7FF, (ATTR & 0x18000000) >> 21 | (LINE));
 
 /* Draw 2-cell column (16 pixels high) */
 /*
-   Pattern cache base address: VHN NNNNNNNN NYYYYxxx
-   with :
-      x = Pattern Pixel (0-7)
-      Y = Pattern Row (0-15)
-      N = Pattern Number (0-1023)
-      H = Horizontal Flip bit
-      V = Vertical Flip bit
+   LINE = Pattern Row (0-15) << 3, the cell is made of patterns 2N & 2N+1
+   (swapped by vertical flip) with N = Pattern Number (0-1023)
 */
 #define GET_LSB_TILE_IM2(ATTR, LINE) \
   atex = atex_table[(ATTR >> 13) & 7]; \
-  src = (uint32 *)&bg_pattern_cache[((ATTR & 0x000003FF) << 7 | (ATTR & 0x00001800) << 6 | (LINE)) ^ ((ATTR & 0x00001000) >> 6)];
+  src = (uint32 *)get_pattern_line(((ATTR & 0x3FF) << 1 | (LINE) >> 6) ^ ((ATTR >> 12) & 1), (ATTR & 0x1800) >> 5 | ((LINE) & 0x38));
 #define GET_MSB_TILE_IM2(ATTR, LINE) \
   atex = atex_table[(ATTR >> 29) & 7]; \
-  src = (uint32 *)&bg_pattern_cache[((ATTR & 0x03FF0000) >> 9 | (ATTR & 0x18000000) >> 10 | (LINE)) ^ ((ATTR & 0x10000000) >> 22)];
+  src = (uint32 *)get_pattern_line((((ATTR >> 15) & 0x7FE) | ((LINE) >> 6)) ^ ((ATTR >> 28) & 1), (ATTR & 0x18000000) >> 21 | ((LINE) & 0x38));
 
 /*   
    One column = 2 tiles
@@ -384,6 +384,60 @@ static __inline__ void WRITE_LONG(void *address, uint32 data)
   DRAW_BG_TILE(SRC_A, SRC_B)
 #endif
 #endif /* ALIGN_LONG */
+
+/* Draw 2-cell column from a decoded name table row */
+/* CELL = priority & palette bits and pattern cache address of both tiles, in display order */
+#ifdef ALIGN_LONG
+#define DRAW_ROW_COLUMN(CELL, LINE) \
+  src = (uint32 *)&bg_pattern_cache[CELL[1] | (LINE)]; \
+  WRITE_LONG(dst, src[0] | CELL[0]); \
+  dst++; \
+  WRITE_LONG(dst, src[1] | CELL[0]); \
+  dst++; \
+  src = (uint32 *)&bg_pattern_cache[CELL[3] | (LINE)]; \
+  WRITE_LONG(dst, src[0] | CELL[2]); \
+  dst++; \
+  WRITE_LONG(dst, src[1] | CELL[2]); \
+  dst++;
+#define DRAW_BG_ROW_COLUMN(CELL, LINE, SRC_A, SRC_B) \
+  src = (uint32 *)&bg_pattern_cache[CELL[1] | (LINE)]; \
+  SRC_A = READ_LONG((uint32 *)lb); \
+  SRC_B = (src[0] | CELL[0]); \
+  DRAW_BG_TILE(SRC_A, SRC_B) \
+  SRC_A = READ_LONG((uint32 *)lb); \
+  SRC_B = (src[1] | CELL[0]); \
+  DRAW_BG_TILE(SRC_A, SRC_B) \
+  src = (uint32 *)&bg_pattern_cache[CELL[3] | (LINE)]; \
+  SRC_A = READ_LONG((uint32 *)lb); \
+  SRC_B = (src[0] | CELL[2]); \
+  DRAW_BG_TILE(SRC_A, SRC_B) \
+  SRC_A = READ_LONG((uint32 *)lb); \
+  SRC_B = (src[1] | CELL[2]); \
+  DRAW_BG_TILE(SRC_A, SRC_B)
+#else /* NOT ALIGNED */
+#define DRAW_ROW_COLUMN(CELL, LINE) \
+  src = (uint32 *)&bg_pattern_cache[CELL[1] | (LINE)]; \
+  *dst++ = (src[0] | CELL[0]); \
+  *dst++ = (src[1] | CELL[0]); \
+  src = (uint32 *)&bg_pattern_cache[CELL[3] | (LINE)]; \
+  *dst++ = (src[0] | CELL[2]); \
+  *dst++ = (src[1] | CELL[2]);
+#define DRAW_BG_ROW_COLUMN(CELL, LINE, SRC_A, SRC_B) \
+  src = (uint32 *)&bg_pattern_cache[CELL[1] | (LINE)]; \
+  SRC_A = *(uint32 *)(lb); \
+  SRC_B = (src[0] | CELL[0]); \
+  DRAW_BG_TILE(SRC_A, SRC_B) \
+  SRC_A = *(uint32 *)(lb); \
+  SRC_B = (src[1] | CELL[0]); \
+  DRAW_BG_TILE(SRC_A, SRC_B) \
+  src = (uint32 *)&bg_pattern_cache[CELL[3] | (LINE)]; \
+  SRC_A = *(uint32 *)(lb); \
+  SRC_B = (src[0] | CELL[2]); \
+  DRAW_BG_TILE(SRC_A, SRC_B) \
+  SRC_A = *(uint32 *)(lb); \
+  SRC_B = (src[1] | CELL[2]); \
+  DRAW_BG_TILE(SRC_A, SRC_B)
+#endif /* ALIGN_LONG */
 #endif /* ALT_RENDERER */
 
 #define DRAW_SPRITE_TILE(WIDTH,ATTR,TABLE)  \
@@ -536,7 +590,87 @@ uint16 spr_col;
 void (*render_bg)(int line, int width);
 void (*render_obj)(int max_width);
 void (*parse_satb)(int line);
-void (*update_bg_pattern_cache)(int index);
+void (*update_bg_pattern_cache)(int name);
+
+/* Pattern & name table cache statistics (last rendered frame) */
+t_bg_cache_stats bg_cache_stats;
+static t_bg_cache_stats cache_stats;
+
+#ifdef ALT_RENDERER
+/* Decoded name table rows (Plane A, Window & Plane B) */
+static struct
+{
+  uint32 *nt;           /* name table row address */
+  uint32 width;         /* row width (2-cell columns) */
+  uint32 gen;           /* bg_cache_gen when decoded */
+  uint32 cell[64][4];   /* per column: priority & palette bits + pattern cache address of both tiles */
+} bg_row[3];
+#endif
+
+
+/*--------------------------------------------------------------------------*/
+/* Pattern cache access functions                                           */
+/*--------------------------------------------------------------------------*/
+
+/* Cached pattern line, expanding the pattern first if VRAM was modified */
+static __inline__ uint8 *get_pattern_line(uint32 name, uint32 offset)
+{
+  if (bg_name_dirty[name])
+  {
+    update_bg_pattern_cache(name);
+  }
+  else
+  {
+    cache_stats.pattern_hits++;
+  }
+
+  return &bg_pattern_cache[(name << 8) | offset];
+}
+
+#ifdef ALT_RENDERER
+/* Decoded name table row (Mode 5), only decoded again after VRAM writes */
+static uint32 *get_bg_row(int layer, uint32 *nt, uint32 width)
+{
+  uint32 i, attr, atbuf, *cell;
+
+  if ((bg_row[layer].nt == nt) && (bg_row[layer].width == width) && (bg_row[layer].gen == bg_cache_gen))
+  {
+    cache_stats.row_hits++;
+    return bg_row[layer].cell[0];
+  }
+
+  cache_stats.row_misses++;
+  cell = bg_row[layer].cell[0];
+
+  for (i = 0; i < width; i++)
+  {
+    atbuf = nt[i];
+
+    /* Pattern attributes in display order */
+#ifdef LSB_FIRST
+    atbuf = (atbuf >> 16) | (atbuf << 16);
+#endif
+
+    /* First tile */
+    attr = atbuf >> 16;
+    get_pattern_line(attr & 0x7FF, 0);
+    *cell++ = atex_table[(attr >> 13) & 7];
+    *cell++ = ((attr & 0x7FF) << 8) | ((attr & 0x1800) >> 5);
+
+    /* Second tile */
+    attr = atbuf & 0xFFFF;
+    get_pattern_line(attr & 0x7FF, 0);
+    *cell++ = atex_table[(attr >> 13) & 7];
+    *cell++ = ((attr & 0x7FF) << 8) | ((attr & 0x1800) >> 5);
+  }
+
+  bg_row[layer].nt    = nt;
+  bg_row[layer].width = width;
+  bg_row[layer].gen   = bg_cache_gen;
+
+  return bg_row[layer].cell[0];
+}
+#endif
 
 /*--------------------------------------------------------------------------*/
 /* Sprite pattern name offset look-up table function (Mode 5)               */
@@ -1415,7 +1549,7 @@ void render_bg_m4(int line, int width)
     atex = atex_table[(attr >> 11) & 3];
 
     /* Cached pattern data line (4 bytes = 4 pixels at once) */
-    src = (uint32 *)&bg_pattern_cache[((attr & 0x7FF) << 6) | (v_line)];
+    src = (uint32 *)get_pattern_line(attr & 0x1FF, ((attr >> 3) & 0xC0) | (v_line));
 
     /* Copy left & right half, adding the attribute bits in */
 #ifdef ALIGN_DWORD
@@ -2108,7 +2242,7 @@ void render_bg_m5_im2_vs(int line, int width)
 void render_bg_m5(int line, int width)
 {
   int column, start, end;
-  uint32 atex, atbuf, *src, *dst;
+  uint32 *src, *dst, *row, *cell;
   uint32 shift, index, v_line, *nt;
 
   /* Scroll Planes common data */
@@ -2167,6 +2301,7 @@ void render_bg_m5(int line, int width)
 
     /* Plane A name table */
     nt = &vram.getL(ntab + (((v_line >> 3) << pf_shift) & 0x1FC0));
+    row = get_bg_row(0, nt, pf_col_mask + 1);
 
     /* Pattern row index */
     v_line = (v_line & 7) << 3;
@@ -2179,20 +2314,20 @@ void render_bg_m5(int line, int width)
       /* Window bug */
       if (start)
       {
-        atbuf = nt[index & pf_col_mask];
+        cell = &row[(index & pf_col_mask) << 2];
       }
       else
       {
-        atbuf = nt[(index-1) & pf_col_mask];
+        cell = &row[((index-1) & pf_col_mask) << 2];
       }
 
-      DRAW_COLUMN(atbuf, v_line)
+      DRAW_ROW_COLUMN(cell, v_line)
     }
 
     for(column = start; column < end; column++, index++)
     {
-      atbuf = nt[index & pf_col_mask];
-      DRAW_COLUMN(atbuf, v_line)
+      cell = &row[(index & pf_col_mask) << 2];
+      DRAW_ROW_COLUMN(cell, v_line)
     }
 
     /* Window width */
@@ -2214,14 +2349,15 @@ void render_bg_m5(int line, int width)
 
     /* Window name table */
     nt = &vram.getL(ntwb | ((line >> 3) << (6 + (reg[12] & 1))));
+    row = get_bg_row(1, nt, 16 << (reg[12] & 1));
 
     /* Pattern row index */
     v_line = (line & 7) << 3;
 
     for(column = start; column < end; column++)
     {
-      atbuf = nt[column];
-      DRAW_COLUMN(atbuf, v_line)
+      cell = &row[column << 2];
+      DRAW_ROW_COLUMN(cell, v_line)
     }
   }
 
@@ -2238,7 +2374,8 @@ void render_bg_m5(int line, int width)
 
   /* Plane B name table */
   nt = &vram.getL(ntbb + (((v_line >> 3) << pf_shift) & 0x1FC0));
-  
+  row = get_bg_row(2, nt, pf_col_mask + 1);
+
   /* Pattern row index */
   v_line = (v_line & 7) << 3;
 
@@ -2250,14 +2387,14 @@ void render_bg_m5(int line, int width)
     /* Left-most column is partially shown */
     lb -= (0x10 - shift);
 
-    atbuf = nt[(index-1) & pf_col_mask];
-    DRAW_BG_COLUMN(atbuf, v_line, xscroll, yscroll)
+    cell = &row[((index-1) & pf_col_mask) << 2];
+    DRAW_BG_ROW_COLUMN(cell, v_line, xscroll, yscroll)
   }
  
   for(column = 0; column < width; column++, index++)
   {
-    atbuf = nt[index & pf_col_mask];
-    DRAW_BG_COLUMN(atbuf, v_line, xscroll, yscroll)
+    cell = &row[(index & pf_col_mask) << 2];
+    DRAW_BG_ROW_COLUMN(cell, v_line, xscroll, yscroll)
   }
 }
 
@@ -2839,11 +2976,11 @@ void render_obj_m4(int max_width)
   /* Draw sprites in front-to-back order */
   for (count = 0; count < object_count; count++)
   {
-    /* Sprite pattern index */
-    temp = (object_info[count].attr | 0x100) & sg_mask;
+    /* Sprite pattern index (masked, sprites parsed in Mode 5 are still drawn after a mode switch) */
+    temp = (object_info[count].attr | 0x100) & sg_mask & 0x1FF;
 
-    /* Pointer to pattern cache line */
-    src = (uint8 *)&bg_pattern_cache[(temp << 6) | (object_info[count].ypos << 3)];
+    /* Pointer to pattern cache line (8x16 sprites use two consecutive patterns) */
+    src = get_pattern_line(temp + (object_info[count].ypos >> 3), (object_info[count].ypos & 7) << 3);
 
     /* Sprite X position */
     xpos = object_info[count].xpos;
@@ -2970,8 +3107,8 @@ void render_obj_m5(int max_width)
       /* Draw sprite patterns */
       for(column = 0; column < width; column++, lb+=8)
       {
-        temp = attr | ((name + s[column]) & 0x07FF);
-        src = &bg_pattern_cache[(temp << 6) | (v_line)];
+        temp = (name + s[column]) & 0x07FF;
+        src = get_pattern_line(temp, (attr >> 5) | (v_line));
         DRAW_SPRITE_TILE(8,atex,lut[1])
       }
     }
@@ -3079,8 +3216,8 @@ void render_obj_m5_ste(int max_width)
       /* Draw sprite patterns */
       for(column = 0; column < width; column++, lb+=8)
       {
-        temp = attr | ((name + s[column]) & 0x07FF);
-        src = &bg_pattern_cache[(temp << 6) | (v_line)];
+        temp = (name + s[column]) & 0x07FF;
+        src = get_pattern_line(temp, (attr >> 5) | (v_line));
         DRAW_SPRITE_TILE(8,atex,lut[3])
       }
     }
@@ -3192,8 +3329,8 @@ void render_obj_m5_im2(int max_width)
       /* Render sprite patterns */
       for(column = 0; column < width; column ++, lb+=8)
       {
-        temp = attr | (((name + s[column]) & 0x3ff) << 1);
-        src = &bg_pattern_cache[((temp << 6) | (v_line)) ^ ((attr & 0x1000) >> 6)];
+        temp = ((((name + s[column]) & 0x3ff) << 1) | (v_line >> 6)) ^ (attr >> 12);
+        src = get_pattern_line(temp, (attr >> 5) | (v_line & 0x38));
         DRAW_SPRITE_TILE(8,atex,lut[1])
       }
     }
@@ -3302,8 +3439,8 @@ void render_obj_m5_im2_ste(int max_width)
       /* Render sprite patterns */
       for(column = 0; column < width; column ++, lb+=8)
       {
-        temp = attr | (((name + s[column]) & 0x3ff) << 1);
-        src = &bg_pattern_cache[((temp << 6) | (v_line)) ^ ((attr & 0x1000) >> 6)];
+        temp = ((((name + s[column]) & 0x3ff) << 1) | (v_line >> 6)) ^ (attr >> 12);
+        src = get_pattern_line(temp, (attr >> 5) | (v_line & 0x38));
         DRAW_SPRITE_TILE(8,atex,lut[3])
       }
     }
@@ -3492,119 +3629,155 @@ void parse_satb_m5(int line)
 /* Pattern cache update function                                            */
 /*--------------------------------------------------------------------------*/
 
-void update_bg_pattern_cache_m4(int index)
+void update_bg_pattern_cache_m4(int name)
 {
-  int i;
   uint8 x, y, c;
-  uint8 *dst;
-  uint16 name, bp01, bp23;
+  uint8 *dst = &bg_pattern_cache[name << 8];
+  uint16 bp01, bp23;
   uint32 bp;
 
-  for(i = 0; i < index; i++)
+  for(y = 0; y < 8; y++)
   {
-    /* Get modified pattern name index */
-    name = bg_name_list[i];
+    /* Byteplane data */
+    bp01 = vram.getS((name << 5) | (y << 2) | (0));
+    bp23 = vram.getS((name << 5) | (y << 2) | (2));
 
-    /* Check modified lines */
-    for(y = 0; y < 8; y++)
-    {
-      if(bg_name_dirty[name] & (1 << y))
-      {
-        /* Pattern cache base address */
-        dst = &bg_pattern_cache[name << 6];
+    /* Convert to pixel line data (4 bytes = 8 pixels)*/
+    /* (msb) p7p6 p5p4 p3p2 p1p0 (lsb) */
+    bp = (bp_lut[bp01] >> 2) | (bp_lut[bp23]);
 
-        /* Byteplane data */
-        bp01 = vram.getS((name << 5) | (y << 2) | (0));
-        bp23 = vram.getS((name << 5) | (y << 2) | (2));
+    /* Update cached line (8 pixels = 8 bytes) */
+    for(x = 0; x < 8; x++)
+    {
+      /* Extract pixel data */
+      c = bp & 0x0F;
 
-        /* Convert to pixel line data (4 bytes = 8 pixels)*/
-        /* (msb) p7p6 p5p4 p3p2 p1p0 (lsb) */
-        bp = (bp_lut[bp01] >> 2) | (bp_lut[bp23]);
+      /* Pattern cache data (one pattern = 8 bytes) */
+      /* byte0 <-> p0 p1 p2 p3 p4 p5 p6 p7 <-> byte7 (hflip = 0) */
+      /* byte0 <-> p7 p6 p5 p4 p3 p2 p1 p0 <-> byte7 (hflip = 1) */
+      dst[0x00 | (y << 3) | (x)] = (c);            /* vflip=0 & hflip=0 */
+      dst[0x40 | (y << 3) | (x ^ 7)] = (c);        /* vflip=0 & hflip=1 */
+      dst[0x80 | ((y ^ 7) << 3) | (x)] = (c);      /* vflip=1 & hflip=0 */
+      dst[0xC0 | ((y ^ 7) << 3) | (x ^ 7)] = (c);  /* vflip=1 & hflip=1 */
 
-        /* Update cached line (8 pixels = 8 bytes) */
-        for(x = 0; x < 8; x++)
-        {
-          /* Extract pixel data */
-          c = bp & 0x0F;
-
-          /* Pattern cache data (one pattern = 8 bytes) */
-          /* byte0 <-> p0 p1 p2 p3 p4 p5 p6 p7 <-> byte7 (hflip = 0) */
-          /* byte0 <-> p7 p6 p5 p4 p3 p2 p1 p0 <-> byte7 (hflip = 1) */
-          dst[0x00000 | (y << 3) | (x)] = (c);            /* vflip=0 & hflip=0 */
-          dst[0x08000 | (y << 3) | (x ^ 7)] = (c);        /* vflip=0 & hflip=1 */
-          dst[0x10000 | ((y ^ 7) << 3) | (x)] = (c);      /* vflip=1 & hflip=0 */
-          dst[0x18000 | ((y ^ 7) << 3) | (x ^ 7)] = (c);  /* vflip=1 & hflip=1 */
-
-          /* Next pixel */
-          bp = bp >> 4;
-        }
-      }
+      /* Next pixel */
+      bp = bp >> 4;
     }
-
-    /* Clear modified pattern flag */
-    bg_name_dirty[name] = 0;
   }
+
+  /* Clear modified pattern flag */
+  bg_name_dirty[name] = 0;
+  cache_stats.pattern_misses++;
 }
 
-void update_bg_pattern_cache_m5(int index)
+#if defined(__SSE2__)
+/* Store pattern rows 2K & 2K+1 (8 pixels = 8 bytes per row) in all four flipped versions */
+static __inline__ void store_pattern_rows(uint8 *dst, int k, __m128i rows)
 {
+  /* Reverse pixels of each row */
+  __m128i hflip = _mm_shufflehi_epi16(_mm_shufflelo_epi16(rows, _MM_SHUFFLE(0,1,2,3)), _MM_SHUFFLE(0,1,2,3));
+  hflip = _mm_or_si128(_mm_slli_epi16(hflip, 8), _mm_srli_epi16(hflip, 8));
+
+  /* Vertical flip stores them as rows 6-2K & 7-2K */
+  _mm_store_si128((__m128i *)&dst[0x00 + (k << 4)], rows);
+  _mm_store_si128((__m128i *)&dst[0x40 + (k << 4)], hflip);
+  _mm_store_si128((__m128i *)&dst[0xB0 - (k << 4)], _mm_shuffle_epi32(rows, _MM_SHUFFLE(1,0,3,2)));
+  _mm_store_si128((__m128i *)&dst[0xF0 - (k << 4)], _mm_shuffle_epi32(hflip, _MM_SHUFFLE(1,0,3,2)));
+}
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+/* Store pattern rows 2K & 2K+1 (8 pixels = 8 bytes per row) in all four flipped versions */
+static __inline__ void store_pattern_rows(uint8 *dst, int k, uint8x16_t rows)
+{
+  /* Reverse pixels of each row */
+  uint8x16_t hflip = vrev64q_u8(rows);
+
+  /* Vertical flip stores them as rows 6-2K & 7-2K */
+  vst1q_u8(&dst[0x00 + (k << 4)], rows);
+  vst1q_u8(&dst[0x40 + (k << 4)], hflip);
+  vst1q_u8(&dst[0xB0 - (k << 4)], vextq_u8(rows, rows, 8));
+  vst1q_u8(&dst[0xF0 - (k << 4)], vextq_u8(hflip, hflip, 8));
+}
+#endif
+
+void update_bg_pattern_cache_m5(int name)
+{
+  uint8 *dst = &bg_pattern_cache[name << 8];
+
+  /* Byteplane data (one pattern = 4 bytes) */
+  /* LIT_ENDIAN: byte0 (lsb) p2p3 p0p1 p6p7 p4p5 (msb) byte3 */
+  /* BIG_ENDIAN: byte0 (msb) p0p1 p2p3 p4p5 p6p7 (lsb) byte3 */
+#if defined(__SSE2__)
   int i;
+  for(i = 0; i < 2; i++)
+  {
+    /* Four rows at once */
+    __m128i bp = _mm_loadu_si128((__m128i *)&vram.b[(name << 5) | (i << 4)]);
+#ifdef LSB_FIRST
+    bp = _mm_or_si128(_mm_slli_epi16(bp, 8), _mm_srli_epi16(bp, 8));
+#endif
+
+    /* One pixel per byte, even pixels in high nibbles */
+    __m128i mask = _mm_set1_epi8(0x0F);
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(bp, 4), mask);
+    __m128i lo = _mm_and_si128(bp, mask);
+    store_pattern_rows(dst, (i << 1), _mm_unpacklo_epi8(hi, lo));
+    store_pattern_rows(dst, (i << 1) + 1, _mm_unpackhi_epi8(hi, lo));
+  }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+  int i;
+  for(i = 0; i < 2; i++)
+  {
+    /* Four rows at once */
+    uint8x16_t bp = vld1q_u8(&vram.b[(name << 5) | (i << 4)]);
+#ifdef LSB_FIRST
+    bp = vrev16q_u8(bp);
+#endif
+
+    /* One pixel per byte, even pixels in high nibbles */
+    uint8x16x2_t pixels = vzipq_u8(vshrq_n_u8(bp, 4), vandq_u8(bp, vdupq_n_u8(0x0F)));
+    store_pattern_rows(dst, (i << 1), pixels.val[0]);
+    store_pattern_rows(dst, (i << 1) + 1, pixels.val[1]);
+  }
+#else
   uint8 x, y, c;
-  uint8 *dst;
-  uint16 name;
   uint32 bp;
 
-  for(i = 0; i < index; i++)
+  for(y = 0; y < 8; y ++)
   {
-    /* Get modified pattern name index */
-    name = bg_name_list[i];
+    bp = vram.getL((name << 5) | (y << 2));
 
-    /* Check modified lines */
-    for(y = 0; y < 8; y ++)
+    /* Update cached line (8 pixels = 8 bytes) */
+    for(x = 0; x < 8; x ++)
     {
-      if(bg_name_dirty[name] & (1 << y))
-      {
-        /* Pattern cache base address */
-        dst = &bg_pattern_cache[name << 6];
+      /* Extract pixel data */
+      c = bp & 0x0F;
 
-        /* Byteplane data (one pattern = 4 bytes) */
-        /* LIT_ENDIAN: byte0 (lsb) p2p3 p0p1 p6p7 p4p5 (msb) byte3 */
-        /* BIG_ENDIAN: byte0 (msb) p0p1 p2p3 p4p5 p6p7 (lsb) byte3 */
-        bp = vram.getL((name << 5) | (y << 2));
-
-        /* Update cached line (8 pixels = 8 bytes) */
-        for(x = 0; x < 8; x ++)
-        {
-          /* Extract pixel data */
-          c = bp & 0x0F;
-
-          /* Pattern cache data (one pattern = 8 bytes) */
-          /* byte0 <-> p0 p1 p2 p3 p4 p5 p6 p7 <-> byte7 (hflip = 0) */
-          /* byte0 <-> p7 p6 p5 p4 p3 p2 p1 p0 <-> byte7 (hflip = 1) */
+      /* Pattern cache data (one pattern = 8 bytes) */
+      /* byte0 <-> p0 p1 p2 p3 p4 p5 p6 p7 <-> byte7 (hflip = 0) */
+      /* byte0 <-> p7 p6 p5 p4 p3 p2 p1 p0 <-> byte7 (hflip = 1) */
 #ifdef LSB_FIRST
-          /* Byteplane data = (msb) p4p5 p6p7 p0p1 p2p3 (lsb) */
-          dst[0x00000 | (y << 3) | (x ^ 3)] = (c);        /* vflip=0, hflip=0 */
-          dst[0x20000 | (y << 3) | (x ^ 4)] = (c);        /* vflip=0, hflip=1 */
-          dst[0x40000 | ((y ^ 7) << 3) | (x ^ 3)] = (c);  /* vflip=1, hflip=0 */
-          dst[0x60000 | ((y ^ 7) << 3) | (x ^ 4)] = (c);  /* vflip=1, hflip=1 */
+      /* Byteplane data = (msb) p4p5 p6p7 p0p1 p2p3 (lsb) */
+      dst[0x00 | (y << 3) | (x ^ 3)] = (c);        /* vflip=0, hflip=0 */
+      dst[0x40 | (y << 3) | (x ^ 4)] = (c);        /* vflip=0, hflip=1 */
+      dst[0x80 | ((y ^ 7) << 3) | (x ^ 3)] = (c);  /* vflip=1, hflip=0 */
+      dst[0xC0 | ((y ^ 7) << 3) | (x ^ 4)] = (c);  /* vflip=1, hflip=1 */
 #else
-          /* Byteplane data = (msb) p0p1 p2p3 p4p5 p6p7 (lsb) */
-          dst[0x00000 | (y << 3) | (x ^ 7)] = (c);        /* vflip=0, hflip=0 */
-          dst[0x20000 | (y << 3) | (x)] = (c);            /* vflip=0, hflip=1 */
-          dst[0x40000 | ((y ^ 7) << 3) | (x ^ 7)] = (c);  /* vflip=1, hflip=0 */
-          dst[0x60000 | ((y ^ 7) << 3) | (x)] = (c);      /* vflip=1, hflip=1 */
+      /* Byteplane data = (msb) p0p1 p2p3 p4p5 p6p7 (lsb) */
+      dst[0x00 | (y << 3) | (x ^ 7)] = (c);        /* vflip=0, hflip=0 */
+      dst[0x40 | (y << 3) | (x)] = (c);            /* vflip=0, hflip=1 */
+      dst[0x80 | ((y ^ 7) << 3) | (x ^ 7)] = (c);  /* vflip=1, hflip=0 */
+      dst[0xC0 | ((y ^ 7) << 3) | (x)] = (c);      /* vflip=1, hflip=1 */
 #endif
-          /* Next pixel */
-          bp = bp >> 4;
-        }
-      }
+      /* Next pixel */
+      bp = bp >> 4;
     }
-
-    /* Clear modified pattern flag */
-    bg_name_dirty[name] = 0;
   }
-}
+#endif
 
+  /* Clear modified pattern flag */
+  bg_name_dirty[name] = 0;
+  cache_stats.pattern_misses++;
+}
 
 /*--------------------------------------------------------------------------*/
 /* Window & Plane A clipping update function (Mode 5)                       */
@@ -3714,16 +3887,19 @@ void render_line(int line)
 {
   int width = bitmap.viewport.w;
 
+  /* Pattern cache statistics */
+  if (line == 0)
+  {
+    bg_cache_stats = cache_stats;
+    memset(&cache_stats, 0, sizeof(cache_stats));
+#ifdef LOGVDP
+    error("pattern cache: %u hits, %u expanded / name table rows: %u hits, %u decoded\n", bg_cache_stats.pattern_hits, bg_cache_stats.pattern_misses, bg_cache_stats.row_hits, bg_cache_stats.row_misses);
+#endif
+  }
+
   /* Check display status */
   if (reg[1] & 0x40)
   {
-    /* Update pattern cache */
-    if (bg_list_index)
-    {
-      update_bg_pattern_cache(bg_list_index);
-      bg_list_index = 0;
-    }
-
     /* Render BG layer(s) */
     render_bg(line, width);
 
@@ -3791,6 +3967,15 @@ void remap_line(int line)
 #else
     uint16 *dst =((uint16 *)&bitmap.data[(line * bitmap.pitch)]);
 #endif
+
+#ifdef SUPPORT_16BPP_RENDER
+  /* NTSC filter output stage, lines are only filtered once the next one is started */
+  if (ntscOutputActive)
+  {
+    ntscOutputLine(line, width, !(reg[1] & 4));
+  }
+#endif
+
 	do
 	{
 		*dst++ = pixel[*src++];
@@ -24,9 +24,19 @@
 #ifndef _RENDER_H_
 #define _RENDER_H_
 
+/* Pattern & name table cache statistics */
+typedef struct
+{
+  uint32 pattern_hits;    /* pattern lines drawn from the cache */
+  uint32 pattern_misses;  /* patterns expanded after VRAM writes */
+  uint32 row_hits;        /* name table rows reused as decoded */
+  uint32 row_misses;      /* name table rows decoded */
+} t_bg_cache_stats;
+
 /* Global variables */
 extern uint8 object_count;
 extern uint16 spr_col;
+extern t_bg_cache_stats bg_cache_stats;
 
 /* Function prototypes */
 extern void render_init(void);
@@ -47,8 +57,8 @@ extern void render_obj_m5_im2(int max_width);
 extern void render_obj_m5_im2_ste(int max_width);
 extern void parse_satb_m4(int line);
 extern void parse_satb_m5(int line);
-extern void update_bg_pattern_cache_m4(int index);
-extern void update_bg_pattern_cache_m5(int index);
+extern void update_bg_pattern_cache_m4(int name);
+extern void update_bg_pattern_cache_m5(int name);
 extern void color_update_m4(int index, unsigned int data);
 extern void color_update_m5(int index, unsigned int data);
 
@@ -56,7 +66,7 @@ extern void color_update_m5(int index, unsigned int data);
 extern void (*render_bg)(int line, int width);
 extern void (*render_obj)(int max_width);
 extern void (*parse_satb)(int line);
-extern void (*update_bg_pattern_cache)(int index);
+extern void (*update_bg_pattern_cache)(int name);
 
 #endif /* _RENDER_H_ */
 
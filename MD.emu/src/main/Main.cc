@@ -74,6 +74,7 @@ KeyCategory category[categories] =
 #include "genesis.h"
 #include "genplus-config.h"
 #include <scd/scd.h>
+#include "ntsc/ntsc_output.h"
 
 t_config config = { 0 };
 uint config_ym2413_enabled = 1;
@@ -121,13 +122,17 @@ enum {
 	CFGKEY_MDKEY_RIGHT_DOWN = 276, CFGKEY_MDKEY_LEFT_DOWN = 277,
 	CFGKEY_MDKEY_BIG_ENDIAN_SRAM = 278, CFGKEY_MDKEY_SMS_FM = 279,
 	CFGKEY_MDKEY_6_BTN_PAD = 280, CFGKEY_MD_CD_BIOS_USA_PATH = 281,
-	CFGKEY_MD_CD_BIOS_JPN_PATH = 282, CFGKEY_MD_CD_BIOS_EUR_PATH = 283
+	CFGKEY_MD_CD_BIOS_JPN_PATH = 282, CFGKEY_MD_CD_BIOS_EUR_PATH = 283,
+	CFGKEY_MD_FM_THREAD = 284, CFGKEY_MD_NTSC_FILTER = 285
 };
 
 static bool usingMultiTap = 0;
 static BasicByteOption optionBigEndianSram(CFGKEY_MDKEY_BIG_ENDIAN_SRAM, 0);
 static BasicByteOption optionSmsFM(CFGKEY_MDKEY_SMS_FM, 1);
 static BasicByteOption option6BtnPad(CFGKEY_MDKEY_6_BTN_PAD, 0);
+static BasicByteOption optionFMThread(CFGKEY_MD_FM_THREAD, 0);
+static Option<OptionMethodValidatedVar<uint8, optionIsValidWithMax<NTSC_MONOCHROME> > > optionNtscFilter
+		(CFGKEY_MD_NTSC_FILTER, NTSC_OFF);
 FsSys::cPath cdBiosUSAPath = "", cdBiosJpnPath = "", cdBiosEurPath = "";
 static PathOption<CFGKEY_MD_CD_BIOS_USA_PATH> optionCDBiosUsaPath(cdBiosUSAPath, sizeof(cdBiosUSAPath), "");
 static PathOption<CFGKEY_MD_CD_BIOS_JPN_PATH> optionCDBiosJpnPath(cdBiosJpnPath, sizeof(cdBiosJpnPath), "");
@@ -174,6 +179,8 @@ bool EmuSystem::readConfig(Io *io, uint key, uint readSize)
 		bcase CFGKEY_MD_CD_BIOS_USA_PATH: optionCDBiosUsaPath.readFromIO(io, readSize);
 		bcase CFGKEY_MD_CD_BIOS_JPN_PATH: optionCDBiosJpnPath.readFromIO(io, readSize);
 		bcase CFGKEY_MD_CD_BIOS_EUR_PATH: optionCDBiosEurPath.readFromIO(io, readSize);
+		bcase CFGKEY_MD_FM_THREAD: optionFMThread.readFromIO(io, readSize);
+		bcase CFGKEY_MD_NTSC_FILTER: optionNtscFilter.readFromIO(io, readSize);
 		bdefault: return 0;
 	}
 	return 1;
@@ -196,6 +203,16 @@ void EmuSystem::writeConfig(Io *io)
 		io->writeVar((uint16)option6BtnPad.ioSize());
 		option6BtnPad.writeToIO(io);
 	}
+	if(!optionFMThread.isDefault())
+	{
+		io->writeVar((uint16)optionFMThread.ioSize());
+		optionFMThread.writeToIO(io);
+	}
+	if(!optionNtscFilter.isDefault())
+	{
+		io->writeVar((uint16)optionNtscFilter.ioSize());
+		optionNtscFilter.writeToIO(io);
+	}
 	optionCDBiosUsaPath.writeToIO(io);
 	optionCDBiosJpnPath.writeToIO(io);
 	optionCDBiosEurPath.writeToIO(io);
@@ -240,7 +257,8 @@ static bool isMDExtension(const char *name)
 
 static bool isMDCDExtension(const char *name)
 {
-	return string_hasDotExtension(name, "bin") || string_hasDotExtension(name, "iso");
+	return string_hasDotExtension(name, "bin") || string_hasDotExtension(name, "iso")
+		|| string_hasDotExtension(name, "cue");
 }
 
 static int mdROMFsFilter(const char *name, int type)
@@ -271,6 +289,15 @@ static const uint mdMaxResX = 320, mdMaxResY = 240;
 static int mdResX = 256, mdResY = 224;
 static uint16 nativePixBuff[mdMaxResX*mdMaxResY] __attribute__ ((aligned (8)));
 t_bitmap bitmap = { (uint8*)nativePixBuff, mdResY, mdResX * pixFmt->bytesPerPixel };
+static uint ntscResX = 0; // width of the NTSC filtered image being shown, 0 if unfiltered
+
+static void initVideoImage(bool force)
+{
+	if(ntscResX)
+		emuView.initImage(force, ntscResX, mdResY, (ntscMaxWidth - ntscResX) * pixFmt->bytesPerPixel);
+	else
+		emuView.initImage(force, mdResX, mdResY);
+}
 
 static uint ptrInputToSysButton(uint input)
 {
@@ -346,12 +373,28 @@ void EmuSystem::handleInputAction(uint player, uint state, uint emuKey)
 
 void commitVideoFrame()
 {
+	// filter threads must be done with the frame before the pitch can change
+	uint filteredResX = ntscOutputActive ? ntscOutputFinish() : 0;
+	bool resized = 0;
+	if(unlikely(filteredResX != ntscResX))
+	{
+		ntscResX = filteredResX;
+		if(ntscResX)
+			emuView.initPixmap((uchar*)ntscBitmap, pixFmt, ntscResX, mdResY, (ntscMaxWidth - ntscResX) * pixFmt->bytesPerPixel);
+		else
+			emuView.initPixmap((uchar*)nativePixBuff, pixFmt, mdResX, mdResY);
+		resized = 1;
+	}
 	if(unlikely(bitmap.viewport.w != mdResX || bitmap.viewport.h != mdResY))
 	{
 		mdResX = bitmap.viewport.w;
 		mdResY = bitmap.viewport.h;
 		bitmap.pitch = mdResX * pixFmt->bytesPerPixel;
-		emuView.resizeImage(mdResX, mdResY);
+		resized = 1;
+	}
+	if(unlikely(resized))
+	{
+		initVideoImage(1);
 		if(optionImageZoom == optionImageZoomIntegerOnly)
 			emuView.placeEmu();
 	}
@@ -682,7 +725,7 @@ int EmuSystem::loadGame(const char *path, bool allowAutosaveState)
 	#endif
 	snprintf(fullGamePath, sizeof(fullGamePath), "%s/%s", gamePath, path);
 	logMsg("full game path: %s", fullGamePath);
-	if(string_hasDotExtension(path, "iso")
+	if(string_hasDotExtension(path, "iso") || string_hasDotExtension(path, "cue")
 		|| (string_hasDotExtension(path, "bin") && FsSys::fileSize(fullGamePath) > 1024*1024*10)) // CD
 	{
 		uint region;
@@ -821,7 +864,7 @@ int EmuSystem::loadGame(const char *path, bool allowAutosaveState)
 		loadMDState(saveStr);
 	}
 
-	emuView.initImage(0, mdResX, mdResY);
+	initVideoImage(0);
 
 	logMsg("started emu");
 	return 1;
@@ -883,6 +926,8 @@ CallResult onInit()
 	emuView.initPixmap((uchar*)nativePixBuff, pixFmt, mdResX, mdResY);
 	vController.gp.activeFaceBtns = option6BtnPad ? 6 : 3;
 	config_ym2413_enabled = optionSmsFM;
+	fm_set_threaded(optionFMThread);
+	ntscOutputSetup(optionNtscFilter);
 	static uint8 cartMem[MAXROMSIZE] __attribute__ ((aligned (8)));
 	cart.rom = cartMem;
 
@@ -77,6 +77,18 @@ private:
 		}
 	} smsFM;
 
+	struct FMThreadMenuItem : public BoolMenuItem
+	{
+		void init() { BoolMenuItem::init("Threaded FM Sound", optionFMThread); }
+
+		void select(View *view, const InputEvent &e)
+		{
+			toggle();
+			optionFMThread = on;
+			fm_set_threaded(optionFMThread);
+		}
+	} fmThread;
+
 	struct BigEndianSramMenuItem : public BoolMenuItem
 	{
 		void init() { BoolMenuItem::init("Use Big-Endian SRAM", optionBigEndianSram); }
@@ -177,14 +189,39 @@ private:
 		setupMDInput();
 	}
 
+	MultiChoiceSelectMenuItem ntscFilter;
+
+	void ntscFilterInit()
+	{
+		static const char *str[] =
+		{
+			"Off", "Composite", "S-Video", "RGB", "Monochrome"
+		};
+		ntscFilter.init("NTSC Filter", str, int(optionNtscFilter), sizeofArray(str));
+		ntscFilter.valueDelegate().bind<&ntscFilterSet>();
+	}
+
+	static void ntscFilterSet(MultiChoiceMenuItem &, int val)
+	{
+		optionNtscFilter.val = val;
+		ntscOutputSetup(val);
+	}
+
 	MenuItem *item[24];
 
 public:
 
+	void loadVideoItems(MenuItem *item[], uint &items)
+	{
+		OptionView::loadVideoItems(item, items);
+		ntscFilterInit(); item[items++] = &ntscFilter;
+	}
+
 	void loadAudioItems(MenuItem *item[], uint &items)
 	{
 		OptionView::loadAudioItems(item, items);
 		smsFM.init(); item[items++] = &smsFM;
+		fmThread.init(); item[items++] = &fmThread;
 	}
 
 	void loadInputItems(MenuItem *item[], uint &items)
@@ -10,16 +10,245 @@
 #include "scd.h"
 #include "cd_file.h"
 #include "cd_sys.h"
+#include "cd_stream.h"
 #include <logger/interface.h>
 #include <assert.h>
 #include <string.h>
+#include <strings.h>
 #include <stdio.h>
 #include <io/sys.hh>
+#include <util/strings.h>
 
 #define cdprintf(x...)
 //#define cdprintf(f,...) printf(f "\n",##__VA_ARGS__) // tmp
 //#define DEBUG_CD
 
+static uint32 readLE32(const uchar *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24);
+}
+
+// Returns the file position of the samples in a 44.1KHz 16-bit stereo PCM WAV file, or -1
+static int waveDataOffset(Io *f)
+{
+	uchar header[12];
+	if(fseek(f, 0, SEEK_SET) != 0 || fread(header, 12, 1, f) != 1
+		|| memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0)
+		return -1;
+	bool formatOK = false;
+	uchar chunk[8];
+	while(fread(chunk, 8, 1, f) == 1)
+	{
+		uint32 size = readLE32(chunk + 4);
+		if(memcmp(chunk, "fmt ", 4) == 0 && size >= 16)
+		{
+			uchar fmt[16];
+			if(fread(fmt, 16, 1, f) != 1)
+				return -1;
+			formatOK = fmt[0] == 1 && fmt[1] == 0 // PCM
+				&& fmt[2] == 2 && readLE32(fmt + 4) == 44100 && fmt[14] == 16;
+			size -= 16;
+		}
+		else if(memcmp(chunk, "data", 4) == 0)
+		{
+			return formatOK ? ftell(f) : -1;
+		}
+		if(fseek(f, (size + 1) & ~1, SEEK_CUR) != 0)
+			return -1;
+	}
+	return -1;
+}
+
+static const char *skipSpace(const char *s)
+{
+	while(*s == ' ' || *s == '\t')
+		s++;
+	return s;
+}
+
+static bool cueKeyword(const char *&s, const char *keyword)
+{
+	uint len = strlen(keyword);
+	if(strncasecmp(s, keyword, len) != 0 || (s[len] != ' ' && s[len] != '\t'))
+		return false;
+	s = skipSpace(s + len);
+	return true;
+}
+
+static int cueMSF(const char *s)
+{
+	int m, sec, f;
+	if(sscanf(s, "%d:%d:%d", &m, &sec, &f) != 3)
+		return -1;
+	return (m * 60 + sec) * 75 + f;
+}
+
+static void closeTrackFile(int track)
+{
+	_scd_track *Tracks = sCD.TOC.Tracks;
+	// tracks of one cue sheet FILE share its handle
+	if (Tracks[track].F && (track == 0 || Tracks[track].F != Tracks[track - 1].F))
+#if !DONT_OPEN_MANY_FILES
+		fclose(Tracks[track].F);
+#else
+		free(Tracks[track].F);
+#endif
+}
+
+// Builds the TOC from a cue sheet with MODE1 data and AUDIO tracks in BIN or WAV files
+static int Load_CUE(const char *cue_name)
+{
+	_scd_track *Tracks = sCD.TOC.Tracks;
+	char line[1024], path[1024];
+	Io *cue = IoSys::open(cue_name);
+	if (!cue)
+		return -1;
+
+	// FILE names are relative to the cue sheet
+	const char *slash = strrchr(cue_name, '/');
+	int dirLen = slash ? slash - cue_name + 1 : 0;
+
+	Io *file = 0;
+	int fileIsWave = 0, fileOffset = 0, fileLBA = 0;
+	int num_track = 0, ret = 0;
+	while (cue->readLine(line, sizeof(line)) == OK)
+	{
+		line[strcspn(line, "\r\n")] = 0;
+		const char *s = skipSpace(line);
+		if (cueKeyword(s, "FILE"))
+		{
+			char name[512];
+			if (*s == '"' ? sscanf(s + 1, "%511[^\"]", name) != 1 : sscanf(s, "%511s", name) != 1)
+				continue;
+			s = strrchr(s, ' ');
+			fileIsWave = s && strncasecmp(skipSpace(s), "WAVE", 4) == 0;
+			if (dirLen + strlen(name) >= sizeof(path))
+			{
+				ret = -1;
+				break;
+			}
+			memcpy(path, cue_name, dirLen);
+			strcpy(path + dirLen, name);
+			// the next file starts where the last track of the previous one ended
+			if (num_track)
+			{
+				_scd_track &prev = Tracks[num_track - 1];
+				if (prev.Length < 0)
+				{
+					ret = -1;
+					break;
+				}
+				prev.Length = (prev.F->size() - prev.Offset) / prev.SectorSize;
+				fileLBA = Track_to_LBA(num_track) + prev.Length;
+			}
+			file = IoSys::open(path);
+			if (!file)
+			{
+				logErr("unable to open %s from cue sheet", path);
+				ret = -1;
+				break;
+			}
+			fileOffset = 0;
+			if (fileIsWave && (fileOffset = waveDataOffset(file)) < 0)
+			{
+				logErr("%s isn't a 44.1KHz 16-bit stereo WAV", path);
+				fclose(file);
+				file = 0;
+				ret = -1;
+				break;
+			}
+		}
+		else if (cueKeyword(s, "TRACK"))
+		{
+			if (!file || num_track >= 99)
+			{
+				ret = -1;
+				break;
+			}
+			_scd_track &track = Tracks[num_track];
+			s = skipSpace(s + strspn(s, "0123456789"));
+			if (!strncasecmp(s, "AUDIO", 5))
+			{
+				track.ftype = fileIsWave ? TYPE_WAV : TYPE_AUDIO;
+				track.SectorSize = 2352;
+			}
+			else if (!fileIsWave && !strncasecmp(s, "MODE1/2048", 10))
+			{
+				track.ftype = TYPE_ISO;
+				track.SectorSize = 2048;
+			}
+			else if (!fileIsWave && !strncasecmp(s, "MODE1/2352", 10))
+			{
+				track.ftype = TYPE_BIN;
+				track.SectorSize = 2352;
+			}
+			else
+			{
+				logErr("unsupported track type %s", s);
+				ret = -1;
+				break;
+			}
+			track.F = file;
+			track.Length = -1; // set by INDEX 01
+			num_track++;
+		}
+		else if (cueKeyword(s, "PREGAP") && num_track)
+		{
+			// silence not stored in the file, shifts the rest of it
+			int frames = cueMSF(s);
+			if (frames > 0)
+				fileLBA += frames;
+		}
+		else if (cueKeyword(s, "INDEX") && num_track && atoi(s) == 1)
+		{
+			_scd_track &track = Tracks[num_track - 1];
+			int frames = cueMSF(skipSpace(s + strspn(s, "0123456789")));
+			if (frames < 0)
+			{
+				ret = -1;
+				break;
+			}
+			track.Offset = fileOffset + frames * track.SectorSize;
+			track.Length = 0;
+			LBA_to_MSF(fileLBA + frames, &track.MSF);
+			// a track ends where the next one in the same file starts, or at the end of its file
+			if (num_track > 1 && Tracks[num_track - 2].F == file)
+				Tracks[num_track - 2].Length = (track.Offset - Tracks[num_track - 2].Offset) / Tracks[num_track - 2].SectorSize;
+			sCD.TOC.Last_Track = num_track; // for Track_to_LBA()
+		}
+	}
+	fclose(cue);
+
+	if (ret == 0 && (!num_track || Tracks[num_track - 1].Length < 0 || Tracks[0].ftype == TYPE_WAV || Tracks[0].ftype == TYPE_AUDIO))
+	{
+		logErr("cue sheet has no data track");
+		ret = -1;
+	}
+	if (ret != 0)
+	{
+		// the FILE opened last may not have a track yet
+		if (file && (!num_track || Tracks[num_track - 1].F != file))
+			fclose(file);
+		Unload_ISO();
+		return -1;
+	}
+
+	_scd_track &last = Tracks[num_track - 1];
+	last.Length = (last.F->size() - last.Offset) / last.SectorSize;
+	iterateTimes(num_track, i)
+	{
+		logMsg("Track %d - %02d:%02d:%02d %s, %d sectors", i + 1, Tracks[i].MSF.M, Tracks[i].MSF.S, Tracks[i].MSF.F,
+			i ? "AUDIO" : "DATA", Tracks[i].Length);
+	}
+
+	sCD.TOC.Last_Track = num_track;
+	LBA_to_MSF(Track_to_LBA(num_track) + last.Length, &Tracks[num_track].MSF);
+	logMsg("End CD - %02d:%02d:%02d", Tracks[num_track].MSF.M, Tracks[num_track].MSF.S, Tracks[num_track].MSF.F);
+
+	cdStreamStart();
+	return 0;
+}
+
 int Load_ISO(const char *iso_name, int is_bin)
 {
 	int i, j, num_track, Cur_LBA, index, ret, iso_name_len;
@@ -38,6 +267,9 @@ int Load_ISO(const char *iso_name, int is_bin)
 
 	Unload_ISO();
 
+	if (string_hasDotExtension(iso_name, "cue"))
+		return Load_CUE(iso_name);
+
 	Tracks[0].ftype = is_bin ? TYPE_BIN : TYPE_ISO;
 
 	Tracks[0].F = pmf = IoSys::open(iso_name);
@@ -48,9 +280,8 @@ int Load_ISO(const char *iso_name, int is_bin)
 		return -1;
 	}
 
-	if (Tracks[0].ftype == TYPE_ISO)
-		Tracks[0].Length = pmf->size() >> 11;	// size in sectors
-	else	Tracks[0].Length = pmf->size() / 2352;
+	Tracks[0].SectorSize = Tracks[0].ftype == TYPE_ISO ? 2048 : 2352;
+	Tracks[0].Length = pmf->size() / Tracks[0].SectorSize;	// size in sectors
 
 	Tracks[0].MSF.M = 0; // minutes
 	Tracks[0].MSF.S = 2; // seconds
@@ -157,6 +388,7 @@ int Load_ISO(const char *iso_name, int is_bin)
 		Tracks[index].MSF.S, Tracks[index].MSF.F);
 
 	//if (PicoCDLoadProgressCB != NULL) PicoCDLoadProgressCB(100);
+	cdStreamStart();
 	return 0;
 }
 
@@ -165,30 +397,16 @@ void Unload_ISO(void)
 {
 	int i;
 
-	if (sCD.TOC.Tracks[0].F) fclose(sCD.TOC.Tracks[0].F);
+	cdStreamStop();
 
-	for(i = 1; i < 100; i++)
+	for(i = 0; i < 100; i++)
 	{
-		if (sCD.TOC.Tracks[i].F != NULL)
-#if !DONT_OPEN_MANY_FILES
-			fclose(sCD.TOC.Tracks[i].F);
-#else
-			free(sCD.TOC.Tracks[i].F);
-#endif
+		closeTrackFile(i);
 	}
+	sCD.TOC.Last_Track = 0;
 	memset(sCD.TOC.Tracks, 0, sizeof(sCD.TOC.Tracks));
 }
 
-static void readLBA(void *dest, int lba)
-{
-	bool isBin = sCD.TOC.Tracks[0].ftype == TYPE_BIN;
-
-	int pos = isBin ? (lba * 2352 + 16) : (lba << 11);
-	//logMsg("seeking to lba %d, %d", lba, pos);
-	fseek(sCD.TOC.Tracks[0].F, pos, SEEK_SET);
-	fread(dest, 2048, 1, sCD.TOC.Tracks[0].F);
-}
-
 int FILE_Read_One_LBA_CDC(void)
 {
 //	static char cp_buf[2560];
@@ -247,7 +465,7 @@ int FILE_Read_One_LBA_CDC(void)
 				sCD.cdc.PT.N = (sCD.cdc.PT.N + 2352) & 0x7FFF;
 
 				*(uint32a*)(sCD.cdc.Buffer + sCD.cdc.PT.N) = sCD.cdc.HEAD.N;
-				readLBA(sCD.cdc.Buffer + sCD.cdc.PT.N + 4, where_read);
+				cdStreamReadData(sCD.cdc.Buffer + sCD.cdc.PT.N + 4, where_read);
 
 #ifdef DEBUG_CD
 				logMsg("Read -> WA = %d  Buffer[%d] =", sCD.cdc.WA.N, sCD.cdc.PT.N & 0x3FFF);
@@ -268,6 +486,7 @@ int FILE_Read_One_LBA_CDC(void)
 	else		// music track
 	{
 		sCD.Cur_LBA++;
+		cdStreamAudioSector(sCD.Cur_LBA);
 
 		sCD.cdc.WA.N = (sCD.cdc.WA.N + 2352) & 0x7FFF;		// add one sector to WA
 		sCD.cdc.PT.N = (sCD.cdc.PT.N + 2352) & 0x7FFF;
@@ -329,16 +548,10 @@ int FILE_Play_CD_LBA(void)
 		return 1;
 	}
 
-	if (sCD.TOC.Tracks[index].ftype == TYPE_MP3)
+	if (sCD.TOC.Tracks[index].ftype == TYPE_WAV || sCD.TOC.Tracks[index].ftype == TYPE_AUDIO)
 	{
-		int pos1024 = 0;
-		int Track_LBA_Pos = sCD.Cur_LBA - Track_to_LBA(sCD.Cur_Track);
-		if (Track_LBA_Pos < 0) Track_LBA_Pos = 0;
-		if (Track_LBA_Pos)
-			pos1024 = Track_LBA_Pos * 1024 / sCD.TOC.Tracks[index].Length;
-
-		//TODO mp3
-		//mp3_start_play(sCD.TOC.Tracks[index].F, pos1024);
+		// the stream runs on from here across track boundaries like the drive does
+		cdStreamPlayAudio(sCD.Cur_LBA);
 	}
 	else
 	{
@@ -3,7 +3,8 @@
 #define TYPE_ISO 1
 #define TYPE_BIN 2
 #define TYPE_MP3 3
-//#define TYPE_WAV 4
+#define TYPE_WAV 4
+#define TYPE_AUDIO 5 // raw audio sectors in a BIN
 
 
 
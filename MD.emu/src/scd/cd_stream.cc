@@ -0,0 +1,354 @@
+#define thisModuleName "cdStream"
+#include "scd.h"
+#include "cd_stream.h"
+#include <logger/interface.h>
+#include <util/thread/pthread.hh>
+#include <string.h>
+#include <stdlib.h>
+
+static const uint dataSlots = 64; // direct mapped by lba, power of 2
+static const uint dataAhead = 32; // sectors read ahead of the CDC, less than dataSlots
+static const uint audioSectorFrames = 588; // 2352 bytes of 16-bit stereo
+static const uint audioRingFrames = audioSectorFrames * 16; // ~213ms
+static const int audioMaxDrift = 8; // sectors the stream may lag the drive before restarting
+
+template <class T>
+static T loadAcquire(const T &var) { return __atomic_load_n(&var, __ATOMIC_ACQUIRE); }
+
+template <class T>
+static void storeRelease(T &var, T val) { __atomic_store_n(&var, val, __ATOMIC_RELEASE); }
+
+struct CDStream
+{
+	constexpr CDStream() { }
+	bool active = false;
+	bool quit = false;
+	ThreadPThread thread;
+	MutexPThread mutex;
+	CondVarPThread workCond, doneCond;
+
+	// data cache, all fields guarded by the mutex
+	int slotLba[dataSlots] {0};
+	uchar slot[dataSlots][2048] {{0}};
+	int nextLba = 0; // next sector the I/O thread reads
+	int lastLba = 0; // last sector read by the CDC, prefetching stops at lastLba + dataAhead
+	int waitLba = -1; // sector the emulation thread is blocked on
+	uint hits = 0, misses = 0;
+
+	// CD-DA, producer state guarded by the mutex
+	bool audioOn = false;
+	uint audioGen = 0; // bumped on restart so in-flight reads get dropped
+	int audioNextLba = 0;
+	int audioStartLba = 0; // sector at audioRead == 0
+	int16 audioRing[audioRingFrames * 2] {0};
+	uint audioWrite = 0; // frames written, only advanced by the I/O thread
+	uint audioRead = 0; // frames read, only advanced by the mixer
+	uint audioPhase = 0; // 16.16 resampler position past audioRead
+	uint underruns = 0;
+};
+
+static CDStream stream;
+
+// Returns the track holding lba with a file backing it
+static const _scd_track *findTrack(int lba, int &trackLba)
+{
+	iterateTimes(sCD.TOC.Last_Track, i)
+	{
+		const _scd_track &track = sCD.TOC.Tracks[i];
+		if(!track.F)
+			continue;
+		int start = Track_to_LBA(i + 1);
+		if(lba >= start && lba < start + track.Length)
+		{
+			trackLba = start;
+			return &track;
+		}
+	}
+	return nullptr;
+}
+
+static bool isAudioTrack(const _scd_track &track)
+{
+	return track.ftype == TYPE_WAV || track.ftype == TYPE_AUDIO;
+}
+
+static void readDataSector(uchar *dest, int lba)
+{
+	int trackLba;
+	auto track = findTrack(lba, trackLba);
+	if(!track || isAudioTrack(*track))
+	{
+		memset(dest, 0, 2048);
+		return;
+	}
+	// skip the sync & header of raw sectors
+	long pos = track->Offset + (long)(lba - trackLba) * track->SectorSize + (track->SectorSize == 2352 ? 16 : 0);
+	if(fseek(track->F, pos, SEEK_SET) != 0 || fread(dest, 2048, 1, track->F) != 1)
+	{
+		logWarn("error reading data sector %d", lba);
+		memset(dest, 0, 2048);
+	}
+}
+
+static void readAudioSector(int16 *dest, int lba)
+{
+	int trackLba;
+	auto track = findTrack(lba, trackLba);
+	if(!track || !isAudioTrack(*track))
+	{
+		memset(dest, 0, 2352);
+		return;
+	}
+	long pos = track->Offset + (long)(lba - trackLba) * 2352;
+	size_t bytes = 0;
+	if(fseek(track->F, pos, SEEK_SET) == 0)
+		bytes = fread(dest, 1, 2352, track->F);
+	if(bytes < 2352)
+		memset((uchar*)dest + bytes, 0, 2352 - bytes);
+	#ifndef LSB_FIRST
+	iterateTimes(audioSectorFrames * 2, i)
+	{
+		dest[i] = (int16)(((uint16)dest[i] >> 8) | ((uint16)dest[i] << 8));
+	}
+	#endif
+}
+
+static bool audioRoom(CDStream &s)
+{
+	return s.audioWrite - loadAcquire(s.audioRead) + audioSectorFrames <= audioRingFrames;
+}
+
+static bool dataWanted(CDStream &s)
+{
+	return s.waitLba != -1 || (s.nextLba <= s.lastLba + (int)dataAhead && s.nextLba < sCD.TOC.Tracks[0].Length);
+}
+
+static int ioThread(ThreadPThread &thread)
+{
+	auto &s = *(CDStream*)thread.arg;
+	uchar data[2048];
+	int16 audio[audioSectorFrames * 2];
+	s.mutex.lock();
+	for(;;)
+	{
+		bool audioWanted = s.audioOn && audioRoom(s);
+		while(!s.quit && !dataWanted(s) && !audioWanted)
+		{
+			s.workCond.wait();
+			audioWanted = s.audioOn && audioRoom(s);
+		}
+		if(s.quit)
+			break;
+
+		// a blocked CDC read comes first, then keeping the audio ring full
+		if(s.waitLba != -1 || !audioWanted)
+		{
+			int lba = s.nextLba;
+			s.mutex.unlock();
+			readDataSector(data, lba);
+			s.mutex.lock();
+			uint idx = lba & (dataSlots - 1);
+			memcpy(s.slot[idx], data, 2048);
+			s.slotLba[idx] = lba;
+			if(s.nextLba == lba)
+				s.nextLba++;
+			if(s.waitLba == lba)
+			{
+				s.waitLba = -1;
+				s.doneCond.signal();
+			}
+		}
+		else
+		{
+			int lba = s.audioNextLba;
+			uint gen = s.audioGen;
+			s.mutex.unlock();
+			readAudioSector(audio, lba);
+			s.mutex.lock();
+			if(gen == s.audioGen && audioRoom(s))
+			{
+				memcpy(&s.audioRing[(s.audioWrite % audioRingFrames) * 2], audio, sizeof(audio));
+				storeRelease(s.audioWrite, s.audioWrite + audioSectorFrames);
+				s.audioNextLba++;
+			}
+		}
+	}
+	s.mutex.unlock();
+	return 0;
+}
+
+bool cdStreamStart()
+{
+	auto &s = stream;
+	cdStreamStop();
+	iterateTimes(dataSlots, i)
+	{
+		s.slotLba[i] = -1;
+	}
+	s.nextLba = s.lastLba = 0;
+	s.waitLba = -1;
+	s.hits = s.misses = 0;
+	s.audioOn = false;
+	s.audioWrite = s.audioRead = s.audioPhase = 0;
+	s.underruns = 0;
+	s.quit = false;
+
+	s.mutex.create();
+	s.workCond.create(&s.mutex);
+	s.doneCond.create(&s.mutex);
+	if(!s.thread.create(0, ioThread, &s))
+	{
+		logWarn("unable to start CD I/O thread, reading synchronously without CD audio");
+		s.workCond.destroy();
+		s.doneCond.destroy();
+		s.mutex.destroy();
+		return false;
+	}
+	s.active = true;
+	return true;
+}
+
+void cdStreamStop()
+{
+	auto &s = stream;
+	if(!s.active)
+		return;
+	s.mutex.lock();
+	s.quit = true;
+	s.workCond.signal();
+	s.mutex.unlock();
+	s.thread.join();
+	s.active = false;
+	s.workCond.destroy();
+	s.doneCond.destroy();
+	s.mutex.destroy();
+	logMsg("CD data cache %u hits, %u misses, %u audio underruns", s.hits, s.misses, s.underruns);
+}
+
+void cdStreamReadData(void *dest, int lba)
+{
+	auto &s = stream;
+	if(!s.active)
+	{
+		readDataSector((uchar*)dest, lba);
+		return;
+	}
+	s.mutex.lock();
+	uint idx = lba & (dataSlots - 1);
+	if(s.slotLba[idx] == lba)
+		s.hits++;
+	else
+	{
+		s.misses++;
+		if(s.nextLba > lba || s.nextLba + (int)dataAhead < lba)
+			s.nextLba = lba; // not in the current read-ahead window
+		// keep read-ahead from cycling back around to this slot while waiting
+		s.lastLba = lba;
+		s.waitLba = lba;
+		s.workCond.signal();
+		while(s.waitLba != -1)
+			s.doneCond.wait();
+	}
+	memcpy(dest, s.slot[idx], 2048);
+	s.lastLba = lba;
+	if(s.nextLba <= lba)
+		s.nextLba = lba + 1;
+	s.workCond.signal();
+	s.mutex.unlock();
+}
+
+void cdStreamPrefetch(int lba)
+{
+	auto &s = stream;
+	if(!s.active)
+		return;
+	if(lba < 0)
+		lba = 0;
+	s.mutex.lock();
+	if(s.slotLba[lba & (dataSlots - 1)] != lba)
+	{
+		s.nextLba = lba;
+		s.lastLba = lba - 1;
+		s.workCond.signal();
+	}
+	s.mutex.unlock();
+}
+
+static void restartAudio(CDStream &s, int lba)
+{
+	s.audioGen++;
+	s.audioOn = true;
+	s.audioStartLba = s.audioNextLba = lba;
+	s.audioWrite = 0;
+	storeRelease(s.audioRead, 0u);
+	s.audioPhase = 0;
+	s.workCond.signal();
+}
+
+void cdStreamPlayAudio(int lba)
+{
+	auto &s = stream;
+	if(!s.active)
+		return;
+	s.mutex.lock();
+	restartAudio(s, lba);
+	s.mutex.unlock();
+}
+
+void cdStreamAudioSector(int lba)
+{
+	auto &s = stream;
+	if(!s.active || !s.audioOn)
+		return;
+	s.mutex.lock();
+	int playLba = s.audioStartLba + s.audioRead / audioSectorFrames;
+	if(abs(playLba - lba) > audioMaxDrift)
+	{
+		logMsg("CD audio at sector %d, drive at %d, restarting", playLba, lba);
+		restartAudio(s, lba);
+	}
+	else if(audioRoom(s))
+		s.workCond.signal();
+	s.mutex.unlock();
+}
+
+int cdStreamMixAudio(int16 *buff, uint frames, uint rate)
+{
+	auto &s = stream;
+	// only while the CDC is running over an audio track, after any seek delay
+	if(!s.active || !s.audioOn || !(sCD.Status_CDC & 1) || (sCD.gate[0x36] & 1) || sCD.File_Add_Delay)
+		return 0;
+	uint read = s.audioRead;
+	uint avail = loadAcquire(s.audioWrite) - read;
+	if(avail < 2)
+	{
+		s.underruns++;
+		return 0;
+	}
+	uint step = (44100 << 16) / rate;
+	uint phase = s.audioPhase;
+	iterateTimes(frames, i)
+	{
+		if(avail < 2)
+		{
+			s.underruns++;
+			memset(buff, 0, (frames - i) * 4);
+			break;
+		}
+		const int16 *a = &s.audioRing[(read % audioRingFrames) * 2];
+		const int16 *b = &s.audioRing[((read + 1) % audioRingFrames) * 2];
+		int frac = phase >> 1;
+		*buff++ = a[0] + (((b[0] - a[0]) * frac) >> 15);
+		*buff++ = a[1] + (((b[1] - a[1]) * frac) >> 15);
+		phase += step;
+		uint advance = IG::min(phase >> 16, avail);
+		phase &= 0xFFFF;
+		read += advance;
+		avail -= advance;
+	}
+	s.audioPhase = phase;
+	storeRelease(s.audioRead, read);
+	return 1;
+}
+
+#undef thisModuleName
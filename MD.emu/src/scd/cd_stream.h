@@ -0,0 +1,33 @@
+#pragma once
+
+#include <engine-globals.h>
+
+// Background reader for the loaded CD image.
+//
+// All file access happens on one I/O thread, started once the TOC is built
+// and stopped before the tracks are closed. Data sectors are read ahead of
+// the CDC into a small direct mapped cache, so sequential reads are served
+// without touching the file on the emulation thread. CD-DA sectors are
+// streamed into a single producer/single consumer ring that the mixer drains
+// without locking; on underrun it outputs silence instead of waiting.
+
+bool cdStreamStart();
+void cdStreamStop();
+
+// Copies the 2048 byte user data of sector lba, waiting for the I/O thread
+// only if it wasn't prefetched
+void cdStreamReadData(void *dest, int lba);
+
+// Starts reading ahead from lba, used when a seek or play command is issued
+void cdStreamPrefetch(int lba);
+
+// Restarts audio streaming at lba, dropping anything buffered
+void cdStreamPlayAudio(int lba);
+
+// Called as the drive advances one audio sector, restarts the stream if
+// it has drifted from lba and lets the I/O thread refill the ring
+void cdStreamAudioSector(int lba);
+
+// Adds frames of 44.1KHz CD-DA resampled to rate into buff (interleaved stereo),
+// returns 0 if no audio was available
+int cdStreamMixAudio(int16 *buff, uint frames, uint rate);
@@ -13,6 +13,7 @@
 #include "scd.h"
 #include "cd_sys.h"
 #include "cd_file.h"
+#include "cd_stream.h"
 
 #define cdprintf(x...)
 //#define DEBUG_CD
@@ -503,6 +504,7 @@ int Play_CDD_c3(void)
 	if (sCD.Cur_Track == 1)
 	{
 		sCD.gate[0x36] |=  0x01;				// DATA
+		cdStreamPrefetch(sCD.Cur_LBA);			// read ahead during the seek delay
 	}
 	else
 	{
@@ -549,7 +551,10 @@ int Seek_CDD_c4(void)
 
 	// DATA ?
 	if (sCD.Cur_Track == 1)
-	     sCD.gate[0x36] |=  0x01;
+	{
+		sCD.gate[0x36] |=  0x01;
+		cdStreamPrefetch(sCD.Cur_LBA);
+	}
 	else sCD.gate[0x36] &= ~0x01;		// AUDIO
 
 	sCD.cdd.Minute = 0;
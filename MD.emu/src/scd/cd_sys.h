@@ -39,9 +39,11 @@ struct _scd_track
 //	unsigned char Type; // always 1 (data) for 1st track, 0 (audio) for others
 //	unsigned char Num; // unused
 	_msf MSF;
-	char ftype = 0; // TYPE_ISO, TYPE_BIN, TYPE_MP3
-	Io *F = nullptr;
+	char ftype = 0; // TYPE_ISO, TYPE_BIN, TYPE_MP3, TYPE_WAV, TYPE_AUDIO
+	Io *F = nullptr; // may be shared with the neighbouring tracks of a cue sheet
 	int Length = 0;
+	uint Offset = 0; // file position of the first sector
+	ushort SectorSize = 0; // 2048 or 2352 bytes
 	short KBtps = 0; // kbytes per sec for mp3s (bitrate / 1000 / 8)
 };
 
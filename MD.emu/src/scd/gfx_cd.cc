@@ -9,6 +9,14 @@
 #include <logger/interface.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define GFX_CD_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define GFX_CD_NEON
+#endif
+
 static const int Table_Rot_Time[] =
 {
 	0x00054000, 0x00048000, 0x00040000, 0x00036000,          //; 008-032               ; briefing - sprite
@@ -83,217 +91,215 @@ static void gfx_completed(Rot_Comp &rot_comp)
 }
 
 
-static void gfx_do(Rot_Comp &rot_comp, unsigned int func, unsigned short *stamp_base, unsigned int H_Dot)
+// Lines are drawn in two passes. The first steps the texture coordinates of
+// each pixel and packs its stamp map index, dot position inside the stamp and
+// an outside-the-map flag, 4 pixels at a time with SSE2/NEON. The second fetches
+// the stamps & dots and writes the image buffer. Both passes are instantiated
+// per function (stamp & map size, repeat, priority mode), leaving no mode
+// branches in the per pixel loops. Stamps are re-read from word RAM for every
+// pixel, so writes to the stamp map, including the ones made by the image
+// buffer output itself, are always seen.
+
+#define GFX_OUTSIDE 0x80000000
+
+// Rotation & flip of a stamp (stamp number bits 13-15) as
+// {swap x/y, invert x, invert y} of the dot inside the stamp
+static const unsigned char stampXform[8][3] =
 {
-	//logMsg("func 0x%X", func);
-	unsigned int eax, ebx, ecx, edx, esi, edi, pixel;
-	unsigned int XD, Buffer_Adr;
-	int DYXS;
-
-	XD = rot_comp.imgBuffOffset & 7;
-	Buffer_Adr = ((rot_comp.imgBuffStartAddr & 0xfff8) + rot_comp.YD) << 2;
-	//if(rot_comp.imgBuffVDotSize == 40)
-		//logMsg("gfx buff 0x%X", Buffer_Adr);
-	ecx = *(uint32a*)(sCD.word.ram2M + rot_comp.Vector_Adr);
-	//logMsg("H dot %d", H_Dot);
-	edx = ecx >> 16;
-	ecx = (ecx & 0xffff) << 8;
-	edx <<= 8;
-	DYXS = *(int32a*)(sCD.word.ram2M + rot_comp.Vector_Adr + 4);
-	//logMsg("DYXS 0x%X", DYXS);
-	rot_comp.Vector_Adr += 8;
+	{0, 0, 0}, {1, 1, 0}, {0, 1, 1}, {1, 0, 1}, // No_Flip_0, 90, 180, 270
+	{0, 1, 0}, {1, 1, 1}, {0, 0, 1}, {1, 0, 0}, // Flip_0, 90, 180, 270
+};
 
-	// MAKE_IMAGE_LINE
-	while (H_Dot)
+template <unsigned int func>
+struct GfxFunc
+{
+	static const bool tiled = func & 1;
+	static const bool dot32 = func & 2;
+	static const bool screen16 = func & 4;
+	static const unsigned int prio = func & 0x18;
+	static const unsigned int outMask = screen16 ? 0x00800000 : 0x00f80000;
+	static const unsigned int dotMask = dot32 ? 0x1f : 0x0f;
+	// stamp index = ((x >> xShift) & xMask) | ((y >> yShift) & yMask)
+	static const unsigned int xShift = dot32 ? 11+5 : 11+4;
+	static const unsigned int xMask = dot32 ? (screen16 ? 0x007f : 0x07) : (screen16 ? 0x00ff : 0x0f);
+	static const unsigned int yShift = dot32 ? (screen16 ? 11-2 : 11+2) : (screen16 ? 11-4 : 11+0);
+	static const unsigned int yMask = dot32 ? (screen16 ? 0x3f80 : 0x38) : (screen16 ? 0xff00 : 0xf0);
+};
+
+template <unsigned int func>
+static unsigned int gfx_pack_pixel(unsigned int ecx, unsigned int edx)
+{
+	typedef GfxFunc<func> F;
+	unsigned int p = ((ecx >> F::xShift) & F::xMask) | ((edx >> F::yShift) & F::yMask)
+		| ((ecx >> 11) & F::dotMask) << 16 | ((edx >> 11) & F::dotMask) << 21;
+	if (!F::tiled && ((ecx | edx) & F::outMask))
+		p |= GFX_OUTSIDE;
+	return p;
+}
+
+template <unsigned int func>
+static void gfx_pack_line(unsigned int *span, unsigned int ecx, unsigned int edx, int DXS, int DYS, unsigned int H_Dot)
+{
+	typedef GfxFunc<func> F;
+	unsigned int i = 0;
+#if defined(GFX_CD_SSE2)
 	{
-		// MAKE_IMAGE_PIXEL
-		if (!(func & 1))	// NOT TILED
+		__m128i x = _mm_setr_epi32(ecx, ecx + DXS, ecx + DXS * 2, ecx + DXS * 3);
+		__m128i y = _mm_setr_epi32(edx, edx + DYS, edx + DYS * 2, edx + DYS * 3);
+		const __m128i xStep = _mm_set1_epi32(DXS * 4), yStep = _mm_set1_epi32(DYS * 4);
+		const __m128i xMask = _mm_set1_epi32(F::xMask), yMask = _mm_set1_epi32(F::yMask);
+		const __m128i dotMask = _mm_set1_epi32(F::dotMask), outMask = _mm_set1_epi32(F::outMask);
+		const __m128i outside = _mm_set1_epi32(GFX_OUTSIDE);
+		for(; i + 4 <= H_Dot; i += 4)
 		{
-			//logMsg("not tiled");
-			int mask = (func & 4) ? 0x00800000 : 0x00f80000;
-			if ((ecx | edx) & mask)
+			__m128i p = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(x, F::xShift), xMask),
+				_mm_and_si128(_mm_srli_epi32(y, F::yShift), yMask));
+			p = _mm_or_si128(p, _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(x, 11), dotMask), 16));
+			p = _mm_or_si128(p, _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(y, 11), dotMask), 21));
+			if (!F::tiled)
 			{
-				//logMsg("dxs 0x%X dys 0x%X", ecx, edx);
-				if (func & 0x18) goto Next_Pixel;
-				pixel = 0;
-				goto Pixel_Out;
+				__m128i inside = _mm_cmpeq_epi32(_mm_and_si128(_mm_or_si128(x, y), outMask), _mm_setzero_si128());
+				p = _mm_or_si128(p, _mm_andnot_si128(inside, outside));
 			}
+			_mm_storeu_si128((__m128i*)&span[i], p);
+			x = _mm_add_epi32(x, xStep);
+			y = _mm_add_epi32(y, yStep);
 		}
+		ecx += DXS * i;
+		edx += DYS * i;
+	}
+#elif defined(GFX_CD_NEON)
+	{
+		const uint32x4_t lane = {0, 1, 2, 3};
+		uint32x4_t x = vmlaq_n_u32(vdupq_n_u32(ecx), lane, DXS);
+		uint32x4_t y = vmlaq_n_u32(vdupq_n_u32(edx), lane, DYS);
+		const uint32x4_t xStep = vdupq_n_u32(DXS * 4), yStep = vdupq_n_u32(DYS * 4);
+		const uint32x4_t xMask = vdupq_n_u32(F::xMask), yMask = vdupq_n_u32(F::yMask);
+		const uint32x4_t dotMask = vdupq_n_u32(F::dotMask), outMask = vdupq_n_u32(F::outMask);
+		const uint32x4_t outside = vdupq_n_u32(GFX_OUTSIDE);
+		for(; i + 4 <= H_Dot; i += 4)
+		{
+			uint32x4_t p = vorrq_u32(vandq_u32(vshrq_n_u32(x, F::xShift), xMask),
+				vandq_u32(vshrq_n_u32(y, F::yShift), yMask));
+			p = vorrq_u32(p, vshlq_n_u32(vandq_u32(vshrq_n_u32(x, 11), dotMask), 16));
+			p = vorrq_u32(p, vshlq_n_u32(vandq_u32(vshrq_n_u32(y, 11), dotMask), 21));
+			if (!F::tiled)
+				p = vorrq_u32(p, vandq_u32(vtstq_u32(vorrq_u32(x, y), outMask), outside));
+			vst1q_u32(&span[i], p);
+			x = vaddq_u32(x, xStep);
+			y = vaddq_u32(y, yStep);
+		}
+		ecx += DXS * i;
+		edx += DYS * i;
+	}
+#endif
+	for(; i < H_Dot; i++)
+	{
+		span[i] = gfx_pack_pixel<func>(ecx, edx);
+		ecx += DXS;
+		edx += DYS;
+	}
+}
 
-		if (func & 2)		// mode 32x32 dot
+template <unsigned int func>
+static void gfx_draw_line(const unsigned int *span, const unsigned short *stamp_base,
+	unsigned int Buffer_Adr, unsigned int XD, unsigned int VCell_Size, unsigned int H_Dot)
+{
+	typedef GfxFunc<func> F;
+	unsigned char *ram = sCD.word.ram2M;
+	const unsigned int cellStride = F::dot32 ? 0x80 : 0x40; // 8 dot columns of a stamp
+	const unsigned int lineStride = (VCell_Size + 1) << 5; // 8 dot columns of the image buffer
+
+	for (unsigned int i = 0; i < H_Dot; i++)
+	{
+		unsigned int p = span[i];
+		unsigned int pixel = 0;
+		if (!F::tiled && (p & GFX_OUTSIDE))
 		{
-			if (func & 4)	// 16x16 screen
-			{
-				ebx = ((ecx >> (11+5)) & 0x007f) |
-				      ((edx >> (11-2)) & 0x3f80);
-			}
-			else		// 1x1 screen
+			if (F::prio) goto Next_Pixel;
+		}
+		else
+		{
+			unsigned int stamp = stamp_base[p & 0xffff];
+			unsigned int esi = (stamp & 0x7ff) << 7;
+			if (esi)
 			{
-				ebx = ((ecx >> (11+5)) & 0x07) |
-				      ((edx >> (11+2)) & 0x38);
+				const unsigned char *xform = stampXform[stamp >> 13];
+				unsigned int u = (p >> 16) & 0x1f, v = (p >> 21) & 0x1f;
+				unsigned int dx = (xform[0] ? v : u) ^ (xform[1] ? F::dotMask : 0);
+				unsigned int dy = (xform[0] ? u : v) ^ (xform[2] ? F::dotMask : 0);
+				pixel = ram[esi + (dx >> 3) * cellStride + dy * 4 + (((dx & 7) >> 1) ^ 1)];
+				if (dx & 1) pixel &= 0x0f;
+				else pixel >>= 4;
 			}
 		}
-		else			// mode 16x16 dot
+
+		// Pixel_Out:
+		if (!pixel && F::prio) goto Next_Pixel;
 		{
-			if (func & 4)	// 16x16 screen
+			unsigned char *out = ram + Buffer_Adr + ((XD>>1)^1);
+			unsigned int old = *out;
+			if (XD & 1)
 			{
-				//logMsg("16x16 screen");
-				ebx = ((ecx >> (11+4)) & 0x00ff) |
-				      ((edx >> (11-4)) & 0xff00);
+				if ((old & 0x0f) && F::prio == 0x08) goto Next_Pixel; // underwrite
+				*out = pixel | (old & 0xf0);
 			}
-			else		// 1x1 screen
+			else
 			{
-				ebx = ((ecx >> (11+4)) & 0x0f) |
-				      ((edx >> (11+0)) & 0xf0);
+				if ((old & 0xf0) && F::prio == 0x08) goto Next_Pixel; // underwrite
+				*out = (pixel << 4) | (old & 0xf);
 			}
 		}
 
-		edi = stamp_base[ebx];
-		//logMsg("stamp base 0x%X", edi);
-		esi = (edi & 0x7ff) << 7;
-		if (!esi) { pixel = 0; goto Pixel_Out; }
-		edi >>= (11+1);
-		edi &= (0x1c>>1);
-		eax = ecx;
-		ebx = edx;
-		if (func & 2) edi |= 1;	// 32 dots?
-		switch (edi)
-		{
-			case 0x00:	// No_Flip_0, 16x16 dots
-				ebx = (ebx >> 9) & 0x3c;
-				ebx += esi;
-				edi = (eax & 0x3800) ^ 0x1000;		// bswap
-				eax = ((eax >> 8) & 0x40) + ebx;
-				break;
-			case 0x01:	// No_Flip_0, 32x32 dots
-				ebx = (ebx >> 9) & 0x7c;
-				ebx += esi;
-				edi = (eax & 0x3800) ^ 0x1000;		// bswap
-				eax = ((eax >> 7) & 0x180) + ebx;
-				break;
-			case 0x02:	// No_Flip_90, 16x16 dots
-				eax = (eax >> 9) & 0x3c;
-				eax += esi;
-				edi = (ebx & 0x3800) ^ 0x2800;		// bswap
-				eax += ((ebx >> 8) & 0x40) ^ 0x40;
-				break;
-			case 0x03:	// No_Flip_90, 32x32 dots
-				eax = (eax >> 9) & 0x7c;
-				eax += esi;
-				edi = (ebx & 0x3800) ^ 0x2800;		// bswap
-				eax += ((ebx >> 7) & 0x180) ^ 0x180;
-				break;
-			case 0x04:	// No_Flip_180, 16x16 dots
-				ebx = ((ebx >> 9) & 0x3c) ^ 0x3c;
-				ebx += esi;
-				edi = (eax & 0x3800) ^ 0x2800;		// bswap and flip
-				eax = (((eax >> 8) & 0x40) ^ 0x40) + ebx;
-				break;
-			case 0x05:	// No_Flip_180, 32x32 dots
-				ebx = ((ebx >> 9) & 0x7c) ^ 0x7c;
-				ebx += esi;
-				edi = (eax & 0x3800) ^ 0x2800;		// bswap and flip
-				eax = (((eax >> 7) & 0x180) ^ 0x180) + ebx;
-				break;
-			case 0x06:	// No_Flip_270, 16x16 dots
-				eax = ((eax >> 9) & 0x3c) ^ 0x3c;
-				eax += esi;
-				edi = (ebx & 0x3800) ^ 0x1000;		// bswap
-				eax += (ebx >> 8) & 0x40;
-				break;
-			case 0x07:	// No_Flip_270, 32x32 dots
-				eax = ((eax >> 9) & 0x7c) ^ 0x7c;
-				eax += esi;
-				edi = (ebx & 0x3800) ^ 0x1000;		// bswap
-				eax += (ebx >> 7) & 0x180;
-				break;
-			case 0x08:	// Flip_0, 16x16 dots
-				ebx = (ebx >> 9) & 0x3c;
-				ebx += esi;
-				edi = (eax & 0x3800) ^ 0x2800;		// bswap, flip
-				eax = (((eax >> 8) & 0x40) ^ 0x40) + ebx;
-				break;
-			case 0x09:	// Flip_0, 32x32 dots
-				ebx = (ebx >> 9) & 0x7c;
-				ebx += esi;
-				edi = (eax & 0x3800) ^ 0x2800;		// bswap, flip
-				eax = (((eax >> 7) & 0x180) ^ 0x180) + ebx;
-				break;
-			case 0x0a:	// Flip_90, 16x16 dots
-				eax = ((eax >> 9) & 0x3c) ^ 0x3c;
-				eax += esi;
-				edi = (ebx & 0x3800) ^ 0x2800;		// bswap, flip
-				eax += ((ebx >> 8) & 0x40) ^ 0x40;
-				break;
-			case 0x0b:	// Flip_90, 32x32 dots
-				eax = ((eax >> 9) & 0x7c) ^ 0x7c;
-				eax += esi;
-				edi = (ebx & 0x3800) ^ 0x2800;		// bswap, flip
-				eax += ((ebx >> 7) & 0x180) ^ 0x180;
-				break;
-			case 0x0c:	// Flip_180, 16x16 dots
-				ebx = ((ebx >> 9) & 0x3c) ^ 0x3c;
-				ebx += esi;
-				edi = (eax & 0x3800) ^ 0x1000;		// bswap
-				eax = ((eax >> 8) & 0x40) + ebx;
-				break;
-			case 0x0d:	// Flip_180, 32x32 dots
-				ebx = ((ebx >> 9) & 0x7c) ^ 0x7c;
-				ebx += esi;
-				edi = (eax & 0x3800) ^ 0x1000;		// bswap
-				eax = ((eax >> 7) & 0x180) + ebx;
-				break;
-			case 0x0e:	// Flip_270, 16x16 dots
-				eax = (eax >> 9) & 0x3c;
-				eax += esi;
-				edi = (ebx & 0x3800) ^ 0x1000;		// bswap, flip
-				eax += (ebx >> 8) & 0x40;
-				break;
-			case 0x0f:	// Flip_270, 32x32 dots
-				eax = (eax >> 9) & 0x7c;
-				eax += esi;
-				edi = (ebx & 0x3800) ^ 0x1000;		// bswap, flip
-				eax += (ebx >> 7) & 0x180;
-				break;
-		}
-
-		pixel = *(sCD.word.ram2M + (edi >> 12) + eax);
-		if (!(edi & 0x800)) pixel >>= 4;
-		else pixel &= 0x0f;
-
-Pixel_Out:
-		if (!pixel && (func & 0x18)) goto Next_Pixel;
-		esi = Buffer_Adr + ((XD>>1)^1);				// pixel addr
-		eax = *(sCD.word.ram2M + esi);			// old pixel
-		if (XD & 1)
-		{
-			if ((eax & 0x0f) && (func & 0x18) == 0x08) goto Next_Pixel; // underwrite
-			*(sCD.word.ram2M + esi) = pixel | (eax & 0xf0);
-		}
-		else
-		{
-			if ((eax & 0xf0) && (func & 0x18) == 0x08) goto Next_Pixel; // underwrite
-			*(sCD.word.ram2M + esi) = (pixel << 4) | (eax & 0xf);
-		}
-
 Next_Pixel:
-		ecx += (DYXS << 16) >> 16;	// rot_comp.DXS;
-		edx +=  DYXS >> 16;		// rot_comp.DYS;
 		XD++;
 		if (XD >= 8)
 		{
-			Buffer_Adr += ((rot_comp.imgBuffVCallSize & 0x1f) + 1) << 5;
+			Buffer_Adr += lineStride;
 			XD = 0;
 		}
-		H_Dot--;
 	}
-	// end while
+}
+
+template <unsigned int func>
+static void gfx_do_line(Rot_Comp &rot_comp, const unsigned short *stamp_base, unsigned int H_Dot)
+{
+	unsigned int span[0x200];
+	unsigned int XD = rot_comp.imgBuffOffset & 7;
+	unsigned int Buffer_Adr = ((rot_comp.imgBuffStartAddr & 0xfff8) + rot_comp.YD) << 2;
+	unsigned int ecx = *(uint32a*)(sCD.word.ram2M + rot_comp.Vector_Adr);
+	unsigned int edx = ecx >> 16;
+	ecx = (ecx & 0xffff) << 8;
+	edx <<= 8;
+	int DYXS = *(int32a*)(sCD.word.ram2M + rot_comp.Vector_Adr + 4);
+	rot_comp.Vector_Adr += 8;
+
+	// MAKE_IMAGE_LINE
+	gfx_pack_line<func>(span, ecx, edx, (DYXS << 16) >> 16, DYXS >> 16, H_Dot);
+	gfx_draw_line<func>(span, stamp_base, Buffer_Adr, XD, rot_comp.imgBuffVCallSize & 0x1f, H_Dot);
 
 // nothing_to_draw:
 	rot_comp.YD++;
 	// rot_comp.V_Dot--; // will be done by caller
 }
 
+typedef void (*GfxLineFunc)(Rot_Comp &rot_comp, const unsigned short *stamp_base, unsigned int H_Dot);
+
+#define GFX_LINE_FUNCS8(f) gfx_do_line<f>, gfx_do_line<f+1>, gfx_do_line<f+2>, gfx_do_line<f+3>, \
+	gfx_do_line<f+4>, gfx_do_line<f+5>, gfx_do_line<f+6>, gfx_do_line<f+7>
+
+static const GfxLineFunc gfxLineFunc[0x20] =
+{
+	GFX_LINE_FUNCS8(0x00), GFX_LINE_FUNCS8(0x08), GFX_LINE_FUNCS8(0x10), GFX_LINE_FUNCS8(0x18)
+};
+
+#undef GFX_LINE_FUNCS8
+
+static void gfx_do(Rot_Comp &rot_comp, unsigned int func, unsigned short *stamp_base, unsigned int H_Dot)
+{
+	gfxLineFunc[func & 0x1f](rot_comp, stamp_base, H_Dot);
+}
+
 
 void gfx_cd_update(Rot_Comp &rot_comp)
 {
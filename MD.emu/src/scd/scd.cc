@@ -408,6 +408,10 @@ int scd_loadState(uint8 *state)
 
   updateSegaCdMemMap(sCD);
 
+  // pick up CD audio where the state left it
+  if((sCD.Status_CDC & 1) && !(sCD.gate[0x36] & 1))
+    FILE_Play_CD_LBA();
+
   return bufferptr;
 }
 
@@ -0,0 +1,336 @@
+// Pixel comparison of the Sega CD rotation/scaling renderer (scd/gfx_cd.cc)
+// with the per pixel one it replaced, kept below as gfx_do_ref(). Random
+// jobs, covering all 32 functions (stamp & map size, repeat, priority mode),
+// are run through gfx_cd_write16()/gfx_cd_update() on one copy of word RAM
+// and line by line through gfx_do_ref() on another. Both copies and the final
+// ASIC state have to match. Build with the Makefile in this directory, which
+// also builds a version with the SSE2/NEON span packing compiled out.
+
+#include <stdio.h>
+#include <string.h>
+#include "scd/scd.h"
+
+SegaCD sCD;
+
+void scd_interruptSubCpu(uint irq) {}
+
+static unsigned int rndState = 1;
+
+static unsigned int rnd()
+{
+  rndState = rndState * 1103515245 + 12345;
+  return rndState >> 8;
+}
+
+// gfx_do() before the two pass span renderer
+static void gfx_do_ref(Rot_Comp &rot_comp, unsigned int func, unsigned short *stamp_base, unsigned int H_Dot)
+{
+	unsigned int eax, ebx, ecx, edx, esi, edi, pixel;
+	unsigned int XD, Buffer_Adr;
+	int DYXS;
+
+	XD = rot_comp.imgBuffOffset & 7;
+	Buffer_Adr = ((rot_comp.imgBuffStartAddr & 0xfff8) + rot_comp.YD) << 2;
+	ecx = *(uint32a*)(sCD.word.ram2M + rot_comp.Vector_Adr);
+	edx = ecx >> 16;
+	ecx = (ecx & 0xffff) << 8;
+	edx <<= 8;
+	DYXS = *(int32a*)(sCD.word.ram2M + rot_comp.Vector_Adr + 4);
+	rot_comp.Vector_Adr += 8;
+
+	// MAKE_IMAGE_LINE
+	while (H_Dot)
+	{
+		// MAKE_IMAGE_PIXEL
+		if (!(func & 1))	// NOT TILED
+		{
+			int mask = (func & 4) ? 0x00800000 : 0x00f80000;
+			if ((ecx | edx) & mask)
+			{
+				if (func & 0x18) goto Next_Pixel;
+				pixel = 0;
+				goto Pixel_Out;
+			}
+		}
+
+		if (func & 2)		// mode 32x32 dot
+		{
+			if (func & 4)	// 16x16 screen
+			{
+				ebx = ((ecx >> (11+5)) & 0x007f) |
+				      ((edx >> (11-2)) & 0x3f80);
+			}
+			else		// 1x1 screen
+			{
+				ebx = ((ecx >> (11+5)) & 0x07) |
+				      ((edx >> (11+2)) & 0x38);
+			}
+		}
+		else			// mode 16x16 dot
+		{
+			if (func & 4)	// 16x16 screen
+			{
+				ebx = ((ecx >> (11+4)) & 0x00ff) |
+				      ((edx >> (11-4)) & 0xff00);
+			}
+			else		// 1x1 screen
+			{
+				ebx = ((ecx >> (11+4)) & 0x0f) |
+				      ((edx >> (11+0)) & 0xf0);
+			}
+		}
+
+		edi = stamp_base[ebx];
+		esi = (edi & 0x7ff) << 7;
+		if (!esi) { pixel = 0; goto Pixel_Out; }
+		edi >>= (11+1);
+		edi &= (0x1c>>1);
+		eax = ecx;
+		ebx = edx;
+		if (func & 2) edi |= 1;	// 32 dots?
+		switch (edi)
+		{
+			case 0x00:	// No_Flip_0, 16x16 dots
+				ebx = (ebx >> 9) & 0x3c;
+				ebx += esi;
+				edi = (eax & 0x3800) ^ 0x1000;		// bswap
+				eax = ((eax >> 8) & 0x40) + ebx;
+				break;
+			case 0x01:	// No_Flip_0, 32x32 dots
+				ebx = (ebx >> 9) & 0x7c;
+				ebx += esi;
+				edi = (eax & 0x3800) ^ 0x1000;		// bswap
+				eax = ((eax >> 7) & 0x180) + ebx;
+				break;
+			case 0x02:	// No_Flip_90, 16x16 dots
+				eax = (eax >> 9) & 0x3c;
+				eax += esi;
+				edi = (ebx & 0x3800) ^ 0x2800;		// bswap
+				eax += ((ebx >> 8) & 0x40) ^ 0x40;
+				break;
+			case 0x03:	// No_Flip_90, 32x32 dots
+				eax = (eax >> 9) & 0x7c;
+				eax += esi;
+				edi = (ebx & 0x3800) ^ 0x2800;		// bswap
+				eax += ((ebx >> 7) & 0x180) ^ 0x180;
+				break;
+			case 0x04:	// No_Flip_180, 16x16 dots
+				ebx = ((ebx >> 9) & 0x3c) ^ 0x3c;
+				ebx += esi;
+				edi = (eax & 0x3800) ^ 0x2800;		// bswap and flip
+				eax = (((eax >> 8) & 0x40) ^ 0x40) + ebx;
+				break;
+			case 0x05:	// No_Flip_180, 32x32 dots
+				ebx = ((ebx >> 9) & 0x7c) ^ 0x7c;
+				ebx += esi;
+				edi = (eax & 0x3800) ^ 0x2800;		// bswap and flip
+				eax = (((eax >> 7) & 0x180) ^ 0x180) + ebx;
+				break;
+			case 0x06:	// No_Flip_270, 16x16 dots
+				eax = ((eax >> 9) & 0x3c) ^ 0x3c;
+				eax += esi;
+				edi = (ebx & 0x3800) ^ 0x1000;		// bswap
+				eax += (ebx >> 8) & 0x40;
+				break;
+			case 0x07:	// No_Flip_270, 32x32 dots
+				eax = ((eax >> 9) & 0x7c) ^ 0x7c;
+				eax += esi;
+				edi = (ebx & 0x3800) ^ 0x1000;		// bswap
+				eax += (ebx >> 7) & 0x180;
+				break;
+			case 0x08:	// Flip_0, 16x16 dots
+				ebx = (ebx >> 9) & 0x3c;
+				ebx += esi;
+				edi = (eax & 0x3800) ^ 0x2800;		// bswap, flip
+				eax = (((eax >> 8) & 0x40) ^ 0x40) + ebx;
+				break;
+			case 0x09:	// Flip_0, 32x32 dots
+				ebx = (ebx >> 9) & 0x7c;
+				ebx += esi;
+				edi = (eax & 0x3800) ^ 0x2800;		// bswap, flip
+				eax = (((eax >> 7) & 0x180) ^ 0x180) + ebx;
+				break;
+			case 0x0a:	// Flip_90, 16x16 dots
+				eax = ((eax >> 9) & 0x3c) ^ 0x3c;
+				eax += esi;
+				edi = (ebx & 0x3800) ^ 0x2800;		// bswap, flip
+				eax += ((ebx >> 8) & 0x40) ^ 0x40;
+				break;
+			case 0x0b:	// Flip_90, 32x32 dots
+				eax = ((eax >> 9) & 0x7c) ^ 0x7c;
+				eax += esi;
+				edi = (ebx & 0x3800) ^ 0x2800;		// bswap, flip
+				eax += ((ebx >> 7) & 0x180) ^ 0x180;
+				break;
+			case 0x0c:	// Flip_180, 16x16 dots
+				ebx = ((ebx >> 9) & 0x3c) ^ 0x3c;
+				ebx += esi;
+				edi = (eax & 0x3800) ^ 0x1000;		// bswap
+				eax = ((eax >> 8) & 0x40) + ebx;
+				break;
+			case 0x0d:	// Flip_180, 32x32 dots
+				ebx = ((ebx >> 9) & 0x7c) ^ 0x7c;
+				ebx += esi;
+				edi = (eax & 0x3800) ^ 0x1000;		// bswap
+				eax = ((eax >> 7) & 0x180) + ebx;
+				break;
+			case 0x0e:	// Flip_270, 16x16 dots
+				eax = (eax >> 9) & 0x3c;
+				eax += esi;
+				edi = (ebx & 0x3800) ^ 0x1000;		// bswap, flip
+				eax += (ebx >> 8) & 0x40;
+				break;
+			case 0x0f:	// Flip_270, 32x32 dots
+				eax = (eax >> 9) & 0x7c;
+				eax += esi;
+				edi = (ebx & 0x3800) ^ 0x1000;		// bswap, flip
+				eax += (ebx >> 7) & 0x180;
+				break;
+		}
+
+		pixel = *(sCD.word.ram2M + (edi >> 12) + eax);
+		if (!(edi & 0x800)) pixel >>= 4;
+		else pixel &= 0x0f;
+
+Pixel_Out:
+		if (!pixel && (func & 0x18)) goto Next_Pixel;
+		esi = Buffer_Adr + ((XD>>1)^1);				// pixel addr
+		eax = *(sCD.word.ram2M + esi);			// old pixel
+		if (XD & 1)
+		{
+			if ((eax & 0x0f) && (func & 0x18) == 0x08) goto Next_Pixel; // underwrite
+			*(sCD.word.ram2M + esi) = pixel | (eax & 0xf0);
+		}
+		else
+		{
+			if ((eax & 0xf0) && (func & 0x18) == 0x08) goto Next_Pixel; // underwrite
+			*(sCD.word.ram2M + esi) = (pixel << 4) | (eax & 0xf);
+		}
+
+Next_Pixel:
+		ecx += (DYXS << 16) >> 16;	// rot_comp.DXS;
+		edx +=  DYXS >> 16;		// rot_comp.DYS;
+		XD++;
+		if (XD >= 8)
+		{
+			Buffer_Adr += ((rot_comp.imgBuffVCallSize & 0x1f) + 1) << 5;
+			XD = 0;
+		}
+		H_Dot--;
+	}
+	// end while
+
+// nothing_to_draw:
+	rot_comp.YD++;
+	// rot_comp.V_Dot--; // will be done by caller
+}
+
+
+
+
+// gfx_cd_start() state for the reference run
+static void startRef(Rot_Comp &rot_comp)
+{
+  rot_comp.Function = (rot_comp.stampDataSize & 7) | (sCD.gate[3] & 0x18);
+  rot_comp.YD = (rot_comp.imgBuffOffset >> 3) & 7;
+  rot_comp.Vector_Adr = (rot_comp.tvba & 0xfffe) << 2;
+  switch (rot_comp.stampDataSize & 6)
+  {
+    case 0: rot_comp.Stamp_Map_Adr = (rot_comp.stampMapBaseAddr & 0xff80) << 2; break;
+    case 2: rot_comp.Stamp_Map_Adr = (rot_comp.stampMapBaseAddr & 0xffe0) << 2; break;
+    case 4: rot_comp.Stamp_Map_Adr = 0x20000; break;
+    case 6: rot_comp.Stamp_Map_Adr = (rot_comp.stampMapBaseAddr & 0xe000) << 2; break;
+  }
+}
+
+static unsigned char ram[0x40000], refRam[0x40000];
+
+int main(int argc, char **argv)
+{
+  const int jobs = 3000;
+  unsigned long pixels = 0;
+  for (int job = 0; job < jobs; job++)
+  {
+    unsigned int func = rnd() & 0x1f;
+    unsigned int stampSize = func & 7;
+    unsigned int vCell = rnd() & 0x1f;
+    unsigned int imgAdr = rnd() & 0x7ff8; // the buffer and vector table
+    unsigned int offset = rnd() & 0x3f;   // stay inside word RAM
+    unsigned int hDot = (rnd() & 0x1ff) | 1;
+    unsigned int vDot = (rnd() & 0xff) | 1;
+    unsigned int tvba = rnd() & 0xfdfe;
+    for (unsigned int i = 0; i < sizeof(ram); i++)
+      ram[i] = rnd();
+    // mostly sparse stamps, so prio modes see both empty and drawn pixels
+    for (unsigned int i = 0; i < sizeof(ram); i += 2)
+      if (rnd() & 1) ram[i] = ram[i + 1] = 0;
+    // vector table: start point inside the map half of the time, small steps
+    for (unsigned int l = 0; l < vDot; l++)
+    {
+      unsigned char *v = ram + ((tvba << 2) + l * 8);
+      unsigned int x = rnd(), y = rnd();
+      if (rnd() & 1) { x &= 0x7ff; y &= 0x7ff; }
+      int dx = (int)(rnd() & 0x7ff) - 0x400, dy = (int)(rnd() & 0x7ff) - 0x400;
+      if (!(rnd() & 3)) { dx = (int16)rnd(); dy = (int16)rnd(); }
+      *(uint32 *)v = (y & 0xffff) << 16 | (x & 0xffff);
+      *(uint32 *)(v + 4) = (uint32)(dy & 0xffff) << 16 | (dx & 0xffff);
+    }
+    // 32x32 dot stamps 0x7fc-0x7ff end past word RAM, in what follows it in
+    // sCD, which isn't the same for both runs. Keep them out of the data and
+    // the stamp map out of the image buffer, which could write them.
+    unsigned int mapBase = rnd() & 0xffe0;
+    if (func & 2)
+    {
+      unsigned int bufStart = imgAdr << 2;
+      unsigned int bufEnd = bufStart + ((7 + vDot) << 2) + ((offset & 7) + hDot + 7) / 8 * ((vCell + 1) << 5) + 4;
+      for (;;)
+      {
+        unsigned int mapStart = (func & 4) ? (mapBase & 0xe000) << 2 : mapBase << 2;
+        unsigned int mapEnd = mapStart + ((func & 4) ? 0x8000 : 0x80);
+        if (mapEnd <= bufStart || mapStart >= bufEnd)
+          break;
+        mapBase = rnd() & 0xffe0;
+      }
+      for (unsigned int i = 0; i < sizeof(ram); i += 2)
+        if ((ram[i + 1] & 7) == 7 && ram[i] >= 0xfc) ram[i] &= ~3;
+    }
+    memcpy(refRam, ram, sizeof(ram));
+
+    // new renderer through the ASIC registers
+    gfx_cd_reset(sCD.rot_comp);
+    sCD.gate[3] = func & 0x18;
+    Rot_Comp &rot = sCD.rot_comp;
+    memcpy(sCD.word.ram2M, ram, sizeof(ram));
+    gfx_cd_write16(rot, 0x58, stampSize);
+    gfx_cd_write16(rot, 0x5A, mapBase);
+    gfx_cd_write16(rot, 0x5C, vCell);
+    gfx_cd_write16(rot, 0x5E, imgAdr);
+    gfx_cd_write16(rot, 0x60, offset);
+    gfx_cd_write16(rot, 0x62, hDot);
+    gfx_cd_write16(rot, 0x64, vDot);
+    Rot_Comp ref = rot;
+    gfx_cd_write16(rot, 0x66, tvba);
+    while (rot.stampDataSize & 0x8000)
+      gfx_cd_update(rot);
+    memcpy(ram, sCD.word.ram2M, sizeof(ram));
+
+    // reference renderer, one line per call
+    ref.tvba = tvba;
+    startRef(ref);
+    memcpy(sCD.word.ram2M, refRam, sizeof(refRam));
+    for (unsigned int l = 0; l < vDot; l++)
+      gfx_do_ref(ref, ref.Function, (unsigned short *)(sCD.word.ram2M + ref.Stamp_Map_Adr), hDot);
+    pixels += hDot * vDot;
+
+    if (memcmp(ram, sCD.word.ram2M, sizeof(ram)) || rot.YD != ref.YD || rot.Vector_Adr != ref.Vector_Adr)
+    {
+      unsigned int i = 0;
+      while (i < sizeof(ram) && ram[i] == sCD.word.ram2M[i]) i++;
+      printf("job %d (function 0x%02X, %ux%u dots) differs, first at word RAM 0x%05X: 0x%02X, expected 0x%02X\n",
+        job, func, hDot, vDot, i, i < sizeof(ram) ? ram[i] : 0, i < sizeof(ram) ? sCD.word.ram2M[i] : 0);
+      return 1;
+    }
+  }
+  printf("%d jobs, %lu pixels, same as the per pixel renderer\n", jobs, pixels);
+  return 0;
+}
@@ -0,0 +1,216 @@
+// Pixel comparison of the md_ntsc/sms_ntsc row blitters (genplus-gx/ntsc),
+// including the SSE2/NEON md_ntsc one, with the line blitters Genesis Plus
+// used before them, kept below as md_ntsc_blit_ref()/sms_ntsc_blit_ref().
+// Random lines of palette indices are blitted for every preset and for widths
+// taking both the SIMD and the scalar md_ntsc path. The old blitters read the
+// line through a palette and started and ended it with palette entry 0, the
+// new ones take RGB565 pixels and use black, so entry 0 is black here. Build
+// with the Makefile in this directory, which also builds a version with the
+// SSE2/NEON paths compiled out.
+
+#include <stdio.h>
+#include <string.h>
+#include "ntsc/md_ntsc.h"
+#include "ntsc/sms_ntsc.h"
+
+static unsigned int rndState = 1;
+
+static unsigned int rnd()
+{
+  rndState = rndState * 1103515245 + 12345;
+  return rndState >> 8;
+}
+
+// md_ntsc_blit() before the row blitter
+static void md_ntsc_blit_ref(md_ntsc_t const* ntsc, MD_NTSC_IN_T const* table, unsigned char* input,
+  int in_width, unsigned short* line_out)
+{
+  int const chunk_count = in_width / md_ntsc_in_chunk - 1;
+  MD_NTSC_IN_T border = table[0];
+
+  MD_NTSC_BEGIN_ROW( ntsc, border,
+        MD_NTSC_ADJ_IN( table[*input++] ),
+        MD_NTSC_ADJ_IN( table[*input++] ),
+        MD_NTSC_ADJ_IN( table[*input++] ) );
+
+  int n;
+
+  for ( n = chunk_count; n; --n )
+  {
+    /* order of input and output pixels must not be altered */
+    MD_NTSC_COLOR_IN( 0, ntsc, MD_NTSC_ADJ_IN( table[*input++] ) );
+    MD_NTSC_RGB_OUT( 0, *line_out++, MD_NTSC_OUT_DEPTH );
+    MD_NTSC_RGB_OUT( 1, *line_out++, MD_NTSC_OUT_DEPTH );
+
+    MD_NTSC_COLOR_IN( 1, ntsc, MD_NTSC_ADJ_IN( table[*input++] ) );
+    MD_NTSC_RGB_OUT( 2, *line_out++, MD_NTSC_OUT_DEPTH );
+    MD_NTSC_RGB_OUT( 3, *line_out++, MD_NTSC_OUT_DEPTH );
+
+    MD_NTSC_COLOR_IN( 2, ntsc, MD_NTSC_ADJ_IN( table[*input++] ) );
+    MD_NTSC_RGB_OUT( 4, *line_out++, MD_NTSC_OUT_DEPTH );
+    MD_NTSC_RGB_OUT( 5, *line_out++, MD_NTSC_OUT_DEPTH );
+
+    MD_NTSC_COLOR_IN( 3, ntsc, MD_NTSC_ADJ_IN( table[*input++] ) );
+    MD_NTSC_RGB_OUT( 6, *line_out++, MD_NTSC_OUT_DEPTH );
+    MD_NTSC_RGB_OUT( 7, *line_out++, MD_NTSC_OUT_DEPTH );
+  }
+
+  /* finish final pixels */
+  MD_NTSC_COLOR_IN( 0, ntsc, MD_NTSC_ADJ_IN( table[*input++] ) );
+  MD_NTSC_RGB_OUT( 0, *line_out++, MD_NTSC_OUT_DEPTH );
+  MD_NTSC_RGB_OUT( 1, *line_out++, MD_NTSC_OUT_DEPTH );
+
+  MD_NTSC_COLOR_IN( 1, ntsc, border );
+  MD_NTSC_RGB_OUT( 2, *line_out++, MD_NTSC_OUT_DEPTH );
+  MD_NTSC_RGB_OUT( 3, *line_out++, MD_NTSC_OUT_DEPTH );
+
+  MD_NTSC_COLOR_IN( 2, ntsc, border );
+  MD_NTSC_RGB_OUT( 4, *line_out++, MD_NTSC_OUT_DEPTH );
+  MD_NTSC_RGB_OUT( 5, *line_out++, MD_NTSC_OUT_DEPTH );
+
+  MD_NTSC_COLOR_IN( 3, ntsc, border );
+  MD_NTSC_RGB_OUT( 6, *line_out++, MD_NTSC_OUT_DEPTH );
+  MD_NTSC_RGB_OUT( 7, *line_out++, MD_NTSC_OUT_DEPTH );
+}
+
+// sms_ntsc_blit() before the row blitter
+static void sms_ntsc_blit_ref(sms_ntsc_t const* ntsc, SMS_NTSC_IN_T const* table, unsigned char* input,
+  int in_width, unsigned short* line_out)
+{
+  int const chunk_count = in_width / sms_ntsc_in_chunk;
+
+  /* handle extra 0, 1, or 2 pixels by placing them at beginning of row */
+  int const in_extra = in_width - chunk_count * sms_ntsc_in_chunk;
+  unsigned const extra2 = (unsigned) -(in_extra >> 1 & 1); /* (unsigned) -1 = ~0 */
+  unsigned const extra1 = (unsigned) -(in_extra & 1) | extra2;
+
+  SMS_NTSC_IN_T border = table[0];
+
+  SMS_NTSC_BEGIN_ROW( ntsc, border,
+      (SMS_NTSC_ADJ_IN( table[input[0]] )) & extra2,
+      (SMS_NTSC_ADJ_IN( table[input[extra2 & 1]] )) & extra1 );
+
+  int n;
+  input += in_extra;
+
+  for ( n = chunk_count; n; --n )
+  {
+    /* order of input and output pixels must not be altered */
+    SMS_NTSC_COLOR_IN( 0, ntsc, SMS_NTSC_ADJ_IN( table[*input++] ) );
+    SMS_NTSC_RGB_OUT( 0, *line_out++, SMS_NTSC_OUT_DEPTH );
+    SMS_NTSC_RGB_OUT( 1, *line_out++, SMS_NTSC_OUT_DEPTH );
+
+    SMS_NTSC_COLOR_IN( 1, ntsc, SMS_NTSC_ADJ_IN( table[*input++] ) );
+    SMS_NTSC_RGB_OUT( 2, *line_out++, SMS_NTSC_OUT_DEPTH );
+    SMS_NTSC_RGB_OUT( 3, *line_out++, SMS_NTSC_OUT_DEPTH );
+
+    SMS_NTSC_COLOR_IN( 2, ntsc, SMS_NTSC_ADJ_IN( table[*input++] ) );
+    SMS_NTSC_RGB_OUT( 4, *line_out++, SMS_NTSC_OUT_DEPTH );
+    SMS_NTSC_RGB_OUT( 5, *line_out++, SMS_NTSC_OUT_DEPTH );
+    SMS_NTSC_RGB_OUT( 6, *line_out++, SMS_NTSC_OUT_DEPTH );
+  }
+
+  /* finish final pixels */
+  SMS_NTSC_COLOR_IN( 0, ntsc, border );
+  SMS_NTSC_RGB_OUT( 0, *line_out++, SMS_NTSC_OUT_DEPTH );
+  SMS_NTSC_RGB_OUT( 1, *line_out++, SMS_NTSC_OUT_DEPTH );
+
+  SMS_NTSC_COLOR_IN( 1, ntsc, border );
+  SMS_NTSC_RGB_OUT( 2, *line_out++, SMS_NTSC_OUT_DEPTH );
+  SMS_NTSC_RGB_OUT( 3, *line_out++, SMS_NTSC_OUT_DEPTH );
+
+  SMS_NTSC_COLOR_IN( 2, ntsc, border );
+  SMS_NTSC_RGB_OUT( 4, *line_out++, SMS_NTSC_OUT_DEPTH );
+  SMS_NTSC_RGB_OUT( 5, *line_out++, SMS_NTSC_OUT_DEPTH );
+  SMS_NTSC_RGB_OUT( 6, *line_out++, SMS_NTSC_OUT_DEPTH );
+}
+
+static const int lines = 16;
+static const int maxWidth = 520;
+static const int outPitch = 1100; // pixels, more than either out width of maxWidth
+
+static md_ntsc_t mdNtsc;
+static sms_ntsc_t smsNtsc;
+static unsigned short palette[0x40];
+static unsigned char colorIndex[lines][maxWidth];
+static unsigned short rgb[lines][maxWidth];
+static unsigned short out[lines][outPitch], refOut[outPitch];
+
+static void randomLines(int width)
+{
+  for (int i = 1; i < 0x40; i++)
+    palette[i] = rnd();
+  palette[0] = 0;
+  for (int y = 0; y < lines; y++)
+    for (int x = 0; x < width; x++)
+    {
+      // runs of the same color as well as single pixels
+      colorIndex[y][x] = (x && (rnd() & 3)) ? colorIndex[y][x - 1] : rnd() & 0x3f;
+      rgb[y][x] = palette[colorIndex[y][x]];
+    }
+}
+
+static bool compare(const char *name, const char *preset, int width, int y, int outWidth)
+{
+  if (!memcmp(out[y], refOut, outWidth * 2))
+    return true;
+  int x = 0;
+  while (out[y][x] == refOut[x]) x++;
+  printf("%s, %s preset, width %d: line %d differs at x %d: 0x%04X, expected 0x%04X\n",
+    name, preset, width, y, x, out[y][x], refOut[x]);
+  return false;
+}
+
+int main(int argc, char **argv)
+{
+  static const md_ntsc_setup_t *mdPreset[] = { &md_ntsc_composite, &md_ntsc_svideo, &md_ntsc_rgb, &md_ntsc_monochrome };
+  static const sms_ntsc_setup_t *smsPreset[] = { &sms_ntsc_composite, &sms_ntsc_svideo, &sms_ntsc_rgb, &sms_ntsc_monochrome };
+  static const char *presetName[] = { "composite", "s-video", "rgb", "monochrome" };
+  // multiples of 4 up to 512 take the SIMD md_ntsc path, the rest the scalar one
+  static const int mdWidth[] = { 256, 320, 512, 4, 258, 321, 516 };
+  // 0, 1 and 2 extra pixels in front of the sms_ntsc chunks
+  static const int smsWidth[] = { 256, 255, 254, 248, 3 };
+  int rows = 0;
+
+  for (int p = 0; p < 4; p++)
+  {
+    md_ntsc_init(&mdNtsc, mdPreset[p]);
+    sms_ntsc_init(&smsNtsc, smsPreset[p]);
+    for (int pass = 0; pass < 8; pass++)
+    {
+      for (unsigned int w = 0; w < sizeof(mdWidth) / sizeof(*mdWidth); w++)
+      {
+        int width = mdWidth[w];
+        randomLines(width);
+        md_ntsc_blit(&mdNtsc, rgb[0], maxWidth, width, lines, out, outPitch * 2);
+        for (int y = 0; y < lines; y++)
+        {
+          md_ntsc_blit_ref(&mdNtsc, palette, colorIndex[y], width, refOut);
+          if (!compare("md_ntsc", presetName[p], width, y, MD_NTSC_OUT_WIDTH(width)))
+            return 1;
+        }
+        rows += lines;
+      }
+      for (unsigned int w = 0; w < sizeof(smsWidth) / sizeof(*smsWidth); w++)
+      {
+        int width = smsWidth[w];
+        randomLines(width);
+        sms_ntsc_blit(&smsNtsc, rgb[0], maxWidth, width, lines, out, outPitch * 2);
+        for (int y = 0; y < lines; y++)
+        {
+          sms_ntsc_blit_ref(&smsNtsc, palette, colorIndex[y], width, refOut);
+          if (!compare("sms_ntsc", presetName[p], width, y, SMS_NTSC_OUT_WIDTH(width)))
+            return 1;
+        }
+        rows += lines;
+      }
+    }
+  }
+#ifdef MD_NTSC_SIMD
+  const char *mdPath = "SIMD and scalar";
+#else
+  const char *mdPath = "scalar";
+#endif
+  printf("%d rows checked, md_ntsc (%s) and sms_ntsc same as the line blitters\n", rows, mdPath);
+  return 0;
+}
@@ -0,0 +1,138 @@
+// Benchmark for the SSP1601 interpreter (cart_hw/svp/ssp16.cc). Times a
+// DSP style multiply/accumulate loop like the ones Virtua Racing runs, then
+// runs random programs (including IRAM writes through the PM registers) and
+// prints a checksum of the resulting state, which has to stay the same
+// between interpreter changes. Build with the Makefile in this directory.
+
+#include <time.h>
+#include "shared.h"
+
+T_CART cart;
+svp_t *svp;
+
+static uint32 rndState = 1;
+
+static uint32 rnd()
+{
+  rndState = rndState * 1103515245 + 12345;
+  return rndState >> 8;
+}
+
+static unsigned short *romWords() { return (unsigned short *)cart.rom; }
+
+// loads the program written to the ROM into the SVP like svp_reset()
+static void loadProgram()
+{
+  memcpy(svp->iram_rom, cart.rom, 0x20000);
+  ssp1601_reset(&svp->ssp1601);
+}
+
+static void genKernel()
+{
+  unsigned short *w = romWords();
+  memset(w, 0, 0x20000);
+  int a = 0x400;
+  w[a++] = 0x840; w[a++] = 0x0003;        // ldi ST, 3 (modulo 8 pointers)
+  w[a++] = 0x0c00;                        // ldi r0, 0
+  w[a++] = 0x0c00 | 0x400 | 0x10;         // ldi r4, 10h
+  int loop = a;
+  w[a++] = (0x5b << 9) | 0x100 | (3 << 2) | (3 << 6); // mld (r4+), (r0+)
+  for (int i = 0; i < 6; i++)
+    w[a++] = (0x4b << 9) | 0x100 | (3 << 2) | (3 << 6); // mpya (r4+), (r0+)
+  w[a++] = (1 << 4) | 3;                  // ld X, A
+  w[a++] = (0x02 << 9) | (3 << 4) | (3 << 2) | 1; // ld (r1+), A
+  w[a++] = (0x40 << 9) | 2;               // add A, Y
+  w[a++] = (0x4c << 9) | 0x11;            // addi 11h
+  w[a++] = (0x03 << 9) | 0x20;            // ld A, [20h]
+  w[a++] = (0x07 << 9) | 0x21;            // ld [21h], A
+  w[a++] = (2 << 4) | 1;                  // ld Y, X
+  w[a++] = (0x48 << 9) | 2;               // shr
+  w[a++] = (0x26 << 9) | 0x100 | 0x70; w[a++] = loop; // bra N=1, loop
+  w[a++] = 0x26 << 9; w[a++] = loop;      // bra loop
+  loadProgram();
+}
+
+static void genRandom(uint32 seed)
+{
+  static const int ops[] = {0x00, 0x00, 0x00, 0x01, 0x02, 0x04, 0x05, 0x06, 0x07, 0x09, 0x0a, 0x0c, 0x0d,
+    0x24, 0x25, 0x26, 0x26, 0x48, 0x1b, 0x4b, 0x5b, 0x10, 0x30, 0x40, 0x50, 0x60, 0x70, 0x11, 0x31, 0x41,
+    0x51, 0x61, 0x71, 0x03, 0x13, 0x33, 0x43, 0x53, 0x63, 0x73, 0x14, 0x34, 0x44, 0x54, 0x64, 0x74, 0x15,
+    0x35, 0x45, 0x55, 0x65, 0x75, 0x19, 0x39, 0x49, 0x59, 0x69, 0x79, 0x1c, 0x3c, 0x4c, 0x5c, 0x6c, 0x7c, 0x7f};
+  unsigned short *w = romWords();
+  rndState = seed;
+  for (int a = 0; a < 0x10000; a++)
+  {
+    int k = ops[rnd() % (sizeof(ops) / sizeof(ops[0]))];
+    unsigned short op = (k << 9) | (rnd() & 0x1ff);
+    // conditions on the flags only, or always
+    if (k == 0x24 || k == 0x26 || k == 0x48)
+      op = (op & ~0xf0) | (rnd() % 3 == 0 ? 0 : (rnd() & 1) ? 0x50 : 0x70);
+    w[a] = op;
+    if ((k == 0x24 || k == 0x26) && a + 1 < 0x10000)
+    {
+      a++;
+      w[a] = rnd() % 8 == 0 ? rnd() & 0x3ff : 0x400 + rnd() % 0xfb00;
+    }
+    // write IRAM through PM0, so IRAM code changes while running
+    if (rnd() % 64 == 0 && a + 12 < 0x10000)
+    {
+      w[++a] = 0x840; w[++a] = 0x60;          // ldi ST, 60h
+      w[++a] = 0x8e0; w[++a] = rnd() & 0x3ff; // ldi PMC, addr
+      w[++a] = 0x8e0; w[++a] = 0x081c;        // ldi PMC, mode
+      w[++a] = 0x80;                          // ld PM0, -
+      w[++a] = 0x83; w[++a] = 0x83; w[++a] = 0x83; // ld PM0, A
+      w[++a] = 0x840; w[++a] = rnd() & 7;     // ldi ST, x
+    }
+  }
+  for (int a = 0xff00; a < 0x10000; a++)
+    w[a] = 0x4c00;
+  loadProgram();
+}
+
+static uint32 hash(const void *data, size_t size, uint32 h)
+{
+  const unsigned char *c = (const unsigned char *)data;
+  while (size--)
+    h = (h ^ *c++) * 16777619;
+  return h;
+}
+
+static double now()
+{
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int main()
+{
+  cart.rom = (unsigned char *)calloc(1, 0x200000 + sizeof(svp_t));
+  svp = (svp_t *)(cart.rom + 0x200000);
+
+  const int runs = 200000, cycles = 800;
+  genKernel();
+  double start = now();
+  for (int i = 0; i < runs; i++)
+    ssp1601_run(cycles);
+  double secs = now() - start;
+  printf("mac loop: %.1f M SVP cycles/s (%.3fs)\n", (double)runs * cycles / secs / 1e6, secs);
+
+  uint32 h = 2166136261u;
+  for (uint32 seed = 1; seed <= 200; seed++)
+  {
+    memset(svp, 0, sizeof(*svp));
+    genRandom(seed);
+    for (int r = 0; r < 3000; r++)
+    {
+      ssp1601_run(cycles);
+      h = hash(&svp->ssp1601.gr[SSP_PC], sizeof(svp->ssp1601.gr[SSP_PC]), h);
+      h = hash(&svp->ssp1601.emu_status, sizeof(svp->ssp1601.emu_status), h);
+      // leave wait states as the 68k side would
+      if (r % 7 == 0)
+        svp->ssp1601.emu_status &= ~SSP_WAIT_MASK;
+    }
+    h = hash(svp, sizeof(*svp), h);
+  }
+  printf("random programs checksum: %08x\n", h);
+  return 0;
+}
@@ -0,0 +1,146 @@
+// Benchmark for the YM2612 emulation (sound/ym2612.cc). Times a music style
+// setup, six channels with different algorithms, feedback, LFO AM/PM,
+// SSG-EG and notes changing every frame, in samples per second. Then drives
+// the chip with random register writes (including CSM, 3 slot, DAC and
+// timer modes) between updates of random length, saving & loading the
+// context now and then, and prints a checksum of every sample & status read,
+// which has to stay the same between engine changes and between the SIMD &
+// scalar builds. Build with the Makefile in this directory.
+
+#include <algorithm>
+#include <time.h>
+#include "shared.h"
+
+static uint32 rndState = 1;
+
+static uint32 rnd()
+{
+  rndState = rndState * 1103515245 + 12345;
+  return rndState >> 8;
+}
+
+static void write(unsigned int part, unsigned int reg, unsigned int v)
+{
+  YM2612Write(part * 2, reg);
+  YM2612Write(part * 2 + 1, v);
+}
+
+static double now()
+{
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static uint32 hash(const void *data, size_t size, uint32 h)
+{
+  const uint8 *b = (const uint8 *)data;
+  while(size--)
+    h = (h ^ *b++) * 16777619;
+  return h;
+}
+
+// patch & key on channel ch (0-5)
+static void setupChannel(int ch, int algo, int fb, int ams, int pms, bool ssg)
+{
+  unsigned int part = ch / 3, c = ch % 3;
+  for(unsigned int s = 0; s < 4; s++)
+  {
+    unsigned int r = c + s * 4;
+    write(part, 0x30 + r, ((s + ch) & 7) << 4 | (s * 3 + ch + 1) & 15); // DT, MUL
+    write(part, 0x40 + r, (s == 3 || algo >= 4) ? 0x08 : 0x18 + s * 4); // TL
+    write(part, 0x50 + r, 0x40 | (0x1c - s)); // KS, AR
+    write(part, 0x60 + r, 0x80 | (0x06 + s)); // AM, D1R
+    write(part, 0x70 + r, 0x02 + s); // D2R
+    write(part, 0x80 + r, 0x27 + s * 0x10); // SL, RR
+    write(part, 0x90 + r, ssg ? 0x08 | s : 0); // SSG-EG
+  }
+  write(part, 0xb0 + c, fb << 3 | algo);
+  write(part, 0xb4 + c, 0xc0 | ams << 4 | pms);
+}
+
+static void keyOn(int ch, bool on)
+{
+  write(0, 0x28, (on ? 0xf0 : 0) | (ch / 3) << 2 | ch % 3);
+}
+
+static void setFreq(int ch, unsigned int blockFnum)
+{
+  unsigned int part = ch / 3, c = ch % 3;
+  write(part, 0xa4 + c, blockFnum >> 8);
+  write(part, 0xa0 + c, blockFnum & 0xff);
+}
+
+static double music(int frames)
+{
+  static const unsigned int notes[] = { 0x269, 0x28e, 0x2b5, 0x2de, 0x30a, 0x338, 0x369, 0x39d };
+  static FMSampleType buffer[1024 * 2];
+  YM2612ResetChip();
+  write(0, 0x22, 0x0b); // LFO on
+  for(int ch = 0; ch < 6; ch++)
+    setupChannel(ch, ch + 1, ch & 7, ch & 3, (ch * 3) & 7, ch == 4);
+  double start = now();
+  for(int f = 0; f < frames; f++)
+  {
+    // a sound driver updating one channel per frame, 888 samples at 53.2kHz
+    int ch = f % 6;
+    keyOn(ch, false);
+    setFreq(ch, (f & 0x18) << 8 | notes[(f / 6 + ch) & 7]);
+    keyOn(ch, true);
+    for(int part = 0; part < 4; part++)
+      YM2612Update(buffer, 222);
+  }
+  return frames * 888 / (now() - start);
+}
+
+static uint32 randomWrites(int updates)
+{
+  static FMSampleType buffer[256 * 2];
+  static uint8 state[STATE_SIZE];
+  uint32 h = 2166136261u;
+  YM2612ResetChip();
+  for(int i = 0; i < updates; i++)
+  {
+    unsigned int writes = rnd() % 8;
+    while(writes--)
+    {
+      unsigned int r = rnd() % 16;
+      unsigned int v = rnd() & 0xff;
+      if(r == 0)
+        write(0, 0x27, v & 0xc0 | 0x0f); // CSM/3 slot mode, timers running
+      else if(r == 1)
+        write(0, 0x28, v);
+      else if(r == 2)
+        write(0, 0x2a + (v & 1), rnd() & 0xff);
+      else if(r == 3)
+        write(0, 0x22 + (v & 7), rnd() & 0xff);
+      else if(r == 4)
+        write(0, 0xa8 + (v % 7), rnd() & 0xff); // ch 3 slot frequencies
+      else
+        write(v & 1, 0x30 + rnd() % 0x88, rnd() & 0xff);
+    }
+    int length = rnd() % 200;
+    YM2612Update(buffer, length);
+    h = hash(buffer, length * 2 * sizeof(FMSampleType), h);
+    uint8 status = YM2612Read();
+    h = hash(&status, 1, h);
+    if(rnd() % 64 == 0)
+    {
+      int size = YM2612SaveContext(state);
+      if(YM2612LoadContext(state) != size)
+        h = 0;
+    }
+  }
+  return h;
+}
+
+int main()
+{
+  YM2612Init(53693175 / 7.0, 53267);
+  double best = 0;
+  for(int rep = 0; rep < 10; rep++)
+    best = std::max(best, music(300));
+  printf("music: %.2f M samples/s\n", best / 1e6);
+  printf("random writes: checksum %08x\n", randomWrites(20000));
+  return 0;
+}
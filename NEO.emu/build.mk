@@ -21,7 +21,7 @@ SRC += $(GEO)/ym2610/2610intf.c $(GEO)/ym2610/ym2610.c
 
 SRC += $(GEO)/debug.c $(GEO)/emu.c $(GEO)/fileio.c $(GEO)/mame_layer.c \
 $(GEO)/memory.c $(GEO)/neoboot.c $(GEO)/neocrypt.c $(GEO)/pd4990a.c $(GEO)/resfile.c $(GEO)/roms.c $(GEO)/state.c \
-$(GEO)/timer.c $(GEO)/video.c $(GEO)/unzip.c
+$(GEO)/timer.c $(GEO)/video.c $(GEO)/video_simd.c $(GEO)/unzip.c $(GEO)/lzblock.c $(GEO)/parallel.c $(GEO)/pcm_cache.c
 
 ifeq ($(ENV), webos)
  use68KCyclone := 1
@@ -0,0 +1,180 @@
+/*  This file is part of NEO.emu.
+
+	NEO.emu is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	NEO.emu is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with NEO.emu.  If not, see <http://www.gnu.org/licenses/> */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include "lzblock.h"
+
+/* Each sequence is a token (literal count << 4 | match length - MIN_MATCH),
+ * extra literal count bytes, the literals, a 16 bit little endian offset and
+ * extra match length bytes. Counts of 15 continue in bytes of 255 until a
+ * smaller one. The block ends with a sequence of literals only. */
+#define MIN_MATCH     4
+#define LAST_LITERALS 5  /* the last bytes are always literals */
+#define MATCH_LIMIT   12 /* no match starts this close to the end */
+#define MAX_OFFSET    65535
+#define HASH_BITS     12
+
+static Uint32 read32(const Uint8 *p) {
+	Uint32 v;
+	memcpy(&v, p, 4);
+	return v;
+}
+
+static Uint32 hash32(Uint32 v) {
+	return (v * 2654435761U) >> (32 - HASH_BITS);
+}
+
+static Uint8 *put_count(Uint8 *op, Uint32 count) {
+	while (count >= 255) {
+		*op++ = 255;
+		count -= 255;
+	}
+	*op++ = count;
+	return op;
+}
+
+static Uint8 *put_sequence(Uint8 *op, const Uint8 *lit, Uint32 lit_len,
+		Uint32 offset, Uint32 match_len) {
+	Uint8 *token = op++;
+	*token = (lit_len < 15 ? lit_len : 15) << 4;
+	if (lit_len >= 15)
+		op = put_count(op, lit_len - 15);
+	memcpy(op, lit, lit_len);
+	op += lit_len;
+	if (match_len) {
+		match_len -= MIN_MATCH;
+		*op++ = offset;
+		*op++ = offset >> 8;
+		*token |= (match_len < 15 ? match_len : 15);
+		if (match_len >= 15)
+			op = put_count(op, match_len - 15);
+	}
+	return op;
+}
+
+Uint32 lz_compress_block(const Uint8 *src, Uint32 src_size, Uint8 *dst, Uint32 dst_size) {
+	Uint32 table[1 << HASH_BITS];
+	const Uint8 *ip = src;
+	const Uint8 *anchor = src;
+	const Uint8 *iend = src + src_size;
+	const Uint8 *mlimit = iend - LAST_LITERALS;
+	Uint8 *op = dst;
+
+	if (dst_size < LZ_BLOCK_BOUND(src_size))
+		return 0;
+	if (src_size > MATCH_LIMIT) {
+		memset(table, 0, sizeof (table));
+		ip++;
+		while (ip < iend - MATCH_LIMIT) {
+			Uint32 seq = read32(ip);
+			Uint32 h = hash32(seq);
+			const Uint8 *ref = src + table[h];
+			const Uint8 *mp;
+			table[h] = ip - src;
+			if (ref >= ip || ip - ref > MAX_OFFSET || read32(ref) != seq) {
+				ip++;
+				continue;
+			}
+			/* Extend backward over pending literals, then forward */
+			while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+				ip--;
+				ref--;
+			}
+			mp = ip + MIN_MATCH;
+			ref += MIN_MATCH;
+			while (mp < mlimit && *mp == *ref) {
+				mp++;
+				ref++;
+			}
+			op = put_sequence(op, anchor, ip - anchor, mp - ref, mp - ip);
+			/* Index the end of the match before moving on */
+			if (mp - 2 > ip)
+				table[hash32(read32(mp - 2))] = mp - 2 - src;
+			ip = anchor = mp;
+		}
+	}
+	op = put_sequence(op, anchor, iend - anchor, 0, 0);
+	return op - dst;
+}
+
+static const Uint8 *get_count(const Uint8 *ip, const Uint8 *iend, Uint32 *count) {
+	Uint8 s;
+	do {
+		if (ip >= iend)
+			return NULL;
+		s = *ip++;
+		*count += s;
+	} while (s == 255);
+	return ip;
+}
+
+int lz_decompress_block(const Uint8 *src, Uint32 src_size, Uint8 *dst, Uint32 dst_size) {
+	const Uint8 *ip = src;
+	const Uint8 *iend = src + src_size;
+	Uint8 *op = dst;
+	Uint8 *oend = dst + dst_size;
+
+	for (;;) {
+		Uint32 token, len, offset;
+		const Uint8 *match;
+		if (ip >= iend)
+			return -1;
+		token = *ip++;
+
+		len = token >> 4;
+		if (len == 15 && (ip = get_count(ip, iend, &len)) == NULL)
+			return -1;
+		if (len > (Uint32) (iend - ip) || len > (Uint32) (oend - op))
+			return -1;
+		memcpy(op, ip, len);
+		op += len;
+		ip += len;
+		if (ip == iend)
+			break; /* last literals */
+
+		if (iend - ip < 2)
+			return -1;
+		offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (Uint32) (op - dst))
+			return -1;
+		len = token & 15;
+		if (len == 15 && (ip = get_count(ip, iend, &len)) == NULL)
+			return -1;
+		len += MIN_MATCH;
+		if (len > (Uint32) (oend - op))
+			return -1;
+		match = op - offset;
+		if (offset >= len) {
+			memcpy(op, match, len);
+			op += len;
+		} else {
+			/* Overlapping match repeats the last offset bytes, the
+			 * repeated part doubles with each copy */
+			while (len) {
+				Uint32 n = op - match;
+				if (n > len) n = len;
+				memcpy(op, match, n);
+				op += n;
+				len -= n;
+			}
+		}
+	}
+	return op - dst;
+}
@@ -0,0 +1,33 @@
+/*  This file is part of NEO.emu.
+
+	NEO.emu is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	NEO.emu is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with NEO.emu.  If not, see <http://www.gnu.org/licenses/> */
+
+#ifndef _LZBLOCK_H_
+#define _LZBLOCK_H_
+
+#include <gngeoTypes.h>
+
+/* LZ77 block codec using the LZ4 block format. It compresses less than zlib
+ * but decodes several times faster, which is what counts for the sprite
+ * cache since blocks get decompressed while drawing. */
+
+/* Worst case compressed size of a block of size bytes */
+#define LZ_BLOCK_BOUND(size) ((size) + (size) / 255 + 16)
+
+/* Returns the compressed size, 0 if dst_size is too small */
+Uint32 lz_compress_block(const Uint8 *src, Uint32 src_size, Uint8 *dst, Uint32 dst_size);
+/* Returns the decompressed size, -1 on corrupt input or if it doesn't fit in dst */
+int lz_decompress_block(const Uint8 *src, Uint32 src_size, Uint8 *dst, Uint32 dst_size);
+
+#endif
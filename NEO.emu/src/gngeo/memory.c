@@ -595,6 +595,8 @@ void mem68k_store_video_word(Uint32 addr, Uint16 data) {
 	case 0x2:
 		//printf("Store %04x to video %08x @pc=%08x\n",data,vptr<<1,cpu_68k_getpc());
 		WRITE_WORD(&memory.vid.ram[memory.vid.vptr << 1], data);
+		if (memory.vid.spr_cache.data && memory.vid.vptr < 0x7000 && (memory.vid.vptr & 1))
+			prefetch_sprite_tile(memory.vid.vptr); /* SCB1 tile attributes */
 		memory.vid.vptr = (memory.vid.vptr & 0x8000) + ((memory.vid.vptr
 				+ memory.vid.modulo) & 0x7fff);
 		memory.vid.rbuf = READ_WORD(&memory.vid.ram[memory.vid.vptr << 1]);
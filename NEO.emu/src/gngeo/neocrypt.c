@@ -51,6 +51,13 @@
 #include "resfile.h"
 #include "mame_layer.h"
 #include "menu.h"
+#include "parallel.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 /***************************************************************************
 
@@ -532,39 +539,112 @@ static void decrypt(UINT8 *r0, UINT8 *r1,
 
 #include <stdio.h>
 
+/* Both C rom passes work on runs of 256 longwords sharing address bits 8-23,
+ * the data xor of a run only depends on bits 8-15 and its byte swaps are
+ * the same for the whole run */
+#define GFX_RUN 256
 
-static void neogeo_gfx_decrypt(running_machine *machine, int extra_xor)
-{
-	UINT8 *buf;
+typedef struct GFX_DECRYPT {
 	UINT8 *rom;
-	uint rpos;
-	const uint rom_size = memory_region_length(machine, "sprites");
-
-	buf = alloc_array_or_die(UINT8, rom_size);
+	UINT8 *buf;
+	UINT8 *key;  /* data xor for each value of address bits 8-15 */
+	uint rom_size;
+	int extra_xor;
+} GFX_DECRYPT;
 
-	rom = memory_region(machine, "sprites");
-	const uint pbarUpdateCount = 20;
-	const uint pbarSteps = (rom_size/4)/pbarUpdateCount;
-	gn_init_pbar(PBAR_ACTION_DECRYPT, rom_size/2);
-	// Data xor
-	for (rpos = 0;rpos < rom_size/4;rpos++)
+static void gfx_build_keys(void *arg, Uint32 start, Uint32 end)
+{
+	GFX_DECRYPT *d = arg;
+	uint hi, i;
+	for (hi = start; hi < end; hi++)
 	{
-		decrypt(buf+4*rpos+0, buf+4*rpos+3, rom[4*rpos+0], rom[4*rpos+3], type0_t03, type0_t12, type1_t03, rpos, (rpos>>8) & 1);
-		decrypt(buf+4*rpos+1, buf+4*rpos+2, rom[4*rpos+1], rom[4*rpos+2], type0_t12, type0_t03, type1_t12, rpos, ((rpos>>16) ^ address_16_23_xor2[(rpos>>8) & 0xff]) & 1);
-		if (rpos % pbarSteps == 0) {
-			gn_update_pbar(rpos);
+		UINT8 *key = d->key + hi * GFX_RUN * 4;
+		for (i = 0; i < GFX_RUN; i++)
+		{
+			int base = (hi << 8) | i;
+			decrypt(key+4*i+0, key+4*i+3, 0, 0, type0_t03, type0_t12, type1_t03, base, 0);
+			decrypt(key+4*i+1, key+4*i+2, 0, 0, type0_t12, type0_t03, type1_t12, base, 0);
 		}
 	}
-	// Address xor
-	for (rpos = 0;rpos < rom_size/4;rpos++)
+}
+
+/* dst = src with bytes 0&3 and/or 1&2 of each longword swapped, xored with key */
+static void gfx_xor_run(UINT8 *dst, const UINT8 *src, const UINT8 *key, uint count,
+		int swap03, int swap12)
+{
+	uint i = 0;
+#if defined(__SSE2__)
+	const __m128i mask03 = _mm_set1_epi32(0x00ffff00), mask12 = _mm_set1_epi32(0xff0000ff);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)(src + 4*i));
+		if (swap03)
+			v = _mm_or_si128(_mm_and_si128(v, mask03),
+				_mm_or_si128(_mm_slli_epi32(v, 24), _mm_srli_epi32(v, 24)));
+		if (swap12)
+			v = _mm_or_si128(_mm_and_si128(v, mask12),
+				_mm_or_si128(_mm_and_si128(_mm_slli_epi32(v, 8), _mm_set1_epi32(0x00ff0000)),
+					_mm_and_si128(_mm_srli_epi32(v, 8), _mm_set1_epi32(0x0000ff00))));
+		v = _mm_xor_si128(v, _mm_loadu_si128((const __m128i*)(key + 4*i)));
+		_mm_storeu_si128((__m128i*)(dst + 4*i), v);
+	}
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+	const uint32x4_t mask03 = vdupq_n_u32(0x00ffff00), mask12 = vdupq_n_u32(0xff0000ff);
+	for (; i + 4 <= count; i += 4)
+	{
+		uint32x4_t v = vreinterpretq_u32_u8(vld1q_u8(src + 4*i));
+		if (swap03 && swap12)
+			v = vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(v)));
+		else if (swap03)
+			v = vorrq_u32(vandq_u32(v, mask03), vorrq_u32(vshlq_n_u32(v, 24), vshrq_n_u32(v, 24)));
+		else if (swap12)
+			v = vorrq_u32(vandq_u32(v, mask12),
+				vorrq_u32(vandq_u32(vshlq_n_u32(v, 8), vdupq_n_u32(0x00ff0000)),
+					vandq_u32(vshrq_n_u32(v, 8), vdupq_n_u32(0x0000ff00))));
+		v = veorq_u32(v, vreinterpretq_u32_u8(vld1q_u8(key + 4*i)));
+		vst1q_u8(dst + 4*i, vreinterpretq_u8_u32(v));
+	}
+#endif
+	for (; i < count; i++)
+	{
+		dst[4*i+0] = src[4*i + (swap03 ? 3 : 0)] ^ key[4*i+0];
+		dst[4*i+1] = src[4*i + (swap12 ? 2 : 1)] ^ key[4*i+1];
+		dst[4*i+2] = src[4*i + (swap12 ? 1 : 2)] ^ key[4*i+2];
+		dst[4*i+3] = src[4*i + (swap03 ? 0 : 3)] ^ key[4*i+3];
+	}
+}
+
+// Data xor
+static void gfx_data_xor(void *arg, Uint32 start, Uint32 end)
+{
+	GFX_DECRYPT *d = arg;
+	const uint words = d->rom_size/4;
+	uint run;
+	for (run = start; run < end; run++)
+	{
+		uint rpos = run * GFX_RUN;
+		uint hi = run & 0xff;
+		uint count = words - rpos < GFX_RUN ? words - rpos : GFX_RUN;
+		gfx_xor_run(d->buf + 4*rpos, d->rom + 4*rpos, d->key + hi * GFX_RUN * 4, count,
+			(rpos>>8) & 1, ((rpos>>16) ^ address_16_23_xor2[hi]) & 1);
+	}
+}
+
+// Address xor
+static void gfx_address_xor(void *arg, Uint32 start, Uint32 end)
+{
+	GFX_DECRYPT *d = arg;
+	const uint rom_size = d->rom_size;
+	uint rpos;
+	end *= GFX_RUN;
+	if (end > rom_size/4)
+		end = rom_size/4;
+	for (rpos = start * GFX_RUN; rpos < end; rpos++)
 	{
 		int baser;
-		if (rpos % pbarSteps == 0) {
-			gn_update_pbar(rpos + (rom_size >> 2));
-		}
 		baser = rpos;
 
-		baser ^= extra_xor;
+		baser ^= d->extra_xor;
 
 		baser ^= address_8_15_xor1[(baser >> 16) & 0xff] << 8;
 		baser ^= address_8_15_xor2[baser & 0xff] << 8;
@@ -590,13 +670,34 @@ static void neogeo_gfx_decrypt(running_machine *machine, int extra_xor)
 		else /* Clamp to the real rom size */
 			baser &= (rom_size/4)-1;
 
-		rom[4*rpos+0] = buf[4*baser+0];
-		rom[4*rpos+1] = buf[4*baser+1];
-		rom[4*rpos+2] = buf[4*baser+2];
-		rom[4*rpos+3] = buf[4*baser+3];
+		memcpy(d->rom + 4*rpos, d->buf + 4*baser, 4);
 	}
+}
+
+static void neogeo_gfx_decrypt(running_machine *machine, int extra_xor)
+{
+	GFX_DECRYPT d;
+	uint runs;
+	Uint32 ticks, data_ms;
+
+	d.rom_size = memory_region_length(machine, "sprites");
+	d.rom = memory_region(machine, "sprites");
+	d.buf = alloc_array_or_die(UINT8, d.rom_size);
+	d.key = alloc_array_or_die(UINT8, 256 * GFX_RUN * 4);
+	d.extra_xor = extra_xor;
+	runs = (d.rom_size/4 + GFX_RUN - 1) / GFX_RUN;
+
+	ticks = gn_ticks_ms();
+	gn_init_pbar(PBAR_ACTION_DECRYPT, runs * 2);
+	gn_parallel_for(256, 16, gfx_build_keys, &d, -1);
+	gn_parallel_for(runs, 64, gfx_data_xor, &d, 0);
+	free(d.key);
+	data_ms = gn_ticks_ms() - ticks;
+	ticks = gn_ticks_ms();
+	gn_parallel_for(runs, 64, gfx_address_xor, &d, runs);
 	gn_terminate_pbar();
-	free(buf);
+	logMsg("C rom decrypt: data xor %u ms, address xor %u ms", data_ms, gn_ticks_ms() - ticks);
+	free(d.buf);
 }
 
 
@@ -1021,6 +1122,43 @@ NeoGeo 'P' ROM encryption
 ***************************************************************************/
 
 
+typedef struct DATA_LINES {
+	UINT16 *rom;
+	UINT16 lo[256];
+	UINT16 hi[256];
+} DATA_LINES;
+
+static void swap_data_lines_range(void *arg, Uint32 start, Uint32 end)
+{
+	DATA_LINES *d = arg;
+	UINT32 i;
+	for (i = start; i < end; i++)
+		d->rom[i] = d->lo[d->rom[i] & 0xff] | d->hi[d->rom[i] >> 8];
+}
+
+/* BITSWAP16 over a whole rom through one table per byte, bits lists the
+ * source of bits 15 to 0 like the BITSWAP16 arguments */
+static void swap_data_lines(UINT16 *rom, UINT32 count, const UINT8 *bits)
+{
+	DATA_LINES d;
+	int v, k;
+	d.rom = rom;
+	for (v = 0; v < 256; v++)
+	{
+		d.lo[v] = d.hi[v] = 0;
+		for (k = 0; k < 16; k++)
+		{
+			int src = bits[15 - k];
+			if (src < 8)
+				d.lo[v] |= BIT(v, src) << k;
+			else
+				d.hi[v] |= BIT(v, src - 8) << k;
+		}
+	}
+	gn_parallel_for(count, 0x10000, swap_data_lines_range, &d, -1);
+}
+
+
 /* Kof98 uses an early encryption, quite different from the others */
 void kof98_decrypt_68k(running_machine *machine)
 {
@@ -1072,14 +1210,12 @@ void kof98_decrypt_68k(running_machine *machine)
 void kof99_decrypt_68k(running_machine *machine)
 {
 	UINT16 *rom;
+	static const UINT8 data_lines[16] = { 13, 7, 3, 0, 9, 4, 5, 6, 1, 12, 8, 14, 10, 11, 2, 15 };
 	int i,j;
 
 	rom = (UINT16 *)(memory_region(machine, "maincpu") + 0x100000);
 	/* swap data lines on the whole ROMs */
-	for (i = 0;i < 0x800000/2;i++)
-	{
-		rom[i] = BITSWAP16(rom[i],13,7,3,0,9,4,5,6,1,12,8,14,10,11,2,15);
-	}
+	swap_data_lines(rom, 0x800000/2, data_lines);
 
 	/* swap address lines for the banked part */
 	for (i = 0;i < 0x600000/2;i+=0x800/2)
@@ -1104,15 +1240,13 @@ void kof99_decrypt_68k(running_machine *machine)
 void garou_decrypt_68k(running_machine *machine)
 {
 	UINT16 *rom;
+	static const UINT8 data_lines[16] = { 13, 12, 14, 10, 8, 2, 3, 1, 5, 9, 11, 4, 15, 0, 6, 7 };
 	int i,j;
 
 	/* thanks to Razoola and Mr K for the info */
 	rom = (UINT16 *)(memory_region(machine, "maincpu") + 0x100000);
 	/* swap data lines on the whole ROMs */
-	for (i = 0;i < 0x800000/2;i++)
-	{
-		rom[i] = BITSWAP16(rom[i],13,12,14,10,8,2,3,1,5,9,11,4,15,0,6,7);
-	}
+	swap_data_lines(rom, 0x800000/2, data_lines);
 
 	/* swap address lines & relocate fixed part */
 	rom = (UINT16 *)memory_region(machine, "maincpu");
@@ -1138,15 +1272,13 @@ void garou_decrypt_68k(running_machine *machine)
 void garouo_decrypt_68k(running_machine *machine)
 {
 	UINT16 *rom;
+	static const UINT8 data_lines[16] = { 14, 5, 1, 11, 7, 4, 10, 15, 3, 12, 8, 13, 0, 2, 9, 6 };
 	int i,j;
 
 	/* thanks to Razoola and Mr K for the info */
 	rom = (UINT16 *)(memory_region(machine, "maincpu") + 0x100000);
 	/* swap data lines on the whole ROMs */
-	for (i = 0;i < 0x800000/2;i++)
-	{
-		rom[i] = BITSWAP16(rom[i],14,5,1,11,7,4,10,15,3,12,8,13,0,2,9,6);
-	}
+	swap_data_lines(rom, 0x800000/2, data_lines);
 
 	/* swap address lines & relocate fixed part */
 	rom = (UINT16 *)memory_region(machine, "maincpu");
@@ -1172,15 +1304,13 @@ void garouo_decrypt_68k(running_machine *machine)
 void mslug3_decrypt_68k(running_machine *machine)
 {
 	UINT16 *rom;
+	static const UINT8 data_lines[16] = { 4, 11, 14, 3, 1, 13, 0, 7, 2, 8, 12, 15, 10, 9, 5, 6 };
 	int i,j;
 
 	/* thanks to Razoola and Mr K for the info */
 	rom = (UINT16 *)(memory_region(machine, "maincpu") + 0x100000);
 	/* swap data lines on the whole ROMs */
-	for (i = 0;i < 0x800000/2;i++)
-	{
-		rom[i] = BITSWAP16(rom[i],4,11,14,3,1,13,0,7,2,8,12,15,10,9,5,6);
-	}
+	swap_data_lines(rom, 0x800000/2, data_lines);
 
 	/* swap address lines & relocate fixed part */
 	rom = (UINT16 *)memory_region(machine, "maincpu");
@@ -1206,15 +1336,13 @@ void mslug3_decrypt_68k(running_machine *machine)
 void kof2000_decrypt_68k(running_machine *machine)
 {
 	UINT16 *rom;
+	static const UINT8 data_lines[16] = { 12, 8, 11, 3, 15, 14, 7, 0, 10, 13, 6, 5, 9, 2, 1, 4 };
 	int i,j;
 
 	/* thanks to Razoola and Mr K for the info */
 	rom = (UINT16 *)(memory_region(machine, "maincpu") + 0x100000);
 	/* swap data lines on the whole ROMs */
-	for (i = 0;i < 0x800000/2;i++)
-	{
-		rom[i] = BITSWAP16(rom[i],12,8,11,3,15,14,7,0,10,13,6,5,9,2,1,4);
-	}
+	swap_data_lines(rom, 0x800000/2, data_lines);
 
 	/* swap address lines for the banked part */
 	for (i = 0;i < 0x63a000/2;i+=0x800/2)
@@ -0,0 +1,112 @@
+/*  This file is part of NEO.emu.
+
+	NEO.emu is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	NEO.emu is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with NEO.emu.  If not, see <http://www.gnu.org/licenses/> */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include "parallel.h"
+#include "menu.h"
+
+#define MAX_THREADS 16
+#define PBAR_UPDATES 20
+
+typedef struct PARALLEL_JOB {
+	GN_RANGE_FUNC func;
+	void *arg;
+	Uint32 count;
+	Uint32 chunk;
+	/* guarded by lock */
+	Uint32 next;
+	Uint32 done;
+	pthread_mutex_t lock;
+} PARALLEL_JOB;
+
+/* Runs ranges until none are left, returns the items done so far by everyone */
+static Uint32 run_range(PARALLEL_JOB *job, Uint32 done) {
+	Uint32 start, end;
+	pthread_mutex_lock(&job->lock);
+	job->done += done;
+	done = job->done;
+	start = job->next;
+	if (start < job->count) {
+		end = start + job->chunk;
+		if (end > job->count || end < start) end = job->count;
+		job->next = end;
+	}
+	pthread_mutex_unlock(&job->lock);
+	if (start >= job->count)
+		return (Uint32)-1;
+	job->func(job->arg, start, end);
+	return end - start;
+}
+
+static void *parallel_thread(void *arg) {
+	PARALLEL_JOB *job = arg;
+	Uint32 done = 0;
+	while ((done = run_range(job, done)) != (Uint32)-1)
+		;
+	return NULL;
+}
+
+void gn_parallel_for(Uint32 count, Uint32 chunk, GN_RANGE_FUNC func, void *arg, int pbar_base) {
+	pthread_t thread[MAX_THREADS];
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	int nb_thread = 0;
+	Uint32 done = 0, progress, shown = 0;
+	int i;
+	PARALLEL_JOB job;
+
+	if (count == 0)
+		return;
+	if (chunk == 0) chunk = 1;
+	job.func = func;
+	job.arg = arg;
+	job.count = count;
+	job.chunk = chunk;
+	job.next = 0;
+	job.done = 0;
+	pthread_mutex_init(&job.lock, NULL);
+	if (cpus > MAX_THREADS) cpus = MAX_THREADS;
+	for (i = 1; i < cpus && (Uint32) i * chunk < count; i++) {
+		if (pthread_create(&thread[nb_thread], NULL, parallel_thread, &job) != 0)
+			break;
+		nb_thread++;
+	}
+	/* The calling thread takes ranges too, and owns the progress bar */
+	while ((done = run_range(&job, done)) != (Uint32)-1) {
+		if (pbar_base < 0)
+			continue;
+		pthread_mutex_lock(&job.lock);
+		progress = job.done + done;
+		pthread_mutex_unlock(&job.lock);
+		if (progress - shown >= count / PBAR_UPDATES) {
+			gn_update_pbar(pbar_base + progress);
+			shown = progress;
+		}
+	}
+	for (i = 0; i < nb_thread; i++)
+		pthread_join(thread[i], NULL);
+	pthread_mutex_destroy(&job.lock);
+}
+
+Uint32 gn_ticks_ms(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
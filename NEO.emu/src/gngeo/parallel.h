@@ -0,0 +1,33 @@
+/*  This file is part of NEO.emu.
+
+	NEO.emu is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	NEO.emu is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with NEO.emu.  If not, see <http://www.gnu.org/licenses/> */
+
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+#include <gngeoTypes.h>
+
+/* Load time work split across cores: func runs on [start, end) ranges of
+ * at most chunk items, on worker threads and the calling thread, until all
+ * of [0, count) is done. Ranges must be independent of each other. */
+typedef void (*GN_RANGE_FUNC)(void *arg, Uint32 start, Uint32 end);
+
+/* With pbar_base >= 0, the calling thread also moves the progress bar from
+ * pbar_base to pbar_base + count as ranges complete */
+void gn_parallel_for(Uint32 count, Uint32 chunk, GN_RANGE_FUNC func, void *arg, int pbar_base);
+
+/* Monotonic milliseconds, for timing load stages */
+Uint32 gn_ticks_ms(void);
+
+#endif
@@ -0,0 +1,327 @@
+/*  This file is part of NEO.emu.
+
+	NEO.emu is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	NEO.emu is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with NEO.emu.  If not, see <http://www.gnu.org/licenses/> */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <zlib.h>
+#include "pcm_cache.h"
+#include "roms.h"
+#include "lzblock.h"
+
+#define MIN_SLOTS 64
+#define MAX_SLOTS 1024
+#define MAX_PCM_JOBS 16 /* power of 2 */
+
+PCM_CACHE pcm_cache[2] = { { .fd = -1 }, { .fd = -1 } };
+
+/* Blocks past the end of the rom read as silence */
+static const Uint8 zero_block[PCM_BLOCK_SIZE];
+
+/* The worker thread decompresses queued slots of both caches. Block
+ * lookups, slot allocation and pins stay on the emulation thread, slot
+ * states are guarded by pcm_mutex */
+static pthread_t pcm_thread;
+static pthread_mutex_t pcm_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pcm_job_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pcm_done_cond = PTHREAD_COND_INITIALIZER;
+static int pcm_thread_running = 0;
+static int pcm_quit = 0;
+static struct {
+	PCM_CACHE *c;
+	int a;
+} pcm_job[MAX_PCM_JOBS];
+static Uint32 pcm_job_head = 0, pcm_job_tail = 0;
+static Uint8 *pcm_in_buf = NULL;
+static Uint32 pcm_in_size = 0;
+
+static void load_pcm_block(PCM_CACHE *c, int block, int a, Uint8 *in_buf) {
+	Uint32 cmp_size = 0;
+	Uint8 *dst = c->data + (a << PCM_BLOCK_SHIFT);
+	uLongf dst_size = PCM_BLOCK_SIZE;
+	int rc;
+
+	if (pread(c->fd, &cmp_size, sizeof (Uint32), c->offset[block]) != sizeof (Uint32)
+			|| cmp_size > c->in_size
+			|| pread(c->fd, in_buf, cmp_size, c->offset[block] + sizeof (Uint32)) != cmp_size)
+		rc = 0;
+	else if (c->codec == GNO_LZ)
+		rc = lz_decompress_block(in_buf, cmp_size, dst, PCM_BLOCK_SIZE) == PCM_BLOCK_SIZE;
+	else
+		rc = uncompress(dst, &dst_size, in_buf, cmp_size) == Z_OK;
+	if (!rc) {
+		logMsg("Error loading ADPCM block %d\n", block);
+		memset(dst, 0, PCM_BLOCK_SIZE);
+	}
+}
+
+static void *pcm_cache_thread(void *arg) {
+	PCM_CACHE *c;
+	int a;
+
+	pthread_mutex_lock(&pcm_mutex);
+	for (;;) {
+		while (!pcm_quit && pcm_job_head == pcm_job_tail)
+			pthread_cond_wait(&pcm_job_cond, &pcm_mutex);
+		if (pcm_quit) break;
+		c = pcm_job[pcm_job_head & (MAX_PCM_JOBS - 1)].c;
+		a = pcm_job[pcm_job_head & (MAX_PCM_JOBS - 1)].a;
+		pcm_job_head++;
+		/* A channel may have needed it first */
+		if (c->state[a] != PCM_QUEUED) continue;
+		c->state[a] = PCM_BUSY;
+		int block = c->usage[a];
+		pthread_mutex_unlock(&pcm_mutex);
+		load_pcm_block(c, block, a, pcm_in_buf);
+		pthread_mutex_lock(&pcm_mutex);
+		c->state[a] = PCM_READY;
+		pthread_cond_broadcast(&pcm_done_cond);
+	}
+	pthread_mutex_unlock(&pcm_mutex);
+	return NULL;
+}
+
+static void start_pcm_cache_thread(Uint32 in_size) {
+	/* Both regions use the same block size, one input buffer fits all */
+	if (pcm_thread_running)
+		return;
+	/* Without a core to spare, blocks are simply loaded as they're reached */
+	if (sysconf(_SC_NPROCESSORS_ONLN) < 2)
+		return;
+	pcm_in_buf = malloc(in_size);
+	if (pcm_in_buf == NULL)
+		return;
+	pcm_in_size = in_size;
+	pcm_quit = 0;
+	pcm_job_head = pcm_job_tail = 0;
+	if (pthread_create(&pcm_thread, NULL, pcm_cache_thread, NULL) != 0) {
+		free(pcm_in_buf);
+		pcm_in_buf = NULL;
+		return;
+	}
+	pcm_thread_running = 1;
+}
+
+static void stop_pcm_cache_thread(void) {
+	int i, a;
+	if (!pcm_thread_running)
+		return;
+	pthread_mutex_lock(&pcm_mutex);
+	pcm_quit = 1;
+	pthread_cond_signal(&pcm_job_cond);
+	pthread_mutex_unlock(&pcm_mutex);
+	pthread_join(pcm_thread, NULL);
+	/* Drop the jobs it didn't get to */
+	for (i = 0; i < 2; i++) {
+		PCM_CACHE *c = &pcm_cache[i];
+		for (a = 0; c->state && a < c->max_slot; a++) {
+			if (c->state[a] != PCM_QUEUED) continue;
+			c->slot[c->usage[a]] = -1;
+			c->usage[a] = -1;
+			c->state[a] = PCM_READY;
+		}
+	}
+	pcm_thread_running = 0;
+	free(pcm_in_buf);
+	pcm_in_buf = NULL;
+	pcm_in_size = 0;
+}
+
+int init_pcm_cache(PCM_CACHE *c, int fd, Uint8 codec, Uint32 size, Uint32 *offset) {
+	Uint32 i;
+	int a;
+
+	free_pcm_cache(c);
+	c->fd = dup(fd);
+	if (c->fd < 0) {
+		free(offset);
+		return 1;
+	}
+	c->codec = codec;
+	c->offset = offset;
+	c->total_block = size >> PCM_BLOCK_SHIFT;
+	/* An eighth of the rom, enough for a few blocks per channel */
+	c->max_slot = c->total_block / 8;
+	if (c->max_slot < MIN_SLOTS) c->max_slot = MIN_SLOTS;
+	if (c->max_slot > MAX_SLOTS) c->max_slot = MAX_SLOTS;
+	c->in_size = compressBound(PCM_BLOCK_SIZE);
+	if (c->in_size < LZ_BLOCK_BOUND(PCM_BLOCK_SIZE))
+		c->in_size = LZ_BLOCK_BOUND(PCM_BLOCK_SIZE);
+	c->in_buf = malloc(c->in_size);
+	c->data = malloc(c->max_slot << PCM_BLOCK_SHIFT);
+	c->slot = malloc(c->total_block * sizeof (int));
+	c->usage = malloc(c->max_slot * sizeof (int));
+	c->ref = calloc(c->max_slot, 1);
+	c->pin = calloc(c->max_slot, 1);
+	c->state = calloc(c->max_slot, 1);
+	if (!c->in_buf || !c->data || !c->slot || !c->usage || !c->ref || !c->pin || !c->state) {
+		free_pcm_cache(c);
+		return 1;
+	}
+	for (i = 0; i < c->total_block; i++)
+		c->slot[i] = -1;
+	for (a = 0; a < c->max_slot; a++)
+		c->usage[a] = -1;
+	c->hand = 0;
+	c->hits = c->misses = c->stalls = c->prefetches = 0;
+	logMsg("Streaming ADPCM, %d blocks cached of %d\n", c->max_slot, c->total_block);
+	start_pcm_cache_thread(c->in_size);
+	return 0;
+}
+
+void free_pcm_cache(PCM_CACHE *c) {
+	if (c->fd < 0)
+		return;
+	/* The worker thread serves both caches */
+	stop_pcm_cache_thread();
+	if (c->data)
+		logMsg("ADPCM cache: %u hits, %u misses, %u stalls, %u prefetches\n",
+				c->hits, c->misses, c->stalls, c->prefetches);
+	close(c->fd);
+	free(c->offset);
+	free(c->in_buf);
+	free(c->data);
+	free(c->slot);
+	free(c->usage);
+	free(c->ref);
+	free(c->pin);
+	free(c->state);
+	memset(c, 0, sizeof (PCM_CACHE));
+	c->fd = -1;
+	if (pcm_cache[0].fd >= 0 || pcm_cache[1].fd >= 0)
+		start_pcm_cache_thread(pcm_cache[0].fd >= 0 ? pcm_cache[0].in_size : pcm_cache[1].in_size);
+}
+
+PCM_CACHE *pcm_cache_region(int region) {
+	if (region == REGION_AUDIO_DATA_2 && pcm_cache[1].fd >= 0)
+		return &pcm_cache[1];
+	return pcm_cache[0].fd >= 0 ? &pcm_cache[0] : NULL;
+}
+
+/* CLOCK eviction over the slots nobody is reading or decompressing, pcm_mutex
+ * must be held. Returns -1 if all are in use */
+static int alloc_pcm_slot(PCM_CACHE *c, int block) {
+	int i, a;
+	for (i = 0; i < c->max_slot * 2; i++) {
+		a = c->hand;
+		c->hand = (c->hand + 1) % c->max_slot;
+		if (c->pin[a] || c->state[a] != PCM_READY)
+			continue;
+		if (c->ref[a]) {
+			c->ref[a] = 0;
+			continue;
+		}
+		if (c->usage[a] >= 0)
+			c->slot[c->usage[a]] = -1;
+		c->usage[a] = block;
+		c->slot[block] = a;
+		c->ref[a] = 1;
+		return a;
+	}
+	return -1;
+}
+
+/* Returns the ready slot holding block, decompressing it here if needed */
+static int get_pcm_slot(PCM_CACHE *c, Uint32 block) {
+	int a;
+
+	pthread_mutex_lock(&pcm_mutex);
+	a = c->slot[block];
+	if (a >= 0) {
+		c->ref[a] = 1;
+		if (c->state[a] == PCM_READY) {
+			c->hits++;
+			pthread_mutex_unlock(&pcm_mutex);
+			return a;
+		}
+		if (c->state[a] == PCM_BUSY) {
+			c->stalls++;
+			while (c->state[a] != PCM_READY)
+				pthread_cond_wait(&pcm_done_cond, &pcm_mutex);
+			pthread_mutex_unlock(&pcm_mutex);
+			return a;
+		}
+		/* Still queued, no point waiting for it */
+	} else {
+		while ((a = alloc_pcm_slot(c, block)) < 0)
+			pthread_cond_wait(&pcm_done_cond, &pcm_mutex);
+	}
+	c->misses++;
+	c->state[a] = PCM_BUSY;
+	pthread_mutex_unlock(&pcm_mutex);
+	load_pcm_block(c, block, a, c->in_buf);
+	pthread_mutex_lock(&pcm_mutex);
+	c->state[a] = PCM_READY;
+	pthread_mutex_unlock(&pcm_mutex);
+	return a;
+}
+
+static void prefetch_pcm_block(PCM_CACHE *c, Uint32 block) {
+	int a;
+	if (!pcm_thread_running || block >= c->total_block || c->slot[block] >= 0)
+		return;
+	pthread_mutex_lock(&pcm_mutex);
+	if (pcm_job_tail - pcm_job_head < MAX_PCM_JOBS
+			&& (a = alloc_pcm_slot(c, block)) >= 0) {
+		c->state[a] = PCM_QUEUED;
+		pcm_job[pcm_job_tail & (MAX_PCM_JOBS - 1)].c = c;
+		pcm_job[pcm_job_tail & (MAX_PCM_JOBS - 1)].a = a;
+		pcm_job_tail++;
+		c->prefetches++;
+		pthread_cond_signal(&pcm_job_cond);
+	}
+	pthread_mutex_unlock(&pcm_mutex);
+}
+
+void pcm_cache_seek(PCM_CACHE *c, PCM_CURSOR *cur, Uint32 block) {
+	int a;
+	if (cur->slot >= 0)
+		c->pin[cur->slot]--;
+	cur->block = block;
+	if (block >= c->total_block) {
+		cur->data = zero_block;
+		cur->slot = -1;
+		return;
+	}
+	a = get_pcm_slot(c, block);
+	c->pin[a]++;
+	cur->slot = a;
+	cur->data = c->data + (a << PCM_BLOCK_SHIFT);
+	/* Keep a block ahead of the channel */
+	prefetch_pcm_block(c, block + 1);
+}
+
+void pcm_cache_prefetch(PCM_CACHE *c, Uint32 addr) {
+	prefetch_pcm_block(c, addr >> PCM_BLOCK_SHIFT);
+	prefetch_pcm_block(c, (addr >> PCM_BLOCK_SHIFT) + 1);
+}
+
+void pcm_cursor_reset(PCM_CACHE *c, PCM_CURSOR *cur) {
+	if (c && cur->slot >= 0)
+		c->pin[cur->slot]--;
+	cur->data = NULL;
+	cur->block = (Uint32)-1;
+	cur->slot = -1;
+}
+
+void pcm_cache_unpin_all(PCM_CACHE *c) {
+	if (c && c->pin)
+		memset(c->pin, 0, c->max_slot);
+}
@@ -0,0 +1,85 @@
+/*  This file is part of NEO.emu.
+
+	NEO.emu is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	NEO.emu is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with NEO.emu.  If not, see <http://www.gnu.org/licenses/> */
+
+#ifndef _PCM_CACHE_H_
+#define _PCM_CACHE_H_
+
+#include <gngeoTypes.h>
+
+/* Streamed ADPCM sample rom. When enabled, the compressed ADPCM regions of a
+ * .gno stay on disk and the YM2610 reads them through a small cache of
+ * decompressed blocks. Writing a sample start address queues its first blocks
+ * for a worker thread, and each block played queues the next one. */
+
+#define PCM_BLOCK_SHIFT 12
+#define PCM_BLOCK_SIZE (1 << PCM_BLOCK_SHIFT)
+
+enum { PCM_READY, PCM_QUEUED, PCM_BUSY };
+
+typedef struct PCM_CACHE {
+	int fd;              /* own descriptor of the .gno, -1 if not streaming */
+	Uint8 codec;         /* GNO_ZLIB or GNO_LZ */
+	Uint32 total_block;
+	Uint32 *offset;      /* file offset of each compressed block */
+	Uint32 in_size;
+	Uint8 *in_buf;       /* compressed block read by the emulation thread */
+	Uint8 *data;         /* max_slot decompressed blocks */
+	int max_slot;
+	int *slot;           /* slot holding each block, -1 if not cached */
+	int *usage;          /* block held by each slot, -1 if free */
+	Uint8 *ref;          /* set when read, cleared as the clock hand passes */
+	Uint8 *pin;          /* channels reading from each slot, never evicted */
+	Uint8 *state;        /* PCM_READY, or PCM_QUEUED/PCM_BUSY while decompressed */
+	int hand;
+	/* statistics */
+	Uint32 hits;
+	Uint32 misses;       /* block decompressed when a channel reached it */
+	Uint32 stalls;       /* channel waited for the worker thread */
+	Uint32 prefetches;
+} PCM_CACHE;
+
+/* Position of one ADPCM channel in the cache */
+typedef struct PCM_CURSOR {
+	const Uint8 *data;   /* current block */
+	Uint32 block;
+	int slot;            /* pinned slot, -1 if none */
+} PCM_CURSOR;
+
+extern PCM_CACHE pcm_cache[2]; /* REGION_AUDIO_DATA_1, REGION_AUDIO_DATA_2 */
+
+/* Set in the options, streams the ADPCM regions of .gno files */
+int gn_streamADPCM();
+
+/* Takes ownership of offset, returns 0 on success */
+int init_pcm_cache(PCM_CACHE *c, int fd, Uint8 codec, Uint32 size, Uint32 *offset);
+void free_pcm_cache(PCM_CACHE *c);
+/* Cache for a sample region, the ADPCM-B one falls back to ADPCM-A.
+ * NULL if the region isn't streamed */
+PCM_CACHE *pcm_cache_region(int region);
+
+void pcm_cache_seek(PCM_CACHE *c, PCM_CURSOR *cur, Uint32 block);
+void pcm_cache_prefetch(PCM_CACHE *c, Uint32 addr);
+/* Forget a cursor, its slot can be evicted again */
+void pcm_cursor_reset(PCM_CACHE *c, PCM_CURSOR *cur);
+/* Cursors were cleared without being reset */
+void pcm_cache_unpin_all(PCM_CACHE *c);
+
+static inline Uint8 pcm_cache_read(PCM_CACHE *c, PCM_CURSOR *cur, Uint32 addr) {
+	if ((addr >> PCM_BLOCK_SHIFT) != cur->block)
+		pcm_cache_seek(c, cur, addr >> PCM_BLOCK_SHIFT);
+	return cur->data[addr & (PCM_BLOCK_SIZE - 1)];
+}
+
+#endif
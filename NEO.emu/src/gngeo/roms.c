@@ -15,6 +15,7 @@
 #include <strings.h>
 #include <string.h>
 #include <stdbool.h>
+#include <unistd.h>
 #include "roms.h"
 #include "emu.h"
 #include "memory.h"
@@ -25,6 +26,9 @@
 #include "unzip.h"
 
 #include "video.h"
+#include "lzblock.h"
+#include "parallel.h"
+#include "pcm_cache.h"
 #include "transpack.h"
 #include "conf.h"
 #include "resfile.h"
@@ -1140,30 +1144,36 @@ static int convert_roms_tile(Uint8 *g, int tileno) {
 
 }
 
-void convert_all_tile(GAME_ROMS *r) {
+/* Each range covers whole spr_usage words, 16 tiles apiece */
+static void convert_tile_range(void *arg, Uint32 start, Uint32 end) {
+	GAME_ROMS *r = arg;
 	Uint32 i;
-	allocate_region(&r->spr_usage, (r->tiles.size >> 11) * sizeof (Uint32), REGION_SPR_USAGE);
-	memset(r->spr_usage.p, 0, r->spr_usage.size);
-	for (i = 0; i < r->tiles.size >> 7; i++) {
+	for (i = start << 4; i < end << 4 && i < r->tiles.size >> 7; i++) {
 		((Uint32*) r->spr_usage.p)[i >> 4] |= convert_roms_tile(r->tiles.p, i);
 	}
 }
 
-void convert_all_char(Uint8 *Ptr, int Taille,
-		Uint8 *usage_ptr) {
-	int i, j;
-	unsigned char usage;
+void convert_all_tile(GAME_ROMS *r) {
+	allocate_region(&r->spr_usage, (r->tiles.size >> 11) * sizeof (Uint32), REGION_SPR_USAGE);
+	memset(r->spr_usage.p, 0, r->spr_usage.size);
+	gn_parallel_for(((r->tiles.size >> 7) + 15) >> 4, 256, convert_tile_range, r, -1);
+}
 
-	Uint8 *Src;
-	Uint8 *sav_src;
+typedef struct CHAR_CONVERT {
+	const Uint8 *src;
+	Uint8 *dst;
+	Uint8 *usage;
+} CHAR_CONVERT;
+
+static void convert_char_range(void *arg, Uint32 start, Uint32 end) {
+	CHAR_CONVERT *c = arg;
+	const Uint8 *Src = c->src + start * 32;
+	Uint8 *Ptr = c->dst + start * 32;
+	Uint8 *usage_ptr = c->usage + start;
+	unsigned char usage;
+	Uint32 i;
+	int j;
 
-	Src = (Uint8*) malloc(Taille);
-	if (!Src) {
-		logMsg("Not enought memory!!");
-		return;
-	}
-	sav_src = Src;
-	memcpy(Src, Ptr, Taille);
 #ifdef WORDS_BIGENDIAN
 #define CONVERT_TILE *Ptr++ = *(Src+8);\
 	             usage |= *(Src+8);\
@@ -1185,7 +1195,7 @@ void convert_all_char(Uint8 *Ptr, int Taille,
 		     usage |= *(Src+8);\
 		     Src++;
 #endif
-	for (i = Taille; i > 0; i -= 32) {
+	for (i = start; i < end; i++) {
 		usage = 0;
 		for (j = 0; j < 8; j++) {
 			CONVERT_TILE
@@ -1193,10 +1203,27 @@ void convert_all_char(Uint8 *Ptr, int Taille,
 		Src += 24;
 		*usage_ptr++ = usage;
 	}
-	free(sav_src);
 #undef CONVERT_TILE
 }
 
+void convert_all_char(Uint8 *Ptr, int Taille,
+		Uint8 *usage_ptr) {
+	CHAR_CONVERT c;
+	Uint8 *Src;
+
+	Src = (Uint8*) malloc(Taille);
+	if (!Src) {
+		logMsg("Not enought memory!!");
+		return;
+	}
+	memcpy(Src, Ptr, Taille);
+	c.src = Src;
+	c.dst = Ptr;
+	c.usage = usage_ptr;
+	gn_parallel_for((Taille + 31) / 32, 1024, convert_char_range, &c, -1);
+	free(Src);
+}
+
 static int init_roms(GAME_ROMS *r) {
 	int i = 0;
 	//printf("INIT ROM %s\n",r->info.name);
@@ -1371,6 +1398,7 @@ int dr_load_roms(GAME_ROMS *r, char *rom_path, char *name) {
 	ROM_DEF *drv;
 	int i;
 	int romsize;
+	Uint32 ticks, read_ms, decrypt_ms;
 
 	memset(r, 0, sizeof (GAME_ROMS));
 
@@ -1453,6 +1481,7 @@ int dr_load_roms(GAME_ROMS *r, char *rom_path, char *name) {
 	romsize = 0;
 	for (i = 0; i < drv->nb_romfile; i++)
 		romsize += drv->rom[i].size;
+	ticks = gn_ticks_ms();
 	gn_init_pbar(PBAR_ACTION_LOADROM, romsize);
 	for (i = 0; i < drv->nb_romfile; i++) {
 		//		gn_update_pbar(i, drv->nb_romfile);
@@ -1485,6 +1514,7 @@ int dr_load_roms(GAME_ROMS *r, char *rom_path, char *name) {
 
 	}
 	gn_terminate_pbar();
+	read_ms = gn_ticks_ms() - ticks;
 	/* Close/clean up */
 	gn_close_zip(gz);
 	if (gzp) gn_close_zip(gzp);
@@ -1510,8 +1540,13 @@ int dr_load_roms(GAME_ROMS *r, char *rom_path, char *name) {
 	free(iloadbuf);
 
 	/* Init rom and bios */
+	ticks = gn_ticks_ms();
 	init_roms(r);
+	decrypt_ms = gn_ticks_ms() - ticks;
+	ticks = gn_ticks_ms();
 	convert_all_tile(r);
+	logMsg("Load stages: read %u ms, decrypt %u ms, tile convert %u ms",
+			read_ms, decrypt_ms, gn_ticks_ms() - ticks);
 	return dr_load_bios(r);
 
 error1:
@@ -1530,6 +1565,7 @@ int dr_load_game(char *name) {
 	//GAME_ROMS rom;
 	char *rpath = CF_STR(cf_get_item_by_name("rompath"));
 	int rc;
+	Uint32 ticks;
 	logMsg("Loading %s/%s.zip\n", rpath, name);
 	memory.bksw_handler = 0;
 	memory.bksw_unscramble = NULL;
@@ -1548,8 +1584,10 @@ int dr_load_game(char *name) {
 	memcpy(memory.game_vector, memory.rom.cpu_m68k.p, 0x80);
 	memcpy(memory.rom.cpu_m68k.p, memory.rom.bios_m68k.p, 0x80);
 
+	ticks = gn_ticks_ms();
 	convert_all_char(memory.rom.game_sfix.p, memory.rom.game_sfix.size,
 			memory.fix_game_usage);
+	logMsg("Load stages: char convert %u ms", gn_ticks_ms() - ticks);
 
 	/* TODO: Move this somewhere else. */
 	init_video();
@@ -1560,6 +1598,41 @@ int dr_load_game(char *name) {
 
 #if defined(HAVE_LIBZ)//&& defined (HAVE_MMAP)
 
+/* Blocks compressed together before being written out in order */
+#define GNO_BATCH_BLOCKS 2048
+
+typedef struct GNO_BATCH {
+	const Uint8 *in;
+	Uint32 block_size;
+	Uint8 type;
+	Uint8 *out;
+	Uint32 out_stride;
+	Uint32 *out_len;
+} GNO_BATCH;
+
+static Uint32 gno_block_bound(Uint8 type, Uint32 block_size) {
+	if (type == GNO_LZ)
+		return LZ_BLOCK_BOUND(block_size);
+	/* Zlib compress output buffer need to be at least the size
+	 of inbuf + 0.1% + 12 byte */
+	return compressBound(block_size);
+}
+
+static void compress_gno_blocks(void *arg, Uint32 start, Uint32 end) {
+	GNO_BATCH *b = arg;
+	Uint32 i;
+	for (i = start; i < end; i++) {
+		const Uint8 *inbuf = b->in + i * b->block_size;
+		Uint8 *outbuf = b->out + i * b->out_stride;
+		if (b->type == GNO_LZ) {
+			b->out_len[i] = lz_compress_block(inbuf, b->block_size, outbuf, b->out_stride);
+		} else {
+			uLongf outlen = b->out_stride;
+			b->out_len[i] = compress(outbuf, &outlen, inbuf, b->block_size) == Z_OK ? outlen : 0;
+		}
+	}
+}
+
 static int dump_region(FILE *gno, const ROM_REGION *rom, Uint8 id, Uint8 type,
 		Uint32 block_size, uint verbose) {
 	if (rom->p == NULL)
@@ -1567,22 +1640,18 @@ static int dump_region(FILE *gno, const ROM_REGION *rom, Uint8 id, Uint8 type,
 	fwrite(&rom->size, sizeof (Uint32), 1, gno);
 	fwrite(&id, sizeof (Uint8), 1, gno);
 	fwrite(&type, sizeof (Uint8), 1, gno);
-	if (type == 0) {
+	if (type == GNO_RAW) {
 		if(verbose) logMsg("Dump %d %08x", id, rom->size);
 		fwrite(rom->p, rom->size, 1, gno);
 	} else {
 		Uint32 nb_block = rom->size / block_size;
 		Uint32 *block_offset;
-		Uint32 cur_offset = 0;
+		Uint32 cur_offset;
 		long offset_pos;
-		Uint32 i;
-		const Uint8 *inbuf = rom->p;
-		Uint8 *outbuf;
-		uLongf outbuf_len;
-		uLongf outlen;
-		Uint32 outlen32;
+		Uint32 i, j, nb_batch;
 		Uint32 cmpsize = 0;
-		int rc;
+		GNO_BATCH b;
+		int rc = true;
 		if(verbose) logMsg("nb_block=%d", nb_block);
 		fwrite(&block_size, sizeof (Uint32), 1, gno);
 		if ((rom->size & (block_size - 1)) != 0) {
@@ -1590,29 +1659,43 @@ static int dump_region(FILE *gno, const ROM_REGION *rom, Uint8 id, Uint8 type,
 					rom->size, block_size);
 		}
 		block_offset = malloc(nb_block * sizeof (Uint32));
-		/* Zlib compress output buffer need to be at least the size
-		 of inbuf + 0.1% + 12 byte */
-		outbuf_len = compressBound(block_size);
-		outbuf = malloc(outbuf_len);
+		b.block_size = block_size;
+		b.type = type;
+		b.out_stride = gno_block_bound(type, block_size);
+		b.out = malloc((size_t) b.out_stride * GNO_BATCH_BLOCKS);
+		b.out_len = malloc(GNO_BATCH_BLOCKS * sizeof (Uint32));
+		if (block_offset == NULL || b.out == NULL || b.out_len == NULL) {
+			free(block_offset);
+			free(b.out);
+			free(b.out_len);
+			return false;
+		}
 		offset_pos = ftell(gno);
 		fseek(gno, nb_block * 4 + 4, SEEK_CUR); /* Skip all the offset table + the total compressed size */
-
-		for (i = 0; i < nb_block; i++) {
-			cur_offset = ftell(gno);
-			block_offset[i] = cur_offset;
-			outlen = outbuf_len;
-			rc = compress(outbuf, &outlen, inbuf, block_size);
-			if(verbose) logMsg("%d %ld", rc, outlen);
-			//cur_offset += outlen;
-			cmpsize += outlen;
-			if(verbose) logMsg("cmpsize=%d %ld", cmpsize, (long int)sizeof (uLongf));
-			inbuf += block_size;
-			outlen32 = (Uint32) outlen;
-			fwrite(&outlen32, sizeof (Uint32), 1, gno);
-			if(verbose) logMsg("bank %d outlen=%d offset=%d", i, outlen32, cur_offset);
-			fwrite(outbuf, outlen, 1, gno);
+		cur_offset = ftell(gno);
+
+		for (i = 0; i < nb_block; i += nb_batch) {
+			b.in = rom->p + i * block_size;
+			nb_batch = nb_block - i;
+			if (nb_batch > GNO_BATCH_BLOCKS) nb_batch = GNO_BATCH_BLOCKS;
+			gn_parallel_for(nb_batch, 16, compress_gno_blocks, &b, -1);
+			/* Write the batch in order */
+			for (j = 0; j < nb_batch; j++) {
+				Uint32 outlen32 = b.out_len[j];
+				if (outlen32 == 0) {
+					logMsg("Error compressing bank %d", i + j);
+					rc = false;
+				}
+				block_offset[i + j] = cur_offset;
+				cur_offset += sizeof (Uint32) + outlen32;
+				cmpsize += outlen32;
+				fwrite(&outlen32, sizeof (Uint32), 1, gno);
+				if(verbose) logMsg("bank %d outlen=%d offset=%d", i + j, outlen32, block_offset[i + j]);
+				fwrite(b.out + j * b.out_stride, outlen32, 1, gno);
+			}
 		}
-		free(outbuf);
+		free(b.out);
+		free(b.out_len);
 		/* Now, write the offset table */
 		fseek(gno, offset_pos, SEEK_SET);
 		fwrite(block_offset, sizeof (Uint32), nb_block, gno);
@@ -1622,13 +1705,18 @@ static int dump_region(FILE *gno, const ROM_REGION *rom, Uint8 id, Uint8 type,
 		fseek(gno, 0, SEEK_END);
 		offset_pos = ftell(gno);
 		if(verbose) logMsg("currpos=%li", offset_pos);
+		return rc;
 	}
 	return true;
 }
 
+static Uint8 adpcm_gno_type(const ROM_REGION *rom) {
+	return (rom->size & (PCM_BLOCK_SIZE - 1)) ? GNO_RAW : GNO_LZ;
+}
+
 int dr_save_gno(GAME_ROMS *r, char *filename) {
 	FILE *gno;
-	char *fid = "gnodmpv1";
+	char *fid = "gnodmpv2";
 	char fname[9];
 	Uint8 nb_sec = 0;
 	int i;
@@ -1680,9 +1768,10 @@ int dr_save_gno(GAME_ROMS *r, char *filename) {
 	dump_region(gno, &r->cpu_m68k, REGION_MAIN_CPU_CARTRIDGE, 0, 0, 0);
 	dump_region(gno, &r->cpu_z80, REGION_AUDIO_CPU_CARTRIDGE, 0, 0, 0);
 	gn_update_pbar(1);
-	dump_region(gno, &r->adpcma, REGION_AUDIO_DATA_1, 0, 0, 0);
+	/* Compressed in blocks so the ADPCM roms can be streamed */
+	dump_region(gno, &r->adpcma, REGION_AUDIO_DATA_1, adpcm_gno_type(&r->adpcma), PCM_BLOCK_SIZE, 0);
 	if (r->adpcma.p != r->adpcmb.p)
-		dump_region(gno, &r->adpcmb, REGION_AUDIO_DATA_2, 0, 0, 0);
+		dump_region(gno, &r->adpcmb, REGION_AUDIO_DATA_2, adpcm_gno_type(&r->adpcmb), PCM_BLOCK_SIZE, 0);
 	gn_update_pbar(2);
 	dump_region(gno, &r->game_sfix, REGION_FIXED_LAYER_CARTRIDGE, 0, 0, 0);
 	dump_region(gno, &r->spr_usage, REGION_SPR_USAGE, 0, 0, 0);
@@ -1694,22 +1783,117 @@ int dr_save_gno(GAME_ROMS *r, char *filename) {
 		dump_region(gno, &r->bios_sfix, REGION_FIXED_LAYER_BIOS, 0, 0, 0);
 	}
 	gn_update_pbar(3);
-	/* TODO, there is a bug in the loading routine, only one compressed (type 1)
-	 * region can be present at the end of the file */
-	dump_region(gno, &r->tiles, REGION_SPRITES, 1, 4096, 0);
+	if (!dump_region(gno, &r->tiles, REGION_SPRITES, GNO_LZ, 4096, 0)) {
+		fclose(gno);
+		unlink(filename);
+		return false;
+	}
 
 
 	fclose(gno);
 	return true;
 }
 
-int read_region(FILE *gno, GAME_ROMS *roms) {
+/* Bytes the kernel could hand out without swapping, 0 if unknown. Linux and
+ * Android overcommit, so a successful malloc says nothing about this */
+static uint64 available_memory(void) {
+	uint64 avail = 0;
+	long page_size = sysconf(_SC_PAGESIZE);
+#ifdef __linux__
+	char line[128];
+	unsigned long long kb;
+	FILE *f = fopen("/proc/meminfo", "r");
+
+	if (f) {
+		/* MemAvailable counts reclaimable file caches, MemFree doesn't */
+		while (fgets(line, sizeof line, f)) {
+			if (sscanf(line, "MemAvailable: %llu kB", &kb) == 1) {
+				avail = (uint64) kb * 1024;
+				break;
+			}
+		}
+		fclose(f);
+		if (avail)
+			return avail;
+	}
+#endif
+#ifdef _SC_AVPHYS_PAGES
+	{
+		long avail_pages = sysconf(_SC_AVPHYS_PAGES);
+		if (page_size > 0 && avail_pages > 0)
+			avail = (uint64) avail_pages * page_size;
+	}
+#endif
+	return avail;
+}
+
+/* Sprite cache size for a compressed sprite region: half of the available
+ * memory, or an eighth of the physical memory when that's unknown */
+static Uint32 sprite_cache_budget(Uint32 size, Uint32 block_size) {
+	long page_size = sysconf(_SC_PAGESIZE);
+	long phys_pages = sysconf(_SC_PHYS_PAGES);
+	uint64 avail = available_memory();
+	uint64 budget = 16 * 1024 * 1024;
+
+	if (avail)
+		budget = avail / 2;
+	else if (page_size > 0 && phys_pages > 0)
+		budget = (uint64) phys_pages * page_size / 8;
+	if (budget > size) budget = size;
+	budget -= budget % block_size;
+	if (budget < block_size) budget = block_size;
+	return budget;
+}
+
+typedef struct GNO_LOAD {
+	int fd;
+	Uint8 type;
+	Uint32 block_size;
+	Uint32 *offset;
+	Uint8 *dest;
+	int error;
+} GNO_LOAD;
+
+/* Decompresses blocks [start, end) of a region into memory */
+static void load_gno_blocks(void *arg, Uint32 start, Uint32 end) {
+	GNO_LOAD *l = arg;
+	Uint32 in_size = gno_block_bound(l->type, l->block_size);
+	Uint8 *in_buf = malloc(in_size);
+	Uint32 i, cmp_size;
+	uLongf dst_size;
+	int rc;
+
+	if (in_buf == NULL) {
+		l->error = 1;
+		return;
+	}
+	for (i = start; i < end; i++) {
+		Uint8 *dst = l->dest + i * l->block_size;
+		if (pread(l->fd, &cmp_size, sizeof (Uint32), l->offset[i]) != sizeof (Uint32)
+				|| cmp_size > in_size
+				|| pread(l->fd, in_buf, cmp_size, l->offset[i] + sizeof (Uint32)) != cmp_size)
+			rc = 0;
+		else if (l->type == GNO_LZ)
+			rc = lz_decompress_block(in_buf, cmp_size, dst, l->block_size) == (int) l->block_size;
+		else {
+			dst_size = l->block_size;
+			rc = uncompress(dst, &dst_size, in_buf, cmp_size) == Z_OK;
+		}
+		if (!rc) {
+			logMsg("Error loading block %d\n", i);
+			l->error = 1;
+		}
+	}
+	free(in_buf);
+}
+
+/* version is the file's gnodmpv<n> number, GNO_LZ regions need v2 */
+int read_region(FILE *gno, GAME_ROMS *roms, int version) {
 	Uint32 size;
 	Uint8 lid, type;
 	ROM_REGION *r = NULL;
 	size_t totread = 0;
-	Uint32 cache_size[] = {64, 32, 24, 16, 8, 6, 4, 2, 1, 0};
-	int i = 0;
+	Uint32 cache_size;
 
 	/* Read region header */
 	totread = fread(&size, sizeof (Uint32), 1, gno);
@@ -1753,47 +1937,88 @@ int read_region(FILE *gno, GAME_ROMS *roms) {
 	}
 
 	logMsg("Read region %d %08X type %d\n", lid, size, type);
-	if (type == 0) {
-		/* TODO: Support ADPCM streaming for platform with less that 64MB of Mem */
+	if (type > GNO_LZ || (type == GNO_LZ && version < 2)) {
+		logMsg("Unknown region type\n");
+		return false;
+	}
+	if (type == GNO_RAW) {
 		allocate_region(r, size, lid);
 		logMsg("Load %d %08x\n", lid, r->size);
 		totread += fread(r->p, r->size, 1, gno);
 	} else {
 		Uint32 nb_block, block_size;
 		Uint32 cmp_size;
+		Uint32 *offset;
 		totread += fread(&block_size, sizeof (Uint32), 1, gno);
 		nb_block = size / block_size;
 
 		logMsg("Region size=%08X\n", size);
-		r->size = size;
-
-
-		memory.vid.spr_cache.offset = malloc(sizeof (Uint32) * nb_block);
-		totread += fread(memory.vid.spr_cache.offset, sizeof (Uint32), nb_block, gno);
-		memory.vid.spr_cache.gno = gno;
 
+		offset = malloc(sizeof (Uint32) * nb_block);
+		if (offset == NULL)
+			return false;
+		totread += fread(offset, sizeof (Uint32), nb_block, gno);
 		totread += fread(&cmp_size, sizeof (Uint32), 1, gno);
 
-		fseek(gno, cmp_size, SEEK_CUR);
-
-		/* TODO: Find the best cache size dynamically! */
-		for (i = 0; cache_size[i] != 0; i++) {
-			if (init_sprite_cache(cache_size[i]*1024 * 1024, block_size) == 0) {
-				logMsg("Cache size=%dMB\n", cache_size[i]);
-				break;
+		/* Skip the blocks, each one has its compressed size in front */
+		fseek(gno, cmp_size + nb_block * sizeof (Uint32), SEEK_CUR);
+
+		if (lid != REGION_SPRITES) {
+			GNO_LOAD l;
+			if ((lid == REGION_AUDIO_DATA_1 || lid == REGION_AUDIO_DATA_2)
+					&& gn_streamADPCM() && block_size == PCM_BLOCK_SIZE
+					&& init_pcm_cache(&pcm_cache[lid - REGION_AUDIO_DATA_1],
+						fileno(gno), type, size, offset) == 0) {
+				/* Left on disk, the YM2610 reads it through the cache */
+				r->size = size;
+				return true;
 			}
+			/* Anything else is needed whole, decompress it now */
+			allocate_region(r, size, lid);
+			l.fd = fileno(gno);
+			l.type = type;
+			l.block_size = block_size;
+			l.offset = offset;
+			l.dest = r->p;
+			l.error = 0;
+			if (r->p)
+				gn_parallel_for(nb_block, 16, load_gno_blocks, &l, -1);
+			free(offset);
+			return r->p != NULL && !l.error;
 		}
+
+		r->size = size;
+		memory.vid.spr_cache.offset = offset;
+		memory.vid.spr_cache.gno = gno;
+		memory.vid.spr_cache.codec = type;
+
+		cache_size = sprite_cache_budget(size, block_size);
+		if (init_sprite_cache(cache_size, block_size) != 0) {
+			logMsg("Can't allocate %dKB for the sprite cache\n", cache_size / 1024);
+			return false;
+		}
+		logMsg("Cache size=%dKB\n", cache_size / 1024);
 	}
 	return true;
 }
 
+/* Returns the version of a gnodmpv<n> id, 0 if it isn't one this build reads.
+ * v1 files only have zlib compressed regions, v2 added GNO_LZ */
+static int gno_id_version(const char *fid) {
+	if (strncmp(fid, "gnodmpv1", 8) == 0)
+		return 1;
+	if (strncmp(fid, "gnodmpv2", 8) == 0)
+		return 2;
+	return 0;
+}
+
 int dr_open_gno(char *filename) {
 	FILE *gno;
 	char fid[9]; // = "gnodmpv1";
 	char name[9] = {0,};
 	GAME_ROMS *r = &memory.rom;
 	Uint8 nb_sec;
-	int i;
+	int i, version;
 	char *a;
 	size_t totread = 0;
 
@@ -1811,7 +2036,8 @@ int dr_open_gno(char *filename) {
 	}
 
 	totread += fread(fid, 8, 1, gno);
-	if (strncmp(fid, "gnodmpv1", 8) != 0) {
+	version = gno_id_version(fid);
+	if (!version) {
 		fclose(gno);
 		sprintf(romerror, "Invalid GNO file");
 		return false;
@@ -1827,11 +2053,18 @@ int dr_open_gno(char *filename) {
 	gn_init_pbar(PBAR_ACTION_LOADGNO, nb_sec);
 	for (i = 0; i < nb_sec; i++) {
 		gn_update_pbar(i);
-		read_region(gno, r);
+		if (!read_region(gno, r, version)) {
+			gn_terminate_pbar();
+			/* dr_free_roms() closes it if the sprite cache already reads from it */
+			if (memory.vid.spr_cache.gno != gno)
+				fclose(gno);
+			sprintf(romerror, "Invalid GNO file");
+			return false;
+		}
 	}
 	gn_terminate_pbar();
 
-	if (r->adpcmb.p == NULL) {
+	if (r->adpcmb.size == 0) {
 		r->adpcmb.p = r->adpcma.p;
 		r->adpcmb.size = r->adpcma.size;
 	}
@@ -1869,7 +2102,7 @@ char *dr_gno_romname(char *filename) {
 		return NULL;
 
 	totread += fread(fid, 8, 1, gno);
-	if (strncmp(fid, "gnodmpv1", 8) != 0) {
+	if (!gno_id_version(fid)) {
 		fclose(gno);
 		logMsg("Invalid GNO file");
 		return NULL;
@@ -1917,6 +2150,8 @@ void dr_free_roms(GAME_ROMS *r) {
 	}
 
 	free_region(&r->adpcma);
+	free_pcm_cache(&pcm_cache[0]);
+	free_pcm_cache(&pcm_cache[1]);
 #endif
 
 	free_region(&r->bios_m68k);
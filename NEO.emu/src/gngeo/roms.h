@@ -19,6 +19,11 @@
 #define REGION_SPR_USAGE             10
 #define REGION_GAME_FIX_USAGE        11
 
+/* GNO region types, compressed ones name the codec of their blocks */
+#define GNO_RAW  0
+#define GNO_ZLIB 1
+#define GNO_LZ   2 /* gnodmpv2 only */
+
 #define HAS_CUSTOM_CPU_BIOS 0x1
 #define HAS_CUSTOM_AUDIO_BIOS 0x2
 #define HAS_CUSTOM_SFIX_BIOS 0x4
@@ -22,6 +22,8 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
 #include <zlib.h>
 #include "video.h"
 #include "memory.h"
@@ -30,6 +32,9 @@
 #include "screen.h"
 #include "frame_skip.h"
 #include "transpack.h"
+#include "roms.h"
+#include "lzblock.h"
+#include "video_simd.h"
 
 extern int neogeo_fix_bank_type;
 unsigned int neogeo_frame_counter;
@@ -132,14 +137,116 @@ static Uint16 fix_addr[40][32];
 static Uint8 fix_shift[40];
 
 
+/* Sprite bank decompression thread */
+#define MAX_SPR_JOBS 64 /* queued prefetches, power of 2 */
+
+static pthread_t spr_thread;
+static pthread_mutex_t spr_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t spr_job_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t spr_done_cond = PTHREAD_COND_INITIALIZER;
+static int spr_thread_running = 0;
+static int spr_quit = 0;
+static int spr_job[MAX_SPR_JOBS];
+static Uint32 spr_job_head = 0, spr_job_tail = 0;
+static int spr_max_jobs = 0;
+static Uint8 *spr_in_buf = NULL;
+
+static void load_sprite_bank(GFX_CACHE *gcache, int bank, int a, Uint8 *in_buf) {
+	int fd = fileno(gcache->gno);
+	Uint32 cmp_size = 0;
+	Uint8 *dst = gcache->data + a * gcache->slot_size;
+	uLongf dst_size = gcache->slot_size;
+	int rc;
+
+	/* pread keeps the file position shared by both threads out of the way */
+	if (pread(fd, &cmp_size, sizeof (Uint32), gcache->offset[bank]) != sizeof (Uint32)
+			|| cmp_size > gcache->in_size
+			|| pread(fd, in_buf, cmp_size, gcache->offset[bank] + sizeof (Uint32)) != cmp_size) {
+		logMsg("Error reading sprite bank %d\n", bank);
+		return;
+	}
+	if (gcache->codec == GNO_LZ)
+		rc = lz_decompress_block(in_buf, cmp_size, dst, gcache->slot_size) == gcache->slot_size;
+	else
+		rc = uncompress(dst, &dst_size, in_buf, cmp_size) == Z_OK;
+	if (!rc)
+		logMsg("Error loading sprite bank %d\n", bank);
+}
+
+static void *sprite_cache_thread(void *arg) {
+	GFX_CACHE *gcache = &memory.vid.spr_cache;
+	int a, bank;
+
+	pthread_mutex_lock(&spr_mutex);
+	for (;;) {
+		while (!spr_quit && spr_job_head == spr_job_tail)
+			pthread_cond_wait(&spr_job_cond, &spr_mutex);
+		if (spr_quit) break;
+		a = spr_job[spr_job_head++ & (MAX_SPR_JOBS - 1)];
+		/* The render path may have needed it first */
+		if (gcache->state[a] != SLOT_QUEUED) continue;
+		gcache->state[a] = SLOT_BUSY;
+		bank = gcache->usage[a];
+		pthread_mutex_unlock(&spr_mutex);
+		load_sprite_bank(gcache, bank, a, spr_in_buf);
+		pthread_mutex_lock(&spr_mutex);
+		gcache->state[a] = SLOT_READY;
+		pthread_cond_broadcast(&spr_done_cond);
+	}
+	pthread_mutex_unlock(&spr_mutex);
+	return NULL;
+}
+
+static void start_sprite_cache_thread(GFX_CACHE *gcache) {
+	/* Only worth it with a core to spare */
+	if (sysconf(_SC_NPROCESSORS_ONLN) < 2)
+		return;
+	spr_in_buf = malloc(gcache->in_size);
+	if (spr_in_buf == NULL)
+		return;
+	spr_quit = 0;
+	spr_job_head = spr_job_tail = 0;
+	/* Leave most of the cache to banks already drawn */
+	spr_max_jobs = gcache->max_slot / 4;
+	if (spr_max_jobs > MAX_SPR_JOBS) spr_max_jobs = MAX_SPR_JOBS;
+	if (spr_max_jobs == 0 || pthread_create(&spr_thread, NULL, sprite_cache_thread, NULL) != 0) {
+		free(spr_in_buf);
+		spr_in_buf = NULL;
+		return;
+	}
+	spr_thread_running = 1;
+}
+
+static void stop_sprite_cache_thread(void) {
+	if (!spr_thread_running)
+		return;
+	pthread_mutex_lock(&spr_mutex);
+	spr_quit = 1;
+	pthread_cond_signal(&spr_job_cond);
+	pthread_mutex_unlock(&spr_mutex);
+	pthread_join(spr_thread, NULL);
+	spr_thread_running = 0;
+	free(spr_in_buf);
+	spr_in_buf = NULL;
+}
+
 int init_sprite_cache(Uint32 size, Uint32 bsize) {
 	GFX_CACHE *gcache = &memory.vid.spr_cache;
-	int i;
+	Uint32 i;
+	int a;
 
 	if (gcache->data != NULL) { /* We allready have a cache, just reset it */
+		stop_sprite_cache_thread();
 		memset(gcache->ptr, 0, gcache->total_bank * sizeof (Uint8*));
-		for (i = 0; i < gcache->max_slot; i++)
-			gcache->usage[i] = -1;
+		memset(gcache->ref, 0, gcache->total_bank);
+		for (i = 0; i < gcache->total_bank; i++)
+			gcache->slot[i] = -1;
+		for (a = 0; a < gcache->max_slot; a++) {
+			gcache->usage[a] = -1;
+			gcache->state[a] = SLOT_READY;
+		}
+		gcache->hand = 0;
+		start_sprite_cache_thread(gcache);
 		return 0;
 	}
 
@@ -148,39 +255,55 @@ int init_sprite_cache(Uint32 size, Uint32 bsize) {
 	logMsg("gfx_size=%08x\n", memory.rom.tiles.size);
 	gcache->total_bank = memory.rom.tiles.size / gcache->slot_size;
 	gcache->ptr = malloc(gcache->total_bank * sizeof (Uint8*));
-	if (gcache->ptr == NULL)
+	gcache->slot = malloc(gcache->total_bank * sizeof (int));
+	gcache->ref = malloc(gcache->total_bank);
+	if (gcache->ptr == NULL || gcache->slot == NULL || gcache->ref == NULL) {
+		free_sprite_cache();
 		return 1;
+	}
 	//gcache->z_pos=malloc(gcache->total_bank*sizeof(unz_file_pos ));
 	memset(gcache->ptr, 0, gcache->total_bank * sizeof (Uint8*));
+	memset(gcache->ref, 0, gcache->total_bank);
+	for (i = 0; i < gcache->total_bank; i++)
+		gcache->slot[i] = -1;
 
 	gcache->size = size;
 	gcache->data = malloc(gcache->size);
 	if (gcache->data == NULL) {
-		free(gcache->ptr);
+		free_sprite_cache();
 		return 1;
 	}
 	logMsg("INIT CACHE %p\n", gcache->data);
 
-	//gcache->max_slot=((float)gcache->size/0x4000000)*TOTAL_GFX_BANK;
-	//gcache->max_slot=((float)gcache->size/memory.rom.tiles.size)*gcache->total_bank;
 	gcache->max_slot = size / gcache->slot_size;
-	//gcache->slot_size=0x4000000/TOTAL_GFX_BANK;
 	logMsg("Allocating %08x for gfx cache (%d %d slot)\n", gcache->size, gcache->max_slot, gcache->slot_size);
-	gcache->usage = malloc(gcache->max_slot * sizeof (Uint32));
-	for (i = 0; i < gcache->max_slot; i++)
-		gcache->usage[i] = -1;
+	gcache->usage = malloc(gcache->max_slot * sizeof (int));
+	gcache->state = malloc(gcache->max_slot);
+	for (a = 0; a < gcache->max_slot; a++) {
+		gcache->usage[a] = -1;
+		gcache->state[a] = SLOT_READY;
+	}
+	gcache->hand = 0;
+	gcache->hits = gcache->misses = gcache->stalls = gcache->prefetches = 0;
 	//printf("inbuf size= %d\n",compressBound(bsize));
 #ifdef WIZ
-	gcache->in_buf = malloc(bsize + 1024);
+	gcache->in_size = bsize + 1024;
 #else
-	gcache->in_buf = malloc(compressBound(bsize));
+	gcache->in_size = compressBound(bsize);
 #endif
+	if (gcache->in_size < LZ_BLOCK_BOUND(bsize))
+		gcache->in_size = LZ_BLOCK_BOUND(bsize);
+	gcache->in_buf = malloc(gcache->in_size);
+	start_sprite_cache_thread(gcache);
 	return 0;
 }
 
 void free_sprite_cache(void) {
 	GFX_CACHE *gcache = &memory.vid.spr_cache;
+	stop_sprite_cache_thread();
 	if (gcache->data) {
+		logMsg("Sprite cache: %u hits, %u misses, %u stalls, %u prefetches\n",
+				gcache->hits, gcache->misses, gcache->stalls, gcache->prefetches);
 		free(gcache->data);
 		gcache->data = NULL;
 	}
@@ -188,51 +311,179 @@ void free_sprite_cache(void) {
 		free(gcache->ptr);
 		gcache->ptr = NULL;
 	}
+	if (gcache->slot) {
+		free(gcache->slot);
+		gcache->slot = NULL;
+	}
+	if (gcache->ref) {
+		free(gcache->ref);
+		gcache->ref = NULL;
+	}
 	if (gcache->usage) {
 		free(gcache->usage);
 		gcache->usage = NULL;
 	}
+	if (gcache->state) {
+		free(gcache->state);
+		gcache->state = NULL;
+	}
 	if (gcache->in_buf) {
 		free(gcache->in_buf);
 		gcache->in_buf = NULL;
 	}
 }
 
+/* CLOCK replacement: banks drawn since the hand last passed get a second
+ * chance, slots still being decompressed are skipped. Must hold spr_mutex. */
+static int find_sprite_slot(GFX_CACHE *gcache) {
+	int n, a, bank;
+
+	for (n = 0; n < gcache->max_slot * 2; n++) {
+		a = gcache->hand;
+		if (++gcache->hand >= gcache->max_slot) gcache->hand = 0;
+		if (gcache->state[a] != SLOT_READY) continue;
+		bank = gcache->usage[a];
+		if (bank != -1 && gcache->ref[bank]) {
+			gcache->ref[bank] = 0;
+			continue;
+		}
+		return a;
+	}
+	return -1;
+}
+
+/* Evicts a slot for bank, -1 if all slots are being decompressed. Must hold spr_mutex. */
+static int alloc_sprite_slot(GFX_CACHE *gcache, int bank) {
+	int a = find_sprite_slot(gcache);
+
+	if (a == -1)
+		return -1;
+	if (gcache->usage[a] != -1) {
+		gcache->ptr[gcache->usage[a]] = NULL;
+		gcache->slot[gcache->usage[a]] = -1;
+	}
+	gcache->usage[a] = bank;
+	gcache->slot[bank] = a;
+	gcache->ref[bank] = 1;
+	return a;
+}
+
+/* Returns 1 if the render path had to wait for the bank in slot a */
+static int wait_sprite_slot(GFX_CACHE *gcache, int a) {
+	int stalled = 0;
+
+	pthread_mutex_lock(&spr_mutex);
+	if (gcache->state[a] == SLOT_QUEUED) {
+		/* Not started yet, don't wait behind the other queued banks */
+		gcache->state[a] = SLOT_BUSY;
+		pthread_mutex_unlock(&spr_mutex);
+		load_sprite_bank(gcache, gcache->usage[a], a, gcache->in_buf);
+		pthread_mutex_lock(&spr_mutex);
+		gcache->state[a] = SLOT_READY;
+		stalled = 1;
+	}
+	while (gcache->state[a] != SLOT_READY) {
+		stalled = 1;
+		pthread_cond_wait(&spr_done_cond, &spr_mutex);
+	}
+	pthread_mutex_unlock(&spr_mutex);
+	return stalled;
+}
+
 Uint8 *get_cached_sprite_ptr(Uint32 tileno) {
 	GFX_CACHE *gcache = &memory.vid.spr_cache;
-	static int pos = 0;
-	static int init = 1;
-	int tile_sh = ~((gcache->slot_size >> 7) - 1);
-
-	int bank = ((tileno & tile_sh) / (gcache->slot_size >> 7));
+	Uint32 bank = tileno / (gcache->slot_size >> 7);
 	int a;
-	int r;
-	Uint32 cmp_size;
-	uLongf dst_size;
 
+	/* tileno == nb_of_tiles gets through the callers' checks */
+	if (bank >= gcache->total_bank) bank = gcache->total_bank - 1;
+
+	gcache->ref[bank] = 1;
 	if (gcache->ptr[bank]) {
 		/* The bank is present in the cache */
+		gcache->hits++;
 		return gcache->ptr[bank];
 	}
-	/* We have to find a slot for this bank */
-	a = pos;
-	pos++;
-	if (pos >= gcache->max_slot) pos = 0;
-	//printf("Offset for bank is %d\n",gcache->offset[bank]);
-
-	fseek(gcache->gno, gcache->offset[bank], SEEK_SET);
-	r = fread(&cmp_size, sizeof (Uint32), 1, gcache->gno);
-	r = fread(gcache->in_buf, cmp_size, 1, gcache->gno);
-	dst_size = gcache->slot_size;
-	r = uncompress(gcache->data + a * gcache->slot_size, &dst_size, gcache->in_buf, cmp_size);
+
+	a = gcache->slot[bank];
+	if (a != -1) {
+		/* Prefetched, possibly still being decompressed */
+		if (wait_sprite_slot(gcache, a))
+			gcache->stalls++;
+		else
+			gcache->hits++;
+	} else {
+		/* We have to find a slot for this bank */
+		gcache->misses++;
+		pthread_mutex_lock(&spr_mutex);
+		while ((a = alloc_sprite_slot(gcache, bank)) == -1) {
+			gcache->stalls++;
+			pthread_cond_wait(&spr_done_cond, &spr_mutex);
+		}
+		pthread_mutex_unlock(&spr_mutex);
+		load_sprite_bank(gcache, bank, a, gcache->in_buf);
+	}
 
 	gcache->ptr[bank] = gcache->data + a * gcache->slot_size;
+	return gcache->ptr[bank];
+}
 
-	if (gcache->usage[a] != -1) {
-		gcache->ptr[gcache->usage[a]] = 0;
+/* Queues the bank holding tileno for the worker thread if it isn't cached */
+static void prefetch_sprite_bank(Uint32 tileno) {
+	GFX_CACHE *gcache = &memory.vid.spr_cache;
+	Uint32 bank = tileno / (gcache->slot_size >> 7);
+	int a;
+
+	if (bank >= gcache->total_bank || gcache->slot[bank] != -1)
+		return;
+
+	pthread_mutex_lock(&spr_mutex);
+	if ((int)(spr_job_tail - spr_job_head) < spr_max_jobs
+			&& (a = alloc_sprite_slot(gcache, bank)) != -1) {
+		gcache->state[a] = SLOT_QUEUED;
+		spr_job[spr_job_tail++ & (MAX_SPR_JOBS - 1)] = a;
+		gcache->prefetches++;
+		pthread_cond_signal(&spr_job_cond);
+	}
+	pthread_mutex_unlock(&spr_mutex);
+}
+
+static __inline__ Uint32 sprite_tileno(Uint32 tileno, Uint32 tileatr) {
+	if (memory.nb_of_tiles > 0x10000 && tileatr & 0x10) tileno += 0x10000;
+	if (memory.nb_of_tiles > 0x20000 && tileatr & 0x20) tileno += 0x20000;
+	if (memory.nb_of_tiles > 0x40000 && tileatr & 0x40) tileno += 0x40000;
+	return tileno;
+}
+
+/* Called when a tile attribute word of SCB1 is written, the tile is likely
+ * drawn in the next frame */
+void prefetch_sprite_tile(Uint32 vptr) {
+	if (!spr_thread_running)
+		return;
+	prefetch_sprite_bank(sprite_tileno(READ_WORD(&memory.vid.ram[(vptr & ~1) << 1]),
+			READ_WORD(&memory.vid.ram[vptr << 1])));
+}
+
+/* Queues the banks of every strip in the sprite list, so the worker thread
+ * decompresses them while the first sprites are drawn */
+static void prefetch_sprite_list(void) {
+	Uint8 *vidram = memory.vid.ram;
+	unsigned int count, offs, y, my = 0;
+	Uint32 t1;
+
+	if (!spr_thread_running)
+		return;
+	for (count = 0; count < 0x300; count += 2) {
+		t1 = READ_WORD(&vidram[0x10400 + count]);
+		/* Chained strips keep the height of the first one */
+		if (!(t1 & 0x40)) {
+			my = t1 & 0x3f;
+			if (my > 0x20) my = 0x20;
+		}
+		offs = count << 6;
+		for (y = 0; y < my; y++, offs += 4)
+			prefetch_sprite_bank(sprite_tileno(READ_WORD(&vidram[offs]), READ_WORD(&vidram[offs + 2])));
 	}
-	gcache->usage[a] = bank;
-	return gcache->ptr[bank];
 }
 
 static void fix_value_init(void) {
@@ -260,6 +511,43 @@ static void fix_value_init(void) {
 #define PUTPIXEL(dst,src) dst=BLEND16_25(src,dst)
 #include "video_template.h"
 
+static void draw_fix_char_c(const Uint32 *gfxdata, const Uint32 *paldata,
+		Uint16 *br, int pitch) {
+	unsigned int myword;
+	unsigned char col;
+	int yy;
+
+	for (yy = 0; yy < 8; yy++) {
+		myword = gfxdata[yy];
+		col = (myword >> 28)&0xf;
+		if (col) br[7] = paldata[col];
+		col = (myword >> 24)&0xf;
+		if (col) br[6] = paldata[col];
+		col = (myword >> 20)&0xf;
+		if (col) br[5] = paldata[col];
+		col = (myword >> 16)&0xf;
+		if (col) br[4] = paldata[col];
+		col = (myword >> 12)&0xf;
+		if (col) br[3] = paldata[col];
+		col = (myword >> 8)&0xf;
+		if (col) br[2] = paldata[col];
+		col = (myword >> 4)&0xf;
+		if (col) br[1] = paldata[col];
+		col = (myword >> 0)&0xf;
+		if (col) br[0] = paldata[col];
+		br += pitch;
+	}
+}
+
+const TILE_BLITTER c_tile_blitter = {
+	"C",
+	{ draw_tile, NULL, draw_tile_25, draw_tile_50 },
+	{ draw_scanline_tile, NULL, draw_scanline_tile_25, draw_scanline_tile_50 },
+	draw_fix_char_c
+};
+
+TILE_BLITTER tile_blitter;
+
 #ifdef PROCESSOR_ARM
 
 static __inline__ void draw_tile_arm(unsigned int tileno, int sx, int sy, int zx, int zy,
@@ -324,11 +612,8 @@ static __inline__ void draw_tile_arm(unsigned int tileno, int sx, int sy, int zx
 #endif
 
 static __inline__ void draw_fix_char(unsigned char *buf, int start, int end) {
-	unsigned int *gfxdata, myword;
-	int x, y, yy;
-	unsigned char col;
+	int x, y;
 	unsigned short *br;
-	unsigned int *paldata;
 	unsigned int byte1, byte2;
 	int banked, garouoffsets[32];
 	GN_Rect clip;
@@ -386,34 +671,13 @@ static __inline__ void draw_fix_char(unsigned char *buf, int start, int end) {
 			if ((byte1 >= (memory.rom.game_sfix.size >> 5)) || (fix_usage[byte1] == 0x00)) continue;
 
 			br = (unsigned short*) buf + ((y << 3)) * buffer->w + (x << 3) + 16;
-#ifdef PROCESSOR_ARM
+#if defined(PROCESSOR_ARM) && !defined(HAVE_SIMD_BLITTER)
 			draw_one_char_arm(byte1, byte2, br);
-#elif I386_ASM
+#elif defined(I386_ASM) && !defined(HAVE_SIMD_BLITTER)
 			draw_one_char_i386(byte1, byte2, br);
 #else
-			paldata = (unsigned int *) &current_pc_pal[16 * byte2];
-			gfxdata = (unsigned int *) &current_fix[ byte1 << 5];
-
-			for (yy = 0; yy < 8; yy++) {
-				myword = gfxdata[yy];
-				col = (myword >> 28)&0xf;
-				if (col) br[7] = paldata[col];
-				col = (myword >> 24)&0xf;
-				if (col) br[6] = paldata[col];
-				col = (myword >> 20)&0xf;
-				if (col) br[5] = paldata[col];
-				col = (myword >> 16)&0xf;
-				if (col) br[4] = paldata[col];
-				col = (myword >> 12)&0xf;
-				if (col) br[3] = paldata[col];
-				col = (myword >> 8)&0xf;
-				if (col) br[2] = paldata[col];
-				col = (myword >> 4)&0xf;
-				if (col) br[1] = paldata[col];
-				col = (myword >> 0)&0xf;
-				if (col) br[0] = paldata[col];
-				br += buffer->w;
-			}
+			tile_blitter.draw_fix_char((const Uint32 *) &current_fix[byte1 << 5],
+					&current_pc_pal[16 * byte2], br, buffer->w);
 #endif
 
 		}
@@ -434,6 +698,9 @@ void draw_screen(void) {
 	GN_FillRect(buffer, NULL, current_pc_pal[4095]);
 	GN_LockSurface(buffer);
 
+	if (memory.vid.spr_cache.data)
+		prefetch_sprite_list();
+
 	/* Draw sprites */
 	for (count = 0; count < 0x300; count += 2) {
 		t3 = READ_WORD(&vidram[0x10000 + count]);
@@ -589,14 +856,14 @@ void draw_screen(void) {
 				}
 
 
-#ifdef PROCESSOR_ARM
+#if defined(PROCESSOR_ARM) && !defined(HAVE_SIMD_BLITTER)
 				mem_gfx = memory.rom.tiles.p;
 				//if (memory.pen_usage[tileno]!=TILE_INVISIBLE)
 				if (penusage != TILE_INVISIBLE)
 					draw_tile_arm(tileno, sx + 16, sy, rzx, yskip, tileatr >> 8,
 						tileatr & 0x01, tileatr & 0x02,
 						(unsigned char*) buffer->pixels);
-#elif I386_ASM
+#elif defined(I386_ASM) && !defined(HAVE_SIMD_BLITTER)
 				mem_gfx = &memory.rom.tiles.p;
 				//switch (memory.pen_usage[tileno]) {
 				switch (penusage) {
@@ -622,33 +889,10 @@ void draw_screen(void) {
 						break;
 				}
 #else
-				switch (penusage) {
-					case TILE_NORMAL:
-						draw_tile(tileno, sx + 16, sy, rzx, yskip, tileatr >> 8,
-								tileatr & 0x01, tileatr & 0x02,
-								(unsigned char*) buffer->pixels);
-						break;
-					case TILE_TRANSPARENT50:
-						draw_tile_50(tileno, sx + 16, sy, rzx, yskip, tileatr >> 8,
-								tileatr & 0x01, tileatr & 0x02,
-								(unsigned char*) buffer->pixels);
-						break;
-					case TILE_TRANSPARENT25:
-						draw_tile_25(tileno, sx + 16, sy, rzx, yskip, tileatr >> 8,
-								tileatr & 0x01, tileatr & 0x02,
-								(unsigned char*) buffer->pixels);
-						break;
-						/*
-							default:
-								{
-									SDL_Rect r={sx+16,sy,rzx,yskip};
-									SDL_FillRect(buffer,&r,0xFFAA);
-								}
-								//((Uint16*)(buffer->pixels))[sx+16+sy*356]=0xFFFF;
-                    
-								break;
-						 */
-				}
+				if (penusage != TILE_INVISIBLE)
+					tile_blitter.draw_tile[penusage](tileno, sx + 16, sy, rzx, yskip, tileatr >> 8,
+							tileatr & 0x01, tileatr & 0x02,
+							(unsigned char*) buffer->pixels);
 #endif
 			}
 
@@ -696,6 +940,9 @@ void draw_screen_scanline(int start_line, int end_line, int refresh) {
 
 	GN_FillRect(buffer, &clear_rect, current_pc_pal[4095]);
 
+	if (memory.vid.spr_cache.data && start_line == 0)
+		prefetch_sprite_list();
+
 	/* Draw sprites */
 	for (count = 0; count < 0x300; count += 2) {
 
@@ -808,9 +1055,9 @@ void draw_screen_scanline(int start_line, int end_line, int refresh) {
 				tileno = (tileno & ((memory.vid.spr_cache.slot_size >> 7) - 1));
 			}
 
+#if defined(I386_ASM) && !defined(HAVE_SIMD_BLITTER)
+			mem_gfx = &memory.rom.tiles.p;
 			switch (penusage) {
-#ifdef I386_ASM
-					mem_gfx = &memory.rom.tiles.p;
 				case TILE_NORMAL:
 					draw_scanline_tile_i386_norm(tileno, yoffs, sx + 16, yy, zx, tileatr >> 8,
 							tileatr & 0x01, (unsigned char*) buffer->pixels);
@@ -823,21 +1070,12 @@ void draw_screen_scanline(int start_line, int end_line, int refresh) {
 					draw_scanline_tile_25(tileno, yoffs, sx + 16, yy, zx, tileatr >> 8,
 							tileatr & 0x01, (unsigned char*) buffer->pixels);
 					break;
+			}
 #else
-				case TILE_NORMAL:
-					draw_scanline_tile(tileno, yoffs, sx + 16, yy, zx, tileatr >> 8,
-							tileatr & 0x01, (unsigned char*) buffer->pixels);
-					break;
-				case TILE_TRANSPARENT50:
-					draw_scanline_tile_50(tileno, yoffs, sx + 16, yy, zx, tileatr >> 8,
-							tileatr & 0x01, (unsigned char*) buffer->pixels);
-					break;
-				case TILE_TRANSPARENT25:
-					draw_scanline_tile_25(tileno, yoffs, sx + 16, yy, zx, tileatr >> 8,
-							tileatr & 0x01, (unsigned char*) buffer->pixels);
-					break;
+			if (penusage != TILE_INVISIBLE)
+				tile_blitter.draw_scanline_tile[penusage](tileno, yoffs, sx + 16, yy, zx, tileatr >> 8,
+						tileatr & 0x01, (unsigned char*) buffer->pixels);
 #endif
-			}
 
 
 		}
@@ -856,6 +1094,17 @@ void draw_screen_scanline(int start_line, int end_line, int refresh) {
 	}
 }
 
+/* The C blitter stays in use when the cpu has none of the SIMD ones */
+static void init_tile_blitter(void) {
+	const TILE_BLITTER *simd[4];
+
+	if (get_simd_blitters(simd, 4) > 0)
+		tile_blitter = *simd[0];
+	else
+		tile_blitter = c_tile_blitter;
+	logMsg("Using %s tile blitter", tile_blitter.name);
+}
+
 void init_video(void) {
 	logMsg("running init_video");
 #ifdef PROCESSOR_ARM
@@ -871,4 +1120,5 @@ void init_video(void) {
 #endif
 	fix_value_init();
 	memory.vid.modulo = 1;
+	init_tile_blitter();
 }
@@ -32,15 +32,28 @@ typedef struct gfx_cache {
 	Uint8 *data;  /* The cache */
 	Uint32 size;  /* Tha allocated size of the cache */      
 	Uint32 total_bank;  /* total number of rom bank */
-	Uint8 **ptr/*[TOTAL_GFX_BANK]*/; /* ptr[i] Contain a pointer to cached data for bank i */
+	Uint8 **ptr/*[TOTAL_GFX_BANK]*/; /* ptr[i] Contain a pointer to cached data for bank i, once decompressed */
 	int max_slot; /* Maximal numer of bank that can be cached (depend on cache size) */
 	int slot_size;
-	int *usage;   /* contain index to the banks in used order */
+	int *usage;   /* bank held by each slot, -1 if free */
+	int *slot;    /* slot holding each bank, -1 if not cached */
+	Uint8 *ref;   /* set when a bank is drawn, cleared as the clock hand passes */
+	Uint8 *state; /* SLOT_READY, or SLOT_QUEUED/SLOT_BUSY while being decompressed */
+	int hand;     /* next slot considered for eviction */
 	FILE *gno;
     Uint32 *offset;
     Uint8* in_buf;
+    Uint32 in_size;
+	Uint8 codec;  /* GNO_ZLIB or GNO_LZ */
+	/* statistics */
+	Uint32 hits;       /* bank was cached or prefetched in time */
+	Uint32 misses;     /* bank decompressed on the render path */
+	Uint32 stalls;     /* render path waited for a prefetch */
+	Uint32 prefetches; /* banks queued for the worker thread */
 }GFX_CACHE;
 
+enum { SLOT_READY, SLOT_QUEUED, SLOT_BUSY };
+
 typedef struct VIDEO {
 	/* Video Ram&Pal */
 	Uint8 ram[0x20000];
@@ -81,5 +94,6 @@ void draw_screen(void);
 // void show_cache(void);
 int init_sprite_cache(Uint32 size,Uint32 bsize);
 void free_sprite_cache(void);
+void prefetch_sprite_tile(Uint32 vptr);
 
 #endif
@@ -0,0 +1,374 @@
+/*  This file is part of NEO.emu.
+
+	NEO.emu is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	NEO.emu is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with NEO.emu.  If not, see <http://www.gnu.org/licenses/> */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "video_simd.h"
+
+#ifdef HAVE_SIMD_BLITTER
+
+#include <string.h>
+#include "memory.h"
+#include "screen.h"
+
+/* Rows are drawn by reading and writing back all 16 pixels, those outside of
+ * a zoomed tile keep their value. Sprites are only drawn when they fit in the
+ * 352 pixel wide buffer, so the row stays inside it. */
+
+enum { BLIT_NORMAL, BLIT_50, BLIT_25 };
+
+/* Source pixel of each pixel of a zoomed row, 0x80 past its width. Both
+ * pshufb and vtbl give 0 for those, a transparent pixel */
+static Uint8 zoom_shuffle[16][16] __attribute__ ((aligned (16)));
+
+static void init_zoom_shuffle(void) {
+	int zx, x, n;
+
+	for (zx = 0; zx < 16; zx++) {
+		n = 0;
+		for (x = 0; x < 16; x++)
+			if (ddaxskip[zx][x])
+				zoom_shuffle[zx][n++] = x;
+		while (n < 16)
+			zoom_shuffle[zx][n++] = 0x80;
+	}
+}
+
+#if defined(__i386__) || defined(__x86_64__)
+
+#include <immintrin.h>
+
+#ifdef __SSE2__
+#define SSE2_TARGET
+#else
+#define SSE2_TARGET __attribute__ ((target ("sse2")))
+#endif
+#define AVX2_TARGET __attribute__ ((target ("avx2")))
+
+/* SSE2 has no byte shuffle, colors are looked up one by one */
+
+SSE2_TARGET static __inline__ __m128i sse2_blend_25(__m128i p, __m128i d) {
+	const __m128i m6 = _mm_set1_epi16(0x3f), m5 = _mm_set1_epi16(0x1f);
+	const __m128i a = _mm_set1_epi16(63);
+	__m128i pr = _mm_slli_epi16(_mm_srli_epi16(p, 11), 3);
+	__m128i pg = _mm_slli_epi16(_mm_and_si128(_mm_srli_epi16(p, 5), m6), 2);
+	__m128i pb = _mm_slli_epi16(_mm_and_si128(p, m5), 3);
+	__m128i dr = _mm_slli_epi16(_mm_srli_epi16(d, 11), 3);
+	__m128i dg = _mm_slli_epi16(_mm_and_si128(_mm_srli_epi16(d, 5), m6), 2);
+	__m128i db = _mm_slli_epi16(_mm_and_si128(d, m5), 3);
+
+	/* same as alpha_blend(p, d, 63) */
+	pr = _mm_add_epi16(_mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(dr, pr), a), 8), pr);
+	pg = _mm_add_epi16(_mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(dg, pg), a), 8), pg);
+	pb = _mm_add_epi16(_mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(db, pb), a), 8), pb);
+	return _mm_or_si128(_mm_or_si128(_mm_slli_epi16(_mm_srli_epi16(pr, 3), 11),
+			_mm_slli_epi16(_mm_srli_epi16(pg, 2), 5)), _mm_srli_epi16(pb, 3));
+}
+
+/* Puts pixels p over d where mask is clear */
+SSE2_TARGET static __inline__ __m128i sse2_put(__m128i p, __m128i d, __m128i mask, int mode) {
+	const __m128i m50 = _mm_set1_epi16(0xf7de);
+
+	if (mode == BLIT_50)
+		p = _mm_add_epi16(_mm_srli_epi16(_mm_and_si128(p, m50), 1),
+				_mm_srli_epi16(_mm_and_si128(d, m50), 1));
+	else if (mode == BLIT_25)
+		p = sse2_blend_25(p, d);
+	return _mm_or_si128(_mm_andnot_si128(mask, p), _mm_and_si128(mask, d));
+}
+
+/* Color indexes of 16 pixels from 8 bytes */
+SSE2_TARGET static __inline__ __m128i sse2_unpack(uint64 bytes, int hi_first) {
+	__m128i b = _mm_loadl_epi64((const __m128i *) &bytes);
+	__m128i lo = _mm_and_si128(b, _mm_set1_epi8(0x0f));
+	__m128i hi = _mm_and_si128(_mm_srli_epi16(b, 4), _mm_set1_epi8(0x0f));
+	return hi_first ? _mm_unpacklo_epi8(hi, lo) : _mm_unpacklo_epi8(lo, hi);
+}
+
+SSE2_TARGET static __inline__ const Uint32 *sse2_load_pal(const Uint32 *paldata) {
+	return paldata;
+}
+
+SSE2_TARGET static __inline__ void sse2_row(Uint16 *br, uint64 bytes, int hi_first,
+		const Uint8 *zoom, const Uint32 *pal, int mode) {
+	Uint8 col[16];
+	__m128i p0, p1, mask;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		Uint8 b = bytes >> (i << 3);
+		col[i * 2] = hi_first ? b >> 4 : b & 0x0f;
+		col[i * 2 + 1] = hi_first ? b & 0x0f : b >> 4;
+	}
+	if (zoom) {
+		Uint8 src[16];
+		memcpy(src, col, 16);
+		for (i = 0; i < 16; i++)
+			col[i] = (zoom[i] & 0x80) ? 0 : src[zoom[i]];
+	}
+	p0 = _mm_setr_epi16(pal[col[0]], pal[col[1]], pal[col[2]], pal[col[3]],
+			pal[col[4]], pal[col[5]], pal[col[6]], pal[col[7]]);
+	p1 = _mm_setr_epi16(pal[col[8]], pal[col[9]], pal[col[10]], pal[col[11]],
+			pal[col[12]], pal[col[13]], pal[col[14]], pal[col[15]]);
+	mask = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) col), _mm_setzero_si128());
+	_mm_storeu_si128((__m128i *) br, sse2_put(p0, _mm_loadu_si128((const __m128i *) br),
+			_mm_unpacklo_epi8(mask, mask), mode));
+	_mm_storeu_si128((__m128i *) (br + 8), sse2_put(p1, _mm_loadu_si128((const __m128i *) (br + 8)),
+			_mm_unpackhi_epi8(mask, mask), mode));
+}
+
+SSE2_TARGET static __inline__ void sse2_char_row(Uint16 *br, Uint32 word, const Uint32 *pal) {
+	Uint8 col[16] __attribute__ ((aligned (16)));
+	Uint16 pix[8] __attribute__ ((aligned (16)));
+	__m128i mask;
+	int i;
+
+	_mm_store_si128((__m128i *) col, sse2_unpack(word, 0));
+	for (i = 0; i < 8; i++)
+		pix[i] = pal[col[i]];
+	mask = _mm_cmpeq_epi8(_mm_load_si128((const __m128i *) col), _mm_setzero_si128());
+	_mm_storeu_si128((__m128i *) br, sse2_put(_mm_load_si128((const __m128i *) pix),
+			_mm_loadu_si128((const __m128i *) br), _mm_unpacklo_epi8(mask, mask), BLIT_NORMAL));
+}
+
+#define RENAME(name) sse2_##name
+#define SIMD_TARGET SSE2_TARGET
+#define SIMD_PAL const Uint32 *
+#include "video_simd_template.h"
+
+/* AVX2 looks the colors up with pshufb in a table of their low and high
+ * bytes, and handles the 16 pixels of a row in one register */
+
+typedef struct AVX2_PAL {
+	__m128i lo, hi;
+} AVX2_PAL;
+
+AVX2_TARGET static __inline__ __m256i avx2_blend_25(__m256i p, __m256i d) {
+	const __m256i m6 = _mm256_set1_epi16(0x3f), m5 = _mm256_set1_epi16(0x1f);
+	const __m256i a = _mm256_set1_epi16(63);
+	__m256i pr = _mm256_slli_epi16(_mm256_srli_epi16(p, 11), 3);
+	__m256i pg = _mm256_slli_epi16(_mm256_and_si256(_mm256_srli_epi16(p, 5), m6), 2);
+	__m256i pb = _mm256_slli_epi16(_mm256_and_si256(p, m5), 3);
+	__m256i dr = _mm256_slli_epi16(_mm256_srli_epi16(d, 11), 3);
+	__m256i dg = _mm256_slli_epi16(_mm256_and_si256(_mm256_srli_epi16(d, 5), m6), 2);
+	__m256i db = _mm256_slli_epi16(_mm256_and_si256(d, m5), 3);
+
+	pr = _mm256_add_epi16(_mm256_srai_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(dr, pr), a), 8), pr);
+	pg = _mm256_add_epi16(_mm256_srai_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(dg, pg), a), 8), pg);
+	pb = _mm256_add_epi16(_mm256_srai_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(db, pb), a), 8), pb);
+	return _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi16(_mm256_srli_epi16(pr, 3), 11),
+			_mm256_slli_epi16(_mm256_srli_epi16(pg, 2), 5)), _mm256_srli_epi16(pb, 3));
+}
+
+AVX2_TARGET static __inline__ AVX2_PAL avx2_load_pal(const Uint32 *paldata) {
+	const __m128i m16 = _mm_set1_epi32(0xffff), m8 = _mm_set1_epi16(0xff);
+	__m128i c0 = _mm_packus_epi32(_mm_and_si128(_mm_loadu_si128((const __m128i *) paldata), m16),
+			_mm_and_si128(_mm_loadu_si128((const __m128i *) (paldata + 4)), m16));
+	__m128i c1 = _mm_packus_epi32(_mm_and_si128(_mm_loadu_si128((const __m128i *) (paldata + 8)), m16),
+			_mm_and_si128(_mm_loadu_si128((const __m128i *) (paldata + 12)), m16));
+	AVX2_PAL pal;
+
+	pal.lo = _mm_packus_epi16(_mm_and_si128(c0, m8), _mm_and_si128(c1, m8));
+	pal.hi = _mm_packus_epi16(_mm_srli_epi16(c0, 8), _mm_srli_epi16(c1, 8));
+	return pal;
+}
+
+AVX2_TARGET static __inline__ void avx2_put(Uint16 *br, __m128i col, AVX2_PAL pal, int mode) {
+	const __m256i m50 = _mm256_set1_epi16(0xf7de);
+	__m128i lo = _mm_shuffle_epi8(pal.lo, col);
+	__m128i hi = _mm_shuffle_epi8(pal.hi, col);
+	__m256i p = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi8(lo, hi)),
+			_mm_unpackhi_epi8(lo, hi), 1);
+	__m256i d = _mm256_loadu_si256((const __m256i *) br);
+	__m256i mask = _mm256_cmpeq_epi16(_mm256_cvtepu8_epi16(col), _mm256_setzero_si256());
+
+	if (mode == BLIT_50)
+		p = _mm256_add_epi16(_mm256_srli_epi16(_mm256_and_si256(p, m50), 1),
+				_mm256_srli_epi16(_mm256_and_si256(d, m50), 1));
+	else if (mode == BLIT_25)
+		p = avx2_blend_25(p, d);
+	_mm256_storeu_si256((__m256i *) br, _mm256_blendv_epi8(p, d, mask));
+}
+
+AVX2_TARGET static __inline__ void avx2_row(Uint16 *br, uint64 bytes, int hi_first,
+		const Uint8 *zoom, AVX2_PAL pal, int mode) {
+	__m128i col = sse2_unpack(bytes, hi_first);
+
+	if (zoom)
+		col = _mm_shuffle_epi8(col, _mm_load_si128((const __m128i *) zoom));
+	avx2_put(br, col, pal, mode);
+}
+
+AVX2_TARGET static __inline__ void avx2_char_row(Uint16 *br, Uint32 word, AVX2_PAL pal) {
+	__m128i col = sse2_unpack(word, 0);
+	__m128i lo = _mm_shuffle_epi8(pal.lo, col);
+	__m128i hi = _mm_shuffle_epi8(pal.hi, col);
+	__m128i d = _mm_loadu_si128((const __m128i *) br);
+	__m128i mask = _mm_cmpeq_epi16(_mm_cvtepu8_epi16(col), _mm_setzero_si128());
+
+	_mm_storeu_si128((__m128i *) br, _mm_blendv_epi8(_mm_unpacklo_epi8(lo, hi), d, mask));
+}
+
+#define RENAME(name) avx2_##name
+#define SIMD_TARGET AVX2_TARGET
+#define SIMD_PAL AVX2_PAL
+#include "video_simd_template.h"
+
+static const TILE_BLITTER sse2_blitter = {
+	"SSE2",
+	{ sse2_draw_tile, NULL, sse2_draw_tile_25, sse2_draw_tile_50 },
+	{ sse2_draw_scanline_tile, NULL, sse2_draw_scanline_tile_25, sse2_draw_scanline_tile_50 },
+	sse2_draw_fix_char
+};
+
+static const TILE_BLITTER avx2_blitter = {
+	"AVX2",
+	{ avx2_draw_tile, NULL, avx2_draw_tile_25, avx2_draw_tile_50 },
+	{ avx2_draw_scanline_tile, NULL, avx2_draw_scanline_tile_25, avx2_draw_scanline_tile_50 },
+	avx2_draw_fix_char
+};
+
+int get_simd_blitters(const TILE_BLITTER **list, int max) {
+	int n = 0;
+
+	init_zoom_shuffle();
+	__builtin_cpu_init();
+	if (n < max && __builtin_cpu_supports("avx2"))
+		list[n++] = &avx2_blitter;
+	if (n < max && __builtin_cpu_supports("sse2"))
+		list[n++] = &sse2_blitter;
+	return n;
+}
+
+#else /* NEON */
+
+#include <arm_neon.h>
+
+typedef struct NEON_PAL {
+	uint8x16_t lo, hi;
+} NEON_PAL;
+
+#ifdef __aarch64__
+#define neon_lookup(table, col) vqtbl1q_u8(table, col)
+#else
+static __inline__ uint8x16_t neon_lookup(uint8x16_t table, uint8x16_t col) {
+	uint8x8x2_t t = { { vget_low_u8(table), vget_high_u8(table) } };
+	return vcombine_u8(vtbl2_u8(t, vget_low_u8(col)), vtbl2_u8(t, vget_high_u8(col)));
+}
+#endif
+
+static __inline__ uint16x8_t neon_blend_25(uint16x8_t p, uint16x8_t d) {
+	const uint16x8_t m6 = vdupq_n_u16(0x3f), m5 = vdupq_n_u16(0x1f);
+	int16x8_t pr = vreinterpretq_s16_u16(vshlq_n_u16(vshrq_n_u16(p, 11), 3));
+	int16x8_t pg = vreinterpretq_s16_u16(vshlq_n_u16(vandq_u16(vshrq_n_u16(p, 5), m6), 2));
+	int16x8_t pb = vreinterpretq_s16_u16(vshlq_n_u16(vandq_u16(p, m5), 3));
+	int16x8_t dr = vreinterpretq_s16_u16(vshlq_n_u16(vshrq_n_u16(d, 11), 3));
+	int16x8_t dg = vreinterpretq_s16_u16(vshlq_n_u16(vandq_u16(vshrq_n_u16(d, 5), m6), 2));
+	int16x8_t db = vreinterpretq_s16_u16(vshlq_n_u16(vandq_u16(d, m5), 3));
+	uint16x8_t r, g, b;
+
+	r = vreinterpretq_u16_s16(vaddq_s16(vshrq_n_s16(vmulq_n_s16(vsubq_s16(dr, pr), 63), 8), pr));
+	g = vreinterpretq_u16_s16(vaddq_s16(vshrq_n_s16(vmulq_n_s16(vsubq_s16(dg, pg), 63), 8), pg));
+	b = vreinterpretq_u16_s16(vaddq_s16(vshrq_n_s16(vmulq_n_s16(vsubq_s16(db, pb), 63), 8), pb));
+	return vorrq_u16(vorrq_u16(vshlq_n_u16(vshrq_n_u16(r, 3), 11),
+			vshlq_n_u16(vshrq_n_u16(g, 2), 5)), vshrq_n_u16(b, 3));
+}
+
+/* Puts pixels p over d where mask is clear */
+static __inline__ uint16x8_t neon_put(uint16x8_t p, uint16x8_t d, uint16x8_t mask, int mode) {
+	const uint16x8_t m50 = vdupq_n_u16(0xf7de);
+
+	if (mode == BLIT_50)
+		p = vaddq_u16(vshrq_n_u16(vandq_u16(p, m50), 1), vshrq_n_u16(vandq_u16(d, m50), 1));
+	else if (mode == BLIT_25)
+		p = neon_blend_25(p, d);
+	return vbslq_u16(mask, d, p);
+}
+
+static __inline__ NEON_PAL neon_load_pal(const Uint32 *paldata) {
+	uint16x8_t c0 = vcombine_u16(vmovn_u32(vld1q_u32(paldata)), vmovn_u32(vld1q_u32(paldata + 4)));
+	uint16x8_t c1 = vcombine_u16(vmovn_u32(vld1q_u32(paldata + 8)), vmovn_u32(vld1q_u32(paldata + 12)));
+	NEON_PAL pal;
+
+	pal.lo = vcombine_u8(vmovn_u16(c0), vmovn_u16(c1));
+	pal.hi = vcombine_u8(vshrn_n_u16(c0, 8), vshrn_n_u16(c1, 8));
+	return pal;
+}
+
+static __inline__ uint8x16_t neon_unpack(uint64 bytes, int hi_first) {
+	uint8x8_t b = vcreate_u8(bytes);
+	uint8x8_t lo = vand_u8(b, vdup_n_u8(0x0f));
+	uint8x8_t hi = vshr_n_u8(b, 4);
+	uint8x8x2_t z = hi_first ? vzip_u8(hi, lo) : vzip_u8(lo, hi);
+	return vcombine_u8(z.val[0], z.val[1]);
+}
+
+static __inline__ void neon_row(Uint16 *br, uint64 bytes, int hi_first,
+		const Uint8 *zoom, NEON_PAL pal, int mode) {
+	uint8x16_t col = neon_unpack(bytes, hi_first);
+	uint8x16x2_t p, m;
+
+	if (zoom)
+		col = neon_lookup(col, vld1q_u8(zoom));
+	p = vzipq_u8(neon_lookup(pal.lo, col), neon_lookup(pal.hi, col));
+	m = vzipq_u8(vceqq_u8(col, vdupq_n_u8(0)), vceqq_u8(col, vdupq_n_u8(0)));
+	vst1q_u16(br, neon_put(vreinterpretq_u16_u8(p.val[0]), vld1q_u16(br),
+			vreinterpretq_u16_u8(m.val[0]), mode));
+	vst1q_u16(br + 8, neon_put(vreinterpretq_u16_u8(p.val[1]), vld1q_u16(br + 8),
+			vreinterpretq_u16_u8(m.val[1]), mode));
+}
+
+static __inline__ void neon_char_row(Uint16 *br, Uint32 word, NEON_PAL pal) {
+	uint8x16_t col = neon_unpack(word, 0);
+	uint8x16x2_t p, m;
+
+	p = vzipq_u8(neon_lookup(pal.lo, col), neon_lookup(pal.hi, col));
+	m = vzipq_u8(vceqq_u8(col, vdupq_n_u8(0)), vceqq_u8(col, vdupq_n_u8(0)));
+	vst1q_u16(br, neon_put(vreinterpretq_u16_u8(p.val[0]), vld1q_u16(br),
+			vreinterpretq_u16_u8(m.val[0]), BLIT_NORMAL));
+}
+
+#define RENAME(name) neon_##name
+#define SIMD_TARGET
+#define SIMD_PAL NEON_PAL
+#include "video_simd_template.h"
+
+static const TILE_BLITTER neon_blitter = {
+	"NEON",
+	{ neon_draw_tile, NULL, neon_draw_tile_25, neon_draw_tile_50 },
+	{ neon_draw_scanline_tile, NULL, neon_draw_scanline_tile_25, neon_draw_scanline_tile_50 },
+	neon_draw_fix_char
+};
+
+int get_simd_blitters(const TILE_BLITTER **list, int max) {
+	int n = 0;
+
+	init_zoom_shuffle();
+	if (n < max)
+		list[n++] = &neon_blitter;
+	return n;
+}
+
+#endif
+
+#else
+
+int get_simd_blitters(const TILE_BLITTER **list, int max) {
+	return 0;
+}
+
+#endif
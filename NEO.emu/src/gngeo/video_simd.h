@@ -0,0 +1,59 @@
+/*  This file is part of NEO.emu.
+
+	NEO.emu is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	NEO.emu is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with NEO.emu.  If not, see <http://www.gnu.org/licenses/> */
+
+#ifndef _VIDEO_SIMD_H_
+#define _VIDEO_SIMD_H_
+
+#include "video.h"
+
+/* Sprite and fix layer drawing, as C functions or SSE2/AVX2/NEON ones picked
+ * when the video is initialized. The SIMD versions draw exactly the same
+ * pixels, including the 25% and 50% blending. */
+
+#if defined(__i386__) || defined(__x86_64__) || defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define HAVE_SIMD_BLITTER 1
+#endif
+
+typedef void (*DRAW_TILE_FUNC)(unsigned int tileno, int sx, int sy, int zx, int zy,
+		int color, int xflip, int yflip, unsigned char *bmp);
+typedef void (*DRAW_SCANLINE_TILE_FUNC)(unsigned int tileno, int yoffs, int sx, int line, int zx,
+		int color, int xflip, unsigned char *bmp);
+/* Draws the 8 rows of a fix layer char */
+typedef void (*DRAW_FIX_CHAR_FUNC)(const Uint32 *gfxdata, const Uint32 *paldata,
+		Uint16 *br, int pitch);
+
+typedef struct TILE_BLITTER {
+	const char *name;
+	/* Indexed by pen usage, the TILE_INVISIBLE entries are never called */
+	DRAW_TILE_FUNC draw_tile[4];
+	DRAW_SCANLINE_TILE_FUNC draw_scanline_tile[4];
+	DRAW_FIX_CHAR_FUNC draw_fix_char;
+} TILE_BLITTER;
+
+extern TILE_BLITTER tile_blitter;
+/* The C version, used when the cpu has none of the SIMD ones */
+extern const TILE_BLITTER c_tile_blitter;
+
+/* Fills list with the SIMD blitters this cpu supports, fastest first, and
+ * returns how many there are */
+int get_simd_blitters(const TILE_BLITTER **list, int max);
+
+/* Zoom and line skip tables of video.c */
+extern char *dda_x_skip;
+extern char ddaxskip[16][16];
+extern char dda_y_skip[17];
+extern char full_y_skip[16];
+
+#endif
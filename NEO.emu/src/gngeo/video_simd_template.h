@@ -0,0 +1,102 @@
+/* SIMD tile drawing template, included once per instruction set
+   use RENAME to set the name of the functions
+   RENAME(load_pal) converts the 16 colors of a palette to a SIMD_PAL,
+   RENAME(row) draws a row of 16 sprite pixels and RENAME(char_row) a row of
+   8 fix pixels, both leave pixels of color 0 untouched
+   SIMD_TARGET is put in front of each function for instruction sets enabled
+   per function
+*/
+
+/* A sprite row as 8 bytes in screen order, each holding two pixels */
+SIMD_TARGET static __inline__ uint64 RENAME(row_bytes)(const Uint32 *gfxdata, int xflip) {
+	if (xflip)
+		return gfxdata[1] | ((uint64) gfxdata[0] << 32);
+	return __builtin_bswap32(gfxdata[0]) | ((uint64) __builtin_bswap32(gfxdata[1]) << 32);
+}
+
+SIMD_TARGET static __inline__ void RENAME(draw)(unsigned int tileno, int sx, int sy, int zx, int zy,
+		int color, int xflip, int yflip, unsigned char *bmp, int mode) {
+	const Uint32 *gfxdata;
+	const char *l_y_skip = (zy == 16) ? full_y_skip : dda_y_skip;
+	const Uint8 *zoom = (zx == 16) ? NULL : zoom_shuffle[(dda_x_skip - ddaxskip[0]) >> 4];
+	int pitch = buffer->pitch >> 1;
+	SIMD_PAL pal = RENAME(load_pal)(&current_pc_pal[16 * color]);
+	Uint16 *br;
+	int y;
+
+	tileno = tileno % memory.nb_of_tiles;
+	gfxdata = (const Uint32 *) &memory.rom.tiles.p[tileno << 7];
+
+	if (yflip) {
+		br = (Uint16 *) bmp + ((zy - 1) + sy) * pitch + sx;
+		pitch = -pitch;
+	} else
+		br = (Uint16 *) bmp + sy * pitch + sx;
+	for (y = 0; y < zy; y++) {
+		gfxdata += l_y_skip[y] << 1;
+		if (gfxdata[0] || gfxdata[1])
+			RENAME(row)(br, RENAME(row_bytes)(gfxdata, xflip), !xflip, zoom, pal, mode);
+		br += pitch;
+	}
+}
+
+SIMD_TARGET static __inline__ void RENAME(draw_scanline)(unsigned int tileno, int yoffs, int sx, int line, int zx,
+		int color, int xflip, unsigned char *bmp, int mode) {
+	const Uint32 *gfxdata;
+	const Uint8 *zoom = (zx == 16) ? NULL : zoom_shuffle[(dda_x_skip - ddaxskip[0]) >> 4];
+
+	tileno = tileno % memory.nb_of_tiles;
+	gfxdata = (const Uint32 *) &memory.rom.tiles.p[tileno << 7] + (yoffs << 1);
+	/* same test as the C version, which also skips rows adding up to 0 */
+	if (gfxdata[1] + gfxdata[0] == 0) return;
+
+	RENAME(row)((Uint16 *) bmp + line * (buffer->pitch >> 1) + sx,
+			RENAME(row_bytes)(gfxdata, xflip), !xflip, zoom,
+			RENAME(load_pal)(&current_pc_pal[16 * color]), mode);
+}
+
+SIMD_TARGET static void RENAME(draw_tile)(unsigned int tileno, int sx, int sy, int zx, int zy,
+		int color, int xflip, int yflip, unsigned char *bmp) {
+	RENAME(draw)(tileno, sx, sy, zx, zy, color, xflip, yflip, bmp, BLIT_NORMAL);
+}
+
+SIMD_TARGET static void RENAME(draw_tile_50)(unsigned int tileno, int sx, int sy, int zx, int zy,
+		int color, int xflip, int yflip, unsigned char *bmp) {
+	RENAME(draw)(tileno, sx, sy, zx, zy, color, xflip, yflip, bmp, BLIT_50);
+}
+
+SIMD_TARGET static void RENAME(draw_tile_25)(unsigned int tileno, int sx, int sy, int zx, int zy,
+		int color, int xflip, int yflip, unsigned char *bmp) {
+	RENAME(draw)(tileno, sx, sy, zx, zy, color, xflip, yflip, bmp, BLIT_25);
+}
+
+SIMD_TARGET static void RENAME(draw_scanline_tile)(unsigned int tileno, int yoffs, int sx, int line, int zx,
+		int color, int xflip, unsigned char *bmp) {
+	RENAME(draw_scanline)(tileno, yoffs, sx, line, zx, color, xflip, bmp, BLIT_NORMAL);
+}
+
+SIMD_TARGET static void RENAME(draw_scanline_tile_50)(unsigned int tileno, int yoffs, int sx, int line, int zx,
+		int color, int xflip, unsigned char *bmp) {
+	RENAME(draw_scanline)(tileno, yoffs, sx, line, zx, color, xflip, bmp, BLIT_50);
+}
+
+SIMD_TARGET static void RENAME(draw_scanline_tile_25)(unsigned int tileno, int yoffs, int sx, int line, int zx,
+		int color, int xflip, unsigned char *bmp) {
+	RENAME(draw_scanline)(tileno, yoffs, sx, line, zx, color, xflip, bmp, BLIT_25);
+}
+
+SIMD_TARGET static void RENAME(draw_fix_char)(const Uint32 *gfxdata, const Uint32 *paldata,
+		Uint16 *br, int pitch) {
+	SIMD_PAL pal = RENAME(load_pal)(paldata);
+	int yy;
+
+	for (yy = 0; yy < 8; yy++) {
+		if (gfxdata[yy])
+			RENAME(char_row)(br, gfxdata[yy], pal);
+		br += pitch;
+	}
+}
+
+#undef RENAME
+#undef SIMD_TARGET
+#undef SIMD_PAL
@@ -114,6 +114,8 @@
 
 #include "mvs.h"
 #include "../state.h"
+#include "../roms.h"
+#include "../pcm_cache.h"
 #include "2610intf.h"
 #include "ym2610.h"
 
@@ -681,6 +683,7 @@ typedef struct
 	s8		vol_mul;		/* volume in "0.75dB" steps	*/
 	u8		vol_shift;		/* volume in "-6dB" steps	*/
 	s32		*pan;			/* &out_adpcma[OPN_xxxx] 	*/
+	PCM_CURSOR	pcm;			/* streamed rom position	*/
 } ADPCMA;
 
 
@@ -727,6 +730,8 @@ typedef struct adpcmb_state
     */
 	u8		PCM_BSY;		/* 1 when ADPCM is playing; Y8950/YM2608 only */
 
+	PCM_CURSOR	pcm;		/* streamed rom position */
+
 } ADPCMB;
 
 
@@ -2259,6 +2264,11 @@ static void SSG_write(int r, int v)
 
 static u8 *pcmbufA;
 static u32 pcmsizeA;
+static PCM_CACHE *pcmcacheA;	/* streamed rom when pcmbufA is NULL */
+
+/* rom byte from memory or the streamed rom */
+#define PCM_READ(buf, cache, cur, addr) \
+	((buf) ? (buf)[addr] : pcm_cache_read(cache, cur, addr))
 
 
 /* Algorithm and tables verified on real YM2610 */
@@ -2329,7 +2339,7 @@ INLINE void OPNB_ADPCMA_calc_chan(ADPCMA *ch)
 				data = ch->now_data & 0x0f;
 			else
 			{
-				ch->now_data = *(pcmbufA + (ch->now_addr >> 1));
+				ch->now_data = PCM_READ(pcmbufA, pcmcacheA, &ch->pcm, ch->now_addr >> 1);
 				data = (ch->now_data >> 4) & 0x0f;
 			}
 
@@ -2383,7 +2393,7 @@ static void OPNB_ADPCMA_write(int r, int v)
 					adpcma[c].adpcma_out  = 0;
 					adpcma[c].flag        = 1;
 
-					if (pcmbufA == NULL)
+					if (pcmbufA == NULL && pcmcacheA == NULL)
 					{
 						/* Check ROM Mapped */
 //						logerror("YM2610: ADPCM-A rom not mapped\n");
@@ -2402,6 +2412,8 @@ static void OPNB_ADPCMA_write(int r, int v)
 //							logerror("YM2610: ADPCM-A start out of range: $%08x\n", adpcma[c].start);
 							adpcma[c].flag = 0;
 						}
+						else if (pcmcacheA)
+							pcm_cache_prefetch(pcmcacheA, adpcma[c].start);
 					}
 				}
 			}
@@ -2471,6 +2483,9 @@ static void OPNB_ADPCMA_write(int r, int v)
 		case 0x110:
 		case 0x118:
 			adpcma[c].start = ((YM2610.regs[0x118 + c] << 8) | YM2610.regs[0x110 + c]) << ADPCMA_ADDRESS_SHIFT;
+			/* the sample is usually keyed on within the frame, get it ready */
+			if (pcmcacheA && (r & 0x138) == 0x118 && adpcma[c].start < pcmsizeA)
+				pcm_cache_prefetch(pcmcacheA, adpcma[c].start);
 			break;
 
 		case 0x120:
@@ -2496,6 +2511,7 @@ static void OPNB_ADPCMA_write(int r, int v)
 
 static u8 *pcmbufB;
 static u32 pcmsizeB;
+static PCM_CACHE *pcmcacheB;	/* streamed rom when pcmbufB is NULL */
 
 /* Forecast to next Forecast (rate = *8) */
 /* 1/8 , 3/8 , 5/8 , 7/8 , 9/8 , 11/8 , 13/8 , 15/8 */
@@ -2581,7 +2597,7 @@ value:   START, REC, MEMDAT, REPEAT, SPOFF, x,x,RESET   meaning:
 			adpcmb->memread = 2;	/* two dummy reads needed before accesing external memory via register $08*/
 
 			/* if yes, then let's check if ADPCM memory is mapped and big enough */
-			if (!pcmbufB)
+			if (!pcmbufB && !pcmcacheB)
 			{
 //				logerror("YM2610: Delta-T ADPCM rom not mapped\n");
 				adpcmb->portstate = 0x00;
@@ -2600,6 +2616,8 @@ value:   START, REC, MEMDAT, REPEAT, SPOFF, x,x,RESET   meaning:
 					adpcmb->portstate = 0x00;
 					adpcmb->PCM_BSY = 0;
 				}
+				else if (pcmcacheB && (adpcmb->portstate & 0x80))
+					pcm_cache_prefetch(pcmcacheB, adpcmb->start);
 			}
 		}
 #if 0
@@ -2652,6 +2670,8 @@ value:   START, REC, MEMDAT, REPEAT, SPOFF, x,x,RESET   meaning:
 	case 0x12:	/* Start Address L */
 	case 0x13:	/* Start Address H */
 		adpcmb->start = ((YM2610.regs[0x13] << 8) | YM2610.regs[0x12]) << adpcmb->portshift;
+		if (pcmcacheB && r == 0x13 && adpcmb->start < pcmsizeB)
+			pcm_cache_prefetch(pcmcacheB, adpcmb->start);
 		/*logerror("DELTAT start: 02=%2x 03=%2x addr=%8x\n", YM2610.regs[0x12], YM2610.regs[0x13], adpcmb->start);*/
 		break;
 
@@ -2736,7 +2756,7 @@ INLINE void OPNB_ADPCMB_CALC(ADPCMB *adpcmb)
 			}
 			else
 			{
-				adpcmb->now_data = *(pcmbufB + (adpcmb->now_addr >> 1));
+				adpcmb->now_data = PCM_READ(pcmbufB, pcmcacheB, &adpcmb->pcm, adpcmb->now_addr >> 1);
 				data = adpcmb->now_data >> 4;
 			}
 
@@ -2805,7 +2825,9 @@ void YM2610Init(int clock, int rate,
 		sound->callback = YM2610Update;
 */
 
-	/* clear */
+	/* clear, the cursors go with it */
+	pcm_cache_unpin_all(pcmcacheA);
+	pcm_cache_unpin_all(pcmcacheB);
 	memset(&YM2610, 0, sizeof(YM2610));
 	memset(&SSG, 0, sizeof(SSG));
 
@@ -2825,9 +2847,14 @@ void YM2610Init(int clock, int rate,
 	/* ADPCM-A */
 	pcmbufA = (u8 *)pcmroma;
 	pcmsizeA = pcmsizea;
+	pcmcacheA = pcmroma ? NULL : pcm_cache_region(REGION_AUDIO_DATA_1);
 	/* ADPCM-B */
 	pcmbufB = (u8 *)pcmromb;
 	pcmsizeB = pcmsizeb;
+	pcmcacheB = pcmromb ? NULL : pcm_cache_region(REGION_AUDIO_DATA_2);
+	for (int i = 0; i < 6; i++)
+		pcm_cursor_reset(NULL, &YM2610.adpcma[i].pcm);
+	pcm_cursor_reset(NULL, &YM2610.adpcmb.pcm);
 
 	YM2610.adpcmb.status_change_EOS_bit = 0x80;	/* status flag: set bit7 on End Of Sample */
 
@@ -2895,6 +2922,7 @@ void YM2610Reset(void)
 		YM2610.adpcma[i].adpcma_acc  = 0;
 		YM2610.adpcma[i].adpcma_step = 0;
 		YM2610.adpcma[i].adpcma_out  = 0;
+		pcm_cursor_reset(pcmcacheA, &YM2610.adpcma[i].pcm);
 	}
 	YM2610.adpcmaTL = 0x3f;
 
@@ -2919,6 +2947,7 @@ void YM2610Reset(void)
 	YM2610.adpcmb.adpcml       = 0;
 	YM2610.adpcmb.portstate    = 0x20;
 	YM2610.adpcmb.control2     = 0x01;
+	pcm_cursor_reset(pcmcacheB, &YM2610.adpcmb.pcm);
 
 	/* The flag mask register disables the BRDY after the reset, however
     ** as soon as the mask is enabled the flag needs to be set. */
@@ -3412,8 +3441,8 @@ void ym2610_mkstate(gzFile gzf,int mode) {
 		for(int r = 1; r < 16; r++)
 			OPNB_ADPCMB_write(&YM2610.adpcmb, r + 0x10, YM2610.regs[r + 0x10]);
 
-		if (pcmbufB)
-			YM2610.adpcmb.now_data = *(pcmbufB + (YM2610.adpcmb.now_addr >> 1));
+		if (pcmbufB || pcmcacheB)
+			YM2610.adpcmb.now_data = PCM_READ(pcmbufB, pcmcacheB, &YM2610.adpcmb.pcm, YM2610.adpcmb.now_addr >> 1);
 	}
 }
 
@@ -3583,8 +3612,8 @@ STATE_LOAD( ym2610 )
 	for (r = 1; r < 16; r++)
 		OPNB_ADPCMB_write(&YM2610.adpcmb, r + 0x10, YM2610.regs[r + 0x10]);
 
-	if (pcmbufB)
-		YM2610.adpcmb.now_data = *(pcmbufB + (YM2610.adpcmb.now_addr >> 1));
+	if (pcmbufB || pcmcacheB)
+		YM2610.adpcmb.now_data = PCM_READ(pcmbufB, pcmcacheB, &YM2610.adpcmb.pcm, YM2610.adpcmb.now_addr >> 1);
 }
 
 #endif /* SAVE_STATE */
@@ -156,7 +156,8 @@ enum {
 	CFGKEY_LIST_ALL_GAMES = 275, CFGKEY_BIOS_TYPE = 276,
 	CFGKEY_MVS_COUNTRY = 277, CFGKEY_TIMER_INT = 278,
 	CFGKEY_CREATE_USE_CACHE = 279,
-	CFGKEY_NEOGEOKEY_TEST_SWITCH = 280, CFGKEY_STRICT_ROM_CHECKING = 281
+	CFGKEY_NEOGEOKEY_TEST_SWITCH = 280, CFGKEY_STRICT_ROM_CHECKING = 281,
+	CFGKEY_STREAM_ADPCM = 282
 };
 
 static BasicByteOption optionListAllGames(CFGKEY_LIST_ALL_GAMES, 0);
@@ -165,12 +166,18 @@ static BasicByteOption optionMVSCountry(CFGKEY_MVS_COUNTRY, CTY_USA);
 static BasicByteOption optionTimerInt(CFGKEY_TIMER_INT, 2);
 static BasicByteOption optionCreateAndUseCache(CFGKEY_CREATE_USE_CACHE, 0);
 static BasicByteOption optionStrictROMChecking(CFGKEY_STRICT_ROM_CHECKING, 0);
+static BasicByteOption optionStreamADPCM(CFGKEY_STREAM_ADPCM, 0);
 
 CLINK int gn_strictROMChecking()
 {
 	return optionStrictROMChecking;
 }
 
+CLINK int gn_streamADPCM()
+{
+	return optionStreamADPCM;
+}
+
 void EmuSystem::initOptions()
 {
 	optionAutoSaveState.initDefault(0);
@@ -216,6 +223,7 @@ bool EmuSystem::readConfig(Io *io, uint key, uint readSize)
 		bcase CFGKEY_TIMER_INT: optionTimerInt.readFromIO(io, readSize);
 		bcase CFGKEY_CREATE_USE_CACHE: optionCreateAndUseCache.readFromIO(io, readSize);
 		bcase CFGKEY_STRICT_ROM_CHECKING: optionStrictROMChecking.readFromIO(io, readSize);
+		bcase CFGKEY_STREAM_ADPCM: optionStreamADPCM.readFromIO(io, readSize);
 	}
 	return 1;
 }
@@ -272,6 +280,11 @@ void EmuSystem::writeConfig(Io *io)
 		io->writeVar((uint16)optionStrictROMChecking.ioSize());
 		optionStrictROMChecking.writeToIO(io);
 	}
+	if(!optionStreamADPCM.isDefault())
+	{
+		io->writeVar((uint16)optionStreamADPCM.ioSize());
+		optionStreamADPCM.writeToIO(io);
+	}
 }
 
 static void setTimerIntOption()
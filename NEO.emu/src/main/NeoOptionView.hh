@@ -93,6 +93,14 @@ private:
 		optionStrictROMChecking = item.on;
 	}
 
+	BoolMenuItem streamADPCM;
+
+	static void streamADPCMHandler(BoolMenuItem &item, const InputEvent &e)
+	{
+		item.toggle();
+		optionStreamADPCM = item.on;
+	}
+
 	MenuItem *item[24];
 
 public:
@@ -107,6 +115,8 @@ public:
 		createAndUseCache.selectDelegate().bind<&createAndUseCacheHandler>();
 		strictROMChecking.init("Strict ROM Checking", optionStrictROMChecking); item[items++] = &strictROMChecking;
 		strictROMChecking.selectDelegate().bind<&strictROMCheckingHandler>();
+		streamADPCM.init("Stream ADPCM From Cache", optionStreamADPCM); item[items++] = &streamADPCM;
+		streamADPCM.selectDelegate().bind<&streamADPCMHandler>();
 	}
 
 	void loadGUIItems(MenuItem *item[], uint &items)
@@ -0,0 +1,231 @@
+/* Pixel for pixel comparison of the SIMD sprite and fix blitters
+ * (gngeo/video_simd.c) with the C ones they replace. Every blitter the cpu
+ * supports draws the same random tiles as the C one, for all 4 pen usage
+ * types, both flips, every x zoom, y zoom and at the clipped screen edges
+ * draw_screen() and draw_screen_scanline() allow, into copies of the same
+ * random screen. Exits non-zero if any pixel differs or a blitter writes
+ * outside the screen. Build with the Makefile in this directory. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "memory.h"
+#include "screen.h"
+#include "transpack.h"
+#include "video_simd.h"
+
+#define SCREEN_W 352
+#define SCREEN_H 256
+#define GUARD_ROWS 8
+#define NB_TILES 64
+
+neo_mem memory;
+GN_Surface *buffer;
+Uint32 *current_pc_pal;
+Uint8 *current_fix;
+Uint8 *fix_usage;
+int neogeo_fix_bank_type;
+
+void screen_update() {}
+
+static Uint16 screen[2][SCREEN_H + GUARD_ROWS * 2][SCREEN_W];
+static GN_Surface surface[2];
+static int errors;
+
+static Uint32 rnd(void) {
+	static Uint32 s = 1;
+	s ^= s << 13;
+	s ^= s >> 17;
+	s ^= s << 5;
+	return s;
+}
+
+static void fill_random(void *data, size_t size) {
+	Uint8 *b = data;
+	while (size--)
+		*b++ = rnd();
+}
+
+/* Tile rows are often empty or sparse in games, make some of them so */
+static void fill_tiles(Uint8 *p, size_t size) {
+	size_t i;
+
+	fill_random(p, size);
+	for (i = 0; i < size; i += 4) {
+		switch (rnd() % 4) {
+			case 0: memset(p + i, 0, 4); break;
+			case 1: p[i] &= 0x0f; p[i + 2] &= 0xf0; break;
+		}
+	}
+}
+
+static void reset_screens(void) {
+	fill_random(screen[0], sizeof (screen[0]));
+	memcpy(screen[1], screen[0], sizeof (screen[0]));
+}
+
+static unsigned char *screen_pixels(int i) {
+	return (unsigned char *) &screen[i][GUARD_ROWS][0];
+}
+
+/* The C blitters stay inside the screen, so this also catches SIMD writes
+ * to the guard rows around it */
+static void compare(const char *blitter, const char *what, int mode, int xflip, int yflip,
+		int zx, int zy, int sx, int sy) {
+	int y, x;
+
+	if (!memcmp(screen[0], screen[1], sizeof (screen[0])))
+		return;
+	for (y = 0; y < SCREEN_H + GUARD_ROWS * 2; y++) {
+		for (x = 0; x < SCREEN_W; x++) {
+			if (screen[0][y][x] == screen[1][y][x])
+				continue;
+			if (errors++ < 10)
+				printf("%s %s differs: mode %d xflip %d yflip %d zoom %d,%d at %d,%d: "
+						"pixel %d,%d is %04x, C has %04x\n", blitter, what, mode, xflip, yflip,
+						zx, zy, sx, sy, x, y - GUARD_ROWS, screen[1][y][x], screen[0][y][x]);
+			/* go on from the same screen */
+			memcpy(screen[1], screen[0], sizeof (screen[0]));
+			return;
+		}
+	}
+}
+
+/* Sets up dda_y_skip like draw_screen() does for a y zoom, returns the
+ * number of rows drawn */
+static int set_y_zoom(int rzy) {
+	int dday = 0, yskip = 0, i;
+
+	if (rzy == 255)
+		return 16;
+	dda_y_skip[0] = 0;
+	for (i = 0; i < 16; i++) {
+		dda_y_skip[i + 1] = 0;
+		dday -= rzy + 1;
+		if (dday <= 0) {
+			dday += 256;
+			yskip++;
+		}
+		dda_y_skip[yskip]++;
+	}
+	return yskip;
+}
+
+/* Draws with the C blitter into screen 0 and with blitter into screen 1 */
+static void test_tile(const TILE_BLITTER *blitter, int mode, unsigned int tileno, int sx, int sy,
+		int zx, int zy, int color, int xflip, int yflip) {
+	if (mode == TILE_INVISIBLE) {
+		/* draw_screen() never calls these */
+		if (c_tile_blitter.draw_tile[mode] || blitter->draw_tile[mode])
+			errors++;
+		return;
+	}
+	buffer = &surface[0];
+	c_tile_blitter.draw_tile[mode](tileno, sx, sy, zx, zy, color, xflip, yflip, screen_pixels(0));
+	buffer = &surface[1];
+	blitter->draw_tile[mode](tileno, sx, sy, zx, zy, color, xflip, yflip, screen_pixels(1));
+	compare(blitter->name, "tile", mode, xflip, yflip, zx, zy, sx, sy);
+}
+
+static void test_scanline_tile(const TILE_BLITTER *blitter, int mode, unsigned int tileno,
+		int yoffs, int sx, int line, int zx, int color, int xflip) {
+	if (mode == TILE_INVISIBLE) {
+		if (c_tile_blitter.draw_scanline_tile[mode] || blitter->draw_scanline_tile[mode])
+			errors++;
+		return;
+	}
+	buffer = &surface[0];
+	c_tile_blitter.draw_scanline_tile[mode](tileno, yoffs, sx, line, zx, color, xflip, screen_pixels(0));
+	buffer = &surface[1];
+	blitter->draw_scanline_tile[mode](tileno, yoffs, sx, line, zx, color, xflip, screen_pixels(1));
+	compare(blitter->name, "scanline tile", mode, xflip, 0, zx, 1, sx, line);
+}
+
+static void test_blitter(const TILE_BLITTER *blitter) {
+	/* draw_screen() only draws tiles that fit, sx + 16 in 0-335 & sy in 0-240,
+	 * draw_screen_scanline() clips sx + 16 to 0-336 */
+	static const int tile_x[] = { 0, 1, 15, 16, 170, 319, 334, 335 };
+	static const int tile_y[] = { 0, 1, 100, 239, 240 };
+	static const int line_x[] = { 0, 1, 16, 200, 320, 335, 336 };
+	static const int line_y[] = { 0, 1, 128, 254, 255 };
+	static const int y_zooms[] = { 0, 1, 31, 127, 128, 200, 254, 255 };
+	int mode, xflip, yflip, z, zy, i, j, x, y;
+	int checked = 0, failed = errors;
+
+	for (mode = 0; mode < 4; mode++) {
+		for (xflip = 0; xflip < 2; xflip++) {
+			for (z = 0; z < 16; z++) {
+				/* rzx as draw_screen() passes it, dda_x_skip only matters zoomed */
+				int zx = z + 1;
+				dda_x_skip = ddaxskip[z];
+				for (yflip = 0; yflip < 2; yflip++) {
+					for (zy = 0; zy < (int) (sizeof (y_zooms) / sizeof (y_zooms[0])); zy++) {
+						int rows = set_y_zoom(y_zooms[zy]);
+						for (i = 0; i < (int) (sizeof (tile_x) / sizeof (tile_x[0])); i++) {
+							for (j = 0; j < (int) (sizeof (tile_y) / sizeof (tile_y[0])); j++) {
+								test_tile(blitter, mode, rnd() % NB_TILES, tile_x[i], tile_y[j],
+										zx, rows, rnd() % 256, xflip, yflip);
+								checked++;
+							}
+						}
+					}
+				}
+				/* draw_screen_scanline() passes the raw x zoom, 15 is full size */
+				for (y = 0; y < 16; y++) {
+					for (i = 0; i < (int) (sizeof (line_x) / sizeof (line_x[0])); i++) {
+						test_scanline_tile(blitter, mode, rnd() % NB_TILES, y, line_x[i],
+								line_y[rnd() % (sizeof (line_y) / sizeof (line_y[0]))], z,
+								rnd() % 256, xflip);
+						checked++;
+					}
+				}
+			}
+		}
+	}
+
+	/* fix chars, pitch is the screen width as in draw_fix_char() */
+	for (i = 0; i < 2000; i++) {
+		Uint8 *gfx = current_fix + (rnd() % 4096) * 32;
+		const Uint32 *pal = &current_pc_pal[16 * (rnd() % 256)];
+		x = (i % 40) * 8 + 16;
+		y = i < 80 ? (i < 40 ? 0 : 31) * 8 : (rnd() % 32) * 8;
+		c_tile_blitter.draw_fix_char((const Uint32 *) gfx, pal,
+				(Uint16 *) screen_pixels(0) + y * SCREEN_W + x, SCREEN_W);
+		blitter->draw_fix_char((const Uint32 *) gfx, pal,
+				(Uint16 *) screen_pixels(1) + y * SCREEN_W + x, SCREEN_W);
+		compare(blitter->name, "fix char", 0, 0, 0, 8, 8, x, y);
+		checked++;
+	}
+	printf("%s: %d draws checked, %s\n", blitter->name, checked,
+			errors == failed ? "same as C" : "DIFFERENT");
+}
+
+int main(void) {
+	const TILE_BLITTER *simd[4];
+	int nb_simd, i;
+
+	memory.nb_of_tiles = NB_TILES;
+	/* a spare tile as y zoomed tiles read past their last row */
+	memory.rom.tiles.p = malloc((NB_TILES + 1) << 7);
+	fill_tiles(memory.rom.tiles.p, (NB_TILES + 1) << 7);
+	current_pc_pal = malloc(4096 * sizeof (Uint32));
+	for (i = 0; i < 4096; i++)
+		current_pc_pal[i] = rnd() & 0xffff;
+	current_fix = malloc(4096 * 32);
+	fill_tiles(current_fix, 4096 * 32);
+	for (i = 0; i < 2; i++) {
+		surface[i].pitch = SCREEN_W * 2;
+		surface[i].w = SCREEN_W;
+		surface[i].pixels = screen_pixels(i);
+	}
+	reset_screens();
+
+	nb_simd = get_simd_blitters(simd, 4);
+	if (!nb_simd)
+		printf("no SIMD blitter for this cpu\n");
+	for (i = 0; i < nb_simd; i++) {
+		test_blitter(simd[i]);
+		reset_screens();
+	}
+	return errors != 0;
+}
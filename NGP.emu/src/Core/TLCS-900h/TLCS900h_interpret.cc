@@ -600,7 +600,9 @@ static void ExR32()
 	//Undocumented mode!
 	if (data == 0x13)
 	{
-		mem = pc + (int16)fetch16();
+		//Relative to the pc after the displacement, fetch it first
+		int16 disp = fetch16();
+		mem = pc + disp;
 		cycles_extra = 8;	//Unconfirmed... doesn't make much difference
 		return;
 	}
@@ -99,6 +99,8 @@ uint32 timer_hint;
 uint32 timer_clock0, timer_clock1, timer_clock2, timer_clock3;
 uint8 timer[4];	//Up-counters
 
+uint32 timer_batch_ticks, timer_batch_limit;
+
 fbool gfx_hack = FALSE;
 
 //=============================================================================
@@ -484,6 +486,80 @@ template unsigned int updateTimers<0>(uint32 cputicks);
 
 //=============================================================================
 
+static __inline uint32 ticks_until(uint32 clock, uint32 rate)
+{
+	return clock >= rate ? 1 : rate - clock;
+}
+
+// Nothing happens in updateTimers() between these events other than the
+// clocks counting up, so running the CPU up to one of them and updating
+// once with the total gives the same result as updating every instruction.
+uint32 timer_next_event(void)
+{
+	uint32 next = ticks_until(timer_hint, TIMER_HINT_RATE);
+
+	//Timer 0
+	if ((ram[0x20] & 0x01))
+	{
+		if (ram[0x22] && timer[0] >= ram[0x22])
+			return 1;
+
+		switch(ram[0x24] & 0x03)
+		{
+		case 0:	if (h_int) return 1; break;
+		case 1:	next = IG::min(next, ticks_until(timer_clock0, TIMER_T1_RATE)); break;
+		case 2:	next = IG::min(next, ticks_until(timer_clock0, TIMER_T4_RATE)); break;
+		case 3:	next = IG::min(next, ticks_until(timer_clock0, TIMER_T16_RATE)); break;
+		}
+	}
+
+	//Timer 1, chain mode only ticks with timer 0
+	if ((ram[0x20] & 0x02))
+	{
+		if (ram[0x23] && timer[1] >= ram[0x23])
+			return 1;
+
+		switch((ram[0x24] & 0x0C) >> 2)
+		{
+		case 1:	next = IG::min(next, ticks_until(timer_clock1, TIMER_T1_RATE)); break;
+		case 2:	next = IG::min(next, ticks_until(timer_clock1, TIMER_T16_RATE)); break;
+		case 3:	next = IG::min(next, ticks_until(timer_clock1, TIMER_T256_RATE)); break;
+		}
+	}
+
+	//Timer 2
+	if ((ram[0x20] & 0x04))
+	{
+		if (ram[0x26] && timer[2] >= ram[0x26])
+			return 1;
+
+		switch(ram[0x28] & 0x03)
+		{
+		case 1:	next = IG::min(next, ticks_until(timer_clock2, 56)); break;
+		case 2:	next = IG::min(next, ticks_until(timer_clock2, TIMER_T4_RATE)); break;
+		case 3:	next = IG::min(next, ticks_until(timer_clock2, TIMER_T16_RATE)); break;
+		}
+	}
+
+	//Timer 3, chain mode only ticks with timer 2
+	if ((ram[0x20] & 0x08))
+	{
+		if (ram[0x27] && timer[3] >= ram[0x27])
+			return 1;
+
+		switch((ram[0x28] & 0x0C) >> 2)
+		{
+		case 1:	next = IG::min(next, ticks_until(timer_clock3, TIMER_T1_RATE)); break;
+		case 2:	next = IG::min(next, ticks_until(timer_clock3, TIMER_T16_RATE)); break;
+		case 3:	next = IG::min(next, ticks_until(timer_clock3, TIMER_T256_RATE)); break;
+		}
+	}
+
+	return next;
+}
+
+//=============================================================================
+
 void reset_timers(void)
 {
 	timer_hint = 0;
@@ -497,6 +573,9 @@ void reset_timers(void)
 	timer_clock1 = 0;
 	timer_clock2 = 0;
 	timer_clock3 = 0;
+
+	timer_batch_ticks = 0;
+	timer_batch_limit = 0;
 }
 
 //=============================================================================
@@ -70,10 +70,20 @@ void interrupt(uint8 index);
 
 void reset_timers(void);
 
-//Call this after each instruction
+//Call this after each instruction, or after a batch of instructions
+//that doesn't go past timer_next_event()
 template <bool runZ80InHInt>
 unsigned int updateTimers(uint32 cputicks) __attribute__ ((hot));
 
+//CPU ticks until the next H-INT or timer tick
+uint32 timer_next_event(void);
+
+//Ticks run in the current batch and the point where it has to stop
+extern uint32 timer_batch_ticks, timer_batch_limit;
+
+//A timer register changed, end the batch after this instruction
+static inline void timer_reschedule(void) { timer_batch_limit = 0; }
+
 //H-INT Timer
 extern uint32 timer_hint;
 extern uint8 timer[4];	//Up-counters
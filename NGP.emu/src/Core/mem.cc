@@ -149,7 +149,8 @@ void* translate_address_read(uint32 address)
 		//RAS.H read (Simulated horizontal raster position)
 		if (address == 0x8008)
 		{
-			ram[0x8008] = (uint8)((abs(TIMER_HINT_RATE - (int)timer_hint)) >> 2);
+			//timer_hint is only updated after each batch of instructions
+			ram[0x8008] = (uint8)((abs(TIMER_HINT_RATE - (int)(timer_hint + timer_batch_ticks))) >> 2);
 			//logMsg("reading h-ras %d", (int)ram[0x8008]);
 		}
 		return ram + address;
@@ -332,6 +333,10 @@ void post_write(uint32 address)
 	//DAC Write
 	if (address == 0xA2)	dac_write();
 
+	//Timer run/mode/threshold registers
+	if (address >= 0x1D && address <= 0x28)
+		timer_reschedule();
+
 	//Clear counters?
 	if (address == 0x20)
 	{
@@ -352,108 +357,199 @@ void post_write(uint32 address)
 
 static const bool ALIGN_ACCESS = 0;
 
-uint8 loadB(uint32 address)
+//=============================================================================
+
+#define MEM_PAGE_SHIFT	12
+#define MEM_PAGE_MASK	((1 << MEM_PAGE_SHIFT) - 1)
+#define MEM_PAGES		(0x1000000 >> MEM_PAGE_SHIFT)
+
+//Loads and stores go through a map of 4KB pages first. Each entry is the
+//host pointer to the start of the page or NULL when it has side effects
+//(internal I/O, RAS.H, EEPROM/flash commands) and needs the slow path,
+//as do 16/32-bit accesses crossing into the next page.
+//readPage[1] is used while eepromStatusEnable is set and only maps RAM,
+//so the next non-RAM read still goes through translate_address_read().
+static uint8* readPage[2][MEM_PAGES];
+static uint8* writePage[MEM_PAGES];
+
+#define READ_PAGE(address) \
+	readPage[eepromStatusEnable ? 1 : 0][((address) & 0xFFFFFF) >> MEM_PAGE_SHIFT]
+#define WRITE_PAGE(address) \
+	writePage[((address) & 0xFFFFFF) >> MEM_PAGE_SHIFT]
+
+//Returns the direct pointer for the page at 'base' if every address in it
+//resolves linearly in translate_address_read() without side effects.
+static uint8* direct_read_page(uint32 base)
 {
-	uint8* ptr = (uint8*)translate_address_read(address);
-	/*if (ptr == NULL)
-		return 0;
-	else*/
-		return *ptr;
+	uint32 last = base + MEM_PAGE_MASK;
+
+	if (last <= RAM_END)
+	{
+#ifdef NEOPOP_DEBUG
+		if (base == 0)
+			return NULL;
+#endif
+		//RAS.H is computed when read
+		if (base == (0x8008 & ~MEM_PAGE_MASK))
+			return NULL;
+		return ram + base;
+	}
+
+	//ROM (LOW)
+	if (base >= ROM_START && base <= rom.realEnd)
+	{
+		uint32 offset = base & 0x1FFFFF;
+		if (rom.data && last <= rom.realEnd && offset + MEM_PAGE_MASK < rom.length)
+			return rom.data + offset;
+		return NULL;
+	}
+
+	//ROM (HIGH)
+	if (base >= ROM_START && base <= rom.realHEnd)
+	{
+		uint32 offset = 0x200000 + (base - HIROM_START);
+		if (rom.data && base >= HIROM_START && last <= rom.realHEnd
+			&& offset + MEM_PAGE_MASK < rom.length)
+			return rom.data + offset;
+		return NULL;
+	}
+
+	//BIOS
+	if ((base & 0xFF0000) == 0xFF0000)
+		return bios + (base & 0xFFFF);
+
+	return NULL;
 }
 
-uint16 loadW(uint32 address)
+static void build_page_map(void)
 {
-	uint16* ptr = (uint16*)translate_address_read(address);
-	if((ptrsize)ptr % 2 != 0)
+	uint32 page;
+
+	for (page = 0; page < MEM_PAGES; page++)
 	{
-		//bug_exit("address %X", address);
+		uint32 base = page << MEM_PAGE_SHIFT;
+
+		readPage[0][page] = direct_read_page(base);
+		readPage[1][page] = (base <= RAM_END) ? readPage[0][page] : NULL;
+
+		//The first page has the registers checked by post_write(),
+		//anything past RAM is ignored or an EEPROM/flash command.
+		writePage[page] = (base > 0 && base <= RAM_END) ? ram + base : NULL;
 	}
-	/*if (ptr == NULL)
-		return 0;
-	else*/
+}
+
+//=============================================================================
+
+static uint16 readW(const void* ptr)
+{
 	if(ALIGN_ACCESS && ((ptrsize)ptr & BIT(0)))
 	{
 		uint16 v;
 		memcpy(&v, ptr, 2); // LE
-		return v;
+		return le16toh(v);
 	}
 
-	return le16toh(*ptr);
+	return le16toh(*(const uint16*)ptr);
 }
 
-uint32 loadL(uint32 address)
+static uint32 readL(const void* ptr)
 {
-	uint32* ptr = (uint32*)translate_address_read(address);
-	if((ptrsize)ptr % 4 != 0)
-	{
-		//bug_exit("address %X", address);
-	}
-	/*if (ptr == NULL)
-		return 0;
-	else*/
-
 	if(ALIGN_ACCESS && ((ptrsize)ptr & (BIT(0) | BIT(1))))
 	{
 		uint32 v;
 		memcpy(&v, ptr, 4); // LE
-		return v;
+		return le32toh(v);
 	}
 
-	return le32toh(*ptr);
+	return le32toh(*(const uint32*)ptr);
+}
+
+static void writeW(void* ptr, uint16 data)
+{
+	data = htole16(data);
+	if(ALIGN_ACCESS && ((ptrsize)ptr & BIT(0)))
+		memcpy(ptr, &data, 2); // LE
+	else
+		*(uint16*)ptr = data;
+}
+
+static void writeL(void* ptr, uint32 data)
+{
+	data = htole32(data);
+	if(ALIGN_ACCESS && ((ptrsize)ptr & (BIT(0) | BIT(1))))
+		memcpy(ptr, &data, 4); // LE
+	else
+		*(uint32*)ptr = data;
 }
 
 //=============================================================================
 
-void storeB(uint32 address, uint8 data)
+uint8 loadB(uint32 address)
 {
-	uint8* ptr = (uint8*)translate_address_write(address);
+	uint8* page = READ_PAGE(address);
+	if (likely(page != NULL))
+		return page[address & MEM_PAGE_MASK];
 
-	//Write
-	//if (ptr)
-	{
-		*ptr = data;
-		post_write(address);
-	}
+	return *(uint8*)translate_address_read(address);
 }
 
-void storeW(uint32 address, uint16 data)
+uint16 loadW(uint32 address)
+{
+	uint8* page = READ_PAGE(address);
+	if (likely(page != NULL && (address & MEM_PAGE_MASK) <= MEM_PAGE_MASK - 1))
+		return readW(page + (address & MEM_PAGE_MASK));
+
+	return readW(translate_address_read(address));
+}
+
+uint32 loadL(uint32 address)
+{
+	uint8* page = READ_PAGE(address);
+	if (likely(page != NULL && (address & MEM_PAGE_MASK) <= MEM_PAGE_MASK - 3))
+		return readL(page + (address & MEM_PAGE_MASK));
+
+	return readL(translate_address_read(address));
+}
+
+//=============================================================================
+
+void storeB(uint32 address, uint8 data)
 {
-	uint16* ptr = (uint16*)translate_address_write(address);
-	if((ptrsize)ptr % 2 != 0)
+	uint8* page = WRITE_PAGE(address);
+	if (likely(page != NULL))
 	{
-		//bug_exit("address %X", address);
+		page[address & MEM_PAGE_MASK] = data;
+		return;
 	}
 
-	//Write
-	//if (ptr)
+	*(uint8*)translate_address_write(address) = data;
+	post_write(address);
+}
 
-	if(ALIGN_ACCESS && ((ptrsize)ptr & BIT(0)))
-		memcpy(ptr, &data, 2); // LE
-	else
-		*ptr = htole16(data);
+void storeW(uint32 address, uint16 data)
+{
+	uint8* page = WRITE_PAGE(address);
+	if (likely(page != NULL && (address & MEM_PAGE_MASK) <= MEM_PAGE_MASK - 1))
 	{
-
-		post_write(address);
+		writeW(page + (address & MEM_PAGE_MASK), data);
+		return;
 	}
+
+	writeW(translate_address_write(address), data);
+	post_write(address);
 }
 
 void storeL(uint32 address, uint32 data)
 {
-	uint32* ptr = (uint32*)translate_address_write(address);
-	if((ptrsize)ptr % 4 != 0)
+	uint8* page = WRITE_PAGE(address);
+	if (likely(page != NULL && (address & MEM_PAGE_MASK) <= MEM_PAGE_MASK - 3))
 	{
-		//bug_exit("address %X", address);
+		writeL(page + (address & MEM_PAGE_MASK), data);
+		return;
 	}
 
-	//Write
-	//if (ptr)
-	if(ALIGN_ACCESS && ((ptrsize)ptr & (BIT(0) | BIT(1))))
-		memcpy(ptr, &data, 4); // LE
-	else
-		*ptr = htole32(data);
-	{
-		post_write(address);
-	}
+	writeL(translate_address_write(address), data);
+	post_write(address);
 }
 
 //=============================================================================
@@ -551,6 +647,8 @@ void reset_memory(void)
 
 		ram[0x6C55] = 0;	//Bios menu
 	}
+
+	build_page_map();
 	
 
 	ram[0x6F80] = 0xFF;	//Lots of battery power!
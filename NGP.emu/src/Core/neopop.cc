@@ -103,7 +103,19 @@ void emulate(void)
 	//system_message("start loop");
 	while(!gotVBL)
 	{
-		gotVBL = updateTimers<1>(TLCS900h_interpret());
+		//Run instructions up to the next timer event, a timer
+		//register write ends the batch early
+		timer_batch_ticks = 0;
+		timer_batch_limit = timer_next_event();
+		do
+		{
+			timer_batch_ticks += TLCS900h_interpret();
+		}
+		while(timer_batch_ticks < timer_batch_limit);
+
+		uint32 ticks = timer_batch_ticks;
+		timer_batch_ticks = 0;
+		gotVBL = updateTimers<1>(ticks);
 	}
 }
 
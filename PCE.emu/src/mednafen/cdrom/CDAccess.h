@@ -14,6 +14,11 @@ class CDAccess
 
  virtual void Read_Raw_Sector(uint8 *buf, int32 lba) = 0;
 
+ // Same as Read_Raw_Sector(), except sectors built from cooked mode 1 or mode 2 form 1 image data are returned with only the
+ // sync pattern, header, sub-header and user data filled in.  Returns true if the EDC/ECC was left out this way,
+ // encode_omitted_ecc() completes the sector.
+ virtual bool Read_Raw_Sector_NoECC(uint8 *buf, int32 lba) { Read_Raw_Sector(buf, lba); return(false); }
+
  virtual void Read_TOC(CDUtility::TOC *toc) = 0;
 
  virtual bool Is_Physical(void) = 0;
@@ -679,8 +679,15 @@ CDAccess_Image::CDAccess_Image(const char *path)
 }
 
 void CDAccess_Image::Read_Raw_Sector(uint8 *buf, int32 lba)
+{
+ if(Read_Raw_Sector_NoECC(buf, lba))
+  encode_omitted_ecc(lba + 150, buf);
+}
+
+bool CDAccess_Image::Read_Raw_Sector_NoECC(uint8 *buf, int32 lba)
 {
   bool TrackFound = FALSE;
+  bool ECCOmitted = FALSE;
   uint8 SimuQ[0xC];
 
   memset(buf + 2352, 0, 96);
@@ -721,8 +728,8 @@ void CDAccess_Image::Read_Raw_Sector(uint8 *buf, int32 lba)
       if(frames_read < 588)
        memset((uint8 *)AudioBuf + frames_read * 2 * sizeof(int16), 0, (588 - frames_read) * 2 * sizeof(int16));
 
-      for(int i = 0; i < 588 * 2; i++)
-       MDFN_en16lsb(buf + i * 2, AudioBuf[i]);
+      memcpy(buf, AudioBuf, 2352);
+      Endian_A16_NE_to_LE(buf, 588 * 2);
      }
      else	// Binary, woo.
      {
@@ -747,7 +754,8 @@ void CDAccess_Image::Read_Raw_Sector(uint8 *buf, int32 lba)
 
 	case DI_FORMAT_MODE1:
 		fread(buf + 12 + 3 + 1, 1, 2048, ct->fp);
-		encode_mode1_sector(lba + 150, buf);
+		encode_mode1_header(lba + 150, buf);
+		ECCOmitted = TRUE;
 		break;
 
 	case DI_FORMAT_MODE1_RAW:
@@ -764,8 +772,10 @@ void CDAccess_Image::Read_Raw_Sector(uint8 *buf, int32 lba)
 	// FIXME: M2F1, M2F2, does sub-header come before or after user data(standards say before, but I wonder
 	// about cdrdao...).
 	case DI_FORMAT_MODE2_FORM1:
+		memset(buf + 16, 0, 8);	// Form 1 sub-header
 		fread(buf + 24, 1, 2048, ct->fp);
-		//encode_mode2_form1_sector(lba + 150, buf);
+		encode_mode2_sector(lba + 150, buf);	// Sync pattern and header only
+		ECCOmitted = TRUE;
 		break;
 
 	case DI_FORMAT_MODE2_FORM2:
@@ -816,6 +826,8 @@ void CDAccess_Image::Read_Raw_Sector(uint8 *buf, int32 lba)
  //subq_deinterleave(buf + 2352, qbuf);
  //printf("%02x\n", qbuf[0]);
  //printf("%02x\n", buf[12 + 3]);
+
+ return(ECCOmitted);
 }
 
 void CDAccess_Image::MakeSubPQ(int32 lba, uint8 *SubPWBuf)
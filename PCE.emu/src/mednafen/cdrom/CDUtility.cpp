@@ -89,6 +89,19 @@ void encode_mode1_sector(uint32 aba, uint8 *sector_data)
  lec_encode_mode1_sector(aba, sector_data);
 }
 
+void encode_mode1_header(uint32 aba, uint8 *sector_data)
+{
+ lec_encode_mode1_header(aba, sector_data);
+}
+
+void encode_omitted_ecc(uint32 aba, uint8 *sector_data)
+{
+ if(sector_data[12 + 3] == 2)
+  encode_mode2_form1_sector(aba, sector_data);
+ else
+  encode_mode1_sector(aba, sector_data);
+}
+
 void encode_mode2_sector(uint32 aba, uint8 *sector_data)
 {
  CDUtility_Init();
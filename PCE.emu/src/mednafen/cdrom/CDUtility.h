@@ -166,6 +166,8 @@ namespace CDUtility
  //  sector_data must be able to contain at least 2352 bytes.
  void encode_mode0_sector(uint32 aba, uint8 *sector_data);
  void encode_mode1_sector(uint32 aba, uint8 *sector_data);	// 2048 bytes of user data at offset 16
+ void encode_mode1_header(uint32 aba, uint8 *sector_data);	// Sync pattern and header only, no EDC/ECC
+ void encode_omitted_ecc(uint32 aba, uint8 *sector_data);	// Completes a mode 1 or mode 2 form 1 sector from CDAccess::Read_Raw_Sector_NoECC()
  void encode_mode2_sector(uint32 aba, uint8 *sector_data);	// 2336 bytes of user data at offset 16 
  void encode_mode2_form1_sector(uint32 aba, uint8 *sector_data);	// 2048+8 bytes of user data at offset 16
  void encode_mode2_form2_sector(uint32 aba, uint8 *sector_data);	// 2324+8 bytes of user data at offset 16
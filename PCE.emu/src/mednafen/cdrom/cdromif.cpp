@@ -202,23 +202,39 @@ int CDIF::ReadThreadStart(const char *device_name)
                           static const int max_ra = 16;
 			  static const int initial_ra = 1;
 			  static const int speedmult_ra = 2;
+			  // Audio tracks may be Ogg Vorbis or other compressed files, decoding(and especially seeking in) those
+			  // can take a while, so keep further ahead and start filling the whole window right away when playback
+			  // starts somewhere new, rather than having CD-DA playback wait on the decoder.
+			  static const int audio_max_ra = 48;
 			  uint32 new_lba = msg.args[0];
+			  // FindTrackByLBA() gives 0 or a track outside the TOC for LBAs past the lead-out, treat those as data.
+			  const int track = disc_toc.FindTrackByLBA(new_lba);
+			  const bool audio = track >= disc_toc.first_track && track <= disc_toc.last_track &&
+			   !(disc_toc.tracks[track].control & 0x4);
+			  const int cur_max_ra = audio ? audio_max_ra : max_ra;
 
 			  assert((unsigned int)max_ra < (SBSize / 4));
+			  assert((unsigned int)audio_max_ra < (SBSize / 4));
 
 			  if(last_read_lba != ~0U && new_lba == (last_read_lba + 1))
 			  {
 			   int how_far_ahead = ra_lba - new_lba;
 
-			   if(how_far_ahead <= max_ra)
-			    ra_count = std::min(speedmult_ra, 1 + max_ra - how_far_ahead);
+			   if(how_far_ahead <= cur_max_ra)
+			   {
+			    // Don't cut short an audio window that's still being filled.
+			    if(audio)
+			     ra_count = std::max(ra_count, std::min(speedmult_ra, 1 + cur_max_ra - how_far_ahead));
+			    else
+			     ra_count = std::min(speedmult_ra, 1 + cur_max_ra - how_far_ahead);
+			   }
 			   else
 			    ra_count++;
 			  }
 			  else if(new_lba != last_read_lba)
 			  {
                            ra_lba = new_lba;
-			   ra_count = initial_ra;
+			   ra_count = audio ? audio_max_ra : initial_ra;
 			  }
 
 			  last_read_lba = new_lba;
@@ -238,10 +254,11 @@ int CDIF::ReadThreadStart(const char *device_name)
   {
    uint8 tmpbuf[2352 + 96];
    bool error_condition = false;
+   bool ecc_omitted = false;
 
    //try
    {
-    disc_cdaccess->Read_Raw_Sector(tmpbuf, ra_lba);
+    ecc_omitted = disc_cdaccess->Read_Raw_Sector_NoECC(tmpbuf, ra_lba);
    }
    // TODO
    /*catch(std::exception &e)
@@ -257,6 +274,7 @@ int CDIF::ReadThreadStart(const char *device_name)
    memcpy(SectorBuffers[SBWritePos].data, tmpbuf, 2352 + 96);
    SectorBuffers[SBWritePos].valid = TRUE;
    SectorBuffers[SBWritePos].error = error_condition;
+   SectorBuffers[SBWritePos].ecc_omitted = ecc_omitted;
    SBWritePos = (SBWritePos + 1) % SBSize;
 
    MDFND_UnlockMutex(SBMutex);
@@ -333,10 +351,11 @@ bool CDIF::ValidateRawSector(uint8 *buf)
  return(true);
 }
 
-bool CDIF::ReadRawSector(uint8 *buf, uint32 lba)
+bool CDIF::ReadRawSector(uint8 *buf, uint32 lba, bool *ecc_omitted)
 {
  bool found = FALSE;
  bool error_condition = false;
+ bool sector_ecc_omitted = false;
 
  if(UnrecoverableError)
  {
@@ -363,6 +382,7 @@ bool CDIF::ReadRawSector(uint8 *buf, uint32 lba)
    if(SectorBuffers[i].valid && SectorBuffers[i].lba == lba)
    {
     error_condition = SectorBuffers[i].error;
+    sector_ecc_omitted = SectorBuffers[i].ecc_omitted;
     memcpy(buf, SectorBuffers[i].data, 2352 + 96);
     found = TRUE;
    }
@@ -374,6 +394,11 @@ bool CDIF::ReadRawSector(uint8 *buf, uint32 lba)
    MDFND_Sleep(1);
  } while(!found);
 
+ if(ecc_omitted)
+  *ecc_omitted = sector_ecc_omitted;
+ else if(sector_ecc_omitted)
+  encode_omitted_ecc(lba + 150, buf);
+
  return(!error_condition);
 }
 
@@ -398,14 +423,15 @@ int CDIF::ReadSector(uint8* pBuf, uint32 lba, uint32 nSectors)
  while(nSectors--)
  {
   uint8 tmpbuf[2352 + 96];
+  bool ecc_omitted;
 
-  if(!ReadRawSector(tmpbuf, lba))
+  if(!ReadRawSector(tmpbuf, lba, &ecc_omitted))
   {
    MDFN_PrintError("CDIF Raw Read error");
    return(FALSE);
   }
 
-  if(!ValidateRawSector(tmpbuf))
+  if(!ecc_omitted && !ValidateRawSector(tmpbuf))
   {
    MDFN_DispMessage(_("Uncorrectable data at sector %d"), lba);
    MDFN_PrintError(_("Uncorrectable data at sector %d"), lba);
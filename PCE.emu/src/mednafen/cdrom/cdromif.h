@@ -80,6 +80,7 @@ typedef struct
 {
  bool valid;
  bool error;
+ bool ecc_omitted;	// Synthesized mode 1 or mode 2 form 1 sector without EDC/ECC, see CDAccess::Read_Raw_Sector_NoECC()
  uint32 lba;
  uint8 data[2352 + 96];
 } CDIF_Sector_Buffer;
@@ -97,7 +98,10 @@ class CDIF
  void ReadTOC(CDUtility::TOC *read_target);
 
  void HintReadSector(uint32 lba);
- bool ReadRawSector(uint8 *buf, uint32 lba);
+ // If ecc_omitted is non-NULL, the EDC/ECC of sectors synthesized from cooked mode 1 or mode 2 form 1 image data isn't generated
+ // and *ecc_omitted is set to true for them instead; those sectors are correct by construction and don't need
+ // ValidateRawSector().  Otherwise the full raw sector is always returned.
+ bool ReadRawSector(uint8 *buf, uint32 lba, bool *ecc_omitted = NULL);
 
  // Call for mode 1 or mode 2 form 1 only.
  bool ValidateRawSector(uint8 *buf);
@@ -119,10 +119,46 @@ unsigned long  edctable[256] =
  * CDROM EDC calculation
  */
 
+/*
+ * edctable extended for consuming 4 bytes per step(slicing-by-4),
+ * slice[n][i] is the CRC of byte i followed by n + 1 zero bytes.
+ */
+
+static const class EDCSliceTable
+{
+ public:
+ uint32 slice[3][256];
+
+ EDCSliceTable()
+ {
+  for(int i = 0; i < 256; i++)
+  {
+   uint32 crc = edctable[i];
+
+   for(int n = 0; n < 3; n++)
+   {
+    crc = edctable[crc & 0xFF] ^ (crc >> 8);
+    slice[n][i] = crc;
+   }
+  }
+ }
+} edcslice;
+
 uint32 EDCCrc32(const unsigned char *data, int len)
 {  
  uint32 crc = 0;
 
+ while(len >= 4)
+ {
+  crc ^= data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32)data[3] << 24);
+
+  crc = edcslice.slice[2][crc & 0xFF] ^ edcslice.slice[1][(crc >> 8) & 0xFF] ^
+	edcslice.slice[0][(crc >> 16) & 0xFF] ^ edctable[crc >> 24];
+
+  data += 4;
+  len -= 4;
+ }
+
  while(len--)
   crc = edctable[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
 
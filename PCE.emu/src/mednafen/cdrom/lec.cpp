@@ -521,6 +521,16 @@ void lec_encode_mode1_sector(u_int32_t adr, u_int8_t *sector)
   calc_Q_parity(sector);
 }
 
+/* Sets only the sync pattern and header of a MODE 1 sector.
+ * 'adr' is the current physical sector address
+ * 'sector' must be 2352 byte wide
+ */
+void lec_encode_mode1_header(u_int32_t adr, u_int8_t *sector)
+{
+  set_sync_pattern(sector);
+  set_sector_header(1, adr, sector);
+}
+
 /* Encodes a MODE 2 sector.
  * 'adr' is the current physical sector address
  * 'sector' must be 2352 byte wide containing 2336 bytes user data at
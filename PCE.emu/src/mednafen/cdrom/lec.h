@@ -48,6 +48,13 @@ void lec_encode_mode0_sector(u_int32_t adr, u_int8_t *sector);
  */
 void lec_encode_mode1_sector(u_int32_t adr, u_int8_t *sector);
 
+/* Sets only the sync pattern and header of a MODE 1 sector, leaving
+ * the EDC and P/Q parity fields untouched.
+ * 'adr' is the current physical sector address
+ * 'sector' must be 2352 byte wide
+ */
+void lec_encode_mode1_header(u_int32_t adr, u_int8_t *sector);
+
 /* Encodes a MODE 2 sector.
  * 'adr' is the current physical sector address
  * 'sector' must be 2352 byte wide containing 2336 bytes user data at
@@ -2455,8 +2455,8 @@ static INLINE void RunCDDA(uint32 system_timestamp, int32 run_time)
 
      Cur_CDIF->ReadRawSector(tmpbuf, read_sec);	//, read_sec_end, read_sec_start);
 
-     for(int i = 0; i < 588 * 2; i++)
-      cdda.CDDASectorBuffer[i] = MDFN_de16lsb(&tmpbuf[i * 2]);
+     memcpy(cdda.CDDASectorBuffer, tmpbuf, 2352);
+     Endian_A16_LE_to_NE(cdda.CDDASectorBuffer, 588 * 2);
 
      memcpy(cd.SubPWBuf, tmpbuf + 2352, 96);
     }
@@ -2539,6 +2539,7 @@ static INLINE void RunCDRead(uint32 system_timestamp, int32 run_time)
    else
    {
     uint8 tmp_read_buf[2352 + 96];
+    bool ecc_omitted;
 
     if(cd.TrayOpen)
     {
@@ -2551,13 +2552,13 @@ static INLINE void RunCDRead(uint32 system_timestamp, int32 run_time)
     {
      CommandCCError(SENSEKEY_ILLEGAL_REQUEST, NSE_END_OF_VOLUME);
     }
-    else if(!Cur_CDIF->ReadRawSector(tmp_read_buf, SectorAddr))	//, SectorAddr + SectorCount))
+    else if(!Cur_CDIF->ReadRawSector(tmp_read_buf, SectorAddr, &ecc_omitted))	//, SectorAddr + SectorCount))
     {
      cd.data_transfer_done = FALSE;
 
      CommandCCError(SENSEKEY_ILLEGAL_REQUEST);
     }
-    else if(ValidateRawDataSector(tmp_read_buf, SectorAddr))
+    else if(ecc_omitted || ValidateRawDataSector(tmp_read_buf, SectorAddr))
     {
      memcpy(cd.SubPWBuf, tmp_read_buf + 2352, 96);
 
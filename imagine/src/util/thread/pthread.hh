@@ -207,4 +207,25 @@ public:
 		pthread_mutex_t *waitMutex = mutex ? &mutex->mutex : this->mutex;
 		pthread_cond_wait(&cond, waitMutex);
 	}
+
+	void signal()
+	{
+		assert(init);
+		pthread_cond_signal(&cond);
+	}
+
+	void broadcast()
+	{
+		assert(init);
+		pthread_cond_broadcast(&cond);
+	}
+
+	void destroy()
+	{
+		if(init)
+		{
+			pthread_cond_destroy(&cond);
+			init = 0;
+		}
+	}
 };